@@ -42,14 +42,16 @@
 #include "engine/include/core/error.h"
 #include "engine/include/core/platform.h"
 #include "engine/include/core/version.h"
+#include "engine/include/core/allocator.h"
 
 
 /*
     Tracy profiler & allocation macros.
 
-    NS_MALLOC -> stdlib malloc or Tracy equivalent.
-    NS_REALLOC -> stdlib's realloc or Tracy equivalent.
-    NS_FREE -> stdlib's free or Tracy equivalent.
+    NS_MALLOC -> Allocate from the allocator of NS_MEMORY_TAG.
+    NS_REALLOC -> Resize memory from NS_MALLOC.
+    NS_FREE -> Free memory from NS_MALLOC.
+    NS_MEMORY_TAG -> Memory tag of the source file, define it before any include.
 
     NS_TRACY_ZONE_START -> Start profiled function zone.
     NS_TRACY_ZONE_END -> End profiled function zone.
@@ -63,40 +65,22 @@
     #define NS_TRACY_ZONE_END TracyCZoneEnd(_tracy_zone)
     #define NS_TRACY_FRAMEMARK TracyCFrameMark
 
-    static inline void *NS_MALLOC(size_t size) {
-        void *ptr = malloc(size);
-        TracyCAlloc(ptr, size);
-        return ptr;
-    }
-
-    static inline void *NS_REALLOC(void *ptr, size_t new_size) {
-        if (ptr) {
-            TracyCFree(ptr);
-        }
-
-        void *new_ptr = realloc(ptr, new_size);
-        TracyCAlloc(new_ptr, new_size);
-
-        return new_ptr;
-    }
-
-    static inline void NS_FREE(void *ptr) {
-        TracyCFree(ptr);
-        free(ptr);
-    }
-
 #else
 
     #define NS_TRACY_ZONE_START
     #define NS_TRACY_ZONE_END
     #define NS_TRACY_FRAMEMARK
 
-    #define NS_MALLOC(size) malloc(size)
-    #define NS_REALLOC(ptr, new_size) realloc(ptr, new_size)
-    #define NS_FREE(ptr) free(ptr)
+#endif
 
+#ifndef NS_MEMORY_TAG
+    #define NS_MEMORY_TAG nsMemoryTag_GENERAL
 #endif
 
+#define NS_MALLOC(size) ns_alloc(size, NS_MEMORY_TAG)
+#define NS_REALLOC(ptr, new_size) ns_realloc(ptr, new_size, NS_MEMORY_TAG)
+#define NS_FREE(ptr) ns_free(ptr)
+
 
 // Allocate new object of given type.
 #define NS_NEW(type) ((type *)NS_MALLOC(sizeof(type)))
@@ -17,6 +17,9 @@
  */
 #include "engine/include/_internal.h"
 #include "engine/include/scene/scene.h"
+#include "engine/include/loaders/async.h"
+#include "engine/include/core/jobs.h"
+#include "engine/include/core/frame_stats.h"
 
 
 typedef struct {
@@ -39,6 +42,12 @@ typedef struct {
     SDL_GLContext *gl_ctx;
     struct nk_context *ui_ctx;
 
+    nsAsyncLoader *loader;
+    nsJobSystem *jobs;
+
+    nsFrameStats frame_stats; /**< Timings of the most recent frames. */
+    ns_bool show_frame_stats; /**< Draw frame statistics overlay, toggled with F3. */
+
     nsScene *current_scene;
 } nsApp;
 
@@ -0,0 +1,178 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/allocator.h
+ * @brief Pluggable allocators and tagged memory accounting.
+ */
+#ifndef _NS_ALLOCATOR_H
+#define _NS_ALLOCATOR_H
+
+#include <stddef.h>
+#include "engine/include/core/types.h"
+
+
+/**
+ * @brief Subsystem an allocation belongs to.
+ * 
+ * Source files select their tag by defining `NS_MEMORY_TAG` before any
+ * include, @ref NS_MALLOC and friends pick it up from there.
+ */
+typedef enum {
+    nsMemoryTag_GENERAL, /**< Anything without a more specific tag. */
+    nsMemoryTag_CONTAINERS, /**< Arrays, pools and slot maps. */
+    nsMemoryTag_ARENAS, /**< Blocks of arena allocators. */
+    nsMemoryTag_LOADERS, /**< File contents and asset loading. */
+    nsMemoryTag_MESHES, /**< Meshes, buffers and geometry processing. */
+    nsMemoryTag_MATERIALS, /**< Materials and uniforms. */
+    nsMemoryTag_TEXTURES, /**< Textures. */
+    nsMemoryTag_UI, /**< Nuklear contexts, buffers and fonts. */
+    nsMemoryTag_COUNT /**< Number of tags. */
+} nsMemoryTag;
+
+/**
+ * @brief Get the name of memory tag.
+ * 
+ * @param tag Memory tag
+ * @return const char *
+ */
+static inline const char *nsMemoryTag_as_string(nsMemoryTag tag) {
+    switch (tag) {
+        case nsMemoryTag_GENERAL:
+            return "General";
+
+        case nsMemoryTag_CONTAINERS:
+            return "Containers";
+
+        case nsMemoryTag_ARENAS:
+            return "Arenas";
+
+        case nsMemoryTag_LOADERS:
+            return "Loaders";
+
+        case nsMemoryTag_MESHES:
+            return "Meshes";
+
+        case nsMemoryTag_MATERIALS:
+            return "Materials";
+
+        case nsMemoryTag_TEXTURES:
+            return "Textures";
+
+        case nsMemoryTag_UI:
+            return "UI";
+
+        default:
+            return "Unknown";
+    }
+}
+
+/**
+ * @brief Memory allocator interface.
+ * 
+ * Returned memory has to be aligned to at least 16 bytes. Sizes passed to
+ * realloc and free are the sizes the blocks were requested with, so
+ * size-class based allocators don't have to store them.
+ */
+typedef struct {
+    void *(*alloc)(void *user_data, size_t size); /**< Allocate block, return `NULL` on failure. */
+    void *(*realloc)(void *user_data, void *ptr, size_t old_size, size_t new_size); /**< Resize block, return `NULL` on failure and leave the block intact. */
+    void (*free)(void *user_data, void *ptr, size_t size); /**< Free block. */
+    void *user_data; /**< Passed to every callback. */
+} nsAllocator;
+
+/**
+ * @brief Allocation statistics of a memory tag.
+ */
+typedef struct {
+    size_t live_bytes; /**< Bytes currently allocated. */
+    size_t peak_bytes; /**< Highest value of live bytes. */
+    size_t alloc_count; /**< Number of allocations. */
+    size_t realloc_count; /**< Number of reallocations. */
+    size_t free_count; /**< Number of frees. */
+} nsMemoryStats;
+
+/**
+ * @brief Set the allocator of a memory tag.
+ * 
+ * Memory is freed with the allocator it came from, so the allocator can only
+ * be changed while the tag has no live allocations. Set allocators before
+ * creating the app. The allocator struct is copied.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param tag Memory tag
+ * @param allocator Allocator or `NULL` for the standard library
+ * @return int Status
+ */
+int ns_set_allocator(nsMemoryTag tag, const nsAllocator *allocator);
+
+/**
+ * @brief Set the allocator of every memory tag.
+ * 
+ * Fails without changing any tag if one of them has live allocations.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param allocator Allocator or `NULL` for the standard library
+ * @return int Status
+ */
+int ns_set_global_allocator(const nsAllocator *allocator);
+
+/**
+ * @brief Get the allocator of a memory tag.
+ * 
+ * @param tag Memory tag
+ * @return const nsAllocator *
+ */
+const nsAllocator *ns_get_allocator(nsMemoryTag tag);
+
+/**
+ * @brief Get allocation statistics of a memory tag.
+ * 
+ * @param tag Memory tag
+ * @return nsMemoryStats
+ */
+nsMemoryStats ns_get_memory_stats(nsMemoryTag tag);
+
+/**
+ * @brief Allocate memory with the allocator of a tag.
+ * 
+ * Use @ref NS_MALLOC instead of calling this directly.
+ * 
+ * @param size Size in bytes
+ * @param tag Memory tag
+ * @return void *
+ */
+void *ns_alloc(size_t size, nsMemoryTag tag);
+
+/**
+ * @brief Resize memory allocated with @ref ns_alloc.
+ * 
+ * The block keeps the tag it was allocated with.
+ * 
+ * @param ptr Memory or `NULL`
+ * @param size New size in bytes
+ * @param tag Memory tag used if ptr is `NULL`
+ * @return void *
+ */
+void *ns_realloc(void *ptr, size_t size, nsMemoryTag tag);
+
+/**
+ * @brief Free memory allocated with @ref ns_alloc.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param ptr Memory
+ */
+void ns_free(void *ptr);
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/arena.h
+ * @brief Linear arena allocator.
+ */
+#ifndef _NS_ARENA_H
+#define _NS_ARENA_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief Alignment of every arena allocation.
+ */
+#define NS_ARENA_ALIGNMENT 16
+
+/**
+ * @brief Default size of an arena block in bytes.
+ */
+#define NS_ARENA_DEFAULT_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * @brief Unused block bytes a scratch arena keeps for reuse after a load.
+ */
+#define NS_ARENA_SCRATCH_RETAIN (64 * 1024 * 1024)
+
+/**
+ * @brief Block of memory allocations are carved from.
+ */
+typedef struct nsArenaBlock {
+    struct nsArenaBlock *next; /**< Next block in the chain. */
+    size_t capacity; /**< Usable bytes of the block. */
+    size_t used; /**< Bytes handed out from the block. */
+} nsArenaBlock;
+
+/**
+ * @brief Bump allocator for short-lived memory.
+ * 
+ * Allocating is moving a pointer forward, individual allocations are never
+ * freed. Instead a @ref nsArenaMark is taken before a group of temporaries
+ * and the arena is rewound to it once they are done, or the whole arena is
+ * reset.
+ * 
+ * Memory is taken from the heap in blocks and the blocks are kept after
+ * rewinding, so an arena that is reused allocates nothing from the heap once
+ * it has grown to its working size.
+ * 
+ * An arena can only be used by one thread at a time. A zero initialized
+ * arena is valid and uses @ref NS_ARENA_DEFAULT_BLOCK_SIZE.
+ */
+typedef struct {
+    nsArenaBlock *first; /**< First block, `NULL` until the first allocation. */
+    nsArenaBlock *current; /**< Block allocations are made from. */
+    size_t block_size; /**< Minimum size of new blocks. */
+    size_t used; /**< Bytes currently allocated, including alignment padding. */
+    size_t peak; /**< Highest value of used. */
+    size_t reserved; /**< Bytes of all blocks. */
+} nsArena;
+
+/**
+ * @brief Position of an arena to rewind to.
+ */
+typedef struct {
+    nsArenaBlock *block; /**< Current block when the mark was taken. */
+    size_t offset; /**< Used bytes of the block. */
+    size_t used; /**< Used bytes of the arena. */
+} nsArenaMark;
+
+/**
+ * @brief Initialize arena.
+ * 
+ * No memory is allocated until the first allocation.
+ * 
+ * @param arena Arena
+ * @param block_size Minimum size of blocks, 0 to use @ref NS_ARENA_DEFAULT_BLOCK_SIZE
+ */
+void nsArena_init(nsArena *arena, size_t block_size);
+
+/**
+ * @brief Free all blocks of arena.
+ * 
+ * The arena can be used again afterwards.
+ * 
+ * @param arena Arena
+ */
+void nsArena_free(nsArena *arena);
+
+/**
+ * @brief Allocate memory from arena.
+ * 
+ * Allocations bigger than the block size get a block of their own.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param arena Arena
+ * @param size Size in bytes
+ * @return void *
+ */
+void *nsArena_alloc(nsArena *arena, size_t size);
+
+/**
+ * @brief Get the current position of arena.
+ * 
+ * @param arena Arena
+ * @return nsArenaMark
+ */
+nsArenaMark nsArena_mark(const nsArena *arena);
+
+/**
+ * @brief Release every allocation made after the mark was taken.
+ * 
+ * Marks have to be rewound in the reverse order they were taken.
+ * 
+ * @param arena Arena
+ * @param mark Mark taken from the same arena
+ */
+void nsArena_rewind(nsArena *arena, nsArenaMark mark);
+
+/**
+ * @brief Release every allocation but keep the blocks.
+ * 
+ * @param arena Arena
+ */
+void nsArena_reset(nsArena *arena);
+
+/**
+ * @brief Free unused blocks past the current one until at most the given bytes remain unused.
+ * 
+ * An empty current block bigger than the block size is freed too, marks
+ * taken at it are invalidated.
+ * 
+ * @param arena Arena
+ * @param retain Unused block bytes to keep
+ */
+void nsArena_trim(nsArena *arena, size_t retain);
+
+
+/**
+ * @brief Get the scratch arena of the calling thread.
+ * 
+ * Scratch arenas are for temporaries that are freed before the function
+ * returns. Take a mark before allocating and rewind to it on every return
+ * path, so callers' scratch memory stays intact.
+ * 
+ * @return nsArena *
+ */
+nsArena *ns_get_scratch_arena();
+
+/**
+ * @brief Free the scratch arena of the calling thread.
+ * 
+ * Threads that use the scratch arena call this before exiting.
+ */
+void ns_free_scratch_arena();
+
+/**
+ * @brief Get the arena of the current frame.
+ * 
+ * There are two frame arenas, @ref ns_swap_frame_arena switches between them
+ * and resets the new one. Memory from this arena lives until the end of the
+ * next frame, so results of one frame can be read in the next one.
+ * 
+ * Only use this from the main thread.
+ * 
+ * @return nsArena *
+ */
+nsArena *ns_get_frame_arena();
+
+/**
+ * @brief Start a new frame on the frame arenas.
+ * 
+ * Called by @ref nsApp_run at the beginning of every frame.
+ */
+void ns_swap_frame_arena();
+
+/**
+ * @brief Free both frame arenas.
+ */
+void ns_free_frame_arena();
+
+
+#endif
\ No newline at end of file
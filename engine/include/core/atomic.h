@@ -0,0 +1,259 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/atomic.h
+ * @brief Atomic integers with explicit memory ordering.
+ * 
+ * SDL atomics are 32-bit and always sequentially consistent, lock-free
+ * structures need 64-bit counters that don't wrap and cheaper orderings.
+ */
+#ifndef _NS_ATOMIC_H
+#define _NS_ATOMIC_H
+
+#include "engine/include/core/types.h"
+#include "engine/include/core/platform.h"
+
+#if NS_COMPILER == NS_COMPILER_MSVC
+    #include <intrin.h>
+#endif
+
+
+/*
+    Memory orders, same meanings as C11's memory_order_*.
+*/
+
+#if NS_COMPILER == NS_COMPILER_MSVC
+
+    #define NS_ATOMIC_RELAXED 0
+    #define NS_ATOMIC_ACQUIRE 2
+    #define NS_ATOMIC_RELEASE 3
+    #define NS_ATOMIC_ACQ_REL 4
+    #define NS_ATOMIC_SEQ_CST 5
+
+#else
+
+    #define NS_ATOMIC_RELAXED __ATOMIC_RELAXED
+    #define NS_ATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+    #define NS_ATOMIC_RELEASE __ATOMIC_RELEASE
+    #define NS_ATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+    #define NS_ATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+
+#endif
+
+/**
+ * @brief Assumed cache line size, for padding data written by different threads apart.
+ */
+#define NS_CACHE_LINE_SIZE 64
+
+/**
+ * @brief 32-bit atomic integer.
+ */
+typedef struct {
+    volatile ns_i32 value;
+} nsAtomicI32;
+
+/**
+ * @brief 64-bit atomic integer.
+ */
+typedef struct {
+    volatile ns_i64 value;
+} nsAtomicI64;
+
+/**
+ * @brief Atomic pointer.
+ */
+typedef struct {
+    void *volatile value;
+} nsAtomicPtr;
+
+
+/*
+    Operations
+
+    ns_atomic_load_i32/i64 -> Load value.
+    ns_atomic_store_i32/i64 -> Store value.
+    ns_atomic_add_i32/i64 -> Add to value, return the previous value.
+    ns_atomic_cas_i32/i64 -> Set value to desired if it equals expected, return whether it was set.
+    ns_atomic_load_ptr / ns_atomic_store_ptr / ns_atomic_cas_ptr -> Same for pointers.
+    ns_atomic_exchange_ptr -> Set pointer, return the previous one.
+    ns_atomic_fence -> Memory fence.
+    ns_cpu_relax -> Hint the CPU that this is a spin-wait loop.
+*/
+
+#if NS_COMPILER == NS_COMPILER_MSVC
+
+/*
+    x86 loads are acquires and stores are releases already, the compiler
+    barriers keep MSVC from reordering around them. Read-modify-writes are
+    always sequentially consistent.
+*/
+
+static inline ns_i32 ns_atomic_load_i32(const nsAtomicI32 *atomic, int order) {
+    ns_i32 value = atomic->value;
+    (void)order;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void ns_atomic_store_i32(nsAtomicI32 *atomic, ns_i32 value, int order) {
+    if (order == NS_ATOMIC_SEQ_CST) {
+        _InterlockedExchange((volatile long *)&atomic->value, value);
+        return;
+    }
+    _ReadWriteBarrier();
+    atomic->value = value;
+}
+
+static inline ns_i32 ns_atomic_add_i32(nsAtomicI32 *atomic, ns_i32 value, int order) {
+    (void)order;
+    return _InterlockedExchangeAdd((volatile long *)&atomic->value, value);
+}
+
+static inline ns_bool ns_atomic_cas_i32(nsAtomicI32 *atomic, ns_i32 expected, ns_i32 desired, int order) {
+    (void)order;
+    return _InterlockedCompareExchange((volatile long *)&atomic->value, desired, expected) == expected;
+}
+
+static inline ns_i64 ns_atomic_load_i64(const nsAtomicI64 *atomic, int order) {
+    ns_i64 value = atomic->value;
+    (void)order;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void ns_atomic_store_i64(nsAtomicI64 *atomic, ns_i64 value, int order) {
+    if (order == NS_ATOMIC_SEQ_CST) {
+        _InterlockedExchange64(&atomic->value, value);
+        return;
+    }
+    _ReadWriteBarrier();
+    atomic->value = value;
+}
+
+static inline ns_i64 ns_atomic_add_i64(nsAtomicI64 *atomic, ns_i64 value, int order) {
+    (void)order;
+    return _InterlockedExchangeAdd64(&atomic->value, value);
+}
+
+static inline ns_bool ns_atomic_cas_i64(nsAtomicI64 *atomic, ns_i64 expected, ns_i64 desired, int order) {
+    (void)order;
+    return _InterlockedCompareExchange64(&atomic->value, desired, expected) == expected;
+}
+
+static inline void *ns_atomic_load_ptr(const nsAtomicPtr *atomic, int order) {
+    void *value = atomic->value;
+    (void)order;
+    _ReadWriteBarrier();
+    return value;
+}
+
+static inline void ns_atomic_store_ptr(nsAtomicPtr *atomic, void *value, int order) {
+    if (order == NS_ATOMIC_SEQ_CST) {
+        _InterlockedExchangePointer(&atomic->value, value);
+        return;
+    }
+    _ReadWriteBarrier();
+    atomic->value = value;
+}
+
+static inline void *ns_atomic_exchange_ptr(nsAtomicPtr *atomic, void *value, int order) {
+    (void)order;
+    return _InterlockedExchangePointer(&atomic->value, value);
+}
+
+static inline ns_bool ns_atomic_cas_ptr(nsAtomicPtr *atomic, void *expected, void *desired, int order) {
+    (void)order;
+    return _InterlockedCompareExchangePointer(&atomic->value, desired, expected) == expected;
+}
+
+static inline void ns_atomic_fence(int order) {
+    if (order == NS_ATOMIC_SEQ_CST) {
+        // Any locked instruction is a full barrier
+        volatile long dummy = 0;
+        _InterlockedOr(&dummy, 0);
+    }
+    _ReadWriteBarrier();
+}
+
+static inline void ns_cpu_relax() {
+    _mm_pause();
+}
+
+#else
+
+static inline ns_i32 ns_atomic_load_i32(const nsAtomicI32 *atomic, int order) {
+    return __atomic_load_n(&atomic->value, order);
+}
+
+static inline void ns_atomic_store_i32(nsAtomicI32 *atomic, ns_i32 value, int order) {
+    __atomic_store_n(&atomic->value, value, order);
+}
+
+static inline ns_i32 ns_atomic_add_i32(nsAtomicI32 *atomic, ns_i32 value, int order) {
+    return __atomic_fetch_add(&atomic->value, value, order);
+}
+
+static inline ns_bool ns_atomic_cas_i32(nsAtomicI32 *atomic, ns_i32 expected, ns_i32 desired, int order) {
+    return __atomic_compare_exchange_n(&atomic->value, &expected, desired, false, order, NS_ATOMIC_RELAXED);
+}
+
+static inline ns_i64 ns_atomic_load_i64(const nsAtomicI64 *atomic, int order) {
+    return __atomic_load_n(&atomic->value, order);
+}
+
+static inline void ns_atomic_store_i64(nsAtomicI64 *atomic, ns_i64 value, int order) {
+    __atomic_store_n(&atomic->value, value, order);
+}
+
+static inline ns_i64 ns_atomic_add_i64(nsAtomicI64 *atomic, ns_i64 value, int order) {
+    return __atomic_fetch_add(&atomic->value, value, order);
+}
+
+static inline ns_bool ns_atomic_cas_i64(nsAtomicI64 *atomic, ns_i64 expected, ns_i64 desired, int order) {
+    return __atomic_compare_exchange_n(&atomic->value, &expected, desired, false, order, NS_ATOMIC_RELAXED);
+}
+
+static inline void *ns_atomic_load_ptr(const nsAtomicPtr *atomic, int order) {
+    return __atomic_load_n(&atomic->value, order);
+}
+
+static inline void ns_atomic_store_ptr(nsAtomicPtr *atomic, void *value, int order) {
+    __atomic_store_n(&atomic->value, value, order);
+}
+
+static inline void *ns_atomic_exchange_ptr(nsAtomicPtr *atomic, void *value, int order) {
+    return __atomic_exchange_n(&atomic->value, value, order);
+}
+
+static inline ns_bool ns_atomic_cas_ptr(nsAtomicPtr *atomic, void *expected, void *desired, int order) {
+    return __atomic_compare_exchange_n(&atomic->value, &expected, desired, false, order, NS_ATOMIC_RELAXED);
+}
+
+static inline void ns_atomic_fence(int order) {
+    __atomic_thread_fence(order);
+}
+
+static inline void ns_cpu_relax() {
+    #if NS_ARCH == NS_ARCH_X86_64 || NS_ARCH == NS_ARCH_X86
+
+    __builtin_ia32_pause();
+
+    #elif NS_ARCH == NS_ARCH_ARM
+
+    __asm__ __volatile__("yield");
+
+    #endif
+}
+
+#endif
+
+
+#endif
\ No newline at end of file
@@ -16,6 +16,7 @@
 #define _NS_ERROR_H
 
 #include <stdio.h>
+#include "engine/include/core/platform.h"
 
 
 /**
@@ -83,11 +84,14 @@ typedef struct {
 } nsError;
 
 /**
- * @brief Global error state. 
+ * @brief Global error state, one per thread.
+ * 
+ * Worker threads can fail at the same time without overwriting each other's
+ * errors, a thread only sees the errors it threw itself.
  * 
  * TODO: Error stack
  */
-extern nsError _ns_global_error;
+extern NS_THREAD_LOCAL nsError _ns_global_error;
 
 
 #define NS_LOGGER_MAX_OUT_STREAMS 8
@@ -122,8 +126,9 @@ extern nsLogger _ns_global_logger;
 #define ns_throw_error(message_, code_, severity_) {             \
     _ns_global_error.code = (nsErrorCode)code_;                  \
     _ns_global_error.severity = (nsErrorSeverity)severity_;      \
-    sprintf(                                                     \
+    snprintf(                                                    \
         _ns_global_error.message,                                \
+        NS_ERROR_BUFFER_SIZE,                                    \
         "Error in %s, line %d: %s",                              \
         __FILE__, __LINE__, message_                             \
     );                                                           \
@@ -131,7 +136,7 @@ extern nsLogger _ns_global_logger;
 }
 
 /**
- * @brief Get the last occured error.
+ * @brief Get the last error that occured on the calling thread.
  * 
  * @return nsError
  */
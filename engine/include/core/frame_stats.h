@@ -0,0 +1,96 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/frame_stats.h
+ * @brief Rolling frame time statistics.
+ */
+#ifndef _NS_FRAME_STATS_H
+#define _NS_FRAME_STATS_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/core/profiler.h"
+
+
+/**
+ * @brief Number of most recent frames statistics are computed over.
+ */
+#define NS_FRAME_STATS_WINDOW 600
+
+/**
+ * @brief Frames taking longer than this many times the median are counted as hitches.
+ */
+#define NS_FRAME_STATS_HITCH_FACTOR 2.0
+
+/**
+ * @brief Timings of the most recent frames.
+ */
+typedef struct {
+    nsProfiler samples[NS_FRAME_STATS_WINDOW]; /**< Ring of frame timings. */
+    size_t count; /**< Number of recorded frames in the window. */
+    ns_u64 total_frames; /**< Number of frames recorded since reset. */
+    size_t _next;
+} nsFrameStats;
+
+/**
+ * @brief Statistics of the frames in the window, in seconds.
+ * 
+ * Averages hide stutter, a steady 60 FPS with a 100 ms frame every few
+ * seconds has about the same average as a flawless one. Percentiles and
+ * hitches show the frames players actually notice.
+ */
+typedef struct {
+    size_t frames; /**< Number of frames summarized. */
+    nsProfiler average; /**< Average timing of every part, GPU time is averaged over @ref gpu_frames. */
+    size_t gpu_frames; /**< Number of frames with a measured GPU time. */
+    double p50; /**< Median frame time. */
+    double p95; /**< 95th percentile frame time. */
+    double p99; /**< 99th percentile frame time. */
+    double max; /**< Longest frame time. */
+    size_t hitches; /**< Frames longer than @ref NS_FRAME_STATS_HITCH_FACTOR times the median. */
+} nsFrameStatsSummary;
+
+/**
+ * @brief Clear recorded frames.
+ * 
+ * @param stats Frame statistics
+ */
+void nsFrameStats_reset(nsFrameStats *stats);
+
+/**
+ * @brief Record frame, overwriting the oldest one if the window is full.
+ * 
+ * @param stats Frame statistics
+ * @param sample Frame timings
+ */
+void nsFrameStats_push(nsFrameStats *stats, const nsProfiler *sample);
+
+/**
+ * @brief Get frame timings by age.
+ * 
+ * @param stats Frame statistics
+ * @param index 0 for the oldest frame in the window, count - 1 for the newest
+ * @return const nsProfiler *
+ */
+const nsProfiler *nsFrameStats_get(const nsFrameStats *stats, size_t index);
+
+/**
+ * @brief Compute statistics of the frames in the window.
+ * 
+ * Sorts a copy of the frame times, so it's meant to be called once per
+ * frame at most.
+ * 
+ * @param stats Frame statistics
+ * @return nsFrameStatsSummary
+ */
+nsFrameStatsSummary nsFrameStats_summarize(const nsFrameStats *stats);
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/hashmap.h
+ * @brief Open addressing hash map.
+ */
+#ifndef _NS_HASHMAP_H
+#define _NS_HASHMAP_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief Number of slots probed at once.
+ */
+#define NS_HASHMAP_GROUP_WIDTH 16
+
+/**
+ * @brief Key hashing function.
+ */
+typedef ns_u64 (*nsHashMap_hash_callback)(const void *key);
+
+/**
+ * @brief Key equality function.
+ */
+typedef ns_bool (*nsHashMap_equal_callback)(const void *a, const void *b);
+
+/**
+ * @brief Hash map with fixed-size keys and values.
+ * 
+ * Slots are split into groups of @ref NS_HASHMAP_GROUP_WIDTH. Every slot has a
+ * control byte that is either empty, deleted or the low 7 bits of the key's
+ * hash. A lookup compares the control bytes of a whole group to the hash at
+ * once (with SSE2 when available) and only compares keys whose bits match,
+ * so a miss rarely touches a key at all. Groups are probed triangularly
+ * until one with an empty slot is found.
+ * 
+ * Keys and values are copied into the map. Pointers to values are
+ * invalidated by adding.
+ */
+typedef struct {
+    size_t key_size; /**< Size of one key. */
+    size_t value_size; /**< Size of one value. */
+    nsHashMap_hash_callback hash; /**< Hash function, hashes the key bytes if `NULL`. */
+    nsHashMap_equal_callback equal; /**< Equality function, compares the key bytes if `NULL`. */
+    ns_u8 *ctrl; /**< Control byte of every slot. */
+    void *keys; /**< Key of every slot. */
+    void *values; /**< Value of every slot. */
+    size_t capacity; /**< Number of slots, zero or a power of two multiple of the group width. */
+    size_t size; /**< Number of entries. */
+    size_t growth_left; /**< Number of entries that can be added before rehashing. */
+} nsHashMap;
+
+/**
+ * @brief Create new hash map.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param key_size Size of one key
+ * @param value_size Size of one value
+ * @param hash Hash function or `NULL` to hash the key bytes
+ * @param equal Equality function or `NULL` to compare the key bytes
+ * @return nsHashMap *
+ */
+nsHashMap *nsHashMap_new(
+    size_t key_size,
+    size_t value_size,
+    nsHashMap_hash_callback hash,
+    nsHashMap_equal_callback equal
+);
+
+/**
+ * @brief Free hash map.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param hashmap Hash map to free
+ */
+void nsHashMap_free(nsHashMap *hashmap);
+
+/**
+ * @brief Make sure the hash map can hold at least the given number of entries without rehashing.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param hashmap Hash map
+ * @param count Minimum number of entries
+ * @return int Status
+ */
+int nsHashMap_reserve(nsHashMap *hashmap, size_t count);
+
+/**
+ * @brief Add entry or replace the value of an existing key.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param hashmap Hash map
+ * @param key Key to copy
+ * @param value Value to copy
+ * @return int Status
+ */
+int nsHashMap_set(nsHashMap *hashmap, const void *key, const void *value);
+
+/**
+ * @brief Get the reference to the value of key.
+ * 
+ * @param hashmap Hash map
+ * @param key Key
+ * @return void * Value or `NULL` if the key is not in the map
+ */
+void *nsHashMap_get(const nsHashMap *hashmap, const void *key);
+
+/**
+ * @brief Check if key is in the hash map.
+ * 
+ * @param hashmap Hash map
+ * @param key Key
+ * @return ns_bool
+ */
+ns_bool nsHashMap_contains(const nsHashMap *hashmap, const void *key);
+
+/**
+ * @brief Remove entry of key.
+ * 
+ * Returns non-zero if the key is not in the map.
+ * 
+ * @param hashmap Hash map
+ * @param key Key
+ * @return int Status
+ */
+int nsHashMap_remove(nsHashMap *hashmap, const void *key);
+
+/**
+ * @brief Remove all entries, keeping the capacity.
+ * 
+ * @param hashmap Hash map
+ */
+void nsHashMap_clear(nsHashMap *hashmap);
+
+/**
+ * @brief Iterate over the entries.
+ * 
+ * Start with the iterator at 0. Order is unspecified and adding entries
+ * during iteration invalidates the iterator, removing the current entry
+ * doesn't.
+ * 
+ * @param hashmap Hash map
+ * @param iter Iterator
+ * @param key Set to the reference of the key, can be `NULL`
+ * @param value Set to the reference of the value, can be `NULL`
+ * @return ns_bool `true` if an entry was found, `false` at the end
+ */
+ns_bool nsHashMap_iter(const nsHashMap *hashmap, size_t *iter, void **key, void **value);
+
+/**
+ * @brief Get the number of entries.
+ * 
+ * @param hashmap Hash map
+ * @return size_t
+ */
+static inline size_t nsHashMap_size(const nsHashMap *hashmap) {
+    return hashmap->size;
+}
+
+
+/**
+ * @brief Hash bytes.
+ * 
+ * @param data Data
+ * @param size Size of the data in bytes
+ * @return ns_u64
+ */
+ns_u64 ns_hash_bytes(const void *data, size_t size);
+
+/**
+ * @brief Hash 64-bit integer.
+ * 
+ * @param value Integer
+ * @return ns_u64
+ */
+static inline ns_u64 ns_hash_u64(ns_u64 value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+/**
+ * @brief Hash callback for maps keyed by null-terminated strings.
+ * 
+ * Keys are `const char *`, the map stores the pointers and not the strings.
+ * 
+ * @param key Reference to the string pointer
+ * @return ns_u64
+ */
+ns_u64 ns_hash_string_key(const void *key);
+
+/**
+ * @brief Equality callback for maps keyed by null-terminated strings.
+ * 
+ * @param a Reference to the first string pointer
+ * @param b Reference to the second string pointer
+ * @return ns_bool
+ */
+ns_bool ns_equal_string_key(const void *a, const void *b);
+
+
+#endif
\ No newline at end of file
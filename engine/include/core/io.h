@@ -16,6 +16,8 @@
 #define _NS_IO_H
 
 #include <stdio.h>
+#include "engine/include/core/types.h"
+#include "engine/include/core/arena.h"
 
 
 /**
@@ -30,5 +32,68 @@
  */
 char *ns_read_file_raw(const char *filepath);
 
+/**
+ * @brief Read file in binary mode into arena memory.
+ * 
+ * The content is released when the arena is rewound or reset, nothing is
+ * left in the arena on error.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param arena Arena to allocate from
+ * @param filepath Filepath
+ * @return char *
+ */
+char *ns_read_file_arena(nsArena *arena, const char *filepath);
+
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+typedef struct {
+    void *data; /**< Mapped file content. */
+    size_t size; /**< Size of the mapping in bytes. */
+    void *_file_handle;
+    void *_map_handle;
+} nsMappedFile;
+
+/**
+ * @brief Map file into memory for reading.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param mapped Mapping to initialize
+ * @param filepath Filepath
+ * @return int Status
+ */
+int ns_map_file(nsMappedFile *mapped, const char *filepath);
+
+/**
+ * @brief Release file mapping.
+ * 
+ * @param mapped Mapping
+ */
+void ns_unmap_file(nsMappedFile *mapped);
+
+
+/**
+ * @brief Basic file metadata.
+ */
+typedef struct {
+    ns_u64 size; /**< Size of the file in bytes. */
+    ns_i64 modified_time; /**< Last modification time as UNIX timestamp. */
+} nsFileInfo;
+
+/**
+ * @brief Query file metadata.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param filepath Filepath
+ * @param info Metadata output
+ * @return int Status
+ */
+int ns_get_file_info(const char *filepath, nsFileInfo *info);
+
 
 #endif
\ No newline at end of file
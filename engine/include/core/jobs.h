@@ -0,0 +1,210 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/jobs.h
+ * @brief Work-stealing job system.
+ */
+#ifndef _NS_JOBS_H
+#define _NS_JOBS_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/core/atomic.h"
+#include "engine/include/core/pool.h"
+
+
+/**
+ * @brief Maximum number of worker threads.
+ */
+#define NS_JOBS_MAX_WORKERS 64
+
+/**
+ * @brief Number of jobs a thread's queue can hold, jobs pushed to a full queue run immediately.
+ */
+#define NS_JOBS_QUEUE_CAPACITY 4096
+
+/**
+ * @brief Job function.
+ */
+typedef void (*nsJobFunc)(void *data);
+
+/**
+ * @brief Function called for a range of indices by @ref nsJobSystem_parallel_for.
+ */
+typedef void (*nsParallelForFunc)(size_t start, size_t end, void *data);
+
+/**
+ * @brief Function called for every element by @ref nsJobSystem_parallel_for_pool.
+ */
+typedef void (*nsParallelForEachFunc)(void *elem, size_t index, void *data);
+
+/**
+ * @brief Number of unfinished jobs in a group.
+ * 
+ * Pass the same counter to every job of a group and wait on it with
+ * @ref nsJobSystem_wait. Zero-initialized counters are ready to use.
+ */
+typedef struct {
+    nsAtomicI32 pending; /**< Jobs submitted and not finished yet. */
+} nsJobCounter;
+
+/**
+ * @brief Unit of work.
+ */
+typedef struct {
+    nsJobFunc func; /**< Function to run. */
+    void *data; /**< Passed to the function. */
+    nsJobCounter *counter; /**< Decremented when the job finishes, can be `NULL`. */
+} nsJob;
+
+typedef struct nsJobQueue nsJobQueue;
+
+/**
+ * @brief Pool of worker threads that run jobs.
+ * 
+ * Every worker and the thread that created the system own a queue. Jobs
+ * submitted from these threads go to their own queue, which the owner pops
+ * from the newest end while idle threads steal from the oldest end (a
+ * Chase-Lev deque), so related work tends to stay on one core and load
+ * balances itself without a central lock. Jobs submitted from other threads
+ * go through a shared locked queue.
+ * 
+ * Waiting on a counter runs other jobs in the meantime, so jobs can wait on
+ * jobs they submitted. Workers sleep when there is no work.
+ */
+typedef struct {
+    SDL_Thread *workers[NS_JOBS_MAX_WORKERS]; /**< Worker threads. */
+    ns_u32 worker_count; /**< Number of worker threads. */
+
+    nsJobQueue *_queues;
+    ns_u32 _queue_count;
+    nsJob *_injected;
+    size_t _injected_head;
+    size_t _injected_capacity;
+    nsAtomicI32 _injected_count;
+    SDL_SpinLock _injected_lock;
+    SDL_sem *_wake;
+    nsAtomicI32 _sleeping;
+    nsAtomicI32 _searching;
+    nsAtomicI32 _quit;
+} nsJobSystem;
+
+/**
+ * @brief Create new job system.
+ * 
+ * The calling thread can submit jobs and wait without locking, it usually is
+ * the main thread.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param worker_count Number of worker threads, 0 for one less than the CPU count
+ * @return nsJobSystem *
+ */
+nsJobSystem *nsJobSystem_new(ns_u32 worker_count);
+
+/**
+ * @brief Free job system.
+ * 
+ * Queued jobs are finished before the workers exit.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param jobs Job system to free
+ */
+void nsJobSystem_free(nsJobSystem *jobs);
+
+/**
+ * @brief Submit job.
+ * 
+ * @param jobs Job system
+ * @param func Job function
+ * @param data Passed to the function
+ * @param counter Counter to add the job to, can be `NULL`
+ */
+void nsJobSystem_run(nsJobSystem *jobs, nsJobFunc func, void *data, nsJobCounter *counter);
+
+/**
+ * @brief Submit multiple jobs.
+ * 
+ * Counters of the jobs are incremented for you.
+ * 
+ * @param jobs Job system
+ * @param batch Jobs
+ * @param count Number of jobs
+ */
+void nsJobSystem_run_batch(nsJobSystem *jobs, const nsJob *batch, size_t count);
+
+/**
+ * @brief Run one queued job on the calling thread.
+ * 
+ * Lets threads that aren't workers help out while they have nothing else to do.
+ * 
+ * @param jobs Job system
+ * @return ns_bool `true` if a job was run
+ */
+ns_bool nsJobSystem_execute(nsJobSystem *jobs);
+
+/**
+ * @brief Wait until all jobs of counter are finished, running queued jobs meanwhile.
+ * 
+ * @param jobs Job system
+ * @param counter Counter
+ */
+void nsJobSystem_wait(nsJobSystem *jobs, nsJobCounter *counter);
+
+/**
+ * @brief Call function over an index range in parallel and wait for it.
+ * 
+ * The range is split into batches that threads claim one at a time, the
+ * calling thread works on them too.
+ * 
+ * @param jobs Job system
+ * @param count Number of indices
+ * @param batch_size Indices per call, 0 to pick one from the worker count
+ * @param func Function called with every batch
+ * @param data Passed to the function
+ */
+void nsJobSystem_parallel_for(
+    nsJobSystem *jobs,
+    size_t count,
+    size_t batch_size,
+    nsParallelForFunc func,
+    void *data
+);
+
+/**
+ * @brief Call function for every element of pool in parallel and wait for it.
+ * 
+ * @param jobs Job system
+ * @param pool Pool
+ * @param batch_size Elements per job, 0 to pick one from the worker count
+ * @param func Function called with every element
+ * @param data Passed to the function
+ */
+void nsJobSystem_parallel_for_pool(
+    nsJobSystem *jobs,
+    nsPool *pool,
+    size_t batch_size,
+    nsParallelForEachFunc func,
+    void *data
+);
+
+/**
+ * @brief Check if all jobs of counter are finished.
+ * 
+ * @param counter Counter
+ * @return ns_bool
+ */
+static inline ns_bool nsJobCounter_is_done(const nsJobCounter *counter) {
+    return ns_atomic_load_i32(&counter->pending, NS_ATOMIC_ACQUIRE) == 0;
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/number.h
+ * @brief Fast locale-independent number parsing.
+ * 
+ * Replacement for `strtof` and `strtol` in text asset loaders.
+ * Floats are correctly rounded (round-to-nearest-even) like `strtof`,
+ * but the decimal separator is always '.' regardless of the C locale.
+ */
+#ifndef _NS_NUMBER_H
+#define _NS_NUMBER_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief Parse decimal floating point number.
+ * 
+ * Accepts `[+-]digits[.digits][(e|E)[+-]digits]` as well as `inf`, `infinity`
+ * and `nan`. Leading whitespace is not skipped.
+ * 
+ * Returns the pointer past the last parsed character, or `str` if there is no
+ * number at the start of the string, in which case value is set to 0.
+ * 
+ * @param str Start of the number
+ * @param end End of the readable input, parsing never reads at or past it
+ * @param value Parsed value output
+ * @return const char *
+ */
+const char *ns_parse_float(const char *str, const char *end, float *value);
+
+/**
+ * @brief Parse decimal integer.
+ * 
+ * Accepts `[+-]digits`. Leading whitespace is not skipped.
+ * Values out of range are clamped like `strtol` does.
+ * 
+ * Returns the pointer past the last parsed character, or `str` if there is no
+ * number at the start of the string, in which case value is set to 0.
+ * 
+ * @param str Start of the number
+ * @param end End of the readable input, parsing never reads at or past it
+ * @param value Parsed value output
+ * @return const char *
+ */
+const char *ns_parse_long(const char *str, const char *end, long *value);
+
+
+#endif
\ No newline at end of file
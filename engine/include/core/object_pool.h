@@ -0,0 +1,130 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/object_pool.h
+ * @brief Fixed-size object allocator.
+ */
+#ifndef _NS_OBJECT_POOL_H
+#define _NS_OBJECT_POOL_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief Size of an object slot, big enough for a free list link and 16-byte aligned.
+ */
+#define NS_OBJECT_POOL_SLOT_SIZE(size) \
+    ((((size) > sizeof(void *) ? (size) : sizeof(void *)) + 15) & ~(size_t)15)
+
+/**
+ * @brief Static initializer of @ref nsObjectPool.
+ * 
+ * @param type Object type
+ * @param slab_capacity Objects per slab
+ * @param tag Memory tag of the slabs
+ */
+#define NS_OBJECT_POOL_INIT(type, slab_capacity, tag) \
+    {NS_OBJECT_POOL_SLOT_SIZE(sizeof(type)), (slab_capacity), (tag), NULL, NULL, 0, 0, 0, NULL, false}
+
+/**
+ * @brief Contiguous block of object slots.
+ */
+typedef struct nsObjectPoolSlab {
+    struct nsObjectPoolSlab *next; /**< Next slab. */
+} nsObjectPoolSlab;
+
+/**
+ * @brief Allocator for objects of one type.
+ * 
+ * Objects are carved from slabs of @ref slab_capacity slots and freed slots
+ * go on a free list to be reused first. Objects of a type end up next to
+ * each other instead of scattered across the heap, and freeing never
+ * returns memory to the heap, so long sessions don't fragment it.
+ * 
+ * A new slab is threaded onto the free list in address order, so objects
+ * created in a row are adjacent in memory.
+ * 
+ * Pools are safe to use from multiple threads.
+ * 
+ * Pools register themselves globally once they allocate a slab, so static
+ * pools of every module can be freed at once with @ref ns_free_object_pools.
+ */
+typedef struct nsObjectPool {
+    size_t slot_size; /**< Size of one slot. */
+    size_t slab_capacity; /**< Number of slots in a slab. */
+    nsMemoryTag tag; /**< Memory tag slabs are allocated with. */
+    void *free_list; /**< First free slot, the first bytes of a free slot point to the next one. */
+    nsObjectPoolSlab *slabs; /**< All slabs, newest first. */
+    size_t live; /**< Number of allocated objects. */
+    size_t capacity; /**< Number of slots in all slabs. */
+    SDL_SpinLock lock; /**< Guards the free list and the slabs. */
+    struct nsObjectPool *_next_registered;
+    ns_bool _registered;
+} nsObjectPool;
+
+/**
+ * @brief Initialize object pool.
+ * 
+ * Pools can also be initialized statically with @ref NS_OBJECT_POOL_INIT.
+ * No memory is allocated until the first object.
+ * 
+ * @param pool Object pool
+ * @param object_size Size of one object
+ * @param slab_capacity Objects per slab
+ * @param tag Memory tag of the slabs
+ */
+void nsObjectPool_init(
+    nsObjectPool *pool,
+    size_t object_size,
+    size_t slab_capacity,
+    nsMemoryTag tag
+);
+
+/**
+ * @brief Free all slabs of object pool.
+ * 
+ * Every object of the pool is invalidated.
+ * 
+ * @param pool Object pool
+ */
+void nsObjectPool_free(nsObjectPool *pool);
+
+/**
+ * @brief Allocate an object.
+ * 
+ * The object is not initialized. Returns `NULL` if a new slab can't be
+ * allocated, like @ref NS_MALLOC this doesn't throw an error.
+ * 
+ * @param pool Object pool
+ * @return void *
+ */
+void *nsObjectPool_alloc(nsObjectPool *pool);
+
+/**
+ * @brief Return an object to its pool.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param pool Object pool the object was allocated from
+ * @param object Object
+ */
+void nsObjectPool_release(nsObjectPool *pool, void *object);
+
+/**
+ * @brief Free slabs of every pool that has allocated any.
+ * 
+ * Meant for shutdown, objects of every pool are invalidated. Pools stay
+ * usable and allocate new slabs if needed.
+ */
+void ns_free_object_pools();
+
+
+#endif
\ No newline at end of file
@@ -163,6 +163,46 @@
 #endif
 
 
+/*
+    SIMD support
+
+    NS_SIMD_SSE2 -> 1 if SSE2 intrinsics are available, 0 otherwise.
+*/
+
+#if defined(__SSE2__) || \
+    defined(_M_X64)   || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+    #define NS_SIMD_SSE2 1
+
+#else
+
+    #define NS_SIMD_SSE2 0
+
+#endif
+
+
+/*
+    Thread-local storage
+
+    NS_THREAD_LOCAL -> Storage class of variables that have a copy per thread.
+*/
+
+#if NS_COMPILER == NS_COMPILER_MSVC
+
+    #define NS_THREAD_LOCAL __declspec(thread)
+
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+
+    #define NS_THREAD_LOCAL _Thread_local
+
+#else
+
+    #define NS_THREAD_LOCAL __thread
+
+#endif
+
+
 /**
  * @brief Get the compiler identification as string.
  * 
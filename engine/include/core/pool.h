@@ -48,6 +48,36 @@ void nsPool_free(nsPool *pool);
 
 int nsPool_add(nsPool *pool, const void *elem);
 
+/**
+ * @brief Pool reallocations done by one thread.
+ */
+typedef struct {
+    size_t count; /**< Number of reallocations. */
+    size_t bytes; /**< Size of the blocks before reallocating, the most realloc had to copy. */
+    double time; /**< Seconds spent reallocating. */
+} nsPoolReallocStats;
+
+/**
+ * @brief Get the reallocations all pools did on the calling thread so far.
+ * 
+ * Take the difference of two calls to measure a piece of work.
+ * 
+ * @return nsPoolReallocStats
+ */
+nsPoolReallocStats ns_get_pool_realloc_stats();
+
+/**
+ * @brief Make sure the pool can hold at least the given number of elements
+ *        without reallocating.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param pool Pool
+ * @param capacity Minimum capacity in elements
+ * @return int Status
+ */
+int nsPool_reserve(nsPool *pool, size_t capacity);
+
 /**
  * @brief Get the reference to an element at index.
  * 
@@ -61,8 +91,24 @@ int nsPool_add(nsPool *pool, const void *elem);
  */
 void *nsPool_get(nsPool *pool, size_t index);
 
+/**
+ * @brief Remove element at index by moving the last element into its place.
+ * 
+ * This is O(1) but doesn't preserve the order of elements.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param pool Pool
+ * @param index Index of the element to remove
+ * @return int Status
+ */
 int nsPool_remove(nsPool *pool, size_t index);
 
+/**
+ * @brief Remove all elements, keeping the allocated memory.
+ * 
+ * @param pool Pool
+ */
 void nsPool_clear(nsPool *pool);
 
 /**
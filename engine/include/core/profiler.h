@@ -16,86 +16,186 @@
  * @brief Built-in performance profiler.
  */
 #include "engine/include/_internal.h"
+#include "engine/include/core/timer.h"
 
 
 /**
- * @brief Timings for parts of single space simulation step in seconds.
+ * @brief Timings for parts of single game frame in seconds.
  */
 typedef struct {
     double frame; /**< Time spent in one game frame. */
+    double input; /**< Time spent for polling events. */
     double render; /**< Time spent for rendering. */
+    double ui; /**< Time spent for rendering UI. */
+    double swap; /**< Time spent for swapping buffers, includes waiting for vsync. */
+    double gpu; /**< GPU time of the latest finished frame, a few frames behind. */
+    ns_bool gpu_valid; /**< If the GPU time was measured, the GPU profiler can be disabled. */
 } nsProfiler;
 
 
 static inline void nsProfiler_reset(nsProfiler *profiler) {
     profiler->frame = 0.0;
+    profiler->input = 0.0;
     profiler->render = 0.0;
+    profiler->ui = 0.0;
+    profiler->swap = 0.0;
+    profiler->gpu = 0.0;
+    profiler->gpu_valid = false;
 }
 
 
-#if NS_PLATFORM == NS_PLATFORM_WINDOWS
+/*
+    Zone profiler
 
-    #include <windows.h>
+    Zones are recorded as begin/end events into a lock-free ring buffer per
+    thread, which the main thread drains at every frame mark. Events are only
+    kept while a capture is running, captures are saved as Chrome trace event
+    JSON for chrome://tracing, Perfetto or Speedscope.
 
-    typedef struct {
-        double elapsed;
-        LARGE_INTEGER _start;
-        LARGE_INTEGER _end;
-    } nsPrecisionTimer;
+    The macros compile to nothing unless NS_PROFILER_ENABLE is defined, so
+    zones cost nothing in builds that don't profile.
 
-    static inline void nsPrecisionTimer_start(nsPrecisionTimer *timer) {
-        QueryPerformanceCounter(&timer->_start);
-    }
+    NS_PROFILE_ZONE_BEGIN(name) -> Begin zone, name has to outlive the capture, like a string literal.
+    NS_PROFILE_ZONE_END() -> End the innermost zone of the calling thread.
+    NS_PROFILE_FRAME() -> Mark the start of a new frame, only from the main thread.
+    NS_PROFILE_THREAD(name) -> Name the calling thread in traces.
+    NS_PROFILE_THREAD_EXIT() -> Give the ring buffer of the calling thread back before it exits.
+*/
+#ifdef NS_PROFILER_ENABLE
 
-    static inline double nsPrecisionTimer_stop(nsPrecisionTimer *timer ) {
-        QueryPerformanceCounter(&timer->_end);
+    #define NS_PROFILE_ZONE_BEGIN(name) ns_profiler_begin_zone(name)
+    #define NS_PROFILE_ZONE_END() ns_profiler_end_zone()
+    #define NS_PROFILE_FRAME() ns_profiler_frame()
+    #define NS_PROFILE_THREAD(name) ns_profiler_set_thread_name(name)
+    #define NS_PROFILE_THREAD_EXIT() ns_profiler_release_thread()
 
-        LARGE_INTEGER frequency;
-        QueryPerformanceFrequency(&frequency);
+#else
 
-        timer->elapsed = (double)(timer->_end.QuadPart - timer->_start.QuadPart) / (double)frequency.QuadPart;
-        return timer->elapsed;
-    }
+    #define NS_PROFILE_ZONE_BEGIN(name) ((void)0)
+    #define NS_PROFILE_ZONE_END() ((void)0)
+    #define NS_PROFILE_FRAME() ((void)0)
+    #define NS_PROFILE_THREAD(name) ((void)0)
+    #define NS_PROFILE_THREAD_EXIT() ((void)0)
 
-#else
+#endif
 
-    #include <time.h>
-    #include <unistd.h>
+/**
+ * @brief Events a thread can record between two frame marks.
+ */
+#define NS_PROFILER_RING_CAPACITY 16384
 
-    // TODO: On OSX, frequency can be milliseconds instead of nanoseconds
-    #define NS_PER_SECOND 1e9
+/**
+ * @brief Maximum number of threads that record zones at the same time.
+ */
+#define NS_PROFILER_MAX_THREADS 64
 
-    typedef struct {
-        double elapsed;
-        struct timespec _start;
-        struct timespec _end;
-        struct timespec _delta;
-    } nsPrecisionTimer;
+/**
+ * @brief Begin zone on the calling thread.
+ * 
+ * Zones nest and have to be ended on the same thread. Zones that don't fit
+ * into the ring buffer are dropped along with the zones inside them.
+ * 
+ * @param name Zone name, only the pointer is stored
+ */
+void ns_profiler_begin_zone(const char *name);
 
-    static inline void nsPrecisionTimer_start(nsPrecisionTimer *timer) {
-        clock_gettime(CLOCK_REALTIME, &timer->_start);
-    }
+/**
+ * @brief End the innermost zone of the calling thread.
+ */
+void ns_profiler_end_zone();
 
-    static inline double nsPrecisionTimer_stop(nsPrecisionTimer *timer) {
-        clock_gettime(CLOCK_REALTIME, &timer->_end);
+/**
+ * @brief Mark the start of a new frame and collect the events of all threads.
+ * 
+ * Call this from the main thread once per frame.
+ */
+void ns_profiler_frame();
 
-        timer->_delta.tv_nsec = timer->_end.tv_nsec - timer->_start.tv_nsec;
-        timer->_delta.tv_sec = timer->_end.tv_sec - timer->_start.tv_sec;
+/**
+ * @brief Begin zone on the GPU track at a time that already passed.
+ * 
+ * Used by the GPU profiler to put GPU timings next to the threads, only
+ * call from the main thread.
+ * 
+ * @param name Zone name, only the pointer is stored
+ * @param time Begin time in ticks of @ref ns_ticks
+ */
+void ns_profiler_begin_gpu_zone(const char *name, ns_u64 time);
 
-        if (timer->_delta.tv_sec > 0 && timer->_delta.tv_nsec < 0) {
-            timer->_delta.tv_nsec += NS_PER_SECOND;
-            timer->_delta.tv_sec--;
-        }
-        else if (timer->_delta.tv_sec < 0 && timer->_delta.tv_nsec > 0) {
-            timer->_delta.tv_nsec -= NS_PER_SECOND;
-            timer->_delta.tv_sec++;
-        }
+/**
+ * @brief End the innermost zone of the GPU track.
+ * 
+ * @param time End time in ticks of @ref ns_ticks
+ */
+void ns_profiler_end_gpu_zone(ns_u64 time);
 
-        timer->elapsed = (double)timer->_delta.tv_nsec / NS_PER_SECOND;
-        return timer->elapsed;
-    }
+/**
+ * @brief Name the calling thread in traces.
+ * 
+ * @param name Thread name, only the pointer is stored
+ */
+void ns_profiler_set_thread_name(const char *name);
 
-#endif
+/**
+ * @brief Let a new thread reuse the ring buffer of the calling thread.
+ * 
+ * Call before exiting threads that recorded zones.
+ */
+void ns_profiler_release_thread();
+
+/**
+ * @brief Start capturing events at the next frame mark.
+ * 
+ * A previous capture is discarded.
+ * 
+ * @param frame_count Number of frames to capture
+ */
+void ns_profiler_start_capture(ns_u32 frame_count);
+
+/**
+ * @brief Check if a capture is requested or running.
+ * 
+ * @return ns_bool
+ */
+ns_bool ns_profiler_is_capturing();
+
+/**
+ * @brief Save the finished capture as Chrome trace event JSON.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param filepath File to write
+ * @return int Status
+ */
+int ns_profiler_save_capture(const char *filepath);
+
+/**
+ * @brief Free ring buffers and captured events.
+ * 
+ * No thread can be recording zones when this is called.
+ */
+void ns_free_profiler();
+
+
+/**
+ * @brief Measures the time between start and stop in seconds.
+ * 
+ * Built on @ref ns_ticks, so it costs a few nanoseconds. Don't calibrate
+ * the timer between start and stop.
+ */
+typedef struct {
+    double elapsed; /**< Seconds between the last start and stop. */
+    ns_u64 _start;
+} nsPrecisionTimer;
+
+static inline void nsPrecisionTimer_start(nsPrecisionTimer *timer) {
+    timer->_start = ns_ticks();
+}
+
+static inline double nsPrecisionTimer_stop(nsPrecisionTimer *timer) {
+    timer->elapsed = ns_ticks_to_seconds(ns_ticks() - timer->_start);
+    return timer->elapsed;
+}
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,213 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/queue.h
+ * @brief Lock-free queues for passing data between threads.
+ */
+#ifndef _NS_QUEUE_H
+#define _NS_QUEUE_H
+
+#include <stddef.h>
+#include "engine/include/_internal.h"
+#include "engine/include/core/atomic.h"
+
+
+/**
+ * @brief Get the struct that contains a member from a pointer to the member.
+ */
+#define NS_CONTAINER_OF(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+
+/**
+ * @brief Bounded single-producer single-consumer ring queue.
+ * 
+ * One thread pushes and one other thread pops. Both only touch their own
+ * index and a cached copy of the other one, so the common case doesn't share
+ * any cache lines between them.
+ */
+typedef struct {
+    size_t elem_size; /**< Fixed element size. */
+    size_t capacity; /**< Maximum number of elements, a power of two. */
+    ns_u8 *data; /**< Ring of elements. */
+
+    char _pad0[NS_CACHE_LINE_SIZE];
+    nsAtomicI64 _head;
+    ns_i64 _tail_cache;
+    char _pad1[NS_CACHE_LINE_SIZE];
+    nsAtomicI64 _tail;
+    ns_i64 _head_cache;
+    char _pad2[NS_CACHE_LINE_SIZE];
+} nsSPSCQueue;
+
+/**
+ * @brief Create new SPSC queue.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param elem_size Fixed element size
+ * @param capacity Maximum number of elements, rounded up to a power of two
+ * @return nsSPSCQueue *
+ */
+nsSPSCQueue *nsSPSCQueue_new(size_t elem_size, size_t capacity);
+
+/**
+ * @brief Free SPSC queue.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param queue Queue to free
+ */
+void nsSPSCQueue_free(nsSPSCQueue *queue);
+
+/**
+ * @brief Copy element into the queue, only called from the producer thread.
+ * 
+ * @param queue Queue
+ * @param elem Element to copy
+ * @return ns_bool `false` if the queue is full
+ */
+ns_bool nsSPSCQueue_push(nsSPSCQueue *queue, const void *elem);
+
+/**
+ * @brief Copy the oldest element out of the queue, only called from the consumer thread.
+ * 
+ * @param queue Queue
+ * @param elem Element to copy into
+ * @return ns_bool `false` if the queue is empty
+ */
+ns_bool nsSPSCQueue_pop(nsSPSCQueue *queue, void *elem);
+
+/**
+ * @brief Get the number of elements in the queue.
+ * 
+ * Only a snapshot if the other thread is active.
+ * 
+ * @param queue Queue
+ * @return size_t
+ */
+size_t nsSPSCQueue_size(nsSPSCQueue *queue);
+
+
+/**
+ * @brief Bounded multi-producer multi-consumer queue.
+ * 
+ * Dmitry Vyukov's array queue. Every cell has a sequence number that tells
+ * whether it's ready to be written or read on the current lap, so producers
+ * and consumers only contend on their own position with a single CAS.
+ */
+typedef struct {
+    size_t elem_size; /**< Fixed element size. */
+    size_t capacity; /**< Maximum number of elements, a power of two. */
+    size_t _stride;
+    ns_u8 *_cells;
+
+    char _pad0[NS_CACHE_LINE_SIZE];
+    nsAtomicI64 _enqueue_pos;
+    char _pad1[NS_CACHE_LINE_SIZE];
+    nsAtomicI64 _dequeue_pos;
+    char _pad2[NS_CACHE_LINE_SIZE];
+} nsMPMCQueue;
+
+/**
+ * @brief Create new MPMC queue.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param elem_size Fixed element size
+ * @param capacity Maximum number of elements, rounded up to a power of two
+ * @return nsMPMCQueue *
+ */
+nsMPMCQueue *nsMPMCQueue_new(size_t elem_size, size_t capacity);
+
+/**
+ * @brief Free MPMC queue.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param queue Queue to free
+ */
+void nsMPMCQueue_free(nsMPMCQueue *queue);
+
+/**
+ * @brief Copy element into the queue.
+ * 
+ * @param queue Queue
+ * @param elem Element to copy
+ * @return ns_bool `false` if the queue is full
+ */
+ns_bool nsMPMCQueue_push(nsMPMCQueue *queue, const void *elem);
+
+/**
+ * @brief Copy the oldest element out of the queue.
+ * 
+ * @param queue Queue
+ * @param elem Element to copy into
+ * @return ns_bool `false` if the queue is empty
+ */
+ns_bool nsMPMCQueue_pop(nsMPMCQueue *queue, void *elem);
+
+
+/**
+ * @brief Link embedded in structs that go into an @ref nsIntrusiveStack.
+ */
+typedef struct nsStackNode {
+    struct nsStackNode *next; /**< Next node in the list. */
+} nsStackNode;
+
+/**
+ * @brief Unbounded multi-producer stack of intrusive nodes.
+ * 
+ * Any thread can push, and the consumer takes all nodes at once, which
+ * leaves no window for the ABA problem of single pops. Nodes are never
+ * allocated or copied, use @ref NS_CONTAINER_OF to get back to the owner.
+ * 
+ * Zero-initialized stacks are ready to use.
+ */
+typedef struct {
+    nsAtomicPtr _head;
+} nsIntrusiveStack;
+
+/**
+ * @brief Push node.
+ * 
+ * @param stack Stack
+ * @param node Node, not in any other list
+ */
+void nsIntrusiveStack_push(nsIntrusiveStack *stack, nsStackNode *node);
+
+/**
+ * @brief Take all nodes, newest first.
+ * 
+ * @param stack Stack
+ * @return nsStackNode * First node of the list or `NULL` if empty
+ */
+nsStackNode *nsIntrusiveStack_pop_all(nsIntrusiveStack *stack);
+
+/**
+ * @brief Check if stack is empty.
+ * 
+ * @param stack Stack
+ * @return ns_bool
+ */
+static inline ns_bool nsIntrusiveStack_is_empty(nsIntrusiveStack *stack) {
+    return ns_atomic_load_ptr(&stack->_head, NS_ATOMIC_RELAXED) == NULL;
+}
+
+/**
+ * @brief Reverse list of nodes, to turn popped nodes into push order.
+ * 
+ * @param list First node
+ * @return nsStackNode * New first node
+ */
+nsStackNode *nsStackNode_reverse(nsStackNode *list);
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/slotmap.h
+ * @brief Generational handle slot map.
+ */
+#ifndef _NS_SLOTMAP_H
+#define _NS_SLOTMAP_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/core/pool.h"
+
+
+/**
+ * @brief Stable reference to an element of @ref nsSlotMap.
+ * 
+ * Low @ref NS_HANDLE_INDEX_BITS bits are the slot index, high
+ * @ref NS_HANDLE_GENERATION_BITS bits are the generation of the slot when the
+ * element was added. Removing the element bumps the generation, so old
+ * handles to the slot are detected as stale.
+ */
+typedef ns_u32 nsHandle;
+
+#define NS_HANDLE_INDEX_BITS 20
+#define NS_HANDLE_GENERATION_BITS 12
+#define NS_HANDLE_INDEX_MASK ((1u << NS_HANDLE_INDEX_BITS) - 1)
+#define NS_HANDLE_GENERATION_MASK ((1u << NS_HANDLE_GENERATION_BITS) - 1)
+
+/**
+ * @brief Handle that never refers to an element.
+ */
+#define NS_HANDLE_NULL 0
+
+/**
+ * @brief Maximum number of slots a slot map can have.
+ */
+#define NS_SLOTMAP_MAX_SLOTS (NS_HANDLE_INDEX_MASK + 1)
+
+static inline nsHandle nsHandle_make(ns_u32 index, ns_u32 generation) {
+    return (generation << NS_HANDLE_INDEX_BITS) | index;
+}
+
+static inline ns_u32 nsHandle_index(nsHandle handle) {
+    return handle & NS_HANDLE_INDEX_MASK;
+}
+
+static inline ns_u32 nsHandle_generation(nsHandle handle) {
+    return handle >> NS_HANDLE_INDEX_BITS;
+}
+
+/**
+ * @brief Container with O(1) add, remove and lookup through handles.
+ * 
+ * Values are kept densely packed in one pool for cache-friendly iteration,
+ * removing swaps the last value into the gap. Slots map handles to the
+ * current position of their value and freed slots are reused LIFO.
+ * 
+ * Pointers to values are invalidated by adding and removing, handles are not.
+ * 
+ * A slot is retired when its generation would wrap around, so a stale handle
+ * can never point at a newer element.
+ */
+typedef struct {
+    nsPool *values; /**< Densely packed values, iterate over these. */
+    nsPool *value_slots; /**< Slot index of every value, parallel to values. */
+    nsPool *slots; /**< Dense index and generation of every slot. */
+    ns_u32 free_slot; /**< First slot of the free list, @ref NS_SLOTMAP_MAX_SLOTS if empty. */
+} nsSlotMap;
+
+/**
+ * @brief Create new slot map.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param elem_size Size of one value
+ * @return nsSlotMap *
+ */
+nsSlotMap *nsSlotMap_new(size_t elem_size);
+
+/**
+ * @brief Free slot map.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param slotmap Slot map to free
+ */
+void nsSlotMap_free(nsSlotMap *slotmap);
+
+/**
+ * @brief Make sure the slot map can hold at least the given number of values without reallocating.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param slotmap Slot map
+ * @param capacity Minimum capacity in values
+ * @return int Status
+ */
+int nsSlotMap_reserve(nsSlotMap *slotmap, size_t capacity);
+
+/**
+ * @brief Add value.
+ * 
+ * Returns @ref NS_HANDLE_NULL on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param slotmap Slot map
+ * @param elem Value to copy
+ * @return nsHandle
+ */
+nsHandle nsSlotMap_add(nsSlotMap *slotmap, const void *elem);
+
+/**
+ * @brief Get the reference to the value of handle.
+ * 
+ * @param slotmap Slot map
+ * @param handle Handle
+ * @return void * Value or `NULL` if the handle is stale
+ */
+void *nsSlotMap_get(nsSlotMap *slotmap, nsHandle handle);
+
+/**
+ * @brief Check if handle refers to a value.
+ * 
+ * @param slotmap Slot map
+ * @param handle Handle
+ * @return ns_bool
+ */
+ns_bool nsSlotMap_contains(nsSlotMap *slotmap, nsHandle handle);
+
+/**
+ * @brief Remove value of handle.
+ * 
+ * Returns non-zero if the handle is stale.
+ * 
+ * @param slotmap Slot map
+ * @param handle Handle
+ * @return int Status
+ */
+int nsSlotMap_remove(nsSlotMap *slotmap, nsHandle handle);
+
+/**
+ * @brief Remove all values, invalidating every handle.
+ * 
+ * @param slotmap Slot map
+ */
+void nsSlotMap_clear(nsSlotMap *slotmap);
+
+/**
+ * @brief Get the handle of value at dense index, for removing while iterating.
+ * 
+ * @param slotmap Slot map
+ * @param index Dense index
+ * @return nsHandle
+ */
+nsHandle nsSlotMap_handle_at(nsSlotMap *slotmap, size_t index);
+
+/**
+ * @brief Get the number of values.
+ * 
+ * @param slotmap Slot map
+ * @return size_t
+ */
+static inline size_t nsSlotMap_size(const nsSlotMap *slotmap) {
+    return slotmap->values->size;
+}
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/string_id.h
+ * @brief Interned string IDs.
+ */
+#ifndef _NS_STRING_ID_H
+#define _NS_STRING_ID_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief ID of an interned string.
+ * 
+ * Every distinct string is interned once into a global table and gets an ID,
+ * so names can be compared and hashed as integers. IDs are valid until
+ * @ref ns_free_string_ids and aren't stable across runs.
+ */
+typedef ns_u32 nsStringId;
+
+/**
+ * @brief ID that never refers to a string.
+ */
+#define NS_STRING_ID_NONE 0
+
+/**
+ * @brief Get the ID of string, interning it if it's new.
+ * 
+ * The string is copied. This function is thread-safe.
+ * 
+ * Returns @ref NS_STRING_ID_NONE on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param string Null-terminated string
+ * @return nsStringId
+ */
+nsStringId ns_intern_string(const char *string);
+
+/**
+ * @brief Get the ID of string without interning it.
+ * 
+ * This function is thread-safe.
+ * 
+ * @param string Null-terminated string
+ * @return nsStringId ID or @ref NS_STRING_ID_NONE if the string was never interned
+ */
+nsStringId ns_find_string_id(const char *string);
+
+/**
+ * @brief Get the string of ID.
+ * 
+ * The returned string lives until @ref ns_free_string_ids. This function is
+ * thread-safe.
+ * 
+ * @param id String ID
+ * @return const char * String or `NULL` if the ID is unknown
+ */
+const char *ns_string_id_as_string(nsStringId id);
+
+/**
+ * @brief Get the number of interned strings.
+ * 
+ * @return size_t
+ */
+size_t ns_get_string_id_count();
+
+/**
+ * @brief Free the interned strings, invalidating every ID.
+ */
+void ns_free_string_ids();
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file core/timer.h
+ * @brief Monotonic high resolution clock.
+ */
+#ifndef _NS_TIMER_H
+#define _NS_TIMER_H
+
+#include "engine/include/core/types.h"
+#include "engine/include/core/platform.h"
+
+#if NS_PLATFORM == NS_PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#if NS_COMPILER == NS_COMPILER_MSVC && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define _NS_TIMER_TSC 1
+#elif NS_ARCH == NS_ARCH_X86_64 || NS_ARCH == NS_ARCH_X86
+    #include <x86intrin.h>
+    #define _NS_TIMER_TSC 1
+#else
+    #define _NS_TIMER_TSC 0
+#endif
+
+
+/*
+    Ticks are the cheapest timestamps the CPU can give. On x86 CPUs with an
+    invariant TSC they are raw RDTSC cycles, which cost a few nanoseconds and
+    don't need a system call. Everywhere else they are nanoseconds of the
+    monotonic system clock.
+
+    Call ns_timer_calibrate once at startup, before taking any ticks. Until
+    then ticks come from the system clock, and ticks taken before and after
+    calibration can't be compared.
+
+    ns_time_ns -> Nanoseconds of the monotonic system clock, not affected by NTP.
+    ns_ticks -> Raw ticks for timing short intervals.
+    ns_ticks_to_ns -> Convert a tick difference to nanoseconds.
+    ns_ticks_to_seconds -> Convert a tick difference to seconds.
+*/
+
+
+/**
+ * @brief Tick source and its rate, set by @ref ns_timer_calibrate.
+ */
+typedef struct {
+    ns_bool use_tsc; /**< Ticks are TSC cycles. */
+    double ns_per_tick; /**< Nanoseconds per tick. */
+    double ticks_per_second; /**< Tick frequency. */
+} nsTimerCalibration;
+
+extern nsTimerCalibration _ns_global_timer;
+
+/**
+ * @brief Pick the tick source and measure its rate against the system clock.
+ * 
+ * Blocks for about 10 milliseconds the first time, later calls do nothing.
+ */
+void ns_timer_calibrate();
+
+/**
+ * @brief Get the tick source and its rate.
+ * 
+ * @return nsTimerCalibration
+ */
+static inline nsTimerCalibration ns_timer_get_calibration() {
+    return _ns_global_timer;
+}
+
+/**
+ * @brief Get nanoseconds of the monotonic system clock.
+ * 
+ * The starting point is unspecified, use it for differences only.
+ * 
+ * @return ns_u64
+ */
+static inline ns_u64 ns_time_ns() {
+    #if NS_PLATFORM == NS_PLATFORM_WINDOWS
+
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    // Split to not overflow after a few hours of uptime
+    ns_u64 seconds = (ns_u64)(counter.QuadPart / frequency.QuadPart);
+    ns_u64 rest = (ns_u64)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ULL + rest * 1000000000ULL / (ns_u64)frequency.QuadPart;
+
+    #else
+
+    struct timespec time;
+
+    // Raw clock isn't slewed by NTP, so its rate stays constant
+    #ifdef CLOCK_MONOTONIC_RAW
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+
+    #else
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    #endif
+
+    return (ns_u64)time.tv_sec * 1000000000ULL + (ns_u64)time.tv_nsec;
+
+    #endif
+}
+
+/**
+ * @brief Get raw ticks.
+ * 
+ * @return ns_u64
+ */
+static inline ns_u64 ns_ticks() {
+    #if _NS_TIMER_TSC
+
+    if (_ns_global_timer.use_tsc) return __rdtsc();
+
+    #endif
+
+    return ns_time_ns();
+}
+
+/**
+ * @brief Convert ticks to nanoseconds.
+ * 
+ * @param ticks Tick difference
+ * @return ns_u64
+ */
+static inline ns_u64 ns_ticks_to_ns(ns_u64 ticks) {
+    return (ns_u64)((double)ticks * _ns_global_timer.ns_per_tick);
+}
+
+/**
+ * @brief Convert ticks to seconds.
+ * 
+ * @param ticks Tick difference
+ * @return double
+ */
+static inline double ns_ticks_to_seconds(ns_u64 ticks) {
+    return (double)ticks / _ns_global_timer.ticks_per_second;
+}
+
+
+#endif
\ No newline at end of file
@@ -22,8 +22,20 @@
 #include "engine/include/core/platform.h"
 #include "engine/include/core/array.h"
 #include "engine/include/core/pool.h"
+#include "engine/include/core/slotmap.h"
+#include "engine/include/core/hashmap.h"
+#include "engine/include/core/string_id.h"
+#include "engine/include/core/arena.h"
+#include "engine/include/core/allocator.h"
+#include "engine/include/core/atomic.h"
+#include "engine/include/core/jobs.h"
+#include "engine/include/core/queue.h"
+#include "engine/include/core/object_pool.h"
 #include "engine/include/core/io.h"
+#include "engine/include/core/number.h"
+#include "engine/include/core/timer.h"
 #include "engine/include/core/profiler.h"
+#include "engine/include/core/frame_stats.h"
 #include "engine/include/core/version.h"
 
 #include "engine/include/math/math.h"
@@ -34,9 +46,14 @@
 #include "engine/include/graphics/color.h"
 #include "engine/include/graphics/material.h"
 #include "engine/include/graphics/mesh.h"
+#include "engine/include/graphics/mesh_optimizer.h"
+#include "engine/include/graphics/quantize.h"
+#include "engine/include/graphics/lod.h"
+#include "engine/include/graphics/meshlet.h"
 #include "engine/include/graphics/buffer.h"
 #include "engine/include/graphics/uniform.h"
 #include "engine/include/graphics/texture.h"
+#include "engine/include/graphics/gpu_profiler.h"
 
 #include "engine/include/model/model.h"
 
@@ -44,6 +61,8 @@
 #include "engine/include/scene/camera.h"
 
 #include "engine/include/loaders/obj.h"
+#include "engine/include/loaders/mesh_cache.h"
+#include "engine/include/loaders/async.h"
 
 #include "engine/include/app/app.h"
 
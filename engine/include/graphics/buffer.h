@@ -18,26 +18,82 @@
 #include "engine/include/_internal.h"
 
 
+/**
+ * @brief What the buffer data is used for.
+ */
+typedef enum {
+    nsBufferType_VERTEX, /**< Per-vertex attribute data. */
+    nsBufferType_INDEX /**< Triangle indices into vertex buffers. */
+} nsBufferType;
+
+/**
+ * @brief Maximum number of vertex attributes one buffer can feed.
+ */
+#define NS_BUFFER_MAX_ATTRIBUTES 8
+
+/**
+ * @brief Layout of one vertex attribute inside a vertex buffer.
+ */
+typedef struct {
+    ns_u32 location; /**< Attribute location in the VAO. */
+    ns_u32 components; /**< Number of components. */
+    ns_u32 type; /**< GL type of one component. */
+    ns_bool normalized; /**< Whether integer components are normalized to [0, 1] or [-1, 1]. */
+    size_t offset; /**< Byte offset of the attribute in one element. */
+} nsVertexAttribute;
+
 /**
  * @brief General-purpose data container allocated on the GPU.
+ * 
+ * A vertex buffer can be interleaved, in which case every element holds
+ * multiple attributes at their own offsets.
  */
 typedef struct {
     ns_u32 buffer_id; /**< GL buffer object. */
-    ns_u32 attribute_loc; /**< Attribute location in the VAO. */
-    ns_u32 components; /**< Number of components per element. */
+    nsBufferType type; /**< Buffer type. */
+    nsVertexAttribute attributes[NS_BUFFER_MAX_ATTRIBUTES]; /**< Attribute layout, only for vertex buffers. */
+    ns_u32 attribute_count; /**< Number of attributes. */
+    ns_u32 index_type; /**< GL type of indices, only for index buffers. */
     size_t stride; /**< Byte stride between elements. */
     size_t count; /**< Number of elements. */
 } nsBuffer;
 
 /**
- * @brief Create new buffer.
+ * @brief Create new buffer of a single float attribute.
  * 
  * Returns `NULL` on error. Use @ref ns_get_error to get more information.
  * 
+ * @param attribute_loc Attribute location
+ * @param components Number of float components
  * @return nsBuffer *
  */
 nsBuffer *nsBuffer_new(ns_u32 attribute_loc, ns_u32 components);
 
+/**
+ * @brief Create new interleaved vertex buffer.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param attributes Array of attribute layouts
+ * @param attribute_count Number of attributes, at most @ref NS_BUFFER_MAX_ATTRIBUTES
+ * @param stride Byte size of one element
+ * @return nsBuffer *
+ */
+nsBuffer *nsBuffer_new_interleaved(
+    const nsVertexAttribute *attributes,
+    ns_u32 attribute_count,
+    size_t stride
+);
+
+/**
+ * @brief Create new index buffer.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @return nsBuffer *
+ */
+nsBuffer *nsBuffer_new_index(void);
+
 /**
  * @brief Free buffer.
  * 
@@ -54,7 +110,74 @@ void nsBuffer_free(nsBuffer *buffer);
  * @param data Array of data
  * @param count Amount of elements
  */
-void nsBuffer_write(nsBuffer *buffer, float *data, size_t count);
+void nsBuffer_write(nsBuffer *buffer, const float *data, size_t count);
+
+/**
+ * @brief Write already laid out elements on buffer as is.
+ * 
+ * Data has to match the buffer's layout, `count * stride` bytes are uploaded.
+ * If data is `NULL` the storage is only allocated, to be filled later with
+ * @ref nsBufferUpload_step.
+ * 
+ * @param buffer Buffer
+ * @param data Element data
+ * @param count Amount of elements
+ */
+void nsBuffer_write_raw(nsBuffer *buffer, const void *data, size_t count);
+
+/**
+ * @brief Write indices on index buffer.
+ * 
+ * Indices are narrowed down to 16-bit on the GPU if they all fit.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param buffer Index buffer
+ * @param indices Array of indices
+ * @param count Amount of indices
+ * @return int Status
+ */
+int nsBuffer_write_indices(nsBuffer *buffer, const ns_u32 *indices, size_t count);
+
+/**
+ * @brief Write already packed indices on index buffer as is.
+ * 
+ * If indices is `NULL` the storage is only allocated.
+ * 
+ * @param buffer Index buffer
+ * @param indices Array of indices
+ * @param count Amount of indices
+ * @param index_type GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ */
+void nsBuffer_write_indices_ex(
+    nsBuffer *buffer,
+    const void *indices,
+    size_t count,
+    ns_u32 index_type
+);
+
+
+/**
+ * @brief Pending copy of CPU data into already allocated buffer storage.
+ * 
+ * Large uploads can be spread over multiple frames by copying a limited
+ * amount of bytes each step.
+ */
+typedef struct {
+    nsBuffer *buffer; /**< Destination buffer. */
+    const void *data; /**< Source data, has to stay valid until the upload is complete. */
+    size_t size; /**< Total bytes to copy. */
+    size_t uploaded; /**< Bytes copied so far. */
+} nsBufferUpload;
+
+/**
+ * @brief Copy the next part of a pending upload.
+ * 
+ * @param upload Upload
+ * @param max_bytes Maximum bytes to copy in this step
+ * @return ns_bool Whether the upload is complete
+ */
+ns_bool nsBufferUpload_step(nsBufferUpload *upload, size_t max_bytes);
 
 
 #endif
\ No newline at end of file
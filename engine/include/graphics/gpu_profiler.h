@@ -0,0 +1,128 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file graphics/gpu_profiler.h
+ * @brief GPU timings of render passes.
+ */
+#ifndef _NS_GPU_PROFILER_H
+#define _NS_GPU_PROFILER_H
+
+#include "engine/include/_internal.h"
+
+
+/*
+    GPU zones put a GL_TIMESTAMP query at their begin and end, so they can
+    nest like CPU zones. Queries of a frame are read back only after
+    NS_GPU_PROFILER_FRAMES - 1 more frames were submitted. By then the GPU
+    is long done with them, so reading never stalls the pipeline. Frames
+    whose results still aren't available are dropped instead of waited on.
+
+    Timings of the latest read frame are available to the frame statistics.
+    When built with NS_PROFILER_ENABLE, they also go to zone profiler captures
+    as a separate "GPU" track.
+
+    Zones are only recorded while the GPU profiler is enabled, disabled zones
+    cost one branch.
+*/
+
+
+/**
+ * @brief Number of frames of queries in flight.
+ */
+#define NS_GPU_PROFILER_FRAMES 3
+
+/**
+ * @brief Maximum number of zone begins and ends in one frame.
+ */
+#define NS_GPU_PROFILER_MAX_EVENTS 512
+
+/**
+ * @brief Timing of a GPU zone.
+ */
+typedef struct {
+    const char *name; /**< Zone name. */
+    ns_u32 depth; /**< Number of zones this one is nested in. */
+    double start; /**< Seconds since the first zone of the frame began. */
+    double duration; /**< Seconds the zone took on the GPU. */
+} nsGPUZone;
+
+/**
+ * @brief Enable or disable recording GPU zones, takes effect at the next frame.
+ * 
+ * @param enabled Enabled
+ */
+void ns_gpu_profiler_set_enabled(ns_bool enabled);
+
+/**
+ * @brief Check if GPU zones are being recorded.
+ * 
+ * @return ns_bool
+ */
+ns_bool ns_gpu_profiler_is_enabled();
+
+/**
+ * @brief Begin GPU zone.
+ * 
+ * Zones nest and have to end in the same frame. Zones that don't fit into
+ * the frame are dropped along with the zones inside them.
+ * 
+ * @param name Zone name, only the pointer is stored
+ */
+void ns_gpu_profiler_begin_zone(const char *name);
+
+/**
+ * @brief End the innermost GPU zone.
+ */
+void ns_gpu_profiler_end_zone();
+
+/**
+ * @brief Finish the queries of the current frame and read back the oldest one.
+ * 
+ * Call once per frame from the thread that owns the GL context.
+ */
+void ns_gpu_profiler_frame();
+
+/**
+ * @brief Check if a frame was read since the GPU profiler got enabled.
+ * 
+ * Frame time is only a measurement when this is true, results lag a few
+ * frames behind enabling.
+ * 
+ * @return ns_bool
+ */
+ns_bool ns_gpu_profiler_has_frame_time();
+
+/**
+ * @brief Get the GPU time of the latest read frame.
+ * 
+ * It's the sum of the outermost zones, frames in flight are not included.
+ * 
+ * @return double Seconds
+ */
+double ns_gpu_profiler_get_frame_time();
+
+/**
+ * @brief Get zones of the latest read frame, in the order they began.
+ * 
+ * @param count Number of zones
+ * @return const nsGPUZone *
+ */
+const nsGPUZone *ns_gpu_profiler_get_zones(size_t *count);
+
+/**
+ * @brief Delete queries.
+ * 
+ * The GL context still has to be current.
+ */
+void ns_free_gpu_profiler();
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file graphics/lod.h
+ * @brief Mesh simplification and level of detail selection.
+ * 
+ * Levels of detail of a mesh share its vertex buffer, each level is only a
+ * range of the index buffer. Level 0 is always the full detail mesh.
+ */
+#ifndef _NS_LOD_H
+#define _NS_LOD_H
+
+#include "engine/include/_internal.h"
+
+
+/**
+ * @brief Maximum number of detail levels a mesh can have, including the full one.
+ */
+#define NS_MESH_MAX_LODS 8
+
+/**
+ * @brief Default projected error threshold, as a fraction of the screen height.
+ * 
+ * This is about one pixel at 1080p.
+ */
+#define NS_LOD_DEFAULT_THRESHOLD (1.0f / 1080.0f)
+
+/**
+ * @brief Fraction below the threshold a coarser level has to be to switch to it.
+ * 
+ * Keeps models near a switching distance from popping back and forth.
+ */
+#define NS_LOD_HYSTERESIS 0.25f
+
+/**
+ * @brief One level of detail of a mesh.
+ */
+typedef struct {
+    ns_u32 index_offset; /**< First index of the level in the index buffer. */
+    ns_u32 index_count; /**< Number of indices of the level. */
+    float error; /**< Object-space geometric error compared to the full detail level. */
+    ns_u32 meshlet_offset; /**< First meshlet of the level. */
+    ns_u32 meshlet_count; /**< Number of meshlets of the level, 0 if the level isn't split. */
+} nsMeshLOD;
+
+/**
+ * @brief Simplify triangle list by collapsing edges.
+ * 
+ * Edges are collapsed onto existing vertices, so the output indexes the same
+ * vertices as the input. Quadric error metrics drive the collapse order.
+ * Vertices that share a position but differ in other attributes (UV seams,
+ * hard edges) are collapsed together along the seam, mesh borders are kept
+ * in place.
+ * 
+ * Simplification stops when the target index count is reached or when the
+ * next collapse would go over the target error.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param destination Output indices, room for index count indices
+ * @param destination_count Number of output indices
+ * @param indices Triangle list indices
+ * @param index_count Number of indices
+ * @param positions Pointer to the position of the first vertex
+ * @param position_stride Byte stride between vertex positions
+ * @param vertex_count Number of vertices
+ * @param target_index_count Number of indices to simplify down to
+ * @param target_error Maximum object-space error allowed
+ * @param result_error Object-space error of the output, can be `NULL`
+ * @return int Status
+ */
+int ns_simplify(
+    ns_u32 *destination,
+    size_t *destination_count,
+    const ns_u32 *indices,
+    size_t index_count,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count,
+    size_t target_index_count,
+    float target_error,
+    float *result_error
+);
+
+/**
+ * @brief Select detail level by its projected error on the screen.
+ * 
+ * The coarsest level whose error projects below the threshold is chosen.
+ * Switching to a coarser level additionally requires it to be
+ * @ref NS_LOD_HYSTERESIS below the threshold.
+ * 
+ * @param lods Detail levels, finest first
+ * @param lod_count Number of detail levels
+ * @param current Currently selected level
+ * @param scale Object to world scale of the errors
+ * @param distance Distance from the camera to the closest point of the object
+ * @param projection_scale Vertical projection scale, 1 / tan(fov / 2)
+ * @param threshold Maximum projected error as a fraction of the screen height
+ * @return ns_u32 Selected level
+ */
+ns_u32 ns_select_lod(
+    const nsMeshLOD *lods,
+    ns_u32 lod_count,
+    ns_u32 current,
+    float scale,
+    float distance,
+    float projection_scale,
+    float threshold
+);
+
+
+#endif
\ No newline at end of file
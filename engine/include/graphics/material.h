@@ -18,18 +18,50 @@
 #include "engine/include/_internal.h"
 #include "engine/include/graphics/uniform.h"
 #include "engine/include/core/array.h"
+#include "engine/include/core/hashmap.h"
 #include "engine/include/math/vector.h"
 #include "engine/include/math/matrix.h"
 
 
+/**
+ * @brief Index of a uniform in its material.
+ * 
+ * Resolve names into handles once with @ref nsMaterial_get_uniform_handle and
+ * set values through the handles, so no string is hashed or compared when
+ * drawing. Handles are only valid for the material they came from.
+ */
+typedef ns_i32 nsUniformHandle;
+
+/**
+ * @brief Handle that never refers to a uniform, setting it does nothing.
+ */
+#define NS_UNIFORM_HANDLE_NONE -1
+
 /**
  * @brief Abstract type that encapsulates a GPU shader program and potential
  * associated data such as textures, uniforms and states.
+ * 
+ * Active uniforms of the program are enumerated once after linking. Arrays of
+ * basic types can be accessed both as `name` and `name[i]`.
+ * 
+ * Setting a uniform only writes its staged value on the CPU and marks it dirty
+ * if the value changed. Dirty uniforms are uploaded together when the
+ * material is bound for drawing with @ref nsMaterial_bind, so values that are
+ * set every frame but rarely change cost no GL calls.
  */
 typedef struct {
     ns_u32 program_id; /**< GL shader program object. */
 
-    nsArray *uniforms_cache;
+    nsArray *uniforms; /**< Active uniforms of the program, indexed by handle. */
+    nsHashMap *uniform_handles; /**< Interned uniform name to handle. */
+    ns_u8 *uniform_values; /**< Staged value of every uniform. */
+    ns_u64 *dirty_uniforms; /**< Bit per uniform, set if the staged value isn't uploaded yet. */
+    ns_u64 *synced_uniforms; /**< Bit per uniform, set if the staged value matches the program. */
+    ns_bool dirty; /**< Whether any uniform is dirty. */
+
+    nsUniformHandle model_uniform; /**< Handle of `u_model`. */
+    nsUniformHandle position_scale_uniform; /**< Handle of `u_position_scale`. */
+    nsUniformHandle position_offset_uniform; /**< Handle of `u_position_offset`. */
 } nsMaterial;
 
 /**
@@ -70,7 +102,19 @@ nsMaterial *nsMaterial_from_files(
 void nsMaterial_free(nsMaterial *material);
 
 /**
- * @brief Get uniform, cache it if first time.
+ * @brief Get the handle of uniform by name.
+ * 
+ * Returns @ref NS_UNIFORM_HANDLE_NONE if the program has no active uniform
+ * with the name. Use @ref ns_get_error to get more information.
+ * 
+ * @param material Material
+ * @param name Uniform name
+ * @return nsUniformHandle
+ */
+nsUniformHandle nsMaterial_get_uniform_handle(const nsMaterial *material, const char *name);
+
+/**
+ * @brief Get uniform by name.
  * 
  * Returns `NULL` on error. Use @ref ns_get_error to get more information.
  * 
@@ -78,25 +122,50 @@ void nsMaterial_free(nsMaterial *material);
  * @param name Uniform name
  * @return nsUniform *
  */
-nsUniform *nsMaterial_get_uniform(nsMaterial *material, char *name);
+nsUniform *nsMaterial_get_uniform(const nsMaterial *material, const char *name);
+
+/**
+ * @brief Use the material's program and upload dirty uniforms.
+ * 
+ * Meshes call this before drawing. Call it before drawing with the program
+ * directly.
+ * 
+ * @param material Material
+ */
+void nsMaterial_bind(nsMaterial *material);
+
+void nsMaterial_set_vector3(nsMaterial *material, nsUniformHandle handle, nsVector3 vec);
+
+void nsMaterial_set_matrix4(nsMaterial *material, nsUniformHandle handle, nsMatrix4 mat);
+
+void nsMaterial_set_float(nsMaterial *material, nsUniformHandle handle, float value);
+
+void nsMaterial_set_int(nsMaterial *material, nsUniformHandle handle, int value);
+
+float nsMaterial_get_float(nsMaterial *material, nsUniformHandle handle);
+
+/*
+    Name based versions of the functions above, these look up the handle on
+    every call. Prefer handles for anything that's set every frame.
+*/
 
 void nsMaterial_set_uniform_vector3(
     nsMaterial *material,
-    char *name,
+    const char *name,
     nsVector3 vec
 );
 
 void nsMaterial_set_uniform_matrix4(
     nsMaterial *material,
-    char *name,
+    const char *name,
     nsMatrix4 mat
 );
 
-void nsMaterial_set_uniform_float(nsMaterial *material, char *name, float value);
+void nsMaterial_set_uniform_float(nsMaterial *material, const char *name, float value);
 
-void nsMaterial_set_uniform_int(nsMaterial *material, char *name, int value);
+void nsMaterial_set_uniform_int(nsMaterial *material, const char *name, int value);
 
-float nsMaterial_get_uniform_float(nsMaterial *material, char *name);
+float nsMaterial_get_uniform_float(nsMaterial *material, const char *name);
 
 
 #endif
\ No newline at end of file
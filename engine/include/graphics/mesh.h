@@ -19,9 +19,17 @@
 #include "engine/include/core/array.h"
 #include "engine/include/graphics/material.h"
 #include "engine/include/graphics/buffer.h"
+#include "engine/include/graphics/lod.h"
+#include "engine/include/graphics/meshlet.h"
 #include "engine/include/loaders/obj.h"
+#include "engine/include/loaders/mesh_cache.h"
 
 
+/**
+ * @brief Maximum number of buffer uploads a mesh created from a cache can have.
+ */
+#define NS_MESH_MAX_UPLOADS (NS_MESH_CACHE_MAX_ATTRIBUTES + 1)
+
 /**
  * @brief Abstract type that manages a collection of buffers and materials.
  */
@@ -30,7 +38,22 @@ typedef struct {
 
     nsArray *buffers; /**< Array of assigned buffers, first is the primary. */
 
+    nsBuffer *index_buffer; /**< Optional index buffer, mesh is drawn indexed if assigned. */
+
     nsMaterial *material; /**< Assigned material. */
+
+    nsVector3 position_scale; /**< Position dequantization scale, (1, 1, 1) if positions are not quantized. */
+    nsVector3 position_offset; /**< Position dequantization offset, (0, 0, 0) if positions are not quantized. */
+
+    nsMeshLOD lods[NS_MESH_MAX_LODS]; /**< Detail levels as ranges of the index buffer, finest first. */
+    ns_u32 lod_count; /**< Number of detail levels, 0 draws the whole index buffer. */
+
+    nsVector3 bounds_center; /**< Center of the object-space bounding sphere. */
+    float bounds_radius; /**< Radius of the object-space bounding sphere. */
+
+    nsMeshlet *meshlets; /**< Meshlets of all detail levels, `NULL` if the mesh isn't split. */
+    ns_u32 meshlet_count; /**< Number of meshlets. */
+    ns_u32 drawn_meshlets; /**< Number of meshlets that passed culling in the last culled render. */
 } nsMesh;
 
 /**
@@ -79,6 +102,99 @@ nsMesh *nsMesh_from_plane(
 
 nsMesh *nsMesh_from_obj(nsMaterial *material, nsOBJ *obj);
 
+/**
+ * @brief Factory function for a mesh uploaded straight from a mapped mesh cache.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param material Material
+ * @param cache Opened mesh cache
+ * @return nsMesh *
+ */
+nsMesh *nsMesh_from_cache(nsMaterial *material, const nsMeshCache *cache);
+
+/**
+ * @brief Factory function for a mesh whose buffer data is uploaded later.
+ * 
+ * Buffers are created with their storage allocated, the copies that fill them
+ * are written to the uploads array and have to be completed with
+ * @ref nsBufferUpload_step before the mesh is rendered. The cache has to stay
+ * open until then.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param material Material
+ * @param cache Opened mesh cache
+ * @param uploads Array of at least @ref NS_MESH_MAX_UPLOADS uploads
+ * @param upload_count Number of uploads written
+ * @return nsMesh *
+ */
+nsMesh *nsMesh_from_cache_deferred(
+    nsMaterial *material,
+    const nsMeshCache *cache,
+    nsBufferUpload *uploads,
+    size_t *upload_count
+);
+
+/**
+ * @brief Mesh data loaded on the CPU, ready to be uploaded.
+ */
+typedef struct {
+    nsMeshCache cache; /**< Mapped mesh cache. */
+    ns_bool cached; /**< Whether the cache is open, otherwise the parsed OBJ is used. */
+    nsOBJ obj; /**< Parsed OBJ, only if the cache couldn't be written. */
+} nsMeshSource;
+
+/**
+ * @brief Load mesh data from file, going through the binary mesh cache.
+ * 
+ * `.nsmesh` files are mapped directly. For other files the cache next to the
+ * source (filepath + @ref NS_MESH_CACHE_EXTENSION) is used if it is up-to-date,
+ * otherwise the source is parsed, detail levels are generated with
+ * @ref nsOBJMesh_generate_lods, it is optimized with @ref nsOBJMesh_optimize and
+ * the cache is (re)written with quantized vertices and meshlets.
+ * 
+ * This doesn't make any GL calls, so it can run on any thread.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param source Mesh source to initialize
+ * @param filepath Mesh filepath
+ * @return int Status
+ */
+int nsMeshSource_load(nsMeshSource *source, const char *filepath);
+
+/**
+ * @brief Free mesh source.
+ * 
+ * @param source Mesh source
+ */
+void nsMeshSource_free(nsMeshSource *source);
+
+/**
+ * @brief Factory function for a mesh uploaded from loaded mesh data.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param material Material
+ * @param source Loaded mesh source
+ * @return nsMesh *
+ */
+nsMesh *nsMesh_from_source(nsMaterial *material, nsMeshSource *source);
+
+/**
+ * @brief Load mesh from file, going through the binary mesh cache.
+ * 
+ * Same as @ref nsMeshSource_load followed by @ref nsMesh_from_source.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param material Material
+ * @param filepath Mesh filepath
+ * @return nsMesh *
+ */
+nsMesh *nsMesh_load(nsMaterial *material, const char *filepath);
+
 /**
  * @brief Push new buffer to the mesh.
  * 
@@ -90,9 +206,65 @@ nsMesh *nsMesh_from_obj(nsMaterial *material, nsOBJ *obj);
  */
 int nsMesh_push_buffer(nsMesh *mesh, nsBuffer *buffer);
 
+/**
+ * @brief Copy meshlets to the mesh.
+ * 
+ * Meshlet ranges of the detail levels have to be set as well for culled
+ * rendering to use them.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param mesh Mesh
+ * @param meshlets Meshlets
+ * @param meshlet_count Number of meshlets
+ * @return int Status
+ */
+int nsMesh_set_meshlets(nsMesh *mesh, const nsMeshlet *meshlets, size_t meshlet_count);
+
+/**
+ * @brief Assign index buffer to the mesh.
+ * 
+ * Mesh takes the ownership of the buffer and frees the old one if there is.
+ * 
+ * @param mesh Mesh
+ * @param buffer Index buffer
+ */
+void nsMesh_set_index_buffer(nsMesh *mesh, nsBuffer *buffer);
+
 void nsMesh_initialize(nsMesh *mesh);
 
+/**
+ * @brief Render the full detail level of the mesh.
+ * 
+ * @param mesh Mesh
+ */
 void nsMesh_render(nsMesh *mesh);
 
+/**
+ * @brief Render one detail level of the mesh.
+ * 
+ * Levels past the coarsest one render the coarsest one.
+ * 
+ * @param mesh Mesh
+ * @param lod Detail level
+ */
+void nsMesh_render_lod(nsMesh *mesh, ns_u32 lod);
+
+/**
+ * @brief Render the visible meshlets of one detail level.
+ * 
+ * Meshlets outside the frustum or facing away from the camera are skipped,
+ * consecutive visible meshlets are merged and everything is submitted with
+ * one multi-draw. Levels without meshlets are rendered whole.
+ * 
+ * The draw ranges are allocated from the frame arena, see
+ * @ref ns_get_frame_arena.
+ * 
+ * @param mesh Mesh
+ * @param lod Detail level
+ * @param context Cull context of the model the mesh is rendered with
+ */
+void nsMesh_render_culled(nsMesh *mesh, ns_u32 lod, const nsCullContext *context);
+
 
 #endif
\ No newline at end of file
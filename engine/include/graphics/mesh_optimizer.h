@@ -0,0 +1,187 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file graphics/mesh_optimizer.h
+ * @brief Index and vertex reordering for faster rendering.
+ * 
+ * Optimizations are meant to run in this order on indexed triangle lists:
+ * 0. @ref nsOBJMesh_generate_lods to append simplified detail levels
+ * 1. @ref ns_optimize_vertex_cache to reuse post-transform vertices
+ * 2. @ref ns_optimize_overdraw to draw outer surfaces first
+ * 3. @ref ns_optimize_vertex_fetch to read vertex memory linearly
+ * 
+ * All of them are deterministic, same input always gives the same output.
+ */
+#ifndef _NS_MESH_OPTIMIZER_H
+#define _NS_MESH_OPTIMIZER_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/loaders/obj.h"
+
+
+/**
+ * @brief Cache size the vertex cache optimization targets.
+ */
+#define NS_MESH_OPTIMIZER_CACHE_SIZE 32
+
+/**
+ * @brief FIFO cache size used for analysis and overdraw clustering.
+ */
+#define NS_MESH_OPTIMIZER_FIFO_SIZE 16
+
+/**
+ * @brief Default ACMR degradation allowed by overdraw optimization.
+ */
+#define NS_MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f
+
+/**
+ * @brief Triangle count of each detail level relative to the previous one.
+ */
+#define NS_MESH_OPTIMIZER_LOD_REDUCTION 0.5f
+
+/**
+ * @brief Detail levels that keep more than this of the previous level are dropped.
+ */
+#define NS_MESH_OPTIMIZER_LOD_MIN_REDUCTION 0.85f
+
+/**
+ * @brief Maximum simplification error, relative to the largest mesh extent.
+ */
+#define NS_MESH_OPTIMIZER_LOD_MAX_ERROR 0.05f
+
+/**
+ * @brief Post-transform vertex cache efficiency of an index buffer.
+ */
+typedef struct {
+    float acmr; /**< Average cache miss ratio, transformed vertices per triangle. 3 is the worst. */
+    float atvr; /**< Average transformed vertex ratio, transformed vertices per vertex. 1 is the best. */
+} nsVertexCacheStats;
+
+/**
+ * @brief Statistics of @ref nsOBJMesh_optimize
+ */
+typedef struct {
+    nsVertexCacheStats before; /**< Cache efficiency of the input. */
+    nsVertexCacheStats after; /**< Cache efficiency of the output. */
+} nsMeshOptimizeStats;
+
+/**
+ * @brief Simulate a FIFO vertex cache over the index buffer.
+ * 
+ * @param indices Triangle list indices
+ * @param index_count Number of indices
+ * @param vertex_count Number of vertices
+ * @param cache_size FIFO cache size
+ * @return nsVertexCacheStats
+ */
+nsVertexCacheStats ns_analyze_vertex_cache(
+    const ns_u32 *indices,
+    size_t index_count,
+    size_t vertex_count,
+    ns_u32 cache_size
+);
+
+/**
+ * @brief Reorder triangles to maximize post-transform vertex cache hits.
+ * 
+ * Uses Tom Forsyth's linear-speed vertex cache optimization.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param indices Triangle list indices, reordered in place
+ * @param index_count Number of indices
+ * @param vertex_count Number of vertices
+ * @return int Status
+ */
+int ns_optimize_vertex_cache(ns_u32 *indices, size_t index_count, size_t vertex_count);
+
+/**
+ * @brief Reorder triangle clusters so outward facing surfaces are drawn first.
+ * 
+ * Triangles are split into clusters without hurting vertex cache efficiency
+ * by more than the threshold and the clusters are sorted by how much they
+ * face away from the mesh center. Run this after @ref ns_optimize_vertex_cache
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param indices Triangle list indices, reordered in place
+ * @param index_count Number of indices
+ * @param positions Pointer to the position of the first vertex
+ * @param position_stride Byte stride between vertex positions
+ * @param vertex_count Number of vertices
+ * @param threshold Allowed ACMR degradation, 1.05 allows 5% worse ACMR
+ * @return int Status
+ */
+int ns_optimize_overdraw(
+    ns_u32 *indices,
+    size_t index_count,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count,
+    float threshold
+);
+
+/**
+ * @brief Reorder vertices in the order the index buffer first uses them.
+ * 
+ * Indices are remapped accordingly and unused vertices are dropped.
+ * 
+ * Returns the new number of vertices, or 0 on error.
+ * Use @ref ns_get_error to get more information.
+ * 
+ * @param vertices Vertex data, reordered in place
+ * @param vertex_size Byte size of one vertex
+ * @param vertex_count Number of vertices
+ * @param indices Triangle list indices, remapped in place
+ * @param index_count Number of indices
+ * @return size_t
+ */
+size_t ns_optimize_vertex_fetch(
+    void *vertices,
+    size_t vertex_size,
+    size_t vertex_count,
+    ns_u32 *indices,
+    size_t index_count
+);
+
+/**
+ * @brief Generate simplified detail levels of a loaded OBJ mesh.
+ * 
+ * Every level aims for @ref NS_MESH_OPTIMIZER_LOD_REDUCTION of the previous
+ * level's triangles and is simplified from it. Generation stops early once the
+ * error would exceed @ref NS_MESH_OPTIMIZER_LOD_MAX_ERROR or simplification
+ * stops making progress. Levels share the vertices of the mesh, their indices
+ * are appended to the index pool. Previously generated levels are replaced.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param mesh OBJ mesh
+ * @param max_lods Maximum number of levels including the full one, up to @ref NS_MESH_MAX_LODS
+ * @return int Status
+ */
+int nsOBJMesh_generate_lods(nsOBJMesh *mesh, ns_u32 max_lods);
+
+/**
+ * @brief Run all optimizations on a loaded OBJ mesh.
+ * 
+ * Index optimizations run separately on every detail level, statistics are
+ * of the full detail level.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param mesh OBJ mesh
+ * @param stats Statistics output, can be `NULL`
+ * @return int Status
+ */
+int nsOBJMesh_optimize(nsOBJMesh *mesh, nsMeshOptimizeStats *stats);
+
+
+#endif
\ No newline at end of file
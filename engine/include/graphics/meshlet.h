@@ -0,0 +1,145 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file graphics/meshlet.h
+ * @brief Meshlets and their visibility culling.
+ * 
+ * Meshlets are small clusters of consecutive triangles in the index buffer.
+ * Each has a bounding sphere for frustum culling and a normal cone for
+ * backface culling, so only the visible parts of large meshes are drawn.
+ */
+#ifndef _NS_MESHLET_H
+#define _NS_MESHLET_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/math/vector.h"
+#include "engine/include/math/matrix.h"
+#include "engine/include/scene/camera.h"
+#include "engine/include/loaders/obj.h"
+
+
+/**
+ * @brief Maximum number of unique vertices in one meshlet.
+ */
+#define NS_MESHLET_MAX_VERTICES 64
+
+/**
+ * @brief Maximum number of triangles in one meshlet.
+ */
+#define NS_MESHLET_MAX_TRIANGLES 124
+
+/**
+ * @brief Meshlets whose triangle normals spread more than this cosine off the cone axis have no cone.
+ */
+#define NS_MESHLET_MIN_CONE_SPREAD 0.1f
+
+/**
+ * @brief Cluster of consecutive triangles in the index buffer.
+ */
+typedef struct {
+    ns_u32 index_offset; /**< First index of the meshlet in the index buffer. */
+    ns_u32 index_count; /**< Number of indices of the meshlet. */
+    nsVector3 center; /**< Object-space bounding sphere center. */
+    float radius; /**< Object-space bounding sphere radius. */
+    nsVector3 cone_apex; /**< Apex of the normal cone. */
+    nsVector3 cone_axis; /**< Average direction of the triangle normals. */
+    float cone_cutoff; /**< Sine of the normal cone angle, 1 or more if the meshlet can't be backface culled. */
+} nsMeshlet;
+
+/**
+ * @brief Camera data prepared in the object space of one model for culling.
+ */
+typedef struct {
+    float planes[6][4]; /**< Frustum planes, points inside have non-negative distances. */
+    nsVector3 camera_position; /**< Camera position in object space. */
+    ns_bool cone_culling; /**< Backface cones can be tested, only with perspective cameras. */
+} nsCullContext;
+
+/**
+ * @brief Split triangle list into meshlets.
+ * 
+ * Triangles are grouped in the order they are in, so run vertex cache
+ * optimization first to get compact meshlets. Meshlets are appended to the
+ * pool, their index offsets are relative to the given index offset.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param meshlets Pool of nsMeshlet to append to
+ * @param indices Triangle list indices
+ * @param index_count Number of indices
+ * @param index_offset Offset of the indices in the whole index buffer
+ * @param positions Pointer to the position of the first vertex
+ * @param position_stride Byte stride between vertex positions
+ * @param vertex_count Number of vertices
+ * @return int Status
+ */
+int ns_build_meshlets(
+    nsPool *meshlets,
+    const ns_u32 *indices,
+    size_t index_count,
+    ns_u32 index_offset,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count
+);
+
+/**
+ * @brief Build meshlets for every detail level of a loaded OBJ mesh.
+ * 
+ * Meshlet ranges are recorded in the detail levels. If no detail levels were
+ * generated, the full mesh becomes the only level. Run this after
+ * @ref nsOBJMesh_optimize since it doesn't change the triangle order.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param mesh OBJ mesh
+ * @return int Status
+ */
+int nsOBJMesh_build_meshlets(nsOBJMesh *mesh);
+
+/**
+ * @brief Prepare culling against camera for a model.
+ * 
+ * @param context Context to initialize
+ * @param camera Camera
+ * @param model Model matrix, translation * rotation * scale
+ */
+void nsCullContext_from_camera(
+    nsCullContext *context,
+    const nsCamera *camera,
+    nsMatrix4 model
+);
+
+/**
+ * @brief Test object-space sphere against the frustum.
+ * 
+ * @param context Cull context
+ * @param center Sphere center
+ * @param radius Sphere radius
+ * @return ns_bool Whether the sphere is at least partly inside
+ */
+ns_bool nsCullContext_test_sphere(
+    const nsCullContext *context,
+    nsVector3 center,
+    float radius
+);
+
+/**
+ * @brief Test meshlet against the frustum and its normal cone against the camera.
+ * 
+ * @param meshlet Meshlet
+ * @param context Cull context
+ * @return ns_bool Whether the meshlet can be visible
+ */
+ns_bool nsMeshlet_is_visible(const nsMeshlet *meshlet, const nsCullContext *context);
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file graphics/quantize.h
+ * @brief Compact vertex attribute encodings.
+ * 
+ * All encodings here are decoded by the GPU's vertex fetch, shaders see
+ * regular floats.
+ */
+#ifndef _NS_QUANTIZE_H
+#define _NS_QUANTIZE_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/math/vector.h"
+#include "engine/include/loaders/obj.h"
+
+
+/**
+ * @brief Quantized vertex, half the size of @ref nsOBJVertex
+ * 
+ * Positions are normalized into the mesh bounds and have to be dequantized
+ * with the mesh's position scale and offset in the vertex shader.
+ */
+typedef struct {
+    ns_i16 position[4]; /**< Normalized 16-bit position, 4th is padding. (GL_SHORT) */
+    ns_u32 normal; /**< Normalized 10-bit normal. (GL_INT_2_10_10_10_REV) */
+    ns_u16 uv[2]; /**< Half-float texture coordinates. (GL_HALF_FLOAT) */
+} nsQuantizedVertex;
+
+/**
+ * @brief Mesh vertices in quantized form.
+ */
+typedef struct {
+    nsQuantizedVertex *vertices; /**< Quantized vertices. */
+    size_t vertex_count; /**< Number of vertices. */
+    nsVector3 position_scale; /**< Position = quantized * scale + offset */
+    nsVector3 position_offset; /**< Position = quantized * scale + offset */
+} nsQuantizedMesh;
+
+/**
+ * @brief Convert float to IEEE 754 half-float, rounding to nearest even.
+ * 
+ * @param value Float
+ * @return ns_u16
+ */
+ns_u16 ns_quantize_half(float value);
+
+/**
+ * @brief Convert IEEE 754 half-float to float.
+ * 
+ * @param value Half-float
+ * @return float
+ */
+float ns_dequantize_half(ns_u16 value);
+
+/**
+ * @brief Convert float in [-1, 1] range to normalized signed 16-bit integer.
+ * 
+ * @param value Float
+ * @return ns_i16
+ */
+ns_i16 ns_quantize_snorm16(float value);
+
+/**
+ * @brief Pack unit vector into 10-bit normalized signed integer components.
+ * 
+ * @param normal Unit vector
+ * @return ns_u32 GL_INT_2_10_10_10_REV packed value
+ */
+ns_u32 ns_quantize_normal(nsVector3 normal);
+
+/**
+ * @brief Quantize OBJ mesh vertices using the mesh bounds.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param quantized Quantized mesh to initialize
+ * @param mesh OBJ mesh
+ * @param bounds_min Minimum corner of the mesh bounds
+ * @param bounds_max Maximum corner of the mesh bounds
+ * @return int Status
+ */
+int nsQuantizedMesh_from_obj(
+    nsQuantizedMesh *quantized,
+    const nsOBJMesh *mesh,
+    nsVector3 bounds_min,
+    nsVector3 bounds_max
+);
+
+/**
+ * @brief Free quantized vertices.
+ * 
+ * @param quantized Quantized mesh
+ */
+void nsQuantizedMesh_free(nsQuantizedMesh *quantized);
+
+
+#endif
\ No newline at end of file
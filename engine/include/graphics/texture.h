@@ -50,5 +50,40 @@ int nsTexture_write_from_file(nsTexture *texture, const char *filepath);
 
 int nsTexture_fill(nsTexture *texture, nsColor color);
 
+/**
+ * @brief Allocate texture storage without uploading any pixels.
+ * 
+ * Pixels can be filled in parts with @ref nsTexture_write_rows.
+ * 
+ * @param texture Texture
+ * @param width Width in pixels
+ * @param height Height in pixels
+ */
+void nsTexture_allocate(nsTexture *texture, size_t width, size_t height);
+
+/**
+ * @brief Upload range of rows of RGBA pixels into allocated storage.
+ * 
+ * @param texture Texture
+ * @param y First row
+ * @param width Width of the rows in pixels
+ * @param rows Number of rows
+ * @param data Tightly packed RGBA pixels of the rows
+ */
+void nsTexture_write_rows(
+    nsTexture *texture,
+    size_t y,
+    size_t width,
+    size_t rows,
+    const ns_u8 *data
+);
+
+/**
+ * @brief Regenerate mipmaps from the base level.
+ * 
+ * @param texture Texture
+ */
+void nsTexture_generate_mipmaps(nsTexture *texture);
+
 
 #endif
\ No newline at end of file
@@ -22,8 +22,11 @@
  * @brief Basic handle to a shader uniform storage.
  */
 typedef struct {
-    char *name; /**< Name of the uniform. */
+    char *name; /**< Name of the uniform, owned by the uniform. */
     ns_i32 location; /**< Location of the uniform in the shader program object. */
+    ns_u32 type; /**< GL type of the uniform, like `GL_FLOAT_VEC3`. */
+    ns_i32 size; /**< Number of array elements, 1 if not an array. */
+    size_t value_offset; /**< Offset of the staged value in the material's uniform values. */
 } nsUniform;
 
 /**
@@ -31,11 +34,13 @@ typedef struct {
  * 
  * Returns `NULL` on error. Use @ref ns_get_error to get more information.
  * 
- * @param name Name of the uniform.
+ * @param name Name of the uniform, copied.
  * @param location Location of the uniform in the shader program object.
+ * @param type GL type of the uniform.
+ * @param size Number of array elements.
  * @return nsUniform *
  */
-nsUniform *nsUniform_new(char *name, ns_u32 location);
+nsUniform *nsUniform_new(const char *name, ns_i32 location, ns_u32 type, ns_i32 size);
 
 /**
  * @brief Free uniform.
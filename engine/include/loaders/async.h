@@ -0,0 +1,217 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file loaders/async.h
+ * @brief Asset loading on background threads.
+ * 
+ * File reads, OBJ parsing and image decoding run on worker threads and
+ * requests return their handles right away. Finished CPU data is queued for
+ * the main thread, which creates the GL objects in @ref nsAsyncLoader_upload
+ * under a time budget every frame. Buffers and textures are uploaded in
+ * chunks, so big assets are spread over multiple frames instead of causing a
+ * hitch.
+ */
+#ifndef _NS_ASYNC_H
+#define _NS_ASYNC_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/graphics/mesh.h"
+#include "engine/include/graphics/material.h"
+#include "engine/include/graphics/texture.h"
+#include "engine/include/core/queue.h"
+
+
+/**
+ * @brief Maximum number of worker threads of a loader.
+ */
+#define NS_ASYNC_MAX_WORKERS 8
+
+/**
+ * @brief Default time the main thread spends uploading each frame, in seconds.
+ */
+#define NS_ASYNC_DEFAULT_UPLOAD_BUDGET 0.002
+
+/**
+ * @brief Maximum bytes copied to the GPU in one upload step.
+ */
+#define NS_ASYNC_UPLOAD_CHUNK_SIZE (1024 * 1024)
+
+/**
+ * @brief Kind of asset.
+ */
+typedef enum {
+    nsAssetType_MESH, /**< @ref nsMesh loaded with @ref nsMeshSource_load. */
+    nsAssetType_TEXTURE, /**< @ref nsTexture loaded from an image file. */
+    nsAssetType_MATERIAL /**< @ref nsMaterial compiled from shader source files. */
+} nsAssetType;
+
+/**
+ * @brief Loading progress of an asset.
+ */
+typedef enum {
+    nsAssetState_QUEUED, /**< Waiting for a worker thread. */
+    nsAssetState_LOADING, /**< Being loaded on a worker thread. */
+    nsAssetState_UPLOADING, /**< Waiting for or being uploaded on the main thread. */
+    nsAssetState_READY, /**< Loaded, the result can be used. */
+    nsAssetState_FAILED /**< Loading failed, the reason is in @ref nsAsset.error. */
+} nsAssetState;
+
+/**
+ * @brief Handle of an asset requested from @ref nsAsyncLoader.
+ * 
+ * Handles are owned by the loader and stay valid until it is freed. Once the
+ * asset is ready, the loaded object belongs to the caller.
+ */
+typedef struct nsAsset {
+    nsAssetType type; /**< Asset type. */
+    SDL_atomic_t state; /**< @ref nsAssetState, use @ref nsAsset_get_state to read. */
+    char *filepaths[2]; /**< Source filepaths, the second is only used by materials for the fragment shader. */
+    struct nsAsset *dependency; /**< Asset that has to be ready before this one is uploaded, or `NULL`. */
+
+    nsMesh *mesh; /**< Loaded mesh, `NULL` until ready. */
+    nsTexture *texture; /**< Loaded texture, `NULL` until ready. */
+    nsMaterial *material; /**< Loaded material, `NULL` until ready. */
+    char error[NS_ERROR_BUFFER_SIZE]; /**< Why loading failed, empty unless failed. */
+
+    nsMeshSource _mesh_source;
+    SDL_Surface *_surface;
+    char *_shader_sources[2];
+    nsBufferUpload _uploads[NS_MESH_MAX_UPLOADS];
+    size_t _upload_count;
+    size_t _upload_index;
+    size_t _uploaded_rows;
+    struct nsAsset *_next;
+    struct nsAsset *_next_owned;
+    nsStackNode _loaded_node;
+} nsAsset;
+
+/**
+ * @brief Loads assets on worker threads and uploads them on the main thread.
+ * 
+ * Requests and uploads are only made from the main thread.
+ */
+typedef struct {
+    SDL_Thread *workers[NS_ASYNC_MAX_WORKERS]; /**< Worker threads. */
+    ns_u32 worker_count; /**< Number of worker threads. */
+    SDL_mutex *mutex; /**< Guards the request queue. */
+    SDL_cond *condition; /**< Signaled when requests are queued or the loader quits. */
+    ns_bool quit; /**< Workers exit when set. */
+
+    nsAsset *requests; /**< Assets waiting for a worker, oldest first. */
+    nsAsset *requests_tail; /**< Newest request. */
+    nsIntrusiveStack loaded; /**< Assets loaded on the CPU, pushed by workers without locking. */
+    nsAsset *uploading; /**< Assets being uploaded, only touched by the main thread. */
+    nsAsset *assets; /**< Every requested asset. */
+
+    double upload_budget; /**< Time spent uploading each frame in seconds. */
+} nsAsyncLoader;
+
+/**
+ * @brief Create new asset loader and start its worker threads.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param worker_count Number of worker threads, 0 to use one less than the CPU count
+ * @return nsAsyncLoader *
+ */
+nsAsyncLoader *nsAsyncLoader_new(ns_u32 worker_count);
+
+/**
+ * @brief Stop worker threads and free loader and all asset handles.
+ * 
+ * Objects of assets that aren't ready yet are freed too, so the GL context
+ * has to be current. Ready objects are left to the caller.
+ * 
+ * It's safe to pass `NULL` to this function.
+ * 
+ * @param loader Loader to free
+ */
+void nsAsyncLoader_free(nsAsyncLoader *loader);
+
+/**
+ * @brief Request mesh to be loaded in the background.
+ * 
+ * The mesh is uploaded after its material asset is ready and takes ownership
+ * of the material like @ref nsMesh_load does, so every mesh needs its own
+ * material asset.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param loader Loader
+ * @param material Material asset
+ * @param filepath Mesh filepath
+ * @return nsAsset *
+ */
+nsAsset *nsAsyncLoader_load_mesh(
+    nsAsyncLoader *loader,
+    nsAsset *material,
+    const char *filepath
+);
+
+/**
+ * @brief Request texture to be loaded in the background.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param loader Loader
+ * @param filepath Image filepath
+ * @return nsAsset *
+ */
+nsAsset *nsAsyncLoader_load_texture(nsAsyncLoader *loader, const char *filepath);
+
+/**
+ * @brief Request material to be loaded in the background.
+ * 
+ * Shader sources are read on a worker, compiling has to happen on the main
+ * thread during upload.
+ * 
+ * Returns `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param loader Loader
+ * @param vertex_shader_source_filepath Vertex shader source filepath
+ * @param fragment_shader_source_filepath Fragment shader source filepath
+ * @return nsAsset *
+ */
+nsAsset *nsAsyncLoader_load_material(
+    nsAsyncLoader *loader,
+    const char *vertex_shader_source_filepath,
+    const char *fragment_shader_source_filepath
+);
+
+/**
+ * @brief Create GL objects of loaded assets until the upload budget is spent.
+ * 
+ * Call this once per frame on the thread that owns the GL context. At least
+ * one upload step is done every call, so uploads progress even if a step
+ * takes longer than the budget.
+ * 
+ * @param loader Loader
+ */
+void nsAsyncLoader_upload(nsAsyncLoader *loader);
+
+/**
+ * @brief Get loading progress of asset.
+ * 
+ * @param asset Asset
+ * @return nsAssetState
+ */
+nsAssetState nsAsset_get_state(nsAsset *asset);
+
+/**
+ * @brief Check if asset is loaded and can be used.
+ * 
+ * @param asset Asset
+ * @return ns_bool
+ */
+ns_bool nsAsset_is_ready(nsAsset *asset);
+
+
+#endif
\ No newline at end of file
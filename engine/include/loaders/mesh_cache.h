@@ -0,0 +1,193 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/**
+ * @file loaders/mesh_cache.h
+ * @brief Binary mesh cache (.nsmesh).
+ * 
+ * Parsing text formats like OBJ on every run is slow, so parsed meshes are
+ * baked into a binary file that can be memory mapped and uploaded to the GPU
+ * as is.
+ * 
+ * Layout of the file:
+ * - @ref nsMeshCacheHeader
+ * - Vertex streams, each aligned to @ref NS_MESH_CACHE_ALIGNMENT
+ *   Attributes that share a stream offset are interleaved in that stream.
+ * - Index stream, aligned to @ref NS_MESH_CACHE_ALIGNMENT
+ *   Detail levels are ranges of this stream, full detail level first.
+ * - Meshlet stream, aligned to @ref NS_MESH_CACHE_ALIGNMENT
+ * 
+ * All values are little-endian.
+ */
+#ifndef _NS_MESH_CACHE_H
+#define _NS_MESH_CACHE_H
+
+#include "engine/include/_internal.h"
+#include "engine/include/core/io.h"
+#include "engine/include/loaders/obj.h"
+#include "engine/include/graphics/meshlet.h"
+
+
+#define NS_MESH_CACHE_MAGIC "NSMESH\0\0"
+#define NS_MESH_CACHE_VERSION 5
+#define NS_MESH_CACHE_ALIGNMENT 64
+#define NS_MESH_CACHE_MAX_ATTRIBUTES 8
+
+/**
+ * @brief Positions are normalized into the bounds and need dequantization.
+ */
+#define NS_MESH_CACHE_FLAG_QUANTIZED_POSITIONS 1
+
+/**
+ * @brief Extension appended to the source filepath for cache files.
+ */
+#define NS_MESH_CACHE_EXTENSION ".nsmesh"
+
+/**
+ * @brief Vertex attribute layout descriptor.
+ */
+typedef struct {
+    ns_u32 location; /**< Shader attribute location. */
+    ns_u32 components; /**< Number of components per vertex. */
+    ns_u32 type; /**< GL type of one component. */
+    ns_u32 normalized; /**< Whether integer components are normalized. */
+    ns_u32 stride; /**< Byte stride between vertices in the stream. */
+    ns_u32 offset; /**< Byte offset of the attribute in one vertex. */
+    ns_u64 stream_offset; /**< Byte offset of the stream from the start of the file. */
+} nsMeshCacheAttribute;
+
+/**
+ * @brief Header at the start of every cache file.
+ */
+typedef struct {
+    char magic[8]; /**< Always @ref NS_MESH_CACHE_MAGIC */
+    ns_u32 version; /**< Format version, @ref NS_MESH_CACHE_VERSION */
+    ns_u32 header_size; /**< Size of this header in bytes. */
+
+    ns_u64 source_size; /**< Size of the source file this cache was baked from. */
+    ns_i64 source_mtime; /**< Modification time of the source file. */
+    ns_u64 source_hash; /**< Hash of the source filepath. */
+
+    ns_u32 attribute_count; /**< Number of used attribute descriptors. */
+    ns_u32 flags; /**< NS_MESH_CACHE_FLAG_* bits. */
+    nsMeshCacheAttribute attributes[NS_MESH_CACHE_MAX_ATTRIBUTES]; /**< Vertex layout. */
+
+    float bounds_min[3]; /**< Minimum corner of the bounding box. */
+    float bounds_max[3]; /**< Maximum corner of the bounding box. */
+
+    ns_u64 vertex_count; /**< Number of vertices. */
+    ns_u64 index_count; /**< Number of indices. */
+    ns_u32 index_type; /**< GL type of indices. */
+    ns_u32 _pad1;
+    ns_u64 index_offset; /**< Byte offset of the index stream from the start of the file. */
+
+    ns_u32 lod_count; /**< Number of detail levels, at least 1. */
+    ns_u32 _pad2;
+    nsMeshLOD lods[NS_MESH_MAX_LODS]; /**< Detail levels as ranges of the index stream. */
+
+    ns_u64 meshlet_count; /**< Number of meshlets of all detail levels. */
+    ns_u64 meshlet_offset; /**< Byte offset of the meshlet stream from the start of the file. */
+} nsMeshCacheHeader;
+
+/**
+ * @brief Memory mapped mesh cache file.
+ */
+typedef struct {
+    nsMappedFile file; /**< File mapping. */
+    const nsMeshCacheHeader *header; /**< Header, points into the mapping. */
+} nsMeshCache;
+
+/**
+ * @brief Bake OBJ mesh into a cache file.
+ * 
+ * If source filepath is given, its size and modification time are recorded so
+ * stale caches can be detected later.
+ * 
+ * Quantized caches store @ref nsQuantizedVertex instead of @ref nsOBJVertex
+ * with positions normalized into the bounds.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param filepath Cache filepath to write
+ * @param mesh OBJ mesh
+ * @param source_filepath Source filepath the mesh was loaded from, can be `NULL`
+ * @param quantize Store vertices in quantized form
+ * @return int Status
+ */
+int nsMeshCache_write(
+    const char *filepath,
+    const nsOBJMesh *mesh,
+    const char *source_filepath,
+    ns_bool quantize
+);
+
+/**
+ * @brief Map and validate a cache file.
+ * 
+ * If source filepath is given, the cache is rejected when it was baked from a
+ * different version of the source. Every index is checked against the
+ * vertex count, which reads through the index stream once.
+ * 
+ * Returns non-zero on error or stale cache. Use @ref ns_get_error to get more information.
+ * 
+ * @param cache Cache to initialize
+ * @param filepath Cache filepath
+ * @param source_filepath Source filepath to validate against, can be `NULL`
+ * @return int Status
+ */
+int nsMeshCache_open(
+    nsMeshCache *cache,
+    const char *filepath,
+    const char *source_filepath
+);
+
+/**
+ * @brief Unmap the cache file.
+ * 
+ * @param cache Cache
+ */
+void nsMeshCache_close(nsMeshCache *cache);
+
+/**
+ * @brief Get the pointer to vertex attribute stream.
+ * 
+ * @param cache Cache
+ * @param attribute Attribute index
+ * @return const void *
+ */
+static inline const void *nsMeshCache_get_stream(
+    const nsMeshCache *cache,
+    ns_u32 attribute
+) {
+    return (const char *)cache->file.data + cache->header->attributes[attribute].stream_offset;
+}
+
+/**
+ * @brief Get the pointer to index stream.
+ * 
+ * @param cache Cache
+ * @return const void *
+ */
+static inline const void *nsMeshCache_get_indices(const nsMeshCache *cache) {
+    return (const char *)cache->file.data + cache->header->index_offset;
+}
+
+/**
+ * @brief Get the pointer to meshlet stream.
+ * 
+ * @param cache Cache
+ * @return const nsMeshlet *
+ */
+static inline const nsMeshlet *nsMeshCache_get_meshlets(const nsMeshCache *cache) {
+    return (const nsMeshlet *)((const char *)cache->file.data + cache->header->meshlet_offset);
+}
+
+
+#endif
\ No newline at end of file
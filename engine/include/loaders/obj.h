@@ -21,53 +21,90 @@
 #include "engine/include/_internal.h"
 #include "engine/include/math/vector.h"
 #include "engine/include/core/pool.h"
+#include "engine/include/graphics/lod.h"
 
 
 /**
- * @brief Face definition with property IDs in OBJ file.
+ * @brief Unique vertex of the mesh, combination of one v/vt/vn triple.
+ */
+typedef struct {
+    nsVector3 position;
+    nsVector3 normal;
+    nsVector2 uv;
+} nsOBJVertex;
+
+/**
+ * @brief Indexed triangular mesh geometry defined in OBJ file.
  * 
- * f v/n/uv ...
+ * Every unique v/vt/vn triple referenced by faces is stored once in
+ * `vertices`, triangles refer to them with 3 consecutive `indices`.
+ * 
+ * If detail levels are generated, their index ranges are appended to
+ * `indices` after the full detail triangles.
  */
 typedef struct {
-    long vertex_ids[3];
-    long normal_ids[3];
-    long uv_ids[3];
-} nsOBJFace;
+    nsPool *vertices; /**< Pool of nsOBJVertex. */
+    nsPool *indices; /**< Pool of ns_u32, 3 per triangle. */
+    nsMeshLOD lods[NS_MESH_MAX_LODS]; /**< Detail levels, finest first. */
+    ns_u32 lod_count; /**< Number of detail levels, 0 if none were generated. */
+    nsPool *meshlets; /**< Pool of nsMeshlet, `NULL` if meshlets weren't built. */
+} nsOBJMesh;
 
 /**
- * @brief Simple triangle face.
+ * @brief Type representing loaded Wavefront OBJ file.
  */
 typedef struct {
-    nsVector3 vertices[3];
-    nsVector3 normals[3];
-    nsVector2 uvs[3];
-} nsOBJTri;
+    nsOBJMesh mesh;
+} nsOBJ;
+
+/**
+ * @brief Minimum amount of bytes a single parsing thread works on.
+ * 
+ * Sources smaller than this are always parsed on the calling thread.
+ */
+#define NS_OBJ_MIN_CHUNK_SIZE (1024 * 1024)
 
 /**
- * @brief Triangular mesh geometry defined in OBJ file.
+ * @brief Maximum number of threads the loader can split the parsing on.
+ */
+#define NS_OBJ_MAX_THREADS 64
+
+/**
+ * @brief Default size of the rolling read buffer of @ref nsOBJ_load_stream
+ */
+#define NS_OBJ_STREAM_BUFFER_SIZE (4 * 1024 * 1024)
+
+/**
+ * @brief Timing and memory statistics of one OBJ load.
  */
 typedef struct {
-    nsPool *tris;
-} nsOBJMesh;
+    double prescan_time; /**< Seconds spent counting records, slowest chunk. */
+    double parse_time; /**< Seconds spent parsing, slowest chunk. */
+    double build_time; /**< Seconds spent resolving stored faces after parsing, 0 if they were resolved while parsing. */
+    size_t realloc_count; /**< Number of pool reallocations while loading, on all threads. */
+    size_t realloc_bytes; /**< Size of the reallocated blocks, the most realloc had to copy. */
+    double realloc_time; /**< Seconds spent reallocating, summed over all threads. */
+    size_t pool_memory; /**< Heap memory of the parsing pools after parsing. */
+} nsOBJLoadStats;
 
 /**
- * @brief Type representing loaded Wavefront OBJ file.
+ * @brief Options to control how the OBJ loader works.
  */
 typedef struct {
-    /*
-        Temporary state used by the loader.
-    */
-    char *current;
-    nsPool *vertices;
-    nsPool *normals;
-    nsPool *uvs;
-    nsPool *faces;
-    
-    /*
-        Public members.
-    */
-    nsOBJMesh mesh;
-} nsOBJ;
+    ns_u32 thread_count; /**< Number of threads to parse on, 0 picks it from the CPU count.
+                              1 parses on the calling thread only. */
+    ns_bool prescan; /**< Count records before parsing and allocate pools at exact capacity. */
+    nsOBJLoadStats *stats; /**< Statistics output, can be `NULL`. */
+} nsOBJLoadOptions;
+
+/**
+ * @brief Default loader options.
+ */
+static const nsOBJLoadOptions nsOBJLoadOptions_default = {
+    0,
+    true,
+    NULL
+};
 
 /**
  * @brief Load OBJ from source null-terminated string.
@@ -77,13 +114,74 @@ typedef struct {
  */
 nsOBJ nsOBJ_load_raw(char *source);
 
+/**
+ * @brief Load OBJ from source string with more control than @ref nsOBJ_load_raw
+ * 
+ * The source is split on line boundaries into chunks that are parsed
+ * concurrently and then merged, the output is identical to single-threaded
+ * parsing.
+ * 
+ * Parsed on one thread, faces are resolved into interleaved vertices and
+ * indices as they are parsed and never stored. Faces of several chunks can
+ * refer to attributes of other chunks, so they are stored as compact v/vt/vn
+ * triples until every chunk is parsed.
+ * 
+ * @param source OBJ content
+ * @param length Length of the content in bytes
+ * @param options Loader options
+ * @return nsOBJ 
+ */
+nsOBJ nsOBJ_load_raw_ex(
+    const char *source,
+    size_t length,
+    nsOBJLoadOptions options
+);
+
 /**
  * @brief Load OBJ from file.
  * 
+ * Mesh pools are `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
  * @param filepath 
  * @return nsOBJ 
  */
 nsOBJ nsOBJ_load(const char *filepath);
 
+/**
+ * @brief Load OBJ from file with more control than @ref nsOBJ_load
+ * 
+ * @param filepath Filepath
+ * @param options Loader options
+ * @return nsOBJ 
+ */
+nsOBJ nsOBJ_load_ex(const char *filepath, nsOBJLoadOptions options);
+
+/**
+ * @brief Load OBJ from file by streaming it through a fixed-size buffer.
+ * 
+ * Unlike @ref nsOBJ_load the whole file is never held in memory, the buffer is
+ * refilled on line boundaries and parsed on the calling thread. Faces are
+ * resolved into the output as each window is parsed and never stored. Peak
+ * memory is the buffer, the output, the vertex dedup table and the v/vn/vt
+ * records, which faces can refer to until the end of the file. This is
+ * suitable for files of any size, including ones larger than 2 GB.
+ * 
+ * The buffer only grows if a single line doesn't fit in it.
+ * 
+ * Mesh pools are `NULL` on error. Use @ref ns_get_error to get more information.
+ * 
+ * @param filepath Filepath
+ * @param buffer_size Size of the read buffer in bytes, 0 uses @ref NS_OBJ_STREAM_BUFFER_SIZE
+ * @return nsOBJ 
+ */
+nsOBJ nsOBJ_load_stream(const char *filepath, size_t buffer_size);
+
+/**
+ * @brief Free the mesh data of the loaded OBJ.
+ * 
+ * @param obj OBJ
+ */
+void nsOBJ_free(nsOBJ *obj);
+
 
 #endif
\ No newline at end of file
@@ -45,6 +45,7 @@ static inline float ns_clamp(float value, float min, float max) {
 #define ns_sin sinf
 #define ns_cos cosf
 #define ns_tan tanf
+#define ns_fabs fabsf
 
 
 #endif
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "engine/include/math/transform.h"
 #include "engine/include/graphics/mesh.h"
 #include "engine/include/graphics/material.h"
+#include "engine/include/scene/camera.h"
 
 
 /**
@@ -28,6 +29,8 @@ typedef struct {
     nsTransform xform;
     nsMatrix4 xform_mat;
     nsMesh *mesh;
+    ns_u32 lod; /**< Currently selected detail level of the mesh. */
+    float lod_threshold; /**< Projected error allowed as a fraction of the screen height. */
 } nsModel;
 
 /**
@@ -60,7 +63,27 @@ void nsModel_set_scale(nsModel *model, nsVector3 scale);
 
 nsVector3 nsModel_get_scale(nsModel *model);
 
+/**
+ * @brief Render model with the full detail level of its mesh.
+ * 
+ * @param model Model
+ */
 void nsModel_render(nsModel *model);
 
+/**
+ * @brief Render model with the detail level selected for the camera.
+ * 
+ * The coarsest level whose error projects under the model's LOD threshold
+ * from the camera is selected, with hysteresis against the previous
+ * selection. See @ref ns_select_lod
+ * 
+ * Models outside the camera frustum are skipped, and meshes split into
+ * meshlets only draw the visible ones. See @ref nsMesh_render_culled
+ * 
+ * @param model Model
+ * @param camera Perspective camera the model is rendered with
+ */
+void nsModel_render_ex(nsModel *model, const nsCamera *camera);
+
 
 #endif
\ No newline at end of file
@@ -16,9 +16,15 @@
 #include "engine/include/graphics/mesh.h"
 #include "engine/include/graphics/buffer.h"
 #include "engine/include/graphics/texture.h"
+#include "engine/include/graphics/gpu_profiler.h"
 #include "engine/include/model/model.h"
 #include "engine/include/loaders/obj.h"
+#include "engine/include/loaders/async.h"
 #include "engine/include/core/pool.h"
+#include "engine/include/core/arena.h"
+#include "engine/include/core/object_pool.h"
+#include "engine/include/core/string_id.h"
+#include "engine/include/core/jobs.h"
 #include "engine/include/core/profiler.h"
 #include "engine/include/scene/camera.h"
 
@@ -28,20 +34,109 @@
 #include "nuklear/nuklear_sdl_gl3.h"
 
 
+// Frames captured when F2 is pressed in profiling builds
+#define PROFILER_CAPTURE_FRAMES 300
+#define PROFILER_CAPTURE_FILEPATH "nsprofile.json"
+
+#define FRAME_STATS_WIDTH 300.0f
+#define FRAME_STATS_HEIGHT 330.0f
+
+
 nsApp *ns_global_app = NULL;
 
 
+static void *ui_alloc(nk_handle handle, void *old, nk_size size) {
+    (void)handle;
+    (void)old;
+    return ns_alloc(size, nsMemoryTag_UI);
+}
+
+static void ui_free(nk_handle handle, void *ptr) {
+    (void)handle;
+    ns_free(ptr);
+}
+
+
+static void draw_frame_stats(nsApp *app) {
+    struct nk_context *ui_ctx = app->ui_ctx;
+    nsFrameStatsSummary summary = nsFrameStats_summarize(&app->frame_stats);
+
+    int window_width, window_height;
+    SDL_GetWindowSize(app->window, &window_width, &window_height);
+
+    struct nk_rect bounds = nk_rect(
+        (float)window_width - FRAME_STATS_WIDTH, 0.0f,
+        FRAME_STATS_WIDTH, FRAME_STATS_HEIGHT
+    );
+
+    if (nk_begin(ui_ctx, "Frame Stats", bounds, NK_WINDOW_TITLE | NK_WINDOW_MOVABLE | NK_WINDOW_NO_SCROLLBAR)) {
+        nk_layout_row_dynamic(ui_ctx, 16, 1);
+        nk_labelf(
+            ui_ctx, NK_TEXT_LEFT, "avg %.2f ms  (%.1f FPS)",
+            summary.average.frame * 1000.0,
+            summary.average.frame > 0.0 ? 1.0 / summary.average.frame : 0.0
+        );
+        nk_labelf(
+            ui_ctx, NK_TEXT_LEFT, "p50 %.2f  p95 %.2f  p99 %.2f ms",
+            summary.p50 * 1000.0, summary.p95 * 1000.0, summary.p99 * 1000.0
+        );
+        nk_labelf(
+            ui_ctx, NK_TEXT_LEFT, "max %.2f ms  hitches %zu/%zu",
+            summary.max * 1000.0, summary.hitches, summary.frames
+        );
+        nk_labelf(
+            ui_ctx, NK_TEXT_LEFT, "input %.2f  render %.2f  ui %.2f  swap %.2f",
+            summary.average.input * 1000.0, summary.average.render * 1000.0,
+            summary.average.ui * 1000.0, summary.average.swap * 1000.0
+        );
+        if (summary.gpu_frames > 0) {
+            nk_labelf(
+                ui_ctx, NK_TEXT_LEFT, "gpu %.2f ms  over %zu/%zu",
+                summary.average.gpu * 1000.0, summary.gpu_frames, summary.frames
+            );
+        }
+        else {
+            nk_label(ui_ctx, "gpu waiting for results", NK_TEXT_LEFT);
+        }
+
+        // Outermost passes of the latest frame the GPU finished
+        size_t gpu_zone_count;
+        const nsGPUZone *gpu_zones = ns_gpu_profiler_get_zones(&gpu_zone_count);
+        for (size_t i = 0; i < gpu_zone_count; i++) {
+            if (gpu_zones[i].depth > 0) continue;
+            nk_labelf(ui_ctx, NK_TEXT_LEFT, "  %s %.3f ms", gpu_zones[i].name, gpu_zones[i].duration * 1000.0);
+        }
+
+        // Scale so the median sits in the lower half and spikes stand out
+        float scale = (float)fmax(summary.max, summary.p50 * 2.0) * 1000.0f;
+
+        nk_layout_row_dynamic(ui_ctx, 100, 1);
+        if (app->frame_stats.count > 0 && nk_chart_begin(ui_ctx, NK_CHART_LINES, (int)app->frame_stats.count, 0.0f, scale)) {
+            for (size_t i = 0; i < app->frame_stats.count; i++) {
+                nk_chart_push(ui_ctx, (float)(nsFrameStats_get(&app->frame_stats, i)->frame * 1000.0));
+            }
+            nk_chart_end(ui_ctx);
+        }
+    }
+    nk_end(ui_ctx);
+}
+
+
 nsApp *nsApp_new(nsAppDefinition app_def) {
     // There can only be one app instance.
     if (ns_global_app) {
         return ns_global_app;
     }
 
+    ns_timer_calibrate();
+
     nsApp *app = NS_NEW(nsApp);
     NS_MEM_CHECK(app);
 
     app->app_def = app_def;
     app->is_running = false;
+    app->show_frame_stats = false;
+    nsFrameStats_reset(&app->frame_stats);
 
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
         ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_FATAL);
@@ -97,6 +192,25 @@ nsApp *nsApp_new(nsAppDefinition app_def) {
 
     SDL_GL_SetSwapInterval(app_def.vsync);
 
+    app->loader = nsAsyncLoader_new(0);
+    if (!app->loader) {
+        SDL_GL_DeleteContext(app->gl_ctx);
+        SDL_DestroyWindow(app->window);
+        IMG_Quit();
+        SDL_Quit();
+        return NULL;
+    }
+
+    app->jobs = nsJobSystem_new(0);
+    if (!app->jobs) {
+        nsAsyncLoader_free(app->loader);
+        SDL_GL_DeleteContext(app->gl_ctx);
+        SDL_DestroyWindow(app->window);
+        IMG_Quit();
+        SDL_Quit();
+        return NULL;
+    }
+
     ns_global_app = app;
     return app;
 }
@@ -110,6 +224,18 @@ void nsApp_free(nsApp *app) {
         app->current_scene->on_free(app->current_scene);
     }
 
+    nsJobSystem_free(app->jobs);
+    nsAsyncLoader_free(app->loader);
+
+    // Worker threads are gone, nothing records zones anymore
+    ns_free_profiler();
+    ns_free_gpu_profiler();
+    ns_free_object_pools();
+
+    ns_free_frame_arena();
+    ns_free_scratch_arena();
+    ns_free_string_ids();
+
     nk_sdl_shutdown();
     SDL_GL_DeleteContext(app->gl_ctx);
     SDL_DestroyWindow(app->window);
@@ -155,6 +281,10 @@ GLVersionInfo fetch_opengl_version() {
 }
 
 void nsApp_run(nsApp *app) {
+    // Route Nuklear memory through the UI allocator
+    struct nk_allocator ui_allocator = {.userdata = nk_handle_ptr(NULL), .alloc = ui_alloc, .free = ui_free};
+    nk_sdl_set_allocator(&ui_allocator);
+
     app->ui_ctx = nk_sdl_init(app->window);
     struct nk_font_atlas *atlas;
     nk_sdl_font_stash_begin(&atlas);
@@ -163,23 +293,59 @@ void nsApp_run(nsApp *app) {
     nk_sdl_font_stash_end();
     nk_style_set_font(app->ui_ctx, &font->handle);
 
+    NS_PROFILE_THREAD("Main");
+
     // Initialize all scenes
     // TODO: resource manager shenanigans...
     // for scene in app.scenes: scene.on_ready()
     if (app->current_scene->on_ready) {
+        NS_PROFILE_ZONE_BEGIN("Scene on_ready");
         app->current_scene->on_ready(app->current_scene);
+        NS_PROFILE_ZONE_END();
     }
 
     // Reset all scenes
     // for scene in app.scenes: scene.on_ready()
     if (app->current_scene->on_reset) {
+        NS_PROFILE_ZONE_BEGIN("Scene on_reset");
         app->current_scene->on_reset(app->current_scene);
+        NS_PROFILE_ZONE_END();
     }
 
+    #ifdef NS_PROFILER_ENABLE
+
+    ns_bool save_capture = false;
+
+    #endif
+
     app->is_running = true;
     while (app->is_running) {
-        // TODO: clock tick
+        nsProfiler timings;
+        ns_u64 frame_start = ns_ticks();
+        ns_u64 part_start;
 
+        NS_PROFILE_FRAME();
+
+        // GPU timings are only needed while someone looks at them
+        ns_gpu_profiler_set_enabled(app->show_frame_stats || ns_profiler_is_capturing());
+        ns_gpu_profiler_frame();
+
+        #ifdef NS_PROFILER_ENABLE
+
+        if (save_capture && !ns_profiler_is_capturing()) {
+            if (!ns_profiler_save_capture(PROFILER_CAPTURE_FILEPATH)) {
+                ns_log("Saved profiler capture to " PROFILER_CAPTURE_FILEPATH ".", nsErrorSeverity_INFO);
+            }
+            save_capture = false;
+        }
+
+        #endif
+
+        // Per-frame temporaries of two frames ago are released here
+        ns_swap_frame_arena();
+
+        NS_PROFILE_ZONE_BEGIN("Events");
+        part_start = ns_ticks();
         nk_input_begin(app->ui_ctx);
         SDL_Event event;
         while (SDL_PollEvent(&event) != 0) {
@@ -191,6 +357,19 @@ void nsApp_run(nsApp *app) {
                 if (event.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
                     nsApp_stop(app);
                 }
+
+                #ifdef NS_PROFILER_ENABLE
+
+                else if (event.key.keysym.scancode == SDL_SCANCODE_F2 && !ns_profiler_is_capturing()) {
+                    ns_profiler_start_capture(PROFILER_CAPTURE_FRAMES);
+                    save_capture = true;
+                }
+
+                #endif
+
+                else if (event.key.keysym.scancode == SDL_SCANCODE_F3) {
+                    app->show_frame_stats = !app->show_frame_stats;
+                }
             }
 
             else if (event.type == SDL_WINDOWEVENT) {
@@ -206,6 +385,11 @@ void nsApp_run(nsApp *app) {
         }
         nk_sdl_handle_grab();
         nk_input_end(app->ui_ctx);
+        timings.input = ns_ticks_to_seconds(ns_ticks() - part_start);
+        NS_PROFILE_ZONE_END();
+
+        // Finish background loads before the scene looks at them
+        nsAsyncLoader_upload(app->loader);
 
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glEnable(GL_BLEND);
@@ -215,15 +399,37 @@ void nsApp_run(nsApp *app) {
         glClear(GL_COLOR_BUFFER_BIT);
         glClear(GL_DEPTH_BUFFER_BIT);
 
+        NS_PROFILE_ZONE_BEGIN("Scene on_render");
+        part_start = ns_ticks();
+        ns_gpu_profiler_begin_zone("Scene on_render");
         app->current_scene->on_render(app->current_scene);
-
+        ns_gpu_profiler_end_zone();
+        timings.render = ns_ticks_to_seconds(ns_ticks() - part_start);
+        NS_PROFILE_ZONE_END();
+
+        NS_PROFILE_ZONE_BEGIN("UI render");
+        part_start = ns_ticks();
+        if (app->show_frame_stats) draw_frame_stats(app);
+        ns_gpu_profiler_begin_zone("UI render");
         nk_sdl_render(
             NK_ANTI_ALIASING_ON,
             100 * 1024,
             25 * 1024
         );
+        ns_gpu_profiler_end_zone();
+        timings.ui = ns_ticks_to_seconds(ns_ticks() - part_start);
+        NS_PROFILE_ZONE_END();
 
+        NS_PROFILE_ZONE_BEGIN("Swap");
+        part_start = ns_ticks();
         SDL_GL_SwapWindow(app->window);
+        timings.swap = ns_ticks_to_seconds(ns_ticks() - part_start);
+        NS_PROFILE_ZONE_END();
+
+        timings.gpu = ns_gpu_profiler_get_frame_time();
+        timings.gpu_valid = ns_gpu_profiler_has_frame_time();
+        timings.frame = ns_ticks_to_seconds(ns_ticks() - frame_start);
+        nsFrameStats_push(&app->frame_stats, &timings);
     }
 }
 
@@ -0,0 +1,235 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include "engine/include/_internal.h"
+#include "engine/include/core/allocator.h"
+
+
+/**
+ * @brief Stored in front of every block so frees know the size and tag.
+ * 
+ * Padded to 16 bytes so the memory after it keeps the allocator's alignment.
+ */
+typedef union {
+    struct {
+        size_t size;
+        nsMemoryTag tag;
+    } info;
+    char _align[16];
+} AllocationHeader;
+
+typedef struct {
+    nsAllocator allocator; /**< Allocator of the tag, callbacks are NULL for the standard library. */
+    nsMemoryStats stats;
+    SDL_SpinLock lock; /**< Guards stats, allocations come from worker threads too. */
+} TagState;
+
+static TagState tag_states[nsMemoryTag_COUNT];
+
+
+static void *std_alloc(void *user_data, size_t size) {
+    (void)user_data;
+    return malloc(size);
+}
+
+static void *std_realloc(void *user_data, void *ptr, size_t old_size, size_t new_size) {
+    (void)user_data;
+    (void)old_size;
+    return realloc(ptr, new_size);
+}
+
+static void std_free(void *user_data, void *ptr, size_t size) {
+    (void)user_data;
+    (void)size;
+    free(ptr);
+}
+
+static const nsAllocator std_allocator = {
+    .alloc = std_alloc,
+    .realloc = std_realloc,
+    .free = std_free,
+    .user_data = NULL
+};
+
+static inline const nsAllocator *get_allocator(nsMemoryTag tag) {
+    const nsAllocator *allocator = &tag_states[tag].allocator;
+    return allocator->alloc ? allocator : &std_allocator;
+}
+
+static inline AllocationHeader *get_header(void *ptr) {
+    return (AllocationHeader *)ptr - 1;
+}
+
+static inline void account(nsMemoryTag tag, size_t allocated, size_t freed, size_t *counter) {
+    TagState *state = &tag_states[tag];
+
+    SDL_AtomicLock(&state->lock);
+
+    state->stats.live_bytes += allocated;
+    state->stats.live_bytes -= freed;
+    if (state->stats.live_bytes > state->stats.peak_bytes) {
+        state->stats.peak_bytes = state->stats.live_bytes;
+    }
+    (*counter)++;
+
+    SDL_AtomicUnlock(&state->lock);
+}
+
+
+static inline ns_bool has_live_allocations(const TagState *state) {
+    return state->stats.alloc_count != state->stats.free_count;
+}
+
+static int check_callbacks(const nsAllocator *allocator) {
+    if (allocator && (!allocator->alloc || !allocator->realloc || !allocator->free)) {
+        ns_throw_error("Allocator is missing callbacks.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int ns_set_allocator(nsMemoryTag tag, const nsAllocator *allocator) {
+    if (check_callbacks(allocator)) return 1;
+
+    TagState *state = &tag_states[tag];
+
+    SDL_AtomicLock(&state->lock);
+    ns_bool live = has_live_allocations(state);
+    if (!live) {
+        if (allocator) state->allocator = *allocator;
+        else state->allocator = (nsAllocator){0};
+    }
+    SDL_AtomicUnlock(&state->lock);
+
+    if (live) {
+        ns_throw_error("Can't change the allocator of a tag that has live allocations.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    return 0;
+}
+
+int ns_set_global_allocator(const nsAllocator *allocator) {
+    if (check_callbacks(allocator)) return 1;
+
+    /*
+        Either every tag switches or none does, a mix would split the engine
+        across allocators. Locks are always taken in tag order and account()
+        holds only one at a time, so this can't deadlock.
+    */
+    for (int tag = 0; tag < nsMemoryTag_COUNT; tag++) {
+        SDL_AtomicLock(&tag_states[tag].lock);
+    }
+
+    ns_bool live = false;
+    for (int tag = 0; tag < nsMemoryTag_COUNT; tag++) {
+        if (has_live_allocations(&tag_states[tag])) live = true;
+    }
+
+    if (!live) {
+        for (int tag = 0; tag < nsMemoryTag_COUNT; tag++) {
+            if (allocator) tag_states[tag].allocator = *allocator;
+            else tag_states[tag].allocator = (nsAllocator){0};
+        }
+    }
+
+    for (int tag = nsMemoryTag_COUNT - 1; tag >= 0; tag--) {
+        SDL_AtomicUnlock(&tag_states[tag].lock);
+    }
+
+    if (live) {
+        ns_throw_error("Can't change the allocator of tags that have live allocations.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    return 0;
+}
+
+const nsAllocator *ns_get_allocator(nsMemoryTag tag) {
+    return get_allocator(tag);
+}
+
+nsMemoryStats ns_get_memory_stats(nsMemoryTag tag) {
+    TagState *state = &tag_states[tag];
+
+    SDL_AtomicLock(&state->lock);
+    nsMemoryStats stats = state->stats;
+    SDL_AtomicUnlock(&state->lock);
+
+    return stats;
+}
+
+void *ns_alloc(size_t size, nsMemoryTag tag) {
+    const nsAllocator *allocator = get_allocator(tag);
+
+    AllocationHeader *header = allocator->alloc(allocator->user_data, sizeof(AllocationHeader) + size);
+    if (!header) return NULL;
+
+    header->info.size = size;
+    header->info.tag = tag;
+    account(tag, size, 0, &tag_states[tag].stats.alloc_count);
+
+    void *ptr = header + 1;
+
+    #ifdef TRACY_ENABLE
+        TracyCAlloc(ptr, size);
+    #endif
+
+    return ptr;
+}
+
+void *ns_realloc(void *ptr, size_t size, nsMemoryTag tag) {
+    if (!ptr) return ns_alloc(size, tag);
+
+    AllocationHeader *header = get_header(ptr);
+    size_t old_size = header->info.size;
+    tag = header->info.tag;
+
+    const nsAllocator *allocator = get_allocator(tag);
+
+    AllocationHeader *new_header = allocator->realloc(
+        allocator->user_data,
+        header,
+        sizeof(AllocationHeader) + old_size,
+        sizeof(AllocationHeader) + size
+    );
+    if (!new_header) return NULL;
+
+    new_header->info.size = size;
+    account(tag, size, old_size, &tag_states[tag].stats.realloc_count);
+
+    void *new_ptr = new_header + 1;
+
+    #ifdef TRACY_ENABLE
+        TracyCFree(ptr);
+        TracyCAlloc(new_ptr, size);
+    #endif
+
+    return new_ptr;
+}
+
+void ns_free(void *ptr) {
+    if (!ptr) return;
+
+    #ifdef TRACY_ENABLE
+        TracyCFree(ptr);
+    #endif
+
+    AllocationHeader *header = get_header(ptr);
+    size_t size = header->info.size;
+    nsMemoryTag tag = header->info.tag;
+
+    account(tag, 0, size, &tag_states[tag].stats.free_count);
+
+    const nsAllocator *allocator = get_allocator(tag);
+    allocator->free(allocator->user_data, header, sizeof(AllocationHeader) + size);
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_ARENAS
+
+#include "engine/include/core/arena.h"
+
+
+#define ALIGN_UP(size) (((size) + (NS_ARENA_ALIGNMENT - 1)) & ~((size_t)NS_ARENA_ALIGNMENT - 1))
+
+// Block header is padded so the data after it stays aligned
+#define BLOCK_HEADER_SIZE ALIGN_UP(sizeof(nsArenaBlock))
+
+static NS_THREAD_LOCAL nsArena scratch_arena;
+
+static nsArena frame_arenas[2];
+static ns_u32 frame_index = 0;
+
+
+static inline char *block_data(nsArenaBlock *block) {
+    return (char *)block + BLOCK_HEADER_SIZE;
+}
+
+
+void nsArena_init(nsArena *arena, size_t block_size) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size > 0 ? block_size : NS_ARENA_DEFAULT_BLOCK_SIZE;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->reserved = 0;
+}
+
+void nsArena_free(nsArena *arena) {
+    nsArenaBlock *block = arena->first;
+    while (block) {
+        nsArenaBlock *next = block->next;
+        NS_FREE(block);
+        block = next;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+    arena->reserved = 0;
+}
+
+void *nsArena_alloc(nsArena *arena, size_t size) {
+    size = ALIGN_UP(size);
+
+    nsArenaBlock *block = arena->current;
+
+    // Blocks after the current one are left over from a rewind and unused
+    while (block && block->capacity - block->used < size && block->next) {
+        block = block->next;
+        block->used = 0;
+    }
+
+    if (!block || block->capacity - block->used < size) {
+        size_t block_size = arena->block_size > 0 ? arena->block_size : NS_ARENA_DEFAULT_BLOCK_SIZE;
+        size_t capacity = size > block_size ? size : block_size;
+
+        nsArenaBlock *new_block = NS_MALLOC(BLOCK_HEADER_SIZE + capacity);
+        NS_MEM_CHECK(new_block);
+
+        new_block->next = NULL;
+        new_block->capacity = capacity;
+        new_block->used = 0;
+
+        if (block) block->next = new_block;
+        else arena->first = new_block;
+
+        arena->reserved += capacity;
+        block = new_block;
+    }
+
+    arena->current = block;
+
+    void *ptr = block_data(block) + block->used;
+    block->used += size;
+
+    arena->used += size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+
+    return ptr;
+}
+
+nsArenaMark nsArena_mark(const nsArena *arena) {
+    return (nsArenaMark){
+        .block = arena->current,
+        .offset = arena->current ? arena->current->used : 0,
+        .used = arena->used
+    };
+}
+
+void nsArena_rewind(nsArena *arena, nsArenaMark mark) {
+    // Mark taken before the first allocation rewinds to the start
+    if (!mark.block) {
+        nsArena_reset(arena);
+        return;
+    }
+
+    arena->current = mark.block;
+    arena->current->used = mark.offset;
+    arena->used = mark.used;
+}
+
+void nsArena_reset(nsArena *arena) {
+    arena->current = arena->first;
+    if (arena->current) arena->current->used = 0;
+    arena->used = 0;
+}
+
+void nsArena_trim(nsArena *arena, size_t retain) {
+    if (!arena->current) return;
+
+    /*
+        A block that grew for one big allocation is released once it's empty,
+        even if it's the current or the first one. Otherwise the block of the
+        first big allocation would stay for the life of the arena.
+    */
+    size_t block_size = arena->block_size > 0 ? arena->block_size : NS_ARENA_DEFAULT_BLOCK_SIZE;
+    nsArenaBlock *oversized = arena->current;
+
+    if (oversized->used == 0 && oversized->capacity > block_size) {
+        nsArenaBlock *prev = NULL;
+        for (nsArenaBlock *block = arena->first; block != oversized; block = block->next) prev = block;
+
+        nsArenaBlock *next = oversized->next;
+        if (prev) prev->next = next;
+        else arena->first = next;
+
+        arena->reserved -= oversized->capacity;
+        NS_FREE(oversized);
+
+        // Allocations continue after the previous block, or from the start
+        if (prev) {
+            arena->current = prev;
+        }
+        else {
+            arena->current = next;
+            if (next) next->used = 0;
+        }
+
+        if (!arena->current) return;
+    }
+
+    size_t unused = 0;
+    nsArenaBlock *prev = arena->current;
+    nsArenaBlock *block = prev->next;
+
+    while (block) {
+        nsArenaBlock *next = block->next;
+
+        if (unused + block->capacity > retain) {
+            prev->next = next;
+            arena->reserved -= block->capacity;
+            NS_FREE(block);
+        }
+        else {
+            unused += block->capacity;
+            prev = block;
+        }
+
+        block = next;
+    }
+}
+
+
+nsArena *ns_get_scratch_arena() {
+    return &scratch_arena;
+}
+
+void ns_free_scratch_arena() {
+    nsArena_free(&scratch_arena);
+}
+
+nsArena *ns_get_frame_arena() {
+    return &frame_arenas[frame_index];
+}
+
+void ns_swap_frame_arena() {
+    frame_index ^= 1;
+    nsArena_reset(&frame_arenas[frame_index]);
+}
+
+void ns_free_frame_arena() {
+    nsArena_free(&frame_arenas[0]);
+    nsArena_free(&frame_arenas[1]);
+}
\ No newline at end of file
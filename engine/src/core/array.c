@@ -8,6 +8,8 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
 #include "engine/include/core/array.h"
 
 
@@ -11,7 +11,7 @@
 #include "engine/include/core/error.h"
 
 
-nsError _ns_global_error = {
+NS_THREAD_LOCAL nsError _ns_global_error = {
     .message = "",
     .code = 0,
     .severity = nsErrorSeverity_INFO
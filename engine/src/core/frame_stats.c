@@ -0,0 +1,101 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include <math.h>
+#include "engine/include/core/frame_stats.h"
+
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile of sorted values.
+ */
+static double percentile(const double *sorted, size_t count, double p) {
+    size_t rank = (size_t)ceil(p * (double)count);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+
+void nsFrameStats_reset(nsFrameStats *stats) {
+    stats->count = 0;
+    stats->total_frames = 0;
+    stats->_next = 0;
+}
+
+void nsFrameStats_push(nsFrameStats *stats, const nsProfiler *sample) {
+    stats->samples[stats->_next] = *sample;
+    stats->_next = (stats->_next + 1) % NS_FRAME_STATS_WINDOW;
+
+    if (stats->count < NS_FRAME_STATS_WINDOW) stats->count++;
+    stats->total_frames++;
+}
+
+const nsProfiler *nsFrameStats_get(const nsFrameStats *stats, size_t index) {
+    size_t oldest = (stats->_next + NS_FRAME_STATS_WINDOW - stats->count) % NS_FRAME_STATS_WINDOW;
+    return &stats->samples[(oldest + index) % NS_FRAME_STATS_WINDOW];
+}
+
+nsFrameStatsSummary nsFrameStats_summarize(const nsFrameStats *stats) {
+    nsFrameStatsSummary summary = {0};
+    summary.frames = stats->count;
+    if (stats->count == 0) return summary;
+
+    double sorted[NS_FRAME_STATS_WINDOW];
+
+    for (size_t i = 0; i < stats->count; i++) {
+        const nsProfiler *sample = &stats->samples[i];
+
+        summary.average.frame += sample->frame;
+        summary.average.input += sample->input;
+        summary.average.render += sample->render;
+        summary.average.ui += sample->ui;
+        summary.average.swap += sample->swap;
+
+        // Frames recorded while the GPU profiler was off would pull the average down
+        if (sample->gpu_valid) {
+            summary.average.gpu += sample->gpu;
+            summary.gpu_frames++;
+        }
+
+        sorted[i] = sample->frame;
+    }
+
+    double n = (double)stats->count;
+    summary.average.frame /= n;
+    summary.average.input /= n;
+    summary.average.render /= n;
+    summary.average.ui /= n;
+    summary.average.swap /= n;
+
+    if (summary.gpu_frames > 0) {
+        summary.average.gpu /= (double)summary.gpu_frames;
+        summary.average.gpu_valid = true;
+    }
+
+    qsort(sorted, stats->count, sizeof(double), compare_double);
+
+    summary.p50 = percentile(sorted, stats->count, 0.50);
+    summary.p95 = percentile(sorted, stats->count, 0.95);
+    summary.p99 = percentile(sorted, stats->count, 0.99);
+    summary.max = sorted[stats->count - 1];
+
+    double hitch_time = summary.p50 * NS_FRAME_STATS_HITCH_FACTOR;
+    for (size_t i = stats->count; i > 0; i--) {
+        if (sorted[i - 1] <= hitch_time) break;
+        summary.hitches++;
+    }
+
+    return summary;
+}
\ No newline at end of file
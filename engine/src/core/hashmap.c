@@ -0,0 +1,371 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
+#include "engine/include/core/hashmap.h"
+
+#if NS_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+// Control bytes of full slots are the low 7 hash bits, so they never have the high bit set
+#define CTRL_EMPTY ((ns_u8)0x80)
+#define CTRL_DELETED ((ns_u8)0xFE)
+
+#define ALIGN_UP(size) (((size) + 15) & ~(size_t)15)
+
+#define HASH_MUL 0xc6a4a7935bd1e995ULL
+
+static const size_t NOT_FOUND = (size_t)-1;
+
+
+static inline int count_trailing_zeros(ns_u32 value) {
+    #if NS_COMPILER == NS_COMPILER_MSVC
+
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int)index;
+
+    #else
+
+    return __builtin_ctz(value);
+
+    #endif
+}
+
+/**
+ * @brief Bit mask of slots in the group whose control byte equals the given byte.
+ */
+static inline ns_u32 group_match(const ns_u8 *group, ns_u8 ctrl) {
+    #if NS_SIMD_SSE2
+
+    __m128i bytes = _mm_load_si128((const __m128i *)group);
+    return (ns_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)ctrl)));
+
+    #else
+
+    ns_u32 mask = 0;
+    for (int i = 0; i < NS_HASHMAP_GROUP_WIDTH; i++) {
+        if (group[i] == ctrl) mask |= 1u << i;
+    }
+    return mask;
+
+    #endif
+}
+
+/**
+ * @brief Bit mask of slots in the group that are empty or deleted.
+ */
+static inline ns_u32 group_match_free(const ns_u8 *group) {
+    #if NS_SIMD_SSE2
+
+    return (ns_u32)_mm_movemask_epi8(_mm_load_si128((const __m128i *)group));
+
+    #else
+
+    ns_u32 mask = 0;
+    for (int i = 0; i < NS_HASHMAP_GROUP_WIDTH; i++) {
+        if (group[i] & 0x80) mask |= 1u << i;
+    }
+    return mask;
+
+    #endif
+}
+
+static inline size_t max_load(size_t capacity) {
+    return capacity - capacity / 8;
+}
+
+// Integer sized keys, like IDs and handles, skip the generic byte paths
+static inline ns_u64 hash_key(const nsHashMap *hashmap, const void *key) {
+    if (hashmap->hash) return hashmap->hash(key);
+
+    switch (hashmap->key_size) {
+        case 4: {
+            ns_u32 value;
+            memcpy(&value, key, 4);
+            return ns_hash_u64(value);
+        }
+
+        case 8: {
+            ns_u64 value;
+            memcpy(&value, key, 8);
+            return ns_hash_u64(value);
+        }
+
+        default:
+            return ns_hash_bytes(key, hashmap->key_size);
+    }
+}
+
+static inline ns_bool equal_keys(const nsHashMap *hashmap, const void *a, const void *b) {
+    if (hashmap->equal) return hashmap->equal(a, b);
+
+    switch (hashmap->key_size) {
+        case 4:
+            return *(const ns_u32 *)a == *(const ns_u32 *)b;
+
+        case 8:
+            return *(const ns_u64 *)a == *(const ns_u64 *)b;
+
+        default:
+            return memcmp(a, b, hashmap->key_size) == 0;
+    }
+}
+
+static inline void *key_at(const nsHashMap *hashmap, size_t index) {
+    return (char *)hashmap->keys + index * hashmap->key_size;
+}
+
+static inline void *value_at(const nsHashMap *hashmap, size_t index) {
+    return (char *)hashmap->values + index * hashmap->value_size;
+}
+
+static size_t find(const nsHashMap *hashmap, const void *key, ns_u64 hash) {
+    if (hashmap->capacity == 0) return NOT_FOUND;
+
+    size_t group_mask = hashmap->capacity / NS_HASHMAP_GROUP_WIDTH - 1;
+    size_t group = (size_t)(hash >> 7) & group_mask;
+    ns_u8 h2 = (ns_u8)(hash & 0x7F);
+
+    for (size_t step = 1;; step++) {
+        const ns_u8 *ctrl = hashmap->ctrl + group * NS_HASHMAP_GROUP_WIDTH;
+
+        ns_u32 mask = group_match(ctrl, h2);
+        while (mask) {
+            size_t index = group * NS_HASHMAP_GROUP_WIDTH + count_trailing_zeros(mask);
+            if (equal_keys(hashmap, key_at(hashmap, index), key)) return index;
+            mask &= mask - 1;
+        }
+
+        // Key would have been placed in this group if it was in the map
+        if (group_match(ctrl, CTRL_EMPTY)) return NOT_FOUND;
+
+        // Triangular probing visits every group when the group count is a power of two
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * @brief Find the first empty or deleted slot in the probe sequence of the hash.
+ */
+static size_t find_free(const nsHashMap *hashmap, ns_u64 hash) {
+    size_t group_mask = hashmap->capacity / NS_HASHMAP_GROUP_WIDTH - 1;
+    size_t group = (size_t)(hash >> 7) & group_mask;
+
+    for (size_t step = 1;; step++) {
+        ns_u32 mask = group_match_free(hashmap->ctrl + group * NS_HASHMAP_GROUP_WIDTH);
+        if (mask) return group * NS_HASHMAP_GROUP_WIDTH + count_trailing_zeros(mask);
+
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * @brief Move all entries into new storage of the given capacity, dropping deleted slots.
+ */
+static int rehash(nsHashMap *hashmap, size_t capacity) {
+    size_t keys_offset = capacity;
+    size_t values_offset = ALIGN_UP(keys_offset + capacity * hashmap->key_size);
+
+    ns_u8 *storage = NS_MALLOC(values_offset + capacity * hashmap->value_size);
+    NS_MEM_CHECK_I(storage);
+
+    nsHashMap old = *hashmap;
+
+    hashmap->ctrl = storage;
+    hashmap->keys = storage + keys_offset;
+    hashmap->values = storage + values_offset;
+    hashmap->capacity = capacity;
+    hashmap->growth_left = max_load(capacity) - hashmap->size;
+    memset(hashmap->ctrl, CTRL_EMPTY, capacity);
+
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.ctrl[i] & 0x80) continue;
+
+        const void *key = key_at(&old, i);
+        size_t index = find_free(hashmap, hash_key(hashmap, key));
+
+        hashmap->ctrl[index] = old.ctrl[i];
+        memcpy(key_at(hashmap, index), key, hashmap->key_size);
+        memcpy(value_at(hashmap, index), value_at(&old, i), hashmap->value_size);
+    }
+
+    NS_FREE(old.ctrl);
+
+    return 0;
+}
+
+
+nsHashMap *nsHashMap_new(
+    size_t key_size,
+    size_t value_size,
+    nsHashMap_hash_callback hash,
+    nsHashMap_equal_callback equal
+) {
+    if (key_size == 0) {
+        ns_throw_error("Hash map key size can't be zero.", 0, nsErrorSeverity_ERROR);
+        return NULL;
+    }
+
+    nsHashMap *hashmap = NS_NEW(nsHashMap);
+    NS_MEM_CHECK(hashmap);
+
+    hashmap->key_size = key_size;
+    hashmap->value_size = value_size;
+    hashmap->hash = hash;
+    hashmap->equal = equal;
+    hashmap->ctrl = NULL;
+    hashmap->keys = NULL;
+    hashmap->values = NULL;
+    hashmap->capacity = 0;
+    hashmap->size = 0;
+    hashmap->growth_left = 0;
+
+    return hashmap;
+}
+
+void nsHashMap_free(nsHashMap *hashmap) {
+    if (!hashmap) return;
+
+    NS_FREE(hashmap->ctrl);
+
+    NS_FREE(hashmap);
+}
+
+int nsHashMap_reserve(nsHashMap *hashmap, size_t count) {
+    size_t capacity = NS_HASHMAP_GROUP_WIDTH;
+    while (max_load(capacity) < count) capacity *= 2;
+
+    if (capacity <= hashmap->capacity) return 0;
+
+    return rehash(hashmap, capacity);
+}
+
+int nsHashMap_set(nsHashMap *hashmap, const void *key, const void *value) {
+    ns_u64 hash = hash_key(hashmap, key);
+
+    size_t index = find(hashmap, key, hash);
+    if (index != NOT_FOUND) {
+        if (hashmap->value_size > 0) memcpy(value_at(hashmap, index), value, hashmap->value_size);
+        return 0;
+    }
+
+    if (hashmap->growth_left == 0) {
+        size_t capacity = hashmap->capacity;
+
+        // Rehashing in place is enough if most of the load is deleted slots
+        if (capacity == 0) capacity = NS_HASHMAP_GROUP_WIDTH;
+        else if (hashmap->size > max_load(capacity) / 2) capacity *= 2;
+
+        if (rehash(hashmap, capacity)) return 1;
+    }
+
+    index = find_free(hashmap, hash);
+    if (hashmap->ctrl[index] == CTRL_EMPTY) hashmap->growth_left--;
+
+    hashmap->ctrl[index] = (ns_u8)(hash & 0x7F);
+    memcpy(key_at(hashmap, index), key, hashmap->key_size);
+    if (hashmap->value_size > 0) memcpy(value_at(hashmap, index), value, hashmap->value_size);
+    hashmap->size++;
+
+    return 0;
+}
+
+void *nsHashMap_get(const nsHashMap *hashmap, const void *key) {
+    size_t index = find(hashmap, key, hash_key(hashmap, key));
+    if (index == NOT_FOUND) return NULL;
+
+    return value_at(hashmap, index);
+}
+
+ns_bool nsHashMap_contains(const nsHashMap *hashmap, const void *key) {
+    return find(hashmap, key, hash_key(hashmap, key)) != NOT_FOUND;
+}
+
+int nsHashMap_remove(nsHashMap *hashmap, const void *key) {
+    size_t index = find(hashmap, key, hash_key(hashmap, key));
+    if (index == NOT_FOUND) return 1;
+
+    // A group that still has an empty slot was never full, so no probe went
+    // past it and the slot can be emptied instead of leaving a tombstone
+    const ns_u8 *group = hashmap->ctrl + (index & ~(size_t)(NS_HASHMAP_GROUP_WIDTH - 1));
+    if (group_match(group, CTRL_EMPTY)) {
+        hashmap->ctrl[index] = CTRL_EMPTY;
+        hashmap->growth_left++;
+    }
+    else {
+        hashmap->ctrl[index] = CTRL_DELETED;
+    }
+
+    hashmap->size--;
+
+    return 0;
+}
+
+void nsHashMap_clear(nsHashMap *hashmap) {
+    if (hashmap->capacity == 0) return;
+
+    memset(hashmap->ctrl, CTRL_EMPTY, hashmap->capacity);
+    hashmap->size = 0;
+    hashmap->growth_left = max_load(hashmap->capacity);
+}
+
+ns_bool nsHashMap_iter(const nsHashMap *hashmap, size_t *iter, void **key, void **value) {
+    for (size_t i = *iter; i < hashmap->capacity; i++) {
+        if (hashmap->ctrl[i] & 0x80) continue;
+
+        if (key) *key = key_at(hashmap, i);
+        if (value) *value = value_at(hashmap, i);
+        *iter = i + 1;
+        return true;
+    }
+
+    *iter = hashmap->capacity;
+    return false;
+}
+
+
+ns_u64 ns_hash_bytes(const void *data, size_t size) {
+    const ns_u8 *bytes = data;
+    ns_u64 hash = 0x9e3779b97f4a7c15ULL ^ (size * HASH_MUL);
+
+    for (; size >= 8; size -= 8, bytes += 8) {
+        ns_u64 word;
+        memcpy(&word, bytes, 8);
+
+        word *= HASH_MUL;
+        word ^= word >> 47;
+        word *= HASH_MUL;
+
+        hash ^= word;
+        hash *= HASH_MUL;
+    }
+
+    if (size > 0) {
+        ns_u64 tail = 0;
+        memcpy(&tail, bytes, size);
+        hash ^= tail;
+        hash *= HASH_MUL;
+    }
+
+    return ns_hash_u64(hash);
+}
+
+ns_u64 ns_hash_string_key(const void *key) {
+    const char *string = *(const char *const *)key;
+    return ns_hash_bytes(string, strlen(string));
+}
+
+ns_bool ns_equal_string_key(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b) == 0;
+}
\ No newline at end of file
@@ -8,32 +8,225 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_LOADERS
+
 #include "engine/include/_internal.h"
 #include "engine/include/core/io.h"
 
+#include <sys/stat.h>
 
-char *ns_read_file_raw(const char *filepath) {
+#if NS_PLATFORM == NS_PLATFORM_WINDOWS
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
+
+/**
+ * @brief Read file into memory from arena, or from the heap if arena is `NULL`.
+ */
+static char *read_file(const char *filepath, nsArena *arena) {
     FILE *file = fopen(filepath, "rb");
     if (!file) {
         ns_throw_error("Failed to open file.", 0, nsErrorSeverity_ERROR);
         return NULL;
     }
 
-    // Seek to the end & rewind back to determine the file size
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    rewind(file);
+    // ftell returns long, which is 32-bit on some platforms, query the 64-bit size instead
+    nsFileInfo info;
+    if (ns_get_file_info(filepath, &info)) {
+        fclose(file);
+        return NULL;
+    }
 
-    char *buffer = NS_MALLOC(length + 1);
-    if (!buffer) {
+    if (info.size >= (ns_u64)SIZE_MAX) {
+        ns_throw_error("File is too large to read into memory.", 0, nsErrorSeverity_ERROR);
         fclose(file);
-        NS_MEM_CHECK(buffer);
+        return NULL;
     }
+    size_t length = (size_t)info.size;
 
-    fread(buffer, 1, length, file);
+    nsArenaMark mark = {0};
+    char *buffer;
+    if (arena) {
+        mark = nsArena_mark(arena);
+        buffer = nsArena_alloc(arena, length + 1);
+        if (!buffer) {
+            fclose(file);
+            return NULL;
+        }
+    }
+    else {
+        buffer = NS_MALLOC(length + 1);
+        if (!buffer) {
+            fclose(file);
+            NS_MEM_CHECK(buffer);
+        }
+    }
+
+    if (fread(buffer, 1, length, file) != length) {
+        ns_throw_error("Failed to read file.", 0, nsErrorSeverity_ERROR);
+        if (arena) nsArena_rewind(arena, mark);
+        else NS_FREE(buffer);
+        fclose(file);
+        return NULL;
+    }
     // Make sure to null-terminate the content
     buffer[length] = '\0';
 
     fclose(file);
     return buffer;
-}
\ No newline at end of file
+}
+
+char *ns_read_file_raw(const char *filepath) {
+    return read_file(filepath, NULL);
+}
+
+char *ns_read_file_arena(nsArena *arena, const char *filepath) {
+    return read_file(filepath, arena);
+}
+
+
+#if NS_PLATFORM == NS_PLATFORM_WINDOWS
+
+int ns_map_file(nsMappedFile *mapped, const char *filepath) {
+    *mapped = (nsMappedFile){0};
+
+    HANDLE file = CreateFileA(
+        filepath,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        ns_throw_error("Failed to open file.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        ns_throw_error("Failed to map empty file.", 0, nsErrorSeverity_ERROR);
+        CloseHandle(file);
+        return 1;
+    }
+
+    // Doesn't fit into the address space of 32-bit builds
+    if ((ns_u64)size.QuadPart > (ns_u64)SIZE_MAX) {
+        ns_throw_error("File is too large to map.", 0, nsErrorSeverity_ERROR);
+        CloseHandle(file);
+        return 1;
+    }
+
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!map) {
+        ns_throw_error("Failed to map file.", 0, nsErrorSeverity_ERROR);
+        CloseHandle(file);
+        return 1;
+    }
+
+    void *data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        ns_throw_error("Failed to map file.", 0, nsErrorSeverity_ERROR);
+        CloseHandle(map);
+        CloseHandle(file);
+        return 1;
+    }
+
+    mapped->data = data;
+    mapped->size = (size_t)size.QuadPart;
+    mapped->_file_handle = file;
+    mapped->_map_handle = map;
+
+    return 0;
+}
+
+void ns_unmap_file(nsMappedFile *mapped) {
+    if (!mapped->data) return;
+
+    UnmapViewOfFile(mapped->data);
+    CloseHandle((HANDLE)mapped->_map_handle);
+    CloseHandle((HANDLE)mapped->_file_handle);
+
+    *mapped = (nsMappedFile){0};
+}
+
+int ns_get_file_info(const char *filepath, nsFileInfo *info) {
+    struct _stat64 st;
+    if (_stat64(filepath, &st) != 0) {
+        ns_throw_error("Failed to query file info.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    info->size = (ns_u64)st.st_size;
+    info->modified_time = (ns_i64)st.st_mtime;
+
+    return 0;
+}
+
+#else
+
+int ns_map_file(nsMappedFile *mapped, const char *filepath) {
+    *mapped = (nsMappedFile){0};
+
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        ns_throw_error("Failed to open file.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ns_throw_error("Failed to map empty file.", 0, nsErrorSeverity_ERROR);
+        close(fd);
+        return 1;
+    }
+
+    // Doesn't fit into the address space of 32-bit builds
+    if ((ns_u64)st.st_size > (ns_u64)SIZE_MAX) {
+        ns_throw_error("File is too large to map.", 0, nsErrorSeverity_ERROR);
+        close(fd);
+        return 1;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Mapping keeps its own reference to the file
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        ns_throw_error("Failed to map file.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    mapped->data = data;
+    mapped->size = (size_t)st.st_size;
+
+    return 0;
+}
+
+void ns_unmap_file(nsMappedFile *mapped) {
+    if (!mapped->data) return;
+
+    munmap(mapped->data, mapped->size);
+
+    *mapped = (nsMappedFile){0};
+}
+
+int ns_get_file_info(const char *filepath, nsFileInfo *info) {
+    struct stat st;
+    if (stat(filepath, &st) != 0) {
+        ns_throw_error("Failed to query file info.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    info->size = (ns_u64)st.st_size;
+    info->modified_time = (ns_i64)st.st_mtime;
+
+    return 0;
+}
+
+#endif
\ No newline at end of file
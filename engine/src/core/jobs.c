@@ -0,0 +1,542 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_GENERAL
+
+#include "engine/include/core/jobs.h"
+#include "engine/include/core/arena.h"
+#include "engine/include/core/profiler.h"
+
+
+#define QUEUE_MASK (NS_JOBS_QUEUE_CAPACITY - 1)
+
+// Failed polls before a worker goes to sleep, or a waiter yields its time slice
+#define SPIN_COUNT 256
+
+/*
+    Chase-Lev deque, bounded.
+
+    The owner thread pushes and pops at bottom, thieves take from top. Only
+    the last job is contended, the owner and a thief settle it with a CAS on
+    top. Orderings follow Lê et al., "Correct and Efficient Work-Stealing for
+    Weak Memory Models".
+
+    Thieves copy a job before their CAS, the copy is only used if the CAS
+    wins, which means the owner couldn't have overwritten the slot.
+*/
+struct nsJobQueue {
+    nsAtomicI64 top;
+    char _pad0[NS_CACHE_LINE_SIZE - sizeof(nsAtomicI64)];
+    nsAtomicI64 bottom;
+    char _pad1[NS_CACHE_LINE_SIZE - sizeof(nsAtomicI64)];
+    nsJobSystem *system;
+    nsJob jobs[NS_JOBS_QUEUE_CAPACITY];
+};
+
+// Queue of the calling thread, only valid if local_system matches
+static NS_THREAD_LOCAL nsJobSystem *local_system = NULL;
+static NS_THREAD_LOCAL nsJobQueue *local_queue = NULL;
+static NS_THREAD_LOCAL ns_u32 local_random = 0;
+
+
+static ns_bool queue_push(nsJobQueue *queue, nsJob job) {
+    ns_i64 bottom = ns_atomic_load_i64(&queue->bottom, NS_ATOMIC_RELAXED);
+    ns_i64 top = ns_atomic_load_i64(&queue->top, NS_ATOMIC_ACQUIRE);
+
+    if (bottom - top >= NS_JOBS_QUEUE_CAPACITY) return false;
+
+    queue->jobs[bottom & QUEUE_MASK] = job;
+    ns_atomic_store_i64(&queue->bottom, bottom + 1, NS_ATOMIC_RELEASE);
+
+    return true;
+}
+
+static ns_bool queue_pop(nsJobQueue *queue, nsJob *job) {
+    ns_i64 bottom = ns_atomic_load_i64(&queue->bottom, NS_ATOMIC_RELAXED) - 1;
+    ns_atomic_store_i64(&queue->bottom, bottom, NS_ATOMIC_RELAXED);
+    ns_atomic_fence(NS_ATOMIC_SEQ_CST);
+    ns_i64 top = ns_atomic_load_i64(&queue->top, NS_ATOMIC_RELAXED);
+
+    if (top > bottom) {
+        ns_atomic_store_i64(&queue->bottom, bottom + 1, NS_ATOMIC_RELAXED);
+        return false;
+    }
+
+    *job = queue->jobs[bottom & QUEUE_MASK];
+
+    // Last job, race thieves for it
+    if (top == bottom) {
+        ns_bool won = ns_atomic_cas_i64(&queue->top, top, top + 1, NS_ATOMIC_SEQ_CST);
+        ns_atomic_store_i64(&queue->bottom, bottom + 1, NS_ATOMIC_RELAXED);
+        return won;
+    }
+
+    return true;
+}
+
+static ns_bool queue_steal(nsJobQueue *queue, nsJob *job) {
+    ns_i64 top = ns_atomic_load_i64(&queue->top, NS_ATOMIC_ACQUIRE);
+    ns_atomic_fence(NS_ATOMIC_SEQ_CST);
+    ns_i64 bottom = ns_atomic_load_i64(&queue->bottom, NS_ATOMIC_ACQUIRE);
+
+    if (top >= bottom) return false;
+
+    *job = queue->jobs[top & QUEUE_MASK];
+
+    return ns_atomic_cas_i64(&queue->top, top, top + 1, NS_ATOMIC_SEQ_CST);
+}
+
+static inline ns_bool queue_is_empty(nsJobQueue *queue) {
+    ns_i64 top = ns_atomic_load_i64(&queue->top, NS_ATOMIC_ACQUIRE);
+    ns_i64 bottom = ns_atomic_load_i64(&queue->bottom, NS_ATOMIC_ACQUIRE);
+    return top >= bottom;
+}
+
+
+static ns_bool inject(nsJobSystem *jobs, nsJob job) {
+    SDL_AtomicLock(&jobs->_injected_lock);
+
+    size_t count = (size_t)ns_atomic_load_i32(&jobs->_injected_count, NS_ATOMIC_RELAXED);
+
+    if (count == jobs->_injected_capacity) {
+        size_t capacity = jobs->_injected_capacity ? jobs->_injected_capacity * 2 : 64;
+
+        nsJob *injected = NS_MALLOC(sizeof(nsJob) * capacity);
+        if (!injected) {
+            SDL_AtomicUnlock(&jobs->_injected_lock);
+            return false;
+        }
+
+        // Unwrap the ring while copying
+        for (size_t i = 0; i < count; i++) {
+            injected[i] = jobs->_injected[(jobs->_injected_head + i) % jobs->_injected_capacity];
+        }
+
+        NS_FREE(jobs->_injected);
+        jobs->_injected = injected;
+        jobs->_injected_head = 0;
+        jobs->_injected_capacity = capacity;
+    }
+
+    jobs->_injected[(jobs->_injected_head + count) % jobs->_injected_capacity] = job;
+    ns_atomic_store_i32(&jobs->_injected_count, (ns_i32)count + 1, NS_ATOMIC_RELEASE);
+
+    SDL_AtomicUnlock(&jobs->_injected_lock);
+
+    return true;
+}
+
+static ns_bool take_injected(nsJobSystem *jobs, nsJob *job) {
+    if (ns_atomic_load_i32(&jobs->_injected_count, NS_ATOMIC_ACQUIRE) == 0) return false;
+
+    SDL_AtomicLock(&jobs->_injected_lock);
+
+    ns_i32 count = ns_atomic_load_i32(&jobs->_injected_count, NS_ATOMIC_RELAXED);
+    if (count == 0) {
+        SDL_AtomicUnlock(&jobs->_injected_lock);
+        return false;
+    }
+
+    *job = jobs->_injected[jobs->_injected_head];
+    jobs->_injected_head = (jobs->_injected_head + 1) % jobs->_injected_capacity;
+    ns_atomic_store_i32(&jobs->_injected_count, count - 1, NS_ATOMIC_RELAXED);
+
+    SDL_AtomicUnlock(&jobs->_injected_lock);
+
+    return true;
+}
+
+
+static inline nsJobQueue *get_local_queue(nsJobSystem *jobs) {
+    return local_system == jobs ? local_queue : NULL;
+}
+
+static inline ns_u32 next_random() {
+    // xorshift32, seeded from the address of a thread local so threads differ
+    if (local_random == 0) local_random = (ns_u32)(size_t)&local_random | 1;
+
+    local_random ^= local_random << 13;
+    local_random ^= local_random >> 17;
+    local_random ^= local_random << 5;
+
+    return local_random;
+}
+
+static ns_bool steal(nsJobSystem *jobs, nsJobQueue *own, nsJob *job) {
+    ns_u32 count = jobs->_queue_count;
+    ns_u32 start = next_random() % count;
+
+    for (ns_u32 i = 0; i < count; i++) {
+        nsJobQueue *victim = &jobs->_queues[(start + i) % count];
+        if (victim == own) continue;
+
+        if (queue_steal(victim, job)) return true;
+    }
+
+    return false;
+}
+
+static ns_bool has_work(nsJobSystem *jobs) {
+    if (ns_atomic_load_i32(&jobs->_injected_count, NS_ATOMIC_ACQUIRE) > 0) return true;
+
+    for (ns_u32 i = 0; i < jobs->_queue_count; i++) {
+        if (!queue_is_empty(&jobs->_queues[i])) return true;
+    }
+
+    return false;
+}
+
+static inline void run_job(nsJob job) {
+    NS_PROFILE_ZONE_BEGIN("Job");
+    job.func(job.data);
+    NS_PROFILE_ZONE_END();
+
+    if (job.counter) ns_atomic_add_i32(&job.counter->pending, -1, NS_ATOMIC_RELEASE);
+}
+
+static inline ns_bool find_job(nsJobSystem *jobs, nsJobQueue *own, nsJob *job) {
+    return (own && queue_pop(own, job)) || take_injected(jobs, job) || steal(jobs, own, job);
+}
+
+static ns_bool execute_one(nsJobSystem *jobs, nsJobQueue *own) {
+    nsJob job;
+    if (!find_job(jobs, own, &job)) return false;
+
+    run_job(job);
+    return true;
+}
+
+/**
+ * @brief Wake up to count sleeping workers.
+ */
+static void wake_workers(nsJobSystem *jobs, size_t count) {
+    // Pairs with the fence of a worker going to sleep, one of them sees the other
+    ns_atomic_fence(NS_ATOMIC_SEQ_CST);
+
+    while (count > 0) {
+        ns_i32 sleeping = ns_atomic_load_i32(&jobs->_sleeping, NS_ATOMIC_RELAXED);
+        if (sleeping <= 0) return;
+
+        if (ns_atomic_cas_i32(&jobs->_sleeping, sleeping, sleeping - 1, NS_ATOMIC_SEQ_CST)) {
+            SDL_SemPost(jobs->_wake);
+            count--;
+        }
+    }
+}
+
+/**
+ * @brief Wake workers for new jobs, unless an idle worker is already looking for them.
+ * 
+ * A searching worker that finds a job wakes the next one if it was the last
+ * searcher, so wakeups spread out without a semaphore post per job.
+ */
+static void notify(nsJobSystem *jobs, size_t count) {
+    ns_atomic_fence(NS_ATOMIC_SEQ_CST);
+
+    if (ns_atomic_load_i32(&jobs->_searching, NS_ATOMIC_RELAXED) > 0) return;
+
+    wake_workers(jobs, count);
+}
+
+static void submit(nsJobSystem *jobs, nsJob job) {
+    if (job.counter) ns_atomic_add_i32(&job.counter->pending, 1, NS_ATOMIC_RELAXED);
+
+    nsJobQueue *queue = get_local_queue(jobs);
+
+    // No room left anywhere, running it right away is still correct
+    if (queue ? !queue_push(queue, job) : !inject(jobs, job)) run_job(job);
+}
+
+
+static void sleep_worker(nsJobSystem *jobs) {
+    ns_atomic_add_i32(&jobs->_sleeping, 1, NS_ATOMIC_SEQ_CST);
+    ns_atomic_fence(NS_ATOMIC_SEQ_CST);
+
+    if (!has_work(jobs) && !ns_atomic_load_i32(&jobs->_quit, NS_ATOMIC_ACQUIRE)) {
+        SDL_SemWait(jobs->_wake);
+        return;
+    }
+
+    // Work came in meanwhile, take back the sleep count unless a waker already
+    // took it, then its post is for this worker
+    for (;;) {
+        ns_i32 sleeping = ns_atomic_load_i32(&jobs->_sleeping, NS_ATOMIC_RELAXED);
+
+        if (sleeping <= 0) {
+            SDL_SemWait(jobs->_wake);
+            return;
+        }
+
+        if (ns_atomic_cas_i32(&jobs->_sleeping, sleeping, sleeping - 1, NS_ATOMIC_SEQ_CST)) return;
+    }
+}
+
+static int worker_thread(void *data) {
+    nsJobQueue *queue = data;
+    nsJobSystem *jobs = queue->system;
+
+    local_system = jobs;
+    local_queue = queue;
+
+    NS_PROFILE_THREAD("Job worker");
+
+    ns_u32 idle = 0;
+    ns_bool searching = false;
+    nsJob job;
+
+    for (;;) {
+        if (find_job(jobs, queue, &job)) {
+            if (searching) {
+                searching = false;
+                if (ns_atomic_add_i32(&jobs->_searching, -1, NS_ATOMIC_SEQ_CST) == 1) wake_workers(jobs, 1);
+            }
+
+            run_job(job);
+            idle = 0;
+            continue;
+        }
+
+        // Only exit once every queue is drained
+        if (ns_atomic_load_i32(&jobs->_quit, NS_ATOMIC_ACQUIRE)) break;
+
+        if (!searching) {
+            searching = true;
+            ns_atomic_add_i32(&jobs->_searching, 1, NS_ATOMIC_SEQ_CST);
+        }
+
+        if (idle++ < SPIN_COUNT) {
+            ns_cpu_relax();
+            continue;
+        }
+
+        searching = false;
+        ns_atomic_add_i32(&jobs->_searching, -1, NS_ATOMIC_SEQ_CST);
+
+        // Keep scratch blocks for the next job, but not the peak of a huge one
+        nsArena_trim(ns_get_scratch_arena(), NS_ARENA_SCRATCH_RETAIN);
+
+        sleep_worker(jobs);
+        idle = 0;
+    }
+
+    if (searching) ns_atomic_add_i32(&jobs->_searching, -1, NS_ATOMIC_SEQ_CST);
+
+    ns_free_scratch_arena();
+    NS_PROFILE_THREAD_EXIT();
+
+    local_system = NULL;
+    local_queue = NULL;
+
+    return 0;
+}
+
+
+typedef struct {
+    nsParallelForFunc func;
+    void *data;
+    size_t count;
+    size_t batch_size;
+    nsAtomicI64 next;
+} ParallelFor;
+
+typedef struct {
+    nsPool *pool;
+    nsParallelForEachFunc func;
+    void *data;
+} ParallelForPool;
+
+static void parallel_for_job(void *data) {
+    ParallelFor *pf = data;
+
+    for (;;) {
+        size_t start = (size_t)ns_atomic_add_i64(&pf->next, (ns_i64)pf->batch_size, NS_ATOMIC_RELAXED);
+        if (start >= pf->count) return;
+
+        size_t end = start + pf->batch_size;
+        if (end > pf->count) end = pf->count;
+
+        pf->func(start, end, pf->data);
+    }
+}
+
+static void parallel_for_pool_range(size_t start, size_t end, void *data) {
+    ParallelForPool *pfp = data;
+    char *elems = pfp->pool->data;
+
+    for (size_t i = start; i < end; i++) {
+        pfp->func(elems + i * pfp->pool->elem_size, i, pfp->data);
+    }
+}
+
+
+nsJobSystem *nsJobSystem_new(ns_u32 worker_count) {
+    nsJobSystem *jobs = NS_NEW(nsJobSystem);
+    NS_MEM_CHECK(jobs);
+
+    *jobs = (nsJobSystem){0};
+
+    // Leave a core to the main thread
+    if (worker_count == 0) {
+        int cpu_count = SDL_GetCPUCount();
+        worker_count = cpu_count > 1 ? (ns_u32)cpu_count - 1 : 1;
+    }
+    if (worker_count > NS_JOBS_MAX_WORKERS) worker_count = NS_JOBS_MAX_WORKERS;
+
+    // Queue 0 belongs to the creating thread
+    jobs->_queue_count = worker_count + 1;
+    jobs->_queues = NS_MALLOC(sizeof(nsJobQueue) * jobs->_queue_count);
+    if (!jobs->_queues) {
+        NS_FREE(jobs);
+        NS_MEM_CHECK(NULL);
+    }
+
+    for (ns_u32 i = 0; i < jobs->_queue_count; i++) {
+        nsJobQueue *queue = &jobs->_queues[i];
+        queue->top = (nsAtomicI64){0};
+        queue->bottom = (nsAtomicI64){0};
+        queue->system = jobs;
+    }
+
+    jobs->_wake = SDL_CreateSemaphore(0);
+    if (!jobs->_wake) {
+        ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_ERROR);
+        nsJobSystem_free(jobs);
+        return NULL;
+    }
+
+    local_system = jobs;
+    local_queue = &jobs->_queues[0];
+
+    for (ns_u32 i = 0; i < worker_count; i++) {
+        jobs->workers[i] = SDL_CreateThread(worker_thread, "nsJobSystem", &jobs->_queues[i + 1]);
+        if (!jobs->workers[i]) {
+            ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_ERROR);
+            nsJobSystem_free(jobs);
+            return NULL;
+        }
+        jobs->worker_count++;
+    }
+
+    return jobs;
+}
+
+void nsJobSystem_free(nsJobSystem *jobs) {
+    if (!jobs) return;
+
+    if (jobs->_queues && local_system == jobs) {
+        while (nsJobSystem_execute(jobs));
+    }
+
+    ns_atomic_store_i32(&jobs->_quit, 1, NS_ATOMIC_SEQ_CST);
+    if (jobs->_wake) wake_workers(jobs, jobs->worker_count);
+
+    for (ns_u32 i = 0; i < jobs->worker_count; i++) {
+        SDL_WaitThread(jobs->workers[i], NULL);
+    }
+
+    if (jobs->_wake) SDL_DestroySemaphore(jobs->_wake);
+
+    if (local_system == jobs) {
+        local_system = NULL;
+        local_queue = NULL;
+    }
+
+    NS_FREE(jobs->_queues);
+    NS_FREE(jobs->_injected);
+    NS_FREE(jobs);
+}
+
+void nsJobSystem_run(nsJobSystem *jobs, nsJobFunc func, void *data, nsJobCounter *counter) {
+    submit(jobs, (nsJob){.func = func, .data = data, .counter = counter});
+    notify(jobs, 1);
+}
+
+void nsJobSystem_run_batch(nsJobSystem *jobs, const nsJob *batch, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        submit(jobs, batch[i]);
+    }
+
+    notify(jobs, count);
+}
+
+ns_bool nsJobSystem_execute(nsJobSystem *jobs) {
+    return execute_one(jobs, get_local_queue(jobs));
+}
+
+void nsJobSystem_wait(nsJobSystem *jobs, nsJobCounter *counter) {
+    nsJobQueue *queue = get_local_queue(jobs);
+    ns_u32 idle = 0;
+
+    while (!nsJobCounter_is_done(counter)) {
+        if (execute_one(jobs, queue)) {
+            idle = 0;
+            continue;
+        }
+
+        // The remaining jobs are running on other threads
+        if (idle++ < SPIN_COUNT) ns_cpu_relax();
+        else SDL_Delay(0);
+    }
+}
+
+void nsJobSystem_parallel_for(
+    nsJobSystem *jobs,
+    size_t count,
+    size_t batch_size,
+    nsParallelForFunc func,
+    void *data
+) {
+    if (count == 0) return;
+
+    // A few batches per thread so threads that finish early can take more
+    if (batch_size == 0) {
+        batch_size = count / ((size_t)jobs->_queue_count * 4);
+        if (batch_size == 0) batch_size = 1;
+    }
+
+    size_t batch_count = (count + batch_size - 1) / batch_size;
+    if (batch_count == 1 || jobs->worker_count == 0) {
+        func(0, count, data);
+        return;
+    }
+
+    ParallelFor pf = {
+        .func = func,
+        .data = data,
+        .count = count,
+        .batch_size = batch_size,
+        .next = {0}
+    };
+    nsJobCounter counter = {0};
+
+    // Helpers claim batches until none are left, the caller is one of them
+    size_t helper_count = batch_count - 1;
+    if (helper_count > jobs->worker_count) helper_count = jobs->worker_count;
+
+    for (size_t i = 0; i < helper_count; i++) {
+        submit(jobs, (nsJob){.func = parallel_for_job, .data = &pf, .counter = &counter});
+    }
+    notify(jobs, helper_count);
+
+    parallel_for_job(&pf);
+
+    nsJobSystem_wait(jobs, &counter);
+}
+
+void nsJobSystem_parallel_for_pool(
+    nsJobSystem *jobs,
+    nsPool *pool,
+    size_t batch_size,
+    nsParallelForEachFunc func,
+    void *data
+) {
+    ParallelForPool pfp = {.pool = pool, .func = func, .data = data};
+    nsJobSystem_parallel_for(jobs, pool->size, batch_size, parallel_for_pool_range, &pfp);
+}
\ No newline at end of file
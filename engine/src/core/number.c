@@ -0,0 +1,403 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include "engine/include/core/number.h"
+
+
+/*
+    Float parsing works in two steps:
+
+    1. Digits are accumulated into a 64-bit decimal mantissa and a base 10
+       exponent. Runs of 8 digits are scanned and converted at once with SWAR
+       (SIMD within a register) tricks when the platform is little-endian.
+
+    2. When the mantissa fits in a double exactly and the power of 10 is exact
+       too, one double multiplication/division gives the correctly rounded
+       double. Rounding that to float is then only wrong if the double landed
+       exactly on a float rounding midpoint, which we detect and fall back from.
+       Everything else (very long inputs, extreme exponents, subnormals) goes
+       through the slow path: digits are rewritten as "DIGITSeEXP", which has
+       no radix character, and handed to strtof so it is locale-independent.
+*/
+
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+    NS_COMPILER == NS_COMPILER_MSVC
+
+    #define NS_NUMBER_SWAR 1
+
+#else
+
+    #define NS_NUMBER_SWAR 0
+
+#endif
+
+// Decimal digits that always fit in the 64-bit mantissa
+#define MAX_MANTISSA_DIGITS 19
+
+/*
+    Significant digits kept for the slow path. Float rounding midpoints have
+    fewer significant digits than this, so dropping the rest and keeping a
+    sticky digit can't change the rounding.
+*/
+#define MAX_SLOW_PATH_DIGITS 150
+
+// Explicit exponents are clamped to this, anything beyond is inf or 0 anyway
+#define MAX_EXPONENT 100000
+
+
+static const double POW10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+typedef struct {
+    ns_u64 mantissa; /**< Accumulated significant digits. */
+    int significant; /**< Digits accumulated since the first non-zero one. */
+    long exponent; /**< Base 10 exponent of the mantissa. */
+    ns_bool truncated; /**< Non-zero digits didn't fit in the mantissa. */
+} DecimalState;
+
+
+static inline ns_bool is_digit(char chr) {
+    return (unsigned)(chr - '0') < 10;
+}
+
+static inline char to_lower(char chr) {
+    return (chr >= 'A' && chr <= 'Z') ? chr + ('a' - 'A') : chr;
+}
+
+#if NS_NUMBER_SWAR
+
+static inline ns_u64 load_eight(const char *str) {
+    ns_u64 value;
+    memcpy(&value, str, sizeof(value));
+    return value;
+}
+
+static inline ns_bool is_eight_digits(ns_u64 value) {
+    // Every byte has to be in 0x30..0x39
+    return (
+        ((value & 0xF0F0F0F0F0F0F0F0ull) |
+        (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+        == 0x3333333333333333ull
+    );
+}
+
+static inline ns_u32 parse_eight_digits(ns_u64 value) {
+    const ns_u64 mask = 0x000000FF000000FFull;
+    const ns_u64 mul1 = 100 + (1000000ull << 32);
+    const ns_u64 mul2 = 1 + (10000ull << 32);
+
+    // Combine adjacent digits in pairs, then quads, then the halves
+    value -= 0x3030303030303030ull;
+    value = (value * 10) + (value >> 8);
+    value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+
+    return (ns_u32)value;
+}
+
+static inline int count_digits(ns_u32 value) {
+    int n = 0;
+    while (value) {
+        value /= 10;
+        n++;
+    }
+    return n;
+}
+
+#endif
+
+/**
+ * @brief Accumulate a run of digits into the decimal state.
+ */
+static const char *scan_digits(
+    const char *str,
+    const char *end,
+    DecimalState *state,
+    ns_bool fraction
+) {
+    const char *p = str;
+
+    #if NS_NUMBER_SWAR
+
+    while (end - p >= 8 && state->significant + 8 <= MAX_MANTISSA_DIGITS) {
+        ns_u64 chunk = load_eight(p);
+        if (!is_eight_digits(chunk)) break;
+
+        ns_u32 digits = parse_eight_digits(chunk);
+        ns_u64 old = state->mantissa;
+        state->mantissa = state->mantissa * 100000000ull + digits;
+
+        if (state->mantissa == 0) state->significant = 0;
+        else if (old == 0) state->significant = count_digits(digits);
+        else state->significant += 8;
+
+        if (fraction) state->exponent -= 8;
+        p += 8;
+    }
+
+    #endif
+
+    while (p < end && is_digit(*p)) {
+        int digit = *p - '0';
+
+        if (state->significant < MAX_MANTISSA_DIGITS) {
+            state->mantissa = state->mantissa * 10 + digit;
+            if (state->mantissa) state->significant++;
+            if (fraction) state->exponent--;
+        }
+        else {
+            // Doesn't fit, only the magnitude matters from now on
+            if (!fraction) state->exponent++;
+            if (digit) state->truncated = true;
+        }
+
+        p++;
+    }
+
+    return p;
+}
+
+static const char *parse_special(
+    const char *str,
+    const char *end,
+    ns_bool negative,
+    float *value
+) {
+    static const char *INFINITY_STR = "infinity";
+    static const char *NAN_STR = "nan";
+
+    size_t n = 0;
+    while (str + n < end && n < 8 && to_lower(str[n]) == INFINITY_STR[n]) n++;
+
+    if (n == 8 || n == 3) {
+        *value = negative ? -HUGE_VALF : HUGE_VALF;
+        return str + n;
+    }
+    // "infin" etc. still parses "inf" like strtof does
+    else if (n > 3) {
+        *value = negative ? -HUGE_VALF : HUGE_VALF;
+        return str + 3;
+    }
+
+    n = 0;
+    while (str + n < end && n < 3 && to_lower(str[n]) == NAN_STR[n]) n++;
+
+    if (n == 3) {
+        *value = negative ? -NAN : NAN;
+        return str + 3;
+    }
+
+    return NULL;
+}
+
+static float parse_slow(
+    const char *int_start,
+    const char *int_end,
+    const char *frac_start,
+    const char *frac_end,
+    long explicit_exponent,
+    ns_bool negative
+) {
+    char buffer[MAX_SLOW_PATH_DIGITS + 32];
+    size_t n = 0;
+    long exponent = explicit_exponent - (long)(frac_end - frac_start);
+    ns_bool dropped = false;
+
+    if (negative) buffer[n++] = '-';
+    size_t digits_start = n;
+
+    const char *ranges[2][2] = {{int_start, int_end}, {frac_start, frac_end}};
+    for (size_t r = 0; r < 2; r++) {
+        for (const char *p = ranges[r][0]; p < ranges[r][1]; p++) {
+            // Leading zeros don't change the value
+            if (n == digits_start && *p == '0') continue;
+
+            if (n - digits_start < MAX_SLOW_PATH_DIGITS) {
+                buffer[n++] = *p;
+            }
+            else {
+                exponent++;
+                if (*p != '0') dropped = true;
+            }
+        }
+    }
+
+    if (n == digits_start) {
+        return negative ? -0.0f : 0.0f;
+    }
+
+    // Sticky digit keeps the value strictly above the kept digits
+    if (dropped) {
+        buffer[n++] = '1';
+        exponent--;
+    }
+
+    snprintf(buffer + n, sizeof(buffer) - n, "e%ld", exponent);
+
+    return strtof(buffer, NULL);
+}
+
+
+const char *ns_parse_float(const char *str, const char *end, float *value) {
+    const char *p = str;
+    ns_bool negative = false;
+
+    *value = 0.0f;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (p < end && !is_digit(*p) && *p != '.') {
+        const char *special_end = parse_special(p, end, negative, value);
+        return special_end ? special_end : str;
+    }
+
+    DecimalState state = {0, 0, 0, false};
+
+    const char *int_start = p;
+    p = scan_digits(p, end, &state, false);
+    const char *int_end = p;
+
+    const char *frac_start = p;
+    const char *frac_end = p;
+    if (p < end && *p == '.') {
+        p++;
+        frac_start = p;
+        p = scan_digits(p, end, &state, true);
+        frac_end = p;
+    }
+
+    if (int_end == int_start && frac_end == frac_start) {
+        // No digits at all, not a number
+        return str;
+    }
+
+    long explicit_exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        ns_bool exponent_negative = false;
+
+        if (q < end && (*q == '-' || *q == '+')) {
+            exponent_negative = *q == '-';
+            q++;
+        }
+
+        // Exponent without digits is not part of the number
+        if (q < end && is_digit(*q)) {
+            while (q < end && is_digit(*q)) {
+                if (explicit_exponent < MAX_EXPONENT) {
+                    explicit_exponent = explicit_exponent * 10 + (*q - '0');
+                }
+                q++;
+            }
+
+            if (exponent_negative) explicit_exponent = -explicit_exponent;
+            p = q;
+        }
+    }
+
+    if (state.mantissa == 0) {
+        *value = negative ? -0.0f : 0.0f;
+        return p;
+    }
+
+    long exponent = state.exponent + explicit_exponent;
+
+    // Fast path
+    if (
+        !state.truncated &&
+        state.mantissa <= (1ull << 53) &&
+        exponent >= -22 && exponent <= 22
+    ) {
+        double x = (double)state.mantissa;
+        if (exponent < 0) x /= POW10[-exponent];
+        else x *= POW10[exponent];
+
+        if (x >= FLT_MIN && x <= FLT_MAX) {
+            ns_u64 bits;
+            memcpy(&bits, &x, sizeof(bits));
+
+            // Lower 29 bits are what double has beyond float's precision
+            if ((bits & 0x1FFFFFFFull) != 0x10000000ull) {
+                float result = (float)x;
+                *value = negative ? -result : result;
+                return p;
+            }
+        }
+    }
+
+    // Value is in [10^(e + s - 1), 10^(e + s)), decide obvious overflow/underflow
+    long magnitude = exponent + state.significant;
+    if (magnitude > 39) {
+        *value = negative ? -HUGE_VALF : HUGE_VALF;
+        return p;
+    }
+    if (magnitude < -46) {
+        *value = negative ? -0.0f : 0.0f;
+        return p;
+    }
+
+    *value = parse_slow(int_start, int_end, frac_start, frac_end, explicit_exponent, negative);
+    return p;
+}
+
+const char *ns_parse_long(const char *str, const char *end, long *value) {
+    const char *p = str;
+    ns_bool negative = false;
+
+    *value = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (p >= end || !is_digit(*p)) {
+        return str;
+    }
+
+    ns_u64 result = 0;
+    ns_bool overflow = false;
+
+    #if NS_NUMBER_SWAR
+
+    // Stay well below 2^64 so the multiplication can't wrap
+    while (end - p >= 8 && result < 100000000000ull) {
+        ns_u64 chunk = load_eight(p);
+        if (!is_eight_digits(chunk)) break;
+
+        result = result * 100000000ull + parse_eight_digits(chunk);
+        p += 8;
+    }
+
+    #endif
+
+    while (p < end && is_digit(*p)) {
+        if (result > (0xFFFFFFFFFFFFFFFFull - 9) / 10) overflow = true;
+        else result = result * 10 + (*p - '0');
+        p++;
+    }
+
+    ns_u64 limit = negative ? (ns_u64)LONG_MAX + 1 : (ns_u64)LONG_MAX;
+    if (overflow || result > limit) result = limit;
+
+    if (negative) *value = result == (ns_u64)LONG_MAX + 1 ? LONG_MIN : -(long)result;
+    else *value = (long)result;
+
+    return p;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
+#include "engine/include/core/object_pool.h"
+
+
+// Slab header is padded so the slots after it stay aligned
+#define SLAB_HEADER_SIZE NS_OBJECT_POOL_SLOT_SIZE(sizeof(nsObjectPoolSlab))
+
+// Pools with slabs, guarded by its own lock and never taken with a pool lock held
+static nsObjectPool *registered_pools = NULL;
+static SDL_SpinLock registry_lock = 0;
+
+
+/**
+ * @brief Allocate a new slab and put its slots on the free list, pool has to be locked.
+ */
+static int add_slab(nsObjectPool *pool) {
+    nsObjectPoolSlab *slab = ns_alloc(SLAB_HEADER_SIZE + pool->slot_size * pool->slab_capacity, pool->tag);
+    if (!slab) return 1;
+
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->capacity += pool->slab_capacity;
+
+    // Push backwards so the lowest address is handed out first
+    char *slots = (char *)slab + SLAB_HEADER_SIZE;
+    for (size_t i = pool->slab_capacity; i > 0; i--) {
+        void *slot = slots + (i - 1) * pool->slot_size;
+        *(void **)slot = pool->free_list;
+        pool->free_list = slot;
+    }
+
+    return 0;
+}
+
+static void register_pool(nsObjectPool *pool) {
+    SDL_AtomicLock(&registry_lock);
+
+    if (!pool->_registered) {
+        pool->_next_registered = registered_pools;
+        registered_pools = pool;
+        pool->_registered = true;
+    }
+
+    SDL_AtomicUnlock(&registry_lock);
+}
+
+static void unregister_pool(nsObjectPool *pool) {
+    SDL_AtomicLock(&registry_lock);
+
+    if (pool->_registered) {
+        nsObjectPool **link = &registered_pools;
+        while (*link != pool) link = &(*link)->_next_registered;
+        *link = pool->_next_registered;
+
+        pool->_next_registered = NULL;
+        pool->_registered = false;
+    }
+
+    SDL_AtomicUnlock(&registry_lock);
+}
+
+
+void nsObjectPool_init(
+    nsObjectPool *pool,
+    size_t object_size,
+    size_t slab_capacity,
+    nsMemoryTag tag
+) {
+    pool->slot_size = NS_OBJECT_POOL_SLOT_SIZE(object_size);
+    pool->slab_capacity = slab_capacity > 0 ? slab_capacity : 1;
+    pool->tag = tag;
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    pool->live = 0;
+    pool->capacity = 0;
+    pool->lock = 0;
+    pool->_next_registered = NULL;
+    pool->_registered = false;
+}
+
+void nsObjectPool_free(nsObjectPool *pool) {
+    SDL_AtomicLock(&pool->lock);
+
+    nsObjectPoolSlab *slab = pool->slabs;
+    while (slab) {
+        nsObjectPoolSlab *next = slab->next;
+        ns_free(slab);
+        slab = next;
+    }
+
+    pool->free_list = NULL;
+    pool->slabs = NULL;
+    pool->live = 0;
+    pool->capacity = 0;
+
+    SDL_AtomicUnlock(&pool->lock);
+
+    // Pools on the stack may be gone after this
+    unregister_pool(pool);
+}
+
+void *nsObjectPool_alloc(nsObjectPool *pool) {
+    SDL_AtomicLock(&pool->lock);
+
+    ns_bool added_slab = false;
+    if (!pool->free_list) {
+        if (add_slab(pool)) {
+            SDL_AtomicUnlock(&pool->lock);
+            return NULL;
+        }
+        added_slab = true;
+    }
+
+    void *object = pool->free_list;
+    pool->free_list = *(void **)object;
+    pool->live++;
+
+    SDL_AtomicUnlock(&pool->lock);
+
+    if (added_slab) register_pool(pool);
+
+    return object;
+}
+
+void nsObjectPool_release(nsObjectPool *pool, void *object) {
+    if (!object) return;
+
+    SDL_AtomicLock(&pool->lock);
+
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+    pool->live--;
+
+    SDL_AtomicUnlock(&pool->lock);
+}
+
+void ns_free_object_pools() {
+    while (true) {
+        SDL_AtomicLock(&registry_lock);
+
+        nsObjectPool *pool = registered_pools;
+        if (pool) {
+            registered_pools = pool->_next_registered;
+            pool->_next_registered = NULL;
+            pool->_registered = false;
+        }
+
+        SDL_AtomicUnlock(&registry_lock);
+
+        if (!pool) break;
+        nsObjectPool_free(pool);
+    }
+}
\ No newline at end of file
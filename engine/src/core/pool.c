@@ -8,7 +8,33 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
 #include "engine/include/core/pool.h"
+#include "engine/include/core/timer.h"
+
+
+static NS_THREAD_LOCAL nsPoolReallocStats realloc_stats = {0};
+
+
+/**
+ * @brief Reallocate pool data to the new capacity.
+ */
+static int grow(nsPool *pool, size_t new_capacity) {
+    ns_u64 start = ns_ticks();
+    void *new_data = NS_REALLOC(pool->data, new_capacity * pool->elem_size);
+    ns_u64 elapsed = ns_ticks() - start;
+    NS_MEM_CHECK_I(new_data);
+
+    realloc_stats.count++;
+    realloc_stats.bytes += pool->max * pool->elem_size;
+    realloc_stats.time += ns_ticks_to_seconds(elapsed);
+
+    pool->data = new_data;
+    pool->max = new_capacity;
+
+    return 0;
+}
 
 
 nsPool *nsPool_new(size_t elem_size) {
@@ -56,11 +82,7 @@ int nsPool_add(nsPool *pool, const void *elem) {
     // Only reallocate when max capacity is reached
     if (pool->size >= pool->max) {
         size_t new_capacity = (size_t)((float)pool->max * pool->growth_factor);
-        void *new_data = NS_REALLOC(pool->data, new_capacity * pool->elem_size);
-        NS_MEM_CHECK_I(new_data);
-
-        pool->data = new_data;
-        pool->max = new_capacity;
+        if (grow(pool, new_capacity)) return 1;
     }
 
     memcpy(
@@ -74,6 +96,12 @@ int nsPool_add(nsPool *pool, const void *elem) {
     return 0;
 }
 
+int nsPool_reserve(nsPool *pool, size_t capacity) {
+    if (capacity <= pool->max) return 0;
+
+    return grow(pool, capacity);
+}
+
 void *nsPool_get(nsPool *pool, size_t index) {
     if (index >= pool->size) {
         ns_throw_error("Index is out of bounds.\n", 0, nsErrorSeverity_ERROR);
@@ -83,9 +111,33 @@ void *nsPool_get(nsPool *pool, size_t index) {
     return (char *)pool->data + index * pool->elem_size;
 }
 
-int nsPool_remove(nsPool *pool, size_t index);
+int nsPool_remove(nsPool *pool, size_t index) {
+    if (index >= pool->size) {
+        ns_throw_error("Index is out of bounds.\n", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    pool->size--;
 
-void nsPool_clear(nsPool *pool);
+    // Fill the gap with the last element
+    if (index != pool->size) {
+        memcpy(
+            (char *)pool->data + index * pool->elem_size,
+            (char *)pool->data + pool->size * pool->elem_size,
+            pool->elem_size
+        );
+    }
+
+    return 0;
+}
+
+void nsPool_clear(nsPool *pool) {
+    pool->size = 0;
+}
+
+nsPoolReallocStats ns_get_pool_realloc_stats() {
+    return realloc_stats;
+}
 
 size_t nsPool_total_memory_used(nsPool *pool) {
     size_t pool_s = sizeof(nsPool);
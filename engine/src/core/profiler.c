@@ -0,0 +1,385 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include "engine/include/core/profiler.h"
+#include "engine/include/core/atomic.h"
+#include "engine/include/core/pool.h"
+
+
+#define RING_MASK (NS_PROFILER_RING_CAPACITY - 1)
+
+// Trace thread ID of frame markers, threads start after it
+#define FRAMES_TID 0
+
+/**
+ * @brief Begin or end event, end events have no name.
+ */
+typedef struct {
+    const char *name;
+    ns_u64 time;
+} Event;
+
+typedef struct {
+    const char *name;
+    ns_u64 time;
+    ns_u32 thread;
+} CapturedEvent;
+
+/**
+ * @brief Single-producer single-consumer ring of a recording thread.
+ * 
+ * The thread owns tail and the depth counters, the main thread owns head.
+ */
+typedef struct {
+    nsAtomicI64 head;
+    char _pad0[NS_CACHE_LINE_SIZE - sizeof(nsAtomicI64)];
+    nsAtomicI64 tail;
+    ns_i64 head_cache;
+    ns_u32 open_depth; // Recorded zones that haven't ended
+    ns_u32 dropped_depth; // Dropped zones that haven't ended
+    char _pad1[NS_CACHE_LINE_SIZE];
+    nsAtomicI32 in_use;
+    nsAtomicPtr name;
+    nsAtomicI64 dropped;
+    ns_u32 index;
+    Event events[NS_PROFILER_RING_CAPACITY];
+} ThreadBuffer;
+
+static nsAtomicPtr threads[NS_PROFILER_MAX_THREADS];
+static nsAtomicI32 thread_count;
+static SDL_SpinLock register_lock = 0;
+static NS_THREAD_LOCAL ThreadBuffer *local_buffer = NULL;
+
+// Track of GPU zones, filled by the main thread
+static ThreadBuffer *gpu_buffer = NULL;
+
+// Capture state, only touched by the main thread
+static ns_u32 requested_frames = 0;
+static ns_u32 frames_left = 0;
+static ns_bool capture_active = false;
+static ns_u64 capture_start = 0;
+static ns_u64 capture_end = 0;
+static nsPool *captured_events = NULL;
+static nsPool *frame_marks = NULL;
+
+
+static ThreadBuffer *register_thread() {
+    ThreadBuffer *buffer = NULL;
+
+    SDL_AtomicLock(&register_lock);
+
+    // Reuse the buffer of a thread that exited
+    ns_i32 count = ns_atomic_load_i32(&thread_count, NS_ATOMIC_RELAXED);
+    for (ns_i32 i = 0; i < count; i++) {
+        ThreadBuffer *candidate = ns_atomic_load_ptr(&threads[i], NS_ATOMIC_RELAXED);
+        if (!ns_atomic_load_i32(&candidate->in_use, NS_ATOMIC_ACQUIRE)) {
+            buffer = candidate;
+            break;
+        }
+    }
+
+    if (!buffer && count < NS_PROFILER_MAX_THREADS) {
+        buffer = NS_NEW(ThreadBuffer);
+
+        if (buffer) {
+            memset(buffer, 0, offsetof(ThreadBuffer, events));
+            buffer->index = (ns_u32)count;
+            ns_atomic_store_ptr(&threads[count], buffer, NS_ATOMIC_RELEASE);
+            ns_atomic_store_i32(&thread_count, count + 1, NS_ATOMIC_RELEASE);
+        }
+    }
+
+    if (buffer) {
+        buffer->open_depth = 0;
+        buffer->dropped_depth = 0;
+        ns_atomic_store_ptr(&buffer->name, NULL, NS_ATOMIC_RELAXED);
+        ns_atomic_store_i32(&buffer->in_use, 1, NS_ATOMIC_RELEASE);
+    }
+
+    SDL_AtomicUnlock(&register_lock);
+
+    return buffer;
+}
+
+static inline ThreadBuffer *get_buffer() {
+    if (!local_buffer) local_buffer = register_thread();
+    return local_buffer;
+}
+
+static ThreadBuffer *get_gpu_buffer() {
+    if (!gpu_buffer) {
+        gpu_buffer = register_thread();
+        if (gpu_buffer) ns_atomic_store_ptr(&gpu_buffer->name, "GPU", NS_ATOMIC_RELEASE);
+    }
+    return gpu_buffer;
+}
+
+static inline void push_event(ThreadBuffer *buffer, const char *name, ns_u64 time) {
+    ns_i64 tail = ns_atomic_load_i64(&buffer->tail, NS_ATOMIC_RELAXED);
+
+    buffer->events[tail & RING_MASK] = (Event){.name = name, .time = time};
+    ns_atomic_store_i64(&buffer->tail, tail + 1, NS_ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Check if a zone can begin, zones inside a dropped zone are dropped too.
+ */
+static ns_bool reserve_zone(ThreadBuffer *buffer) {
+    if (buffer->dropped_depth > 0) {
+        buffer->dropped_depth++;
+        return false;
+    }
+
+    // Leave room for the ends of every open zone, so ends are never dropped
+    ns_i64 tail = ns_atomic_load_i64(&buffer->tail, NS_ATOMIC_RELAXED);
+    ns_i64 needed = (ns_i64)buffer->open_depth + 2;
+
+    if (NS_PROFILER_RING_CAPACITY - (tail - buffer->head_cache) < needed) {
+        buffer->head_cache = ns_atomic_load_i64(&buffer->head, NS_ATOMIC_ACQUIRE);
+
+        if (NS_PROFILER_RING_CAPACITY - (tail - buffer->head_cache) < needed) {
+            buffer->dropped_depth = 1;
+            ns_atomic_add_i64(&buffer->dropped, 1, NS_ATOMIC_RELAXED);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check if the innermost zone was recorded and has to be ended.
+ */
+static ns_bool release_zone(ThreadBuffer *buffer) {
+    if (buffer->dropped_depth > 0) {
+        buffer->dropped_depth--;
+        return false;
+    }
+
+    return buffer->open_depth > 0;
+}
+
+
+void ns_profiler_begin_zone(const char *name) {
+    ThreadBuffer *buffer = get_buffer();
+    if (!buffer || !reserve_zone(buffer)) return;
+
+    push_event(buffer, name, ns_ticks());
+    buffer->open_depth++;
+}
+
+void ns_profiler_end_zone() {
+    ThreadBuffer *buffer = local_buffer;
+    if (!buffer || !release_zone(buffer)) return;
+
+    push_event(buffer, NULL, ns_ticks());
+    buffer->open_depth--;
+}
+
+void ns_profiler_begin_gpu_zone(const char *name, ns_u64 time) {
+    ThreadBuffer *buffer = get_gpu_buffer();
+    if (!buffer || !reserve_zone(buffer)) return;
+
+    push_event(buffer, name, time);
+    buffer->open_depth++;
+}
+
+void ns_profiler_end_gpu_zone(ns_u64 time) {
+    ThreadBuffer *buffer = gpu_buffer;
+    if (!buffer || !release_zone(buffer)) return;
+
+    push_event(buffer, NULL, time);
+    buffer->open_depth--;
+}
+
+void ns_profiler_set_thread_name(const char *name) {
+    ThreadBuffer *buffer = get_buffer();
+    if (!buffer) return;
+
+    ns_atomic_store_ptr(&buffer->name, (void *)name, NS_ATOMIC_RELEASE);
+}
+
+void ns_profiler_release_thread() {
+    if (!local_buffer) return;
+
+    ns_atomic_store_i32(&local_buffer->in_use, 0, NS_ATOMIC_RELEASE);
+    local_buffer = NULL;
+}
+
+void ns_profiler_frame() {
+    ns_u64 now = ns_ticks();
+
+    ns_i32 count = ns_atomic_load_i32(&thread_count, NS_ATOMIC_ACQUIRE);
+
+    for (ns_i32 i = 0; i < count; i++) {
+        ThreadBuffer *buffer = ns_atomic_load_ptr(&threads[i], NS_ATOMIC_ACQUIRE);
+        if (!buffer) continue;
+
+        ns_i64 head = ns_atomic_load_i64(&buffer->head, NS_ATOMIC_RELAXED);
+        ns_i64 tail = ns_atomic_load_i64(&buffer->tail, NS_ATOMIC_ACQUIRE);
+
+        if (capture_active) {
+            for (ns_i64 j = head; j < tail; j++) {
+                Event *event = &buffer->events[j & RING_MASK];
+                CapturedEvent captured = {.name = event->name, .time = event->time, .thread = buffer->index};
+
+                // Out of memory only shortens the capture
+                if (nsPool_add(captured_events, &captured)) {
+                    capture_active = false;
+                    break;
+                }
+            }
+        }
+
+        ns_atomic_store_i64(&buffer->head, tail, NS_ATOMIC_RELEASE);
+    }
+
+    if (capture_active) {
+        nsPool_add(frame_marks, &now);
+        capture_end = now;
+
+        if (--frames_left == 0) capture_active = false;
+    }
+    // Events drained above happened before the capture, they are discarded
+    else if (requested_frames > 0) {
+        if (!captured_events) captured_events = nsPool_new(sizeof(CapturedEvent));
+        if (!frame_marks) frame_marks = nsPool_new(sizeof(ns_u64));
+        if (!captured_events || !frame_marks) return;
+
+        nsPool_clear(captured_events);
+        nsPool_clear(frame_marks);
+        nsPool_add(frame_marks, &now);
+
+        capture_active = true;
+        capture_start = now;
+        capture_end = now;
+        frames_left = requested_frames;
+        requested_frames = 0;
+    }
+}
+
+void ns_profiler_start_capture(ns_u32 frame_count) {
+    requested_frames = frame_count;
+    capture_active = false;
+}
+
+ns_bool ns_profiler_is_capturing() {
+    return capture_active || requested_frames > 0;
+}
+
+
+static void write_json_string(FILE *file, const char *string) {
+    fputc('"', file);
+
+    for (const char *c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+        else if ((unsigned char)*c < 0x20) fprintf(file, "\\u%04x", *c);
+        else fputc(*c, file);
+    }
+
+    fputc('"', file);
+}
+
+static inline double trace_time(ns_u64 time) {
+    // Trace timestamps are in microseconds, relative to the capture start.
+    // Events published right after the first frame mark can be slightly before it.
+    double ticks = (double)(ns_i64)(time - capture_start);
+    return ticks * ns_timer_get_calibration().ns_per_tick / 1000.0;
+}
+
+int ns_profiler_save_capture(const char *filepath) {
+    if (!frame_marks || frame_marks->size < 2 || ns_profiler_is_capturing()) {
+        ns_throw_error("There is no finished profiler capture.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    FILE *file = fopen(filepath, "w");
+    if (!file) {
+        ns_throw_error("Failed to open profiler capture for writing.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"nsengine\"}},\n", FRAMES_TID);
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Frames\"}}", FRAMES_TID);
+
+    ns_i32 count = ns_atomic_load_i32(&thread_count, NS_ATOMIC_ACQUIRE);
+    for (ns_i32 i = 0; i < count; i++) {
+        ThreadBuffer *buffer = ns_atomic_load_ptr(&threads[i], NS_ATOMIC_ACQUIRE);
+        const char *name = ns_atomic_load_ptr(&buffer->name, NS_ATOMIC_ACQUIRE);
+
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", i + 1);
+        if (name) write_json_string(file, name);
+        else fprintf(file, "\"Thread %d\"", i + 1);
+        fprintf(file, "}}");
+    }
+
+    ns_u64 *marks = frame_marks->data;
+    for (size_t i = 0; i + 1 < frame_marks->size; i++) {
+        fprintf(
+            file,
+            ",\n{\"name\":\"Frame %zu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            i, FRAMES_TID, trace_time(marks[i]), (double)ns_ticks_to_ns(marks[i + 1] - marks[i]) / 1000.0
+        );
+    }
+
+    // Zones that began before the capture have their ends skipped, zones
+    // still open at the end are closed at the last frame mark
+    ns_u32 depths[NS_PROFILER_MAX_THREADS] = {0};
+
+    CapturedEvent *events = captured_events->data;
+    for (size_t i = 0; i < captured_events->size; i++) {
+        CapturedEvent *event = &events[i];
+
+        if (event->name) {
+            depths[event->thread]++;
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", event->thread + 1, trace_time(event->time));
+        }
+        else if (depths[event->thread] > 0) {
+            depths[event->thread]--;
+            fprintf(file, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", event->thread + 1, trace_time(event->time));
+        }
+    }
+
+    for (ns_i32 i = 0; i < count; i++) {
+        for (; depths[i] > 0; depths[i]--) {
+            fprintf(file, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", i + 1, trace_time(capture_end));
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file)) {
+        ns_throw_error("Failed to write profiler capture.", 0, nsErrorSeverity_ERROR);
+        return 1;
+    }
+
+    return 0;
+}
+
+void ns_free_profiler() {
+    ns_i32 count = ns_atomic_load_i32(&thread_count, NS_ATOMIC_ACQUIRE);
+    for (ns_i32 i = 0; i < count; i++) {
+        NS_FREE(ns_atomic_load_ptr(&threads[i], NS_ATOMIC_RELAXED));
+        ns_atomic_store_ptr(&threads[i], NULL, NS_ATOMIC_RELAXED);
+    }
+    ns_atomic_store_i32(&thread_count, 0, NS_ATOMIC_RELEASE);
+    local_buffer = NULL;
+    gpu_buffer = NULL;
+
+    nsPool_free(captured_events);
+    nsPool_free(frame_marks);
+    captured_events = NULL;
+    frame_marks = NULL;
+    requested_frames = 0;
+    capture_active = false;
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
+#include "engine/include/core/queue.h"
+
+
+#define ALIGN_UP(size) (((size) + 7) & ~(size_t)7)
+
+
+static size_t round_capacity(size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) rounded *= 2;
+    return rounded;
+}
+
+
+nsSPSCQueue *nsSPSCQueue_new(size_t elem_size, size_t capacity) {
+    if (elem_size == 0) {
+        ns_throw_error("Queue element size can't be zero.", 0, nsErrorSeverity_ERROR);
+        return NULL;
+    }
+
+    nsSPSCQueue *queue = NS_NEW(nsSPSCQueue);
+    NS_MEM_CHECK(queue);
+
+    *queue = (nsSPSCQueue){0};
+    queue->elem_size = elem_size;
+    queue->capacity = round_capacity(capacity);
+
+    ns_u8 *data = NS_MALLOC(queue->elem_size * queue->capacity);
+    if (!data) {
+        NS_FREE(queue);
+        NS_MEM_CHECK(data);
+    }
+    queue->data = data;
+
+    return queue;
+}
+
+void nsSPSCQueue_free(nsSPSCQueue *queue) {
+    if (!queue) return;
+
+    NS_FREE(queue->data);
+
+    NS_FREE(queue);
+}
+
+ns_bool nsSPSCQueue_push(nsSPSCQueue *queue, const void *elem) {
+    ns_i64 tail = ns_atomic_load_i64(&queue->_tail, NS_ATOMIC_RELAXED);
+
+    // Only look at the consumer's index when the cached one says full
+    if (tail - queue->_head_cache == (ns_i64)queue->capacity) {
+        queue->_head_cache = ns_atomic_load_i64(&queue->_head, NS_ATOMIC_ACQUIRE);
+        if (tail - queue->_head_cache == (ns_i64)queue->capacity) return false;
+    }
+
+    size_t index = (size_t)tail & (queue->capacity - 1);
+    memcpy(queue->data + index * queue->elem_size, elem, queue->elem_size);
+    ns_atomic_store_i64(&queue->_tail, tail + 1, NS_ATOMIC_RELEASE);
+
+    return true;
+}
+
+ns_bool nsSPSCQueue_pop(nsSPSCQueue *queue, void *elem) {
+    ns_i64 head = ns_atomic_load_i64(&queue->_head, NS_ATOMIC_RELAXED);
+
+    if (head == queue->_tail_cache) {
+        queue->_tail_cache = ns_atomic_load_i64(&queue->_tail, NS_ATOMIC_ACQUIRE);
+        if (head == queue->_tail_cache) return false;
+    }
+
+    size_t index = (size_t)head & (queue->capacity - 1);
+    memcpy(elem, queue->data + index * queue->elem_size, queue->elem_size);
+    ns_atomic_store_i64(&queue->_head, head + 1, NS_ATOMIC_RELEASE);
+
+    return true;
+}
+
+size_t nsSPSCQueue_size(nsSPSCQueue *queue) {
+    ns_i64 head = ns_atomic_load_i64(&queue->_head, NS_ATOMIC_ACQUIRE);
+    ns_i64 tail = ns_atomic_load_i64(&queue->_tail, NS_ATOMIC_ACQUIRE);
+    return tail > head ? (size_t)(tail - head) : 0;
+}
+
+
+static inline nsAtomicI64 *cell_sequence(nsMPMCQueue *queue, ns_i64 pos) {
+    size_t index = (size_t)pos & (queue->capacity - 1);
+    return (nsAtomicI64 *)(queue->_cells + index * queue->_stride);
+}
+
+static inline void *cell_data(nsAtomicI64 *sequence) {
+    return sequence + 1;
+}
+
+
+nsMPMCQueue *nsMPMCQueue_new(size_t elem_size, size_t capacity) {
+    if (elem_size == 0) {
+        ns_throw_error("Queue element size can't be zero.", 0, nsErrorSeverity_ERROR);
+        return NULL;
+    }
+
+    nsMPMCQueue *queue = NS_NEW(nsMPMCQueue);
+    NS_MEM_CHECK(queue);
+
+    *queue = (nsMPMCQueue){0};
+    queue->elem_size = elem_size;
+    queue->capacity = round_capacity(capacity);
+    queue->_stride = sizeof(nsAtomicI64) + ALIGN_UP(elem_size);
+
+    ns_u8 *cells = NS_MALLOC(queue->_stride * queue->capacity);
+    if (!cells) {
+        NS_FREE(queue);
+        NS_MEM_CHECK(cells);
+    }
+    queue->_cells = cells;
+
+    // Cell i is ready to be written at position i
+    for (size_t i = 0; i < queue->capacity; i++) {
+        ns_atomic_store_i64(cell_sequence(queue, (ns_i64)i), (ns_i64)i, NS_ATOMIC_RELAXED);
+    }
+
+    return queue;
+}
+
+void nsMPMCQueue_free(nsMPMCQueue *queue) {
+    if (!queue) return;
+
+    NS_FREE(queue->_cells);
+
+    NS_FREE(queue);
+}
+
+ns_bool nsMPMCQueue_push(nsMPMCQueue *queue, const void *elem) {
+    ns_i64 pos = ns_atomic_load_i64(&queue->_enqueue_pos, NS_ATOMIC_RELAXED);
+    nsAtomicI64 *sequence;
+
+    for (;;) {
+        sequence = cell_sequence(queue, pos);
+        ns_i64 diff = ns_atomic_load_i64(sequence, NS_ATOMIC_ACQUIRE) - pos;
+
+        if (diff == 0) {
+            if (ns_atomic_cas_i64(&queue->_enqueue_pos, pos, pos + 1, NS_ATOMIC_RELAXED)) break;
+        }
+        // Cell still holds an element from the previous lap
+        else if (diff < 0) {
+            return false;
+        }
+
+        pos = ns_atomic_load_i64(&queue->_enqueue_pos, NS_ATOMIC_RELAXED);
+    }
+
+    memcpy(cell_data(sequence), elem, queue->elem_size);
+    ns_atomic_store_i64(sequence, pos + 1, NS_ATOMIC_RELEASE);
+
+    return true;
+}
+
+ns_bool nsMPMCQueue_pop(nsMPMCQueue *queue, void *elem) {
+    ns_i64 pos = ns_atomic_load_i64(&queue->_dequeue_pos, NS_ATOMIC_RELAXED);
+    nsAtomicI64 *sequence;
+
+    for (;;) {
+        sequence = cell_sequence(queue, pos);
+        ns_i64 diff = ns_atomic_load_i64(sequence, NS_ATOMIC_ACQUIRE) - (pos + 1);
+
+        if (diff == 0) {
+            if (ns_atomic_cas_i64(&queue->_dequeue_pos, pos, pos + 1, NS_ATOMIC_RELAXED)) break;
+        }
+        // Cell wasn't written on this lap yet
+        else if (diff < 0) {
+            return false;
+        }
+
+        pos = ns_atomic_load_i64(&queue->_dequeue_pos, NS_ATOMIC_RELAXED);
+    }
+
+    memcpy(elem, cell_data(sequence), queue->elem_size);
+
+    // Ready to be written on the next lap
+    ns_atomic_store_i64(sequence, pos + (ns_i64)queue->capacity, NS_ATOMIC_RELEASE);
+
+    return true;
+}
+
+
+void nsIntrusiveStack_push(nsIntrusiveStack *stack, nsStackNode *node) {
+    for (;;) {
+        nsStackNode *head = ns_atomic_load_ptr(&stack->_head, NS_ATOMIC_RELAXED);
+        node->next = head;
+
+        if (ns_atomic_cas_ptr(&stack->_head, head, node, NS_ATOMIC_RELEASE)) return;
+    }
+}
+
+nsStackNode *nsIntrusiveStack_pop_all(nsIntrusiveStack *stack) {
+    // Cheap check first, so polling an empty stack doesn't take the cache line exclusively
+    if (nsIntrusiveStack_is_empty(stack)) return NULL;
+
+    return ns_atomic_exchange_ptr(&stack->_head, NULL, NS_ATOMIC_ACQUIRE);
+}
+
+nsStackNode *nsStackNode_reverse(nsStackNode *list) {
+    nsStackNode *reversed = NULL;
+
+    while (list) {
+        nsStackNode *next = list->next;
+        list->next = reversed;
+        reversed = list;
+        list = next;
+    }
+
+    return reversed;
+}
\ No newline at end of file
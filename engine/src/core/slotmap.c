@@ -0,0 +1,164 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
+#include "engine/include/core/slotmap.h"
+
+
+typedef struct {
+    ns_u32 index; /**< Dense index of the value if alive, next free slot otherwise. */
+    ns_u32 generation; /**< Generation of the current or the next value. */
+} Slot;
+
+
+static inline Slot *get_slot(nsSlotMap *slotmap, nsHandle handle) {
+    ns_u32 index = nsHandle_index(handle);
+    if (index >= slotmap->slots->size) return NULL;
+
+    Slot *slot = (Slot *)slotmap->slots->data + index;
+    if (slot->generation != nsHandle_generation(handle)) return NULL;
+
+    return slot;
+}
+
+/**
+ * @brief Bump slot's generation and put it on the free list, unless the generation is used up.
+ */
+static inline void release_slot(nsSlotMap *slotmap, ns_u32 index) {
+    Slot *slot = (Slot *)slotmap->slots->data + index;
+
+    slot->generation++;
+    if (slot->generation > NS_HANDLE_GENERATION_MASK) return;
+
+    slot->index = slotmap->free_slot;
+    slotmap->free_slot = index;
+}
+
+
+nsSlotMap *nsSlotMap_new(size_t elem_size) {
+    nsSlotMap *slotmap = NS_NEW(nsSlotMap);
+    NS_MEM_CHECK(slotmap);
+
+    slotmap->free_slot = NS_SLOTMAP_MAX_SLOTS;
+    slotmap->values = nsPool_new(elem_size);
+    slotmap->value_slots = nsPool_new(sizeof(ns_u32));
+    slotmap->slots = nsPool_new(sizeof(Slot));
+
+    if (!slotmap->values || !slotmap->value_slots || !slotmap->slots) {
+        nsSlotMap_free(slotmap);
+        return NULL;
+    }
+
+    return slotmap;
+}
+
+void nsSlotMap_free(nsSlotMap *slotmap) {
+    if (!slotmap) return;
+
+    nsPool_free(slotmap->values);
+    nsPool_free(slotmap->value_slots);
+    nsPool_free(slotmap->slots);
+
+    NS_FREE(slotmap);
+}
+
+int nsSlotMap_reserve(nsSlotMap *slotmap, size_t capacity) {
+    if (nsPool_reserve(slotmap->values, capacity)) return 1;
+    if (nsPool_reserve(slotmap->value_slots, capacity)) return 1;
+    if (nsPool_reserve(slotmap->slots, capacity)) return 1;
+
+    return 0;
+}
+
+nsHandle nsSlotMap_add(nsSlotMap *slotmap, const void *elem) {
+    if (slotmap->free_slot == NS_SLOTMAP_MAX_SLOTS && slotmap->slots->size >= NS_SLOTMAP_MAX_SLOTS) {
+        ns_throw_error("Slot map is full.", 0, nsErrorSeverity_ERROR);
+        return NS_HANDLE_NULL;
+    }
+
+    ns_u32 dense_index = (ns_u32)slotmap->values->size;
+    if (nsPool_add(slotmap->values, elem)) return NS_HANDLE_NULL;
+
+    // Generations start at 1 so that a valid handle is never NS_HANDLE_NULL
+    ns_u32 index = slotmap->free_slot;
+    if (index == NS_SLOTMAP_MAX_SLOTS) {
+        index = (ns_u32)slotmap->slots->size;
+
+        Slot slot = {.index = dense_index, .generation = 1};
+        if (nsPool_add(slotmap->slots, &slot)) {
+            slotmap->values->size--;
+            return NS_HANDLE_NULL;
+        }
+    }
+    else {
+        slotmap->free_slot = ((Slot *)slotmap->slots->data)[index].index;
+    }
+
+    if (nsPool_add(slotmap->value_slots, &index)) {
+        slotmap->values->size--;
+        ((Slot *)slotmap->slots->data)[index].index = slotmap->free_slot;
+        slotmap->free_slot = index;
+        return NS_HANDLE_NULL;
+    }
+
+    Slot *slot = (Slot *)slotmap->slots->data + index;
+    slot->index = dense_index;
+
+    return nsHandle_make(index, slot->generation);
+}
+
+void *nsSlotMap_get(nsSlotMap *slotmap, nsHandle handle) {
+    Slot *slot = get_slot(slotmap, handle);
+    if (!slot) return NULL;
+
+    return (char *)slotmap->values->data + (size_t)slot->index * slotmap->values->elem_size;
+}
+
+ns_bool nsSlotMap_contains(nsSlotMap *slotmap, nsHandle handle) {
+    return get_slot(slotmap, handle) != NULL;
+}
+
+int nsSlotMap_remove(nsSlotMap *slotmap, nsHandle handle) {
+    Slot *slot = get_slot(slotmap, handle);
+    if (!slot) return 1;
+
+    // Last value is swapped into the gap, point its slot to the new place
+    ns_u32 dense_index = slot->index;
+    ns_u32 last_slot = ((ns_u32 *)slotmap->value_slots->data)[slotmap->value_slots->size - 1];
+    ((Slot *)slotmap->slots->data)[last_slot].index = dense_index;
+
+    nsPool_remove(slotmap->values, dense_index);
+    nsPool_remove(slotmap->value_slots, dense_index);
+
+    release_slot(slotmap, nsHandle_index(handle));
+
+    return 0;
+}
+
+void nsSlotMap_clear(nsSlotMap *slotmap) {
+    const ns_u32 *value_slots = (const ns_u32 *)slotmap->value_slots->data;
+
+    for (size_t i = 0; i < slotmap->value_slots->size; i++) {
+        release_slot(slotmap, value_slots[i]);
+    }
+
+    nsPool_clear(slotmap->values);
+    nsPool_clear(slotmap->value_slots);
+}
+
+nsHandle nsSlotMap_handle_at(nsSlotMap *slotmap, size_t index) {
+    if (index >= slotmap->value_slots->size) return NS_HANDLE_NULL;
+
+    ns_u32 slot_index = ((const ns_u32 *)slotmap->value_slots->data)[index];
+    const Slot *slot = (const Slot *)slotmap->slots->data + slot_index;
+
+    return nsHandle_make(slot_index, slot->generation);
+}
\ No newline at end of file
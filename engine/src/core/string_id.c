@@ -0,0 +1,139 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_CONTAINERS
+
+#include "engine/include/core/string_id.h"
+#include "engine/include/core/hashmap.h"
+#include "engine/include/core/pool.h"
+#include "engine/include/core/arena.h"
+
+
+#define STRING_ARENA_BLOCK_SIZE (64 * 1024)
+
+static SDL_SpinLock lock = 0;
+static nsHashMap *ids = NULL; // Interned string -> ID
+static nsPool *strings = NULL; // ID - 1 -> interned string
+static nsArena string_arena; // String copies, arena blocks never move
+
+
+static int init_tables() {
+    if (ids) return 0;
+
+    ids = nsHashMap_new(sizeof(const char *), sizeof(nsStringId), ns_hash_string_key, ns_equal_string_key);
+    strings = nsPool_new(sizeof(const char *));
+
+    if (!ids || !strings) {
+        nsHashMap_free(ids);
+        nsPool_free(strings);
+        ids = NULL;
+        strings = NULL;
+        return 1;
+    }
+
+    nsArena_init(&string_arena, STRING_ARENA_BLOCK_SIZE);
+
+    return 0;
+}
+
+
+nsStringId ns_intern_string(const char *string) {
+    SDL_AtomicLock(&lock);
+
+    if (init_tables()) {
+        SDL_AtomicUnlock(&lock);
+        return NS_STRING_ID_NONE;
+    }
+
+    nsStringId *found = nsHashMap_get(ids, &string);
+    if (found) {
+        nsStringId id = *found;
+        SDL_AtomicUnlock(&lock);
+        return id;
+    }
+
+    size_t length = strlen(string);
+    nsArenaMark mark = nsArena_mark(&string_arena);
+
+    char *copy = nsArena_alloc(&string_arena, length + 1);
+    if (!copy) {
+        SDL_AtomicUnlock(&lock);
+        return NS_STRING_ID_NONE;
+    }
+    memcpy(copy, string, length + 1);
+
+    nsStringId id = (nsStringId)strings->size + 1;
+
+    if (nsPool_add(strings, &copy)) {
+        nsArena_rewind(&string_arena, mark);
+        SDL_AtomicUnlock(&lock);
+        return NS_STRING_ID_NONE;
+    }
+
+    if (nsHashMap_set(ids, &copy, &id)) {
+        strings->size--;
+        nsArena_rewind(&string_arena, mark);
+        SDL_AtomicUnlock(&lock);
+        return NS_STRING_ID_NONE;
+    }
+
+    SDL_AtomicUnlock(&lock);
+
+    return id;
+}
+
+nsStringId ns_find_string_id(const char *string) {
+    nsStringId id = NS_STRING_ID_NONE;
+
+    SDL_AtomicLock(&lock);
+
+    if (ids) {
+        nsStringId *found = nsHashMap_get(ids, &string);
+        if (found) id = *found;
+    }
+
+    SDL_AtomicUnlock(&lock);
+
+    return id;
+}
+
+const char *ns_string_id_as_string(nsStringId id) {
+    const char *string = NULL;
+
+    SDL_AtomicLock(&lock);
+
+    if (strings && id != NS_STRING_ID_NONE && id <= strings->size) {
+        string = ((const char **)strings->data)[id - 1];
+    }
+
+    SDL_AtomicUnlock(&lock);
+
+    return string;
+}
+
+size_t ns_get_string_id_count() {
+    SDL_AtomicLock(&lock);
+    size_t count = strings ? strings->size : 0;
+    SDL_AtomicUnlock(&lock);
+
+    return count;
+}
+
+void ns_free_string_ids() {
+    SDL_AtomicLock(&lock);
+
+    nsHashMap_free(ids);
+    nsPool_free(strings);
+    nsArena_free(&string_arena);
+    ids = NULL;
+    strings = NULL;
+
+    SDL_AtomicUnlock(&lock);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include "engine/include/core/timer.h"
+
+#if _NS_TIMER_TSC && NS_COMPILER != NS_COMPILER_MSVC
+    #include <cpuid.h>
+#endif
+
+
+// Longer calibration averages out the cost of reading the clocks
+#define CALIBRATION_NS 10000000ULL
+
+nsTimerCalibration _ns_global_timer = {
+    .use_tsc = false,
+    .ns_per_tick = 1.0,
+    .ticks_per_second = 1e9
+};
+
+static ns_bool calibrated = false;
+
+
+#if _NS_TIMER_TSC
+
+/**
+ * @brief Check if TSC ticks at a constant rate regardless of frequency scaling and sleep states.
+ */
+static ns_bool has_invariant_tsc() {
+    #if NS_COMPILER == NS_COMPILER_MSVC
+
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if ((unsigned int)info[0] < 0x80000007) return false;
+
+    __cpuid(info, 0x80000007);
+    return (info[3] & (1 << 8)) != 0;
+
+    #else
+
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+
+    return (edx & (1 << 8)) != 0;
+
+    #endif
+}
+
+/**
+ * @brief Read TSC along with the system clock time halfway through the read.
+ */
+static ns_u64 sample_tsc(ns_u64 *time) {
+    ns_u64 before = ns_time_ns();
+    ns_u64 tsc = __rdtsc();
+    ns_u64 after = ns_time_ns();
+
+    *time = before + (after - before) / 2;
+    return tsc;
+}
+
+#endif
+
+
+void ns_timer_calibrate() {
+    if (calibrated) return;
+    calibrated = true;
+
+    #if _NS_TIMER_TSC
+
+    if (!has_invariant_tsc()) return;
+
+    ns_u64 time_start, time_end;
+    ns_u64 tsc_start = sample_tsc(&time_start);
+
+    while (ns_time_ns() - time_start < CALIBRATION_NS);
+
+    ns_u64 tsc_end = sample_tsc(&time_end);
+
+    double ticks_per_ns = (double)(tsc_end - tsc_start) / (double)(time_end - time_start);
+
+    // Broken or virtualized counters, stay on the system clock
+    if (ticks_per_ns < 0.1 || ticks_per_ns > 20.0) return;
+
+    _ns_global_timer.use_tsc = true;
+    _ns_global_timer.ns_per_tick = 1.0 / ticks_per_ns;
+    _ns_global_timer.ticks_per_second = ticks_per_ns * 1e9;
+
+    #endif
+}
\ No newline at end of file
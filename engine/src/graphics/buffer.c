@@ -8,20 +8,77 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_MESHES
+
 #include "engine/include/graphics/buffer.h"
+#include "engine/include/core/arena.h"
+#include "engine/include/core/object_pool.h"
+
+
+static nsObjectPool buffer_pool = NS_OBJECT_POOL_INIT(nsBuffer, 128, nsMemoryTag_MESHES);
 
 
 nsBuffer *nsBuffer_new(ns_u32 attribute_loc, ns_u32 components) {
-    nsBuffer *buffer = NS_NEW(nsBuffer);
+    nsBuffer *buffer = nsObjectPool_alloc(&buffer_pool);
     NS_MEM_CHECK(buffer);
 
     glGenBuffers(1, &buffer->buffer_id);
     // TODO: buffer_id creation fail check
 
-    buffer->attribute_loc = attribute_loc;
-    buffer->components = components;
+    buffer->type = nsBufferType_VERTEX;
+    buffer->attributes[0] = (nsVertexAttribute){
+        .location = attribute_loc,
+        .components = components,
+        .type = GL_FLOAT,
+        .normalized = false,
+        .offset = 0
+    };
+    buffer->attribute_count = 1;
+    buffer->index_type = 0;
+
+    buffer->stride = sizeof(float) * components;
+    buffer->count = 0;
+
+    return buffer;
+}
+
+nsBuffer *nsBuffer_new_interleaved(
+    const nsVertexAttribute *attributes,
+    ns_u32 attribute_count,
+    size_t stride
+) {
+    if (attribute_count == 0 || attribute_count > NS_BUFFER_MAX_ATTRIBUTES) {
+        ns_throw_error("Invalid vertex attribute count.", 0, nsErrorSeverity_ERROR);
+        return NULL;
+    }
+
+    nsBuffer *buffer = nsObjectPool_alloc(&buffer_pool);
+    NS_MEM_CHECK(buffer);
+
+    glGenBuffers(1, &buffer->buffer_id);
+
+    buffer->type = nsBufferType_VERTEX;
+    memcpy(buffer->attributes, attributes, sizeof(nsVertexAttribute) * attribute_count);
+    buffer->attribute_count = attribute_count;
+    buffer->index_type = 0;
+
+    buffer->stride = stride;
+    buffer->count = 0;
+
+    return buffer;
+}
+
+nsBuffer *nsBuffer_new_index(void) {
+    nsBuffer *buffer = nsObjectPool_alloc(&buffer_pool);
+    NS_MEM_CHECK(buffer);
+
+    glGenBuffers(1, &buffer->buffer_id);
+
+    buffer->type = nsBufferType_INDEX;
+    buffer->attribute_count = 0;
+    buffer->index_type = GL_UNSIGNED_INT;
 
-    buffer->stride = sizeof(float) * buffer->components; // TODO: internal
+    buffer->stride = sizeof(ns_u32);
     buffer->count = 0;
 
     return buffer;
@@ -32,13 +89,86 @@ void nsBuffer_free(nsBuffer *buffer) {
 
     glDeleteBuffers(1, &buffer->buffer_id);
 
-    NS_FREE(buffer);
+    nsObjectPool_release(&buffer_pool, buffer);
+}
+
+void nsBuffer_write(nsBuffer *buffer, const float *data, size_t count) {
+    nsBuffer_write_raw(buffer, data, count);
 }
 
-void nsBuffer_write(nsBuffer *buffer, float *data, size_t count) {
+void nsBuffer_write_raw(nsBuffer *buffer, const void *data, size_t count) {
     buffer->count = count;
     glBindBuffer(GL_ARRAY_BUFFER, buffer->buffer_id);
     // TODO: static draw, dynamic draw, diger buffer data fonksiyonu, vs...
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * count * buffer->components, data, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, buffer->stride * count, data, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int nsBuffer_write_indices(nsBuffer *buffer, const ns_u32 *indices, size_t count) {
+    ns_u32 max_index = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (indices[i] > max_index) max_index = indices[i];
+    }
+
+    if (max_index > 0xFFFF) {
+        nsBuffer_write_indices_ex(buffer, indices, count, GL_UNSIGNED_INT);
+        return 0;
+    }
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    ns_u16 *narrow = nsArena_alloc(scratch, sizeof(ns_u16) * count);
+    if (!narrow) return 1;
+
+    for (size_t i = 0; i < count; i++) {
+        narrow[i] = (ns_u16)indices[i];
+    }
+
+    nsBuffer_write_indices_ex(buffer, narrow, count, GL_UNSIGNED_SHORT);
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+void nsBuffer_write_indices_ex(
+    nsBuffer *buffer,
+    const void *indices,
+    size_t count,
+    ns_u32 index_type
+) {
+    buffer->count = count;
+    buffer->index_type = index_type;
+    buffer->stride = index_type == GL_UNSIGNED_SHORT ? sizeof(ns_u16) : sizeof(ns_u32);
+
+    /*
+        Index buffer binding is part of the VAO state,
+        so don't disturb whatever VAO is bound while uploading.
+    */
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->buffer_id);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffer->stride * count, indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+ns_bool nsBufferUpload_step(nsBufferUpload *upload, size_t max_bytes) {
+    size_t size = upload->size - upload->uploaded;
+    if (size > max_bytes) size = max_bytes;
+
+    // Copy target doesn't touch the VAO's index buffer binding
+    if (size > 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, upload->buffer->buffer_id);
+        glBufferSubData(
+            GL_COPY_WRITE_BUFFER,
+            (GLintptr)upload->uploaded,
+            (GLsizeiptr)size,
+            (const char *)upload->data + upload->uploaded
+        );
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        upload->uploaded += size;
+    }
+
+    return upload->uploaded == upload->size;
 }
\ No newline at end of file
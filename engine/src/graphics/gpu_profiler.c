@@ -0,0 +1,231 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include "engine/include/graphics/gpu_profiler.h"
+#include "engine/include/core/profiler.h"
+
+
+/**
+ * @brief Begin or end of a zone, end events have no name.
+ */
+typedef struct {
+    const char *name;
+} Event;
+
+/**
+ * @brief Zone events of a frame, with one timestamp query each.
+ */
+typedef struct {
+    Event events[NS_GPU_PROFILER_MAX_EVENTS];
+    size_t count;
+    ns_bool pending;
+
+    // GPU and CPU time sampled together, maps timestamps to capture ticks
+    ns_bool has_sync;
+    GLint64 sync_gpu;
+    ns_u64 sync_ticks;
+} Frame;
+
+static GLuint queries[NS_GPU_PROFILER_FRAMES][NS_GPU_PROFILER_MAX_EVENTS];
+static Frame frames[NS_GPU_PROFILER_FRAMES];
+static ns_bool queries_created = false;
+
+static ns_bool requested_enabled = false;
+static Frame *current = NULL; // NULL while disabled
+static size_t current_index = 0;
+static ns_u32 open_depth = 0;
+static ns_u32 dropped_depth = 0;
+
+// Results of the latest read frame
+static nsGPUZone zones[NS_GPU_PROFILER_MAX_EVENTS / 2];
+static size_t zone_count = 0;
+static double frame_time = 0.0;
+static ns_bool has_frame_time = false;
+
+
+#ifdef NS_PROFILER_ENABLE
+
+static ns_u64 gpu_to_ticks(const Frame *frame, GLuint64 time) {
+    double ns = (double)((ns_i64)time - (ns_i64)frame->sync_gpu);
+    return frame->sync_ticks + (ns_u64)(ns_i64)(ns / ns_timer_get_calibration().ns_per_tick);
+}
+
+#endif
+
+static void read_frame(size_t index) {
+    Frame *frame = &frames[index];
+    frame->pending = false;
+
+    if (frame->count == 0) {
+        zone_count = 0;
+        frame_time = 0.0;
+        has_frame_time = true;
+        return;
+    }
+
+    // Timestamps are written in order, if the last one is done all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(queries[index][frame->count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+
+    size_t stack[NS_GPU_PROFILER_MAX_EVENTS / 2];
+    ns_u32 depth = 0;
+    GLuint64 first = 0;
+
+    zone_count = 0;
+    frame_time = 0.0;
+    has_frame_time = true;
+
+    for (size_t i = 0; i < frame->count; i++) {
+        GLuint64 time;
+        glGetQueryObjectui64v(queries[index][i], GL_QUERY_RESULT, &time);
+        if (i == 0) first = time;
+
+        double seconds = (double)(time - first) / 1e9;
+
+        if (frame->events[i].name) {
+            zones[zone_count] = (nsGPUZone){
+                .name = frame->events[i].name,
+                .depth = depth,
+                .start = seconds,
+                .duration = 0.0
+            };
+            stack[depth++] = zone_count++;
+        }
+        else {
+            nsGPUZone *zone = &zones[stack[--depth]];
+            zone->duration = seconds - zone->start;
+            if (zone->depth == 0) frame_time += zone->duration;
+        }
+
+        #ifdef NS_PROFILER_ENABLE
+
+        if (frame->has_sync) {
+            if (frame->events[i].name) ns_profiler_begin_gpu_zone(frame->events[i].name, gpu_to_ticks(frame, time));
+            else ns_profiler_end_gpu_zone(gpu_to_ticks(frame, time));
+        }
+
+        #endif
+    }
+}
+
+
+void ns_gpu_profiler_set_enabled(ns_bool enabled) {
+    requested_enabled = enabled;
+}
+
+ns_bool ns_gpu_profiler_is_enabled() {
+    return current != NULL;
+}
+
+void ns_gpu_profiler_begin_zone(const char *name) {
+    if (!current) return;
+
+    if (dropped_depth > 0) {
+        dropped_depth++;
+        return;
+    }
+
+    // Leave room for the ends of every open zone
+    if (current->count + open_depth + 2 > NS_GPU_PROFILER_MAX_EVENTS) {
+        dropped_depth = 1;
+        return;
+    }
+
+    glQueryCounter(queries[current_index][current->count], GL_TIMESTAMP);
+    current->events[current->count++] = (Event){.name = name};
+    open_depth++;
+}
+
+void ns_gpu_profiler_end_zone() {
+    if (!current) return;
+
+    if (dropped_depth > 0) {
+        dropped_depth--;
+        return;
+    }
+
+    if (open_depth == 0) return;
+
+    glQueryCounter(queries[current_index][current->count], GL_TIMESTAMP);
+    current->events[current->count++] = (Event){.name = NULL};
+    open_depth--;
+}
+
+void ns_gpu_profiler_frame() {
+    if (current) {
+        while (open_depth > 0) ns_gpu_profiler_end_zone();
+        dropped_depth = 0;
+
+        current->pending = true;
+        current_index = (current_index + 1) % NS_GPU_PROFILER_FRAMES;
+    }
+
+    // Oldest frame in flight, its slot is reused now
+    if (frames[current_index].pending) read_frame(current_index);
+
+    if (!requested_enabled) {
+        // Results of earlier frames would be stale when enabled again
+        for (size_t i = 0; i < NS_GPU_PROFILER_FRAMES; i++) frames[i].pending = false;
+        current = NULL;
+        zone_count = 0;
+        frame_time = 0.0;
+        has_frame_time = false;
+        return;
+    }
+
+    if (!queries_created) {
+        glGenQueries(NS_GPU_PROFILER_FRAMES * NS_GPU_PROFILER_MAX_EVENTS, &queries[0][0]);
+        queries_created = true;
+    }
+
+    current = &frames[current_index];
+    current->count = 0;
+    current->has_sync = false;
+
+    #ifdef NS_PROFILER_ENABLE
+
+    // Syncing is a round trip to the driver, only worth it for captures
+    if (ns_profiler_is_capturing()) {
+        glGetInteger64v(GL_TIMESTAMP, &current->sync_gpu);
+        current->sync_ticks = ns_ticks();
+        current->has_sync = true;
+    }
+
+    #endif
+}
+
+ns_bool ns_gpu_profiler_has_frame_time() {
+    return has_frame_time;
+}
+
+double ns_gpu_profiler_get_frame_time() {
+    return frame_time;
+}
+
+const nsGPUZone *ns_gpu_profiler_get_zones(size_t *count) {
+    *count = zone_count;
+    return zones;
+}
+
+void ns_free_gpu_profiler() {
+    if (queries_created) {
+        glDeleteQueries(NS_GPU_PROFILER_FRAMES * NS_GPU_PROFILER_MAX_EVENTS, &queries[0][0]);
+        queries_created = false;
+    }
+
+    for (size_t i = 0; i < NS_GPU_PROFILER_FRAMES; i++) frames[i].pending = false;
+    current = NULL;
+    open_depth = 0;
+    dropped_depth = 0;
+    zone_count = 0;
+    frame_time = 0.0;
+    has_frame_time = false;
+}
\ No newline at end of file
@@ -0,0 +1,775 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include <math.h>
+#include "engine/include/graphics/lod.h"
+#include "engine/include/core/arena.h"
+
+
+/*
+    Mesh simplification
+
+    Garland, Heckbert, "Surface Simplification Using Quadric Error Metrics"
+
+    Every vertex accumulates the planes of its triangles as a quadric, which
+    gives the squared distance of any point to those planes. Collapsing an
+    edge sums the quadrics of both ends, so the error of the collapsed vertex
+    is measured against all the original surface it now stands for.
+
+    Collapses run in passes: candidate edges are sorted by error and applied
+    greedily, both ends of a collapse are locked for the rest of the pass so
+    the errors computed at the start of the pass stay valid.
+
+    Vertices are classified on the position-welded mesh:
+    - Manifold vertices can collapse onto any neighbor.
+    - Border vertices can only slide along the border.
+    - Seam vertices (two wedges with different attributes at one position) can
+      only slide along the seam, and both wedges collapse together.
+    - Everything else is locked in place.
+*/
+
+
+#define NO_VERTEX 0xFFFFFFFF
+#define NO_EDGE 0xFFFFFFFFFFFFFFFFull
+
+// Border planes are weighted more than the surface so borders don't shrink
+#define BORDER_WEIGHT 10.0
+
+// Collapses of a pass can go this much over the error of the goal collapse
+#define PASS_ERROR_BOUND 1.5f
+
+// Cosine of the largest rotation a triangle's normal can take with a collapse
+#define FLIP_THRESHOLD 0.25
+
+
+typedef enum {
+    VertexKind_MANIFOLD,
+    VertexKind_BORDER,
+    VertexKind_SEAM,
+    VertexKind_LOCKED
+} VertexKind;
+
+typedef struct {
+    double a00, a11, a22;
+    double a10, a20, a21;
+    double b0, b1, b2;
+    double c;
+    double w; /**< Total weight, error is normalized with it. */
+} Quadric;
+
+typedef struct {
+    ns_u32 u; /**< Vertex that is removed. */
+    ns_u32 v; /**< Vertex it collapses onto. */
+    float error; /**< Squared error of the collapse. */
+} Collapse;
+
+typedef struct {
+    ns_u64 *keys;
+    size_t mask;
+} EdgeSet;
+
+
+static inline const float *get_position(const float *positions, size_t stride, ns_u32 v) {
+    return (const float *)((const char *)positions + stride * v);
+}
+
+static inline ns_u64 hash_u64(ns_u64 key) {
+    // MurmurHash3 finalizer
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline size_t next_power_of_two(size_t value) {
+    size_t n = 16;
+    while (n < value) n <<= 1;
+    return n;
+}
+
+
+static void Quadric_from_plane(
+    Quadric *quadric,
+    double a,
+    double b,
+    double c,
+    double d,
+    double w
+) {
+    quadric->a00 = a * a * w;
+    quadric->a11 = b * b * w;
+    quadric->a22 = c * c * w;
+    quadric->a10 = a * b * w;
+    quadric->a20 = a * c * w;
+    quadric->a21 = b * c * w;
+    quadric->b0 = a * d * w;
+    quadric->b1 = b * d * w;
+    quadric->b2 = c * d * w;
+    quadric->c = d * d * w;
+    quadric->w = w;
+}
+
+static void Quadric_add(Quadric *quadric, const Quadric *other) {
+    quadric->a00 += other->a00;
+    quadric->a11 += other->a11;
+    quadric->a22 += other->a22;
+    quadric->a10 += other->a10;
+    quadric->a20 += other->a20;
+    quadric->a21 += other->a21;
+    quadric->b0 += other->b0;
+    quadric->b1 += other->b1;
+    quadric->b2 += other->b2;
+    quadric->c += other->c;
+    quadric->w += other->w;
+}
+
+static inline double Quadric_evaluate(const Quadric *quadric, const float *p) {
+    double x = p[0], y = p[1], z = p[2];
+
+    // p^T * A * p + 2 * b . p + c
+    double rx = quadric->a00 * x + quadric->a10 * y + quadric->a20 * z + 2.0 * quadric->b0;
+    double ry = quadric->a10 * x + quadric->a11 * y + quadric->a21 * z + 2.0 * quadric->b1;
+    double rz = quadric->a20 * x + quadric->a21 * y + quadric->a22 * z + 2.0 * quadric->b2;
+
+    return fabs(x * rx + y * ry + z * rz + quadric->c);
+}
+
+
+static int EdgeSet_init(EdgeSet *set, nsArena *arena, size_t edge_count) {
+    size_t size = next_power_of_two(edge_count * 2);
+
+    set->keys = nsArena_alloc(arena, sizeof(ns_u64) * size);
+    if (!set->keys) return 1;
+    set->mask = size - 1;
+
+    return 0;
+}
+
+static inline void EdgeSet_clear(EdgeSet *set) {
+    memset(set->keys, 0xFF, sizeof(ns_u64) * (set->mask + 1));
+}
+
+static inline void EdgeSet_insert(EdgeSet *set, ns_u32 a, ns_u32 b) {
+    ns_u64 key = ((ns_u64)a << 32) | b;
+    size_t slot = hash_u64(key) & set->mask;
+
+    while (set->keys[slot] != NO_EDGE && set->keys[slot] != key) {
+        slot = (slot + 1) & set->mask;
+    }
+
+    set->keys[slot] = key;
+}
+
+static inline ns_bool EdgeSet_has(const EdgeSet *set, ns_u32 a, ns_u32 b) {
+    ns_u64 key = ((ns_u64)a << 32) | b;
+    size_t slot = hash_u64(key) & set->mask;
+
+    while (set->keys[slot] != NO_EDGE) {
+        if (set->keys[slot] == key) return true;
+        slot = (slot + 1) & set->mask;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Edge exists in only one direction, there is no triangle on one side.
+ */
+static inline ns_bool EdgeSet_is_open(const EdgeSet *set, ns_u32 a, ns_u32 b) {
+    return EdgeSet_has(set, a, b) != EdgeSet_has(set, b, a);
+}
+
+
+/**
+ * @brief Map every vertex to the first vertex with the same position.
+ */
+static int build_position_remap(
+    ns_u32 *remap,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count
+) {
+    size_t size = next_power_of_two(vertex_count * 2);
+    size_t mask = size - 1;
+
+    nsArena *arena = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(arena);
+
+    ns_u32 *table = nsArena_alloc(arena, sizeof(ns_u32) * size);
+    if (!table) return 1;
+    memset(table, 0xFF, sizeof(ns_u32) * size);
+
+    for (size_t v = 0; v < vertex_count; v++) {
+        const float *p = get_position(positions, position_stride, (ns_u32)v);
+
+        ns_u32 bits[3];
+        memcpy(bits, p, sizeof(bits));
+        size_t slot = hash_u64(((ns_u64)bits[0] << 32 | bits[1]) ^ hash_u64(bits[2])) & mask;
+
+        for (;;) {
+            ns_u32 other = table[slot];
+
+            if (other == NO_VERTEX) {
+                table[slot] = (ns_u32)v;
+                remap[v] = (ns_u32)v;
+                break;
+            }
+
+            if (memcmp(get_position(positions, position_stride, other), p, sizeof(float) * 3) == 0) {
+                remap[v] = other;
+                break;
+            }
+
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    nsArena_rewind(arena, mark);
+
+    return 0;
+}
+
+static void build_quadrics(
+    Quadric *quadrics,
+    const ns_u32 *indices,
+    size_t index_count,
+    const ns_u32 *remap,
+    const EdgeSet *welded_edges,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count
+) {
+    memset(quadrics, 0, sizeof(Quadric) * vertex_count);
+
+    for (size_t i = 0; i < index_count; i += 3) {
+        ns_u32 r[3] = {remap[indices[i + 0]], remap[indices[i + 1]], remap[indices[i + 2]]};
+        const float *p[3] = {
+            get_position(positions, position_stride, r[0]),
+            get_position(positions, position_stride, r[1]),
+            get_position(positions, position_stride, r[2])
+        };
+
+        double e1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+        double e2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+        double n[3] = {
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]
+        };
+
+        // Cross product length is twice the area, used as the weight
+        double area = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (area > 0.0) {
+            n[0] /= area;
+            n[1] /= area;
+            n[2] /= area;
+        }
+
+        double d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+
+        Quadric plane;
+        Quadric_from_plane(&plane, n[0], n[1], n[2], d, area);
+        for (size_t k = 0; k < 3; k++) Quadric_add(&quadrics[r[k]], &plane);
+
+        // Border edges get a plane perpendicular to the triangle that holds them in place
+        for (size_t k = 0; k < 3; k++) {
+            ns_u32 a = r[k];
+            ns_u32 b = r[(k + 1) % 3];
+            if (EdgeSet_has(welded_edges, b, a)) continue;
+
+            const float *pa = p[k];
+            const float *pb = p[(k + 1) % 3];
+            double edge[3] = {pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2]};
+            double length = sqrt(edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+            if (length <= 0.0) continue;
+
+            double en[3] = {
+                edge[1] * n[2] - edge[2] * n[1],
+                edge[2] * n[0] - edge[0] * n[2],
+                edge[0] * n[1] - edge[1] * n[0]
+            };
+            double en_length = sqrt(en[0] * en[0] + en[1] * en[1] + en[2] * en[2]);
+            if (en_length <= 0.0) continue;
+
+            en[0] /= en_length;
+            en[1] /= en_length;
+            en[2] /= en_length;
+            double ed = -(en[0] * pa[0] + en[1] * pa[1] + en[2] * pa[2]);
+
+            Quadric border;
+            Quadric_from_plane(&border, en[0], en[1], en[2], ed, length * length * BORDER_WEIGHT);
+            Quadric_add(&quadrics[a], &border);
+            Quadric_add(&quadrics[b], &border);
+        }
+    }
+}
+
+/**
+ * @brief Squared error of moving welded vertex ru onto welded vertex rv.
+ */
+static inline float collapse_error(
+    const Quadric *quadrics,
+    ns_u32 ru,
+    ns_u32 rv,
+    const float *pv
+) {
+    double w = quadrics[ru].w + quadrics[rv].w;
+    if (w <= 0.0) return 0.0f;
+
+    double error = Quadric_evaluate(&quadrics[ru], pv) + Quadric_evaluate(&quadrics[rv], pv);
+    return (float)(error / w);
+}
+
+/**
+ * @brief Find the other wedge of seam vertex u and the wedge of v it collapses onto.
+ */
+static ns_bool find_seam_twin(
+    ns_u32 u,
+    ns_u32 v,
+    const ns_u32 *wedges,
+    const ns_u8 *used,
+    const EdgeSet *edges,
+    ns_u32 *twin_u,
+    ns_u32 *twin_v
+) {
+    ns_u32 u2 = wedges[u];
+    while (u2 != u && !used[u2]) u2 = wedges[u2];
+    if (u2 == u) return false;
+
+    for (ns_u32 v2 = wedges[v]; v2 != v; v2 = wedges[v2]) {
+        if (used[v2] && EdgeSet_is_open(edges, u2, v2)) {
+            *twin_u = u2;
+            *twin_v = v2;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static ns_bool can_collapse(
+    ns_u32 u,
+    ns_u32 v,
+    const ns_u32 *remap,
+    const ns_u8 *kinds,
+    const EdgeSet *welded_edges,
+    const EdgeSet *edges
+) {
+    ns_u32 ru = remap[u];
+    ns_u32 rv = remap[v];
+
+    switch ((VertexKind)kinds[ru]) {
+        case VertexKind_MANIFOLD:
+            return true;
+
+        case VertexKind_BORDER:
+            return (
+                (kinds[rv] == VertexKind_BORDER || kinds[rv] == VertexKind_LOCKED) &&
+                EdgeSet_is_open(welded_edges, ru, rv)
+            );
+
+        case VertexKind_SEAM:
+            return (
+                (kinds[rv] == VertexKind_SEAM || kinds[rv] == VertexKind_LOCKED) &&
+                EdgeSet_is_open(edges, u, v)
+            );
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Whether moving welded vertex ru onto pv flips or folds any of its triangles.
+ */
+static ns_bool has_triangle_flip(
+    const ns_u32 *indices,
+    const ns_u32 *adjacency,
+    const ns_u32 *offsets,
+    const ns_u32 *remap,
+    const float *positions,
+    size_t position_stride,
+    ns_u32 ru,
+    ns_u32 rv,
+    const float *pv
+) {
+    for (ns_u32 i = offsets[ru]; i < offsets[ru + 1]; i++) {
+        const ns_u32 *triangle = &indices[adjacency[i] * 3];
+        ns_u32 r[3] = {remap[triangle[0]], remap[triangle[1]], remap[triangle[2]]};
+
+        // Triangles on the collapsed edge disappear
+        if (r[0] == rv || r[1] == rv || r[2] == rv) continue;
+
+        const float *p[3];
+        const float *q[3];
+        for (size_t k = 0; k < 3; k++) {
+            p[k] = get_position(positions, position_stride, r[k]);
+            q[k] = r[k] == ru ? pv : p[k];
+        }
+
+        double n0[3], n1[3];
+        {
+            double e1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+            double e2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+            n0[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n0[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n0[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        }
+        {
+            double e1[3] = {q[1][0] - q[0][0], q[1][1] - q[0][1], q[1][2] - q[0][2]};
+            double e2[3] = {q[2][0] - q[0][0], q[2][1] - q[0][1], q[2][2] - q[0][2]};
+            n1[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n1[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n1[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        }
+
+        double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+        double length0 = sqrt(n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]);
+        double length1 = sqrt(n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+
+        if (dot <= FLIP_THRESHOLD * length0 * length1) return true;
+    }
+
+    return false;
+}
+
+typedef struct {
+    ns_u32 *remap; /**< First vertex with the same position. */
+    ns_u32 *wedges; /**< Next vertex with the same position, circular. */
+    ns_u32 *collapse_remap; /**< Vertex each vertex collapses onto in the current pass. */
+    ns_u32 *open_counts; /**< Outgoing and incoming open edges per welded vertex. */
+    ns_u32 *offsets; /**< Welded vertex -> triangle adjacency offsets. */
+    ns_u32 *adjacency; /**< Welded vertex -> triangle adjacency. */
+    ns_u8 *kinds; /**< VertexKind per welded vertex. */
+    ns_u8 *used; /**< Vertex is referenced by the current indices. */
+    ns_u8 *locked; /**< Welded vertex is already part of a collapse in this pass. */
+    Quadric *quadrics; /**< Quadric per welded vertex. */
+    Collapse *collapses; /**< Collapse candidates of the current pass. */
+    EdgeSet welded_edges; /**< Directed edges between welded vertices. */
+    EdgeSet edges; /**< Directed edges between vertices. */
+} SimplifyScratch;
+
+static int SimplifyScratch_init(
+    SimplifyScratch *scratch,
+    nsArena *arena,
+    size_t vertex_count,
+    size_t index_count
+) {
+    memset(scratch, 0, sizeof(SimplifyScratch));
+
+    scratch->remap = nsArena_alloc(arena, sizeof(ns_u32) * vertex_count);
+    scratch->wedges = nsArena_alloc(arena, sizeof(ns_u32) * vertex_count);
+    scratch->collapse_remap = nsArena_alloc(arena, sizeof(ns_u32) * vertex_count);
+    scratch->open_counts = nsArena_alloc(arena, sizeof(ns_u32) * vertex_count * 2);
+    scratch->offsets = nsArena_alloc(arena, sizeof(ns_u32) * (vertex_count + 1));
+    scratch->adjacency = nsArena_alloc(arena, sizeof(ns_u32) * index_count);
+    scratch->kinds = nsArena_alloc(arena, vertex_count);
+    scratch->used = nsArena_alloc(arena, vertex_count);
+    scratch->locked = nsArena_alloc(arena, vertex_count);
+    scratch->quadrics = nsArena_alloc(arena, sizeof(Quadric) * vertex_count);
+    scratch->collapses = nsArena_alloc(arena, sizeof(Collapse) * index_count);
+
+    if (
+        !scratch->remap || !scratch->wedges || !scratch->collapse_remap ||
+        !scratch->open_counts || !scratch->offsets || !scratch->adjacency ||
+        !scratch->kinds || !scratch->used || !scratch->locked ||
+        !scratch->quadrics || !scratch->collapses
+    ) return 1;
+
+    if (EdgeSet_init(&scratch->welded_edges, arena, index_count)) return 1;
+    if (EdgeSet_init(&scratch->edges, arena, index_count)) return 1;
+
+    return 0;
+}
+
+static int compare_collapses(const void *a, const void *b) {
+    const Collapse *ca = a;
+    const Collapse *cb = b;
+
+    // Ascending error, vertex indices for ties so the order is deterministic
+    if (ca->error < cb->error) return -1;
+    if (ca->error > cb->error) return 1;
+    if (ca->u != cb->u) return ca->u < cb->u ? -1 : 1;
+    return (ca->v > cb->v) - (ca->v < cb->v);
+}
+
+int ns_simplify(
+    ns_u32 *destination,
+    size_t *destination_count,
+    const ns_u32 *indices,
+    size_t index_count,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count,
+    size_t target_index_count,
+    float target_error,
+    float *result_error
+) {
+    size_t count = index_count - index_count % 3;
+    memmove(destination, indices, sizeof(ns_u32) * count);
+
+    *destination_count = count;
+    if (result_error) *result_error = 0.0f;
+    if (count <= target_index_count || vertex_count == 0) return 0;
+
+    nsArena *arena = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(arena);
+
+    SimplifyScratch scratch;
+    if (SimplifyScratch_init(&scratch, arena, vertex_count, count)) {
+        nsArena_rewind(arena, mark);
+        return 1;
+    }
+
+    ns_u32 *remap = scratch.remap;
+    ns_u32 *wedges = scratch.wedges;
+    ns_u32 *collapse_remap = scratch.collapse_remap;
+    ns_u32 *open_counts = scratch.open_counts;
+    ns_u32 *offsets = scratch.offsets;
+    ns_u32 *adjacency = scratch.adjacency;
+    ns_u8 *kinds = scratch.kinds;
+    ns_u8 *used = scratch.used;
+    ns_u8 *locked = scratch.locked;
+    Quadric *quadrics = scratch.quadrics;
+    Collapse *collapses = scratch.collapses;
+
+    if (build_position_remap(remap, positions, position_stride, vertex_count)) {
+        nsArena_rewind(arena, mark);
+        return 1;
+    }
+
+    // Circular lists of vertices sharing a position
+    for (size_t v = 0; v < vertex_count; v++) wedges[v] = (ns_u32)v;
+    for (size_t v = 0; v < vertex_count; v++) {
+        ns_u32 r = remap[v];
+        if (r != v) {
+            wedges[v] = wedges[r];
+            wedges[r] = (ns_u32)v;
+        }
+    }
+
+    for (size_t v = 0; v < vertex_count; v++) collapse_remap[v] = (ns_u32)v;
+
+    EdgeSet_clear(&scratch.welded_edges);
+    for (size_t i = 0; i < count; i++) {
+        ns_u32 a = destination[i];
+        ns_u32 b = destination[i - i % 3 + (i + 1) % 3];
+        EdgeSet_insert(&scratch.welded_edges, remap[a], remap[b]);
+    }
+
+    build_quadrics(
+        quadrics,
+        destination,
+        count,
+        remap,
+        &scratch.welded_edges,
+        positions,
+        position_stride,
+        vertex_count
+    );
+
+    double max_error = (double)target_error * (double)target_error;
+    float error = 0.0f;
+
+    while (count > target_index_count) {
+        /*
+            Classify vertices on the current mesh, topology changes with
+            every pass so borders and seams are found again.
+        */
+        memset(used, 0, vertex_count);
+        for (size_t i = 0; i < count; i++) used[destination[i]] = 1;
+
+        EdgeSet_clear(&scratch.welded_edges);
+        EdgeSet_clear(&scratch.edges);
+        memset(open_counts, 0, sizeof(ns_u32) * vertex_count * 2);
+
+        for (size_t i = 0; i < count; i++) {
+            ns_u32 a = destination[i];
+            ns_u32 b = destination[i - i % 3 + (i + 1) % 3];
+            EdgeSet_insert(&scratch.welded_edges, remap[a], remap[b]);
+            EdgeSet_insert(&scratch.edges, a, b);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            ns_u32 a = remap[destination[i]];
+            ns_u32 b = remap[destination[i - i % 3 + (i + 1) % 3]];
+
+            if (!EdgeSet_has(&scratch.welded_edges, b, a)) {
+                open_counts[a * 2 + 0]++;
+                open_counts[b * 2 + 1]++;
+            }
+        }
+
+        for (size_t v = 0; v < vertex_count; v++) {
+            if (remap[v] != v) continue;
+
+            ns_u32 wedge_count = used[v];
+            for (ns_u32 w = wedges[v]; w != v; w = wedges[w]) wedge_count += used[w];
+
+            ns_u32 open_out = open_counts[v * 2 + 0];
+            ns_u32 open_in = open_counts[v * 2 + 1];
+            VertexKind kind;
+
+            if (open_out || open_in) {
+                kind = (open_out == 1 && open_in == 1 && wedge_count == 1) ?
+                    VertexKind_BORDER : VertexKind_LOCKED;
+            }
+            else if (wedge_count == 1) kind = VertexKind_MANIFOLD;
+            else if (wedge_count == 2) kind = VertexKind_SEAM;
+            else kind = VertexKind_LOCKED;
+
+            kinds[v] = (ns_u8)kind;
+        }
+
+        // Collect the cheaper direction of every collapsible edge
+        size_t collapse_n = 0;
+        for (size_t i = 0; i < count; i++) {
+            ns_u32 a = destination[i];
+            ns_u32 b = destination[i - i % 3 + (i + 1) % 3];
+            ns_u32 ra = remap[a];
+            ns_u32 rb = remap[b];
+
+            ns_bool ab = can_collapse(a, b, remap, kinds, &scratch.welded_edges, &scratch.edges);
+            ns_bool ba = can_collapse(b, a, remap, kinds, &scratch.welded_edges, &scratch.edges);
+            if (!ab && !ba) continue;
+
+            float error_ab = ab ? collapse_error(quadrics, ra, rb, get_position(positions, position_stride, rb)) : 0.0f;
+            float error_ba = ba ? collapse_error(quadrics, rb, ra, get_position(positions, position_stride, ra)) : 0.0f;
+
+            if (ab && (!ba || error_ab <= error_ba)) {
+                collapses[collapse_n++] = (Collapse){a, b, error_ab};
+            }
+            else {
+                collapses[collapse_n++] = (Collapse){b, a, error_ba};
+            }
+        }
+
+        if (collapse_n == 0) break;
+
+        qsort(collapses, collapse_n, sizeof(Collapse), compare_collapses);
+
+        // Welded vertex -> triangle adjacency in compressed rows
+        memset(offsets, 0, sizeof(ns_u32) * (vertex_count + 1));
+        for (size_t i = 0; i < count; i++) offsets[remap[destination[i]] + 1]++;
+        for (size_t v = 0; v < vertex_count; v++) offsets[v + 1] += offsets[v];
+        for (size_t i = 0; i < count; i++) {
+            ns_u32 r = remap[destination[i]];
+            adjacency[offsets[r]++] = (ns_u32)(i / 3);
+        }
+        for (size_t v = vertex_count; v > 0; v--) offsets[v] = offsets[v - 1];
+        offsets[0] = 0;
+
+        // Most collapses remove two triangles
+        size_t triangle_goal = (count - target_index_count) / 3;
+        size_t edge_goal = triangle_goal / 2;
+        if (edge_goal >= collapse_n) edge_goal = collapse_n - 1;
+
+        double pass_limit = (double)collapses[edge_goal].error * PASS_ERROR_BOUND;
+        if (pass_limit > max_error) pass_limit = max_error;
+
+        memset(locked, 0, vertex_count);
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (size_t i = 0; i < collapse_n && removed < triangle_goal; i++) {
+            const Collapse *collapse = &collapses[i];
+            if (collapse->error > pass_limit) break;
+
+            ns_u32 ru = remap[collapse->u];
+            ns_u32 rv = remap[collapse->v];
+            if (locked[ru] || locked[rv]) continue;
+
+            const float *pv = get_position(positions, position_stride, rv);
+            ns_u32 twin_u = NO_VERTEX;
+            ns_u32 twin_v = NO_VERTEX;
+
+            if (
+                kinds[ru] == VertexKind_SEAM &&
+                !find_seam_twin(collapse->u, collapse->v, wedges, used, &scratch.edges, &twin_u, &twin_v)
+            ) continue;
+
+            if (has_triangle_flip(
+                destination, adjacency, offsets, remap,
+                positions, position_stride, ru, rv, pv
+            )) continue;
+
+            collapse_remap[collapse->u] = collapse->v;
+            if (twin_u != NO_VERTEX) collapse_remap[twin_u] = twin_v;
+
+            Quadric_add(&quadrics[rv], &quadrics[ru]);
+            locked[ru] = 1;
+            locked[rv] = 1;
+
+            removed += kinds[ru] == VertexKind_BORDER ? 1 : 2;
+            applied++;
+            if (collapse->error > error) error = collapse->error;
+        }
+
+        if (applied == 0) break;
+
+        // Apply collapses and drop the triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < count; i += 3) {
+            ns_u32 a = collapse_remap[destination[i + 0]];
+            ns_u32 b = collapse_remap[destination[i + 1]];
+            ns_u32 c = collapse_remap[destination[i + 2]];
+            ns_u32 ra = remap[a];
+            ns_u32 rb = remap[b];
+            ns_u32 rc = remap[c];
+
+            if (ra == rb || rb == rc || rc == ra) continue;
+
+            destination[write++] = a;
+            destination[write++] = b;
+            destination[write++] = c;
+        }
+        count = write;
+
+        for (size_t v = 0; v < vertex_count; v++) collapse_remap[v] = (ns_u32)v;
+    }
+
+    *destination_count = count;
+    if (result_error) *result_error = sqrtf(error);
+
+    nsArena_rewind(arena, mark);
+
+    return 0;
+}
+
+
+ns_u32 ns_select_lod(
+    const nsMeshLOD *lods,
+    ns_u32 lod_count,
+    ns_u32 current,
+    float scale,
+    float distance,
+    float projection_scale,
+    float threshold
+) {
+    if (lod_count == 0) return 0;
+    if (current >= lod_count) current = lod_count - 1;
+
+    // Camera is inside the bounds
+    if (distance <= 0.0f) return 0;
+
+    // Object-space error to fraction of the screen height, NDC spans 2 units
+    float factor = scale * projection_scale * 0.5f / distance;
+
+    while (current > 0 && lods[current].error * factor > threshold) current--;
+
+    while (
+        current + 1 < lod_count &&
+        lods[current + 1].error * factor <= threshold * (1.0f - NS_LOD_HYSTERESIS)
+    ) current++;
+
+    return current;
+}
\ No newline at end of file
@@ -8,8 +8,20 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_MATERIALS
+
 #include "engine/include/graphics/material.h"
 #include "engine/include/core/io.h"
+#include "engine/include/core/object_pool.h"
+#include "engine/include/core/string_id.h"
+#include "engine/include/core/arena.h"
+
+#if NS_COMPILER == NS_COMPILER_MSVC
+    #include <intrin.h>
+#endif
+
+
+static nsObjectPool material_pool = NS_OBJECT_POOL_INIT(nsMaterial, 64, nsMemoryTag_MATERIALS);
 
 
 /**
@@ -50,6 +62,239 @@ static ns_u32 load_shader(const char *source, ns_u32 shader_type) {
     return shader_id;
 }
 
+/**
+ * @brief Make name refer to the uniform with handle.
+ */
+static int alias_uniform(nsMaterial *material, const char *name, nsUniformHandle handle) {
+    nsStringId id = ns_intern_string(name);
+    if (id == NS_STRING_ID_NONE) return 1;
+
+    return nsHashMap_set(material->uniform_handles, &id, &handle);
+}
+
+static int add_uniform(
+    nsMaterial *material,
+    const char *name,
+    ns_i32 location,
+    ns_u32 type,
+    ns_i32 size
+) {
+    nsUniform *uniform = nsUniform_new(name, location, type, size);
+    if (!uniform) return 1;
+
+    nsUniformHandle handle = (nsUniformHandle)material->uniforms->size;
+    if (nsArray_add(material->uniforms, uniform)) {
+        nsUniform_free(uniform);
+        return 1;
+    }
+
+    return alias_uniform(material, name, handle);
+}
+
+/**
+ * @brief Enumerate the active uniforms of the linked program.
+ */
+static int reflect_uniforms(nsMaterial *material) {
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(material->program_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(material->program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    // Extra room for element indices of arrays
+    size_t name_capacity = (size_t)max_length + 16;
+    char *name = nsArena_alloc(scratch, name_capacity);
+    if (!name) return 1;
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(material->program_id, (GLuint)i, max_length, &length, &size, &type, name);
+
+        // Members of uniform blocks don't have locations
+        ns_i32 location = glGetUniformLocation(material->program_id, name);
+        if (location == -1) continue;
+
+        if (add_uniform(material, name, location, type, size)) {
+            nsArena_rewind(scratch, mark);
+            return 1;
+        }
+
+        // Arrays of basic types are reported once as "name[0]"
+        if (size > 1 && length >= 3 && strcmp(name + length - 3, "[0]") == 0) {
+            nsUniformHandle first = (nsUniformHandle)material->uniforms->size - 1;
+
+            name[length - 3] = '\0';
+            if (alias_uniform(material, name, first)) {
+                nsArena_rewind(scratch, mark);
+                return 1;
+            }
+
+            // Element locations aren't guaranteed to be consecutive
+            for (GLint j = 1; j < size; j++) {
+                snprintf(name + length - 3, name_capacity - (size_t)length + 3, "[%d]", (int)j);
+                location = glGetUniformLocation(material->program_id, name);
+                if (location == -1) continue;
+
+                if (add_uniform(material, name, location, type, 1)) {
+                    nsArena_rewind(scratch, mark);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+static inline int count_trailing_zeros64(ns_u64 value) {
+    #if NS_COMPILER == NS_COMPILER_MSVC
+
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+
+    #else
+
+    return __builtin_ctzll(value);
+
+    #endif
+}
+
+/**
+ * @brief Size of the staged value of uniform type, 0 for types that can't be set.
+ */
+static size_t uniform_value_size(ns_u32 type) {
+    switch (type) {
+        case GL_FLOAT:
+            return sizeof(float);
+
+        case GL_FLOAT_VEC3:
+            return sizeof(float) * 3;
+
+        case GL_FLOAT_MAT4:
+            return sizeof(float) * 16;
+
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+            return sizeof(ns_i32);
+
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Give every uniform a slot for its staged value.
+ */
+static int init_staging(nsMaterial *material) {
+    size_t count = material->uniforms->size;
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        nsUniform *uniform = material->uniforms->data[i];
+        uniform->value_offset = total;
+        total += uniform_value_size(uniform->type);
+    }
+
+    size_t words = (count + 63) / 64;
+
+    material->uniform_values = NS_MALLOC(total > 0 ? total : 1);
+    material->dirty_uniforms = NS_MALLOC(sizeof(ns_u64) * (words > 0 ? words : 1) * 2);
+    NS_MEM_CHECK_I(material->uniform_values);
+    NS_MEM_CHECK_I(material->dirty_uniforms);
+
+    material->synced_uniforms = material->dirty_uniforms + words;
+    memset(material->dirty_uniforms, 0, sizeof(ns_u64) * words * 2);
+    material->dirty = false;
+
+    return 0;
+}
+
+/**
+ * @brief Write the staged value of uniform and mark it dirty if it changed.
+ */
+static void stage_uniform(
+    nsMaterial *material,
+    nsUniformHandle handle,
+    ns_u32 type,
+    const void *value
+) {
+    if (handle < 0 || (size_t)handle >= material->uniforms->size) return;
+
+    nsUniform *uniform = material->uniforms->data[handle];
+
+    // GL ignores mismatched uploads too, but silently
+    ns_bool integer = uniform_value_size(uniform->type) == sizeof(ns_i32) && uniform->type != GL_FLOAT;
+    if (type == GL_INT ? !integer : uniform->type != type) {
+        ns_throw_error("Uniform type mismatch.", 0, nsErrorSeverity_WARNING);
+        return;
+    }
+
+    size_t size = uniform_value_size(uniform->type);
+    ns_u8 *staged = material->uniform_values + uniform->value_offset;
+    ns_u64 bit = 1ull << (handle % 64);
+    size_t word = (size_t)handle / 64;
+
+    if ((material->synced_uniforms[word] & bit) && memcmp(staged, value, size) == 0) return;
+
+    memcpy(staged, value, size);
+    material->synced_uniforms[word] &= ~bit;
+    material->dirty_uniforms[word] |= bit;
+    material->dirty = true;
+}
+
+static void upload_uniform(nsMaterial *material, const nsUniform *uniform) {
+    const void *value = material->uniform_values + uniform->value_offset;
+
+    switch (uniform->type) {
+        case GL_FLOAT:
+            glUniform1fv(uniform->location, 1, value);
+            break;
+
+        case GL_FLOAT_VEC3:
+            glUniform3fv(uniform->location, 1, value);
+            break;
+
+        case GL_FLOAT_MAT4:
+            glUniformMatrix4fv(uniform->location, 1, GL_FALSE, value);
+            break;
+
+        default:
+            glUniform1iv(uniform->location, 1, value);
+            break;
+    }
+}
+
+/**
+ * @brief Get the handle of uniform by name without warning if it doesn't exist.
+ */
+static nsUniformHandle find_uniform(const nsMaterial *material, const char *name) {
+    nsStringId id = ns_find_string_id(name);
+    if (id == NS_STRING_ID_NONE) return NS_UNIFORM_HANDLE_NONE;
+
+    nsUniformHandle *handle = nsHashMap_get(material->uniform_handles, &id);
+    if (!handle) return NS_UNIFORM_HANDLE_NONE;
+
+    return *handle;
+}
+
+static inline nsUniform *get_uniform(const nsMaterial *material, nsUniformHandle handle) {
+    if (handle < 0 || (size_t)handle >= material->uniforms->size) return NULL;
+    return material->uniforms->data[handle];
+}
+
 
 nsMaterial *nsMaterial_new(
     const char *vertex_shader_source,
@@ -66,18 +311,21 @@ nsMaterial *nsMaterial_new(
         return NULL;
     }
 
-    nsMaterial *material = NS_NEW(nsMaterial);
+    nsMaterial *material = nsObjectPool_alloc(&material_pool);
     if (!material) {
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
         NS_MEM_CHECK(material);
     }
 
-    material->uniforms_cache = nsArray_new();
-    if (!material->uniforms_cache) {
+    material->uniforms = nsArray_new();
+    material->uniform_handles = nsHashMap_new(sizeof(nsStringId), sizeof(nsUniformHandle), NULL, NULL);
+    if (!material->uniforms || !material->uniform_handles) {
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
-        NS_FREE(material);
+        nsArray_free(material->uniforms);
+        nsHashMap_free(material->uniform_handles);
+        nsObjectPool_release(&material_pool, material);
         return NULL;
     }
 
@@ -90,8 +338,9 @@ nsMaterial *nsMaterial_new(
         );
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
-        nsArray_free(material->uniforms_cache);
-        NS_FREE(material);
+        nsArray_free(material->uniforms);
+        nsHashMap_free(material->uniform_handles);
+        nsObjectPool_release(&material_pool, material);
         return NULL;
     }
     glAttachShader(material->program_id, vertex_shader);
@@ -109,14 +358,30 @@ nsMaterial *nsMaterial_new(
         glDeleteProgram(material->program_id);
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
-        nsArray_free(material->uniforms_cache);
-        NS_FREE(material);
+        nsArray_free(material->uniforms);
+        nsHashMap_free(material->uniform_handles);
+        nsObjectPool_release(&material_pool, material);
         return NULL;
     }
 
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
+    material->uniform_values = NULL;
+    material->dirty_uniforms = NULL;
+    material->synced_uniforms = NULL;
+    material->dirty = false;
+
+    if (reflect_uniforms(material) || init_staging(material)) {
+        nsMaterial_free(material);
+        return NULL;
+    }
+
+    // Set by the engine on every draw
+    material->model_uniform = find_uniform(material, "u_model");
+    material->position_scale_uniform = find_uniform(material, "u_position_scale");
+    material->position_offset_uniform = find_uniform(material, "u_position_offset");
+
     return material;
 }
 
@@ -124,19 +389,21 @@ nsMaterial *nsMaterial_from_files(
     const char *vertex_shader_source_filepath,  
     const char *fragment_shader_source_filepath
 ) {
-    char *vertex_shader_source = ns_read_file_raw(vertex_shader_source_filepath);
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    char *vertex_shader_source = ns_read_file_arena(scratch, vertex_shader_source_filepath);
     if (!vertex_shader_source) return NULL;
 
-    char *fragment_shader_source = ns_read_file_raw(fragment_shader_source_filepath);
+    char *fragment_shader_source = ns_read_file_arena(scratch, fragment_shader_source_filepath);
     if (!fragment_shader_source) {
-        NS_FREE(vertex_shader_source);
+        nsArena_rewind(scratch, mark);
         return NULL;
     }
 
     nsMaterial *material = nsMaterial_new(vertex_shader_source, fragment_shader_source);
 
-    NS_FREE(vertex_shader_source);
-    NS_FREE(fragment_shader_source);
+    nsArena_rewind(scratch, mark);
 
     return material;
 }
@@ -146,84 +413,111 @@ void nsMaterial_free(nsMaterial *material) {
 
     glDeleteProgram(material->program_id);
     
-    nsArray_free_each(material->uniforms_cache, (nsArray_free_each_callback)nsUniform_free);
-    nsArray_free(material->uniforms_cache);
+    nsArray_free_each(material->uniforms, (nsArray_free_each_callback)nsUniform_free);
+    nsArray_free(material->uniforms);
+    nsHashMap_free(material->uniform_handles);
+    NS_FREE(material->uniform_values);
+    NS_FREE(material->dirty_uniforms);
 
-    NS_FREE(material);
+    nsObjectPool_release(&material_pool, material);
 }
 
-nsUniform *nsMaterial_get_uniform(nsMaterial *material, char *name) {
-    // Search cache
-    for (size_t i = 0; i < material->uniforms_cache->size; i++) {
-        nsUniform *uniform = material->uniforms_cache->data[i];
-        if (strcmp(uniform->name, name) == 0) {
-            return uniform;
-        }
-    }
+nsUniformHandle nsMaterial_get_uniform_handle(const nsMaterial *material, const char *name) {
+    nsUniformHandle handle = find_uniform(material, name);
 
-    // Not found, query it
-    ns_i32 location = glGetUniformLocation(material->program_id, name);
-    if (location == -1) {
+    if (handle == NS_UNIFORM_HANDLE_NONE) {
         ns_throw_error("Uniform not found in shader program.", 0, nsErrorSeverity_WARNING);
-        return NULL;
     }
 
-    // Cache it
-    nsUniform *uniform = nsUniform_new(name, location);
-    nsArray_add(material->uniforms_cache, uniform);
-    return uniform;
+    return handle;
 }
 
-void nsMaterial_set_uniform_vector3(
-    nsMaterial *material,
-    char *name,
-    nsVector3 vec
-) {
-    nsUniform *uniform = nsMaterial_get_uniform(material, name);
+nsUniform *nsMaterial_get_uniform(const nsMaterial *material, const char *name) {
+    return get_uniform(material, nsMaterial_get_uniform_handle(material, name));
+}
+
+void nsMaterial_bind(nsMaterial *material) {
+    glUseProgram(material->program_id);
 
-    if (uniform) {
-        glUseProgram(material->program_id);
-        glUniform3f(uniform->location, vec.x, vec.y, vec.z);
+    if (!material->dirty) return;
+
+    size_t words = (material->uniforms->size + 63) / 64;
+
+    for (size_t word = 0; word < words; word++) {
+        ns_u64 bits = material->dirty_uniforms[word];
+
+        while (bits) {
+            size_t index = word * 64 + count_trailing_zeros64(bits);
+            upload_uniform(material, material->uniforms->data[index]);
+            bits &= bits - 1;
+        }
+
+        material->synced_uniforms[word] |= material->dirty_uniforms[word];
+        material->dirty_uniforms[word] = 0;
     }
+
+    material->dirty = false;
 }
 
-void nsMaterial_set_uniform_matrix4(
-    nsMaterial *material,
-    char *name,
-    nsMatrix4 mat
-) {
-    nsUniform *uniform = nsMaterial_get_uniform(material, name);
+void nsMaterial_set_vector3(nsMaterial *material, nsUniformHandle handle, nsVector3 vec) {
+    float value[3] = {vec.x, vec.y, vec.z};
+    stage_uniform(material, handle, GL_FLOAT_VEC3, value);
+}
 
-    if (uniform) {
-        glUseProgram(material->program_id);
-        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, mat.m);
-    }
+void nsMaterial_set_matrix4(nsMaterial *material, nsUniformHandle handle, nsMatrix4 mat) {
+    stage_uniform(material, handle, GL_FLOAT_MAT4, mat.m);
 }
 
-void nsMaterial_set_uniform_float(nsMaterial *material, char *name, float value) {
-    nsUniform *uniform = nsMaterial_get_uniform(material, name);
+void nsMaterial_set_float(nsMaterial *material, nsUniformHandle handle, float value) {
+    stage_uniform(material, handle, GL_FLOAT, &value);
+}
 
-    if (uniform) {
-        glUseProgram(material->program_id);
-        glUniform1f(uniform->location, value);
-    }
+void nsMaterial_set_int(nsMaterial *material, nsUniformHandle handle, int value) {
+    ns_i32 v = value;
+    stage_uniform(material, handle, GL_INT, &v);
 }
 
-void nsMaterial_set_uniform_int(nsMaterial *material, char *name, int value) {
-    nsUniform *uniform = nsMaterial_get_uniform(material, name);
+float nsMaterial_get_float(nsMaterial *material, nsUniformHandle handle) {
+    nsUniform *uniform = get_uniform(material, handle);
+    if (!uniform || uniform->type != GL_FLOAT) return 0.0f;
+
+    float *staged = (float *)(material->uniform_values + uniform->value_offset);
+    ns_u64 bit = 1ull << (handle % 64);
+    size_t word = (size_t)handle / 64;
 
-    if (uniform) {
-        glUseProgram(material->program_id);
-        glUniform1i(uniform->location, value);
+    // Staged value is newer than the program's unless it was never set
+    if (!((material->dirty_uniforms[word] | material->synced_uniforms[word]) & bit)) {
+        glGetUniformfv(material->program_id, uniform->location, staged);
+        material->synced_uniforms[word] |= bit;
     }
+
+    return *staged;
+}
+
+void nsMaterial_set_uniform_vector3(
+    nsMaterial *material,
+    const char *name,
+    nsVector3 vec
+) {
+    nsMaterial_set_vector3(material, nsMaterial_get_uniform_handle(material, name), vec);
 }
 
-float nsMaterial_get_uniform_float(nsMaterial *material, char *name) {
-    nsUniform *uniform = nsMaterial_get_uniform(material, name);
+void nsMaterial_set_uniform_matrix4(
+    nsMaterial *material,
+    const char *name,
+    nsMatrix4 mat
+) {
+    nsMaterial_set_matrix4(material, nsMaterial_get_uniform_handle(material, name), mat);
+}
 
-    float v = 0.0;
+void nsMaterial_set_uniform_float(nsMaterial *material, const char *name, float value) {
+    nsMaterial_set_float(material, nsMaterial_get_uniform_handle(material, name), value);
+}
 
-    glGetUniformfv(material->program_id, uniform->location, &v);
+void nsMaterial_set_uniform_int(nsMaterial *material, const char *name, int value) {
+    nsMaterial_set_int(material, nsMaterial_get_uniform_handle(material, name), value);
+}
 
-    return v;
+float nsMaterial_get_uniform_float(nsMaterial *material, const char *name) {
+    return nsMaterial_get_float(material, nsMaterial_get_uniform_handle(material, name));
 }
\ No newline at end of file
@@ -8,18 +8,46 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_MESHES
+
+#include <stddef.h>
 #include "engine/include/graphics/mesh.h"
+#include "engine/include/graphics/mesh_optimizer.h"
+#include "engine/include/core/arena.h"
+#include "engine/include/core/object_pool.h"
+#include "engine/include/core/profiler.h"
+#include "engine/include/graphics/gpu_profiler.h"
+
+
+static nsObjectPool mesh_pool = NS_OBJECT_POOL_INIT(nsMesh, 64, nsMemoryTag_MESHES);
 
 
+/**
+ * @brief Set the bounding sphere of the mesh from its bounding box.
+ */
+static void set_bounds(nsMesh *mesh, nsVector3 min, nsVector3 max) {
+    mesh->bounds_center = nsVector3_mul(nsVector3_add(min, max), 0.5f);
+    mesh->bounds_radius = nsVector3_len(nsVector3_sub(max, min)) * 0.5f;
+}
+
 nsMesh *nsMesh_new(nsMaterial *material) {
-    nsMesh *mesh = NS_NEW(nsMesh);
+    nsMesh *mesh = nsObjectPool_alloc(&mesh_pool);
     NS_MEM_CHECK(mesh);
 
     mesh->material = material;
+    mesh->index_buffer = NULL;
+    mesh->position_scale = NS_VECTOR3(1.0f, 1.0f, 1.0f);
+    mesh->position_offset = nsVector3_zero;
+    mesh->lod_count = 0;
+    mesh->bounds_center = nsVector3_zero;
+    mesh->bounds_radius = 0.0f;
+    mesh->meshlets = NULL;
+    mesh->meshlet_count = 0;
+    mesh->drawn_meshlets = 0;
 
     mesh->buffers = nsArray_new();
     if (!mesh->buffers) {
-        NS_FREE(mesh);
+        nsObjectPool_release(&mesh_pool, mesh);
         return NULL;
     }
 
@@ -34,12 +62,15 @@ void nsMesh_free(nsMesh *mesh) {
 
     nsArray_free_each(mesh->buffers, (nsArray_free_each_callback)nsBuffer_free);
     nsArray_free(mesh->buffers);
+    nsBuffer_free(mesh->index_buffer);
+
+    NS_FREE(mesh->meshlets);
 
     nsMaterial_free(mesh->material);
 
     glDeleteVertexArrays(1, &mesh->vao_id);
 
-    NS_FREE(mesh);
+    nsObjectPool_release(&mesh_pool, mesh);
 }
 
 nsMesh *nsMesh_from_cube(
@@ -175,6 +206,7 @@ nsMesh *nsMesh_from_cube(
     nsMesh_push_buffer(mesh, vertices_buffer);
     nsMesh_push_buffer(mesh, normals_buffer);
     nsMesh_push_buffer(mesh, uvs_buffer);
+    set_bounds(mesh, NS_VECTOR3(-width_h, -height_h, -length_h), NS_VECTOR3(width_h, height_h, length_h));
     nsMesh_initialize(mesh);
 
     return mesh;
@@ -226,70 +258,316 @@ nsMesh *nsMesh_from_plane(
     nsMesh_push_buffer(mesh, vertices_buffer);
     nsMesh_push_buffer(mesh, normals_buffer);
     nsMesh_push_buffer(mesh, uvs_buffer);
+    set_bounds(mesh, NS_VECTOR3(-width_h, 0.0f, -length_h), NS_VECTOR3(width_h, 0.0f, length_h));
     nsMesh_initialize(mesh);
 
     return mesh;
 }
 
 nsMesh *nsMesh_from_obj(nsMaterial *material, nsOBJ *obj) {
-    size_t vertex_n = obj->mesh.tris->size * 3;
-    float *vertices = NS_MALLOC(vertex_n * 3 * sizeof(float));
-    float *normals = NS_MALLOC(vertex_n * 3 * sizeof(float));
-    float *uvs = NS_MALLOC(vertex_n * 2 * sizeof(float));
-
-    // Flatten OBJ triangles so we can write as buffers
-    size_t vertex_i = 0;
-    size_t normal_i = 0;
-    size_t uv_i = 0;
-    for (size_t i = 0; i < obj->mesh.tris->size; i++) {
-        nsOBJTri *tri = nsPool_get(obj->mesh.tris, i);
-        
-        vertices[vertex_i++] = tri->vertices[0].x;
-        vertices[vertex_i++] = tri->vertices[0].y;
-        vertices[vertex_i++] = tri->vertices[0].z;
-        vertices[vertex_i++] = tri->vertices[1].x;
-        vertices[vertex_i++] = tri->vertices[1].y;
-        vertices[vertex_i++] = tri->vertices[1].z;
-        vertices[vertex_i++] = tri->vertices[2].x;
-        vertices[vertex_i++] = tri->vertices[2].y;
-        vertices[vertex_i++] = tri->vertices[2].z;
-
-        normals[normal_i++] = tri->normals[0].x;
-        normals[normal_i++] = tri->normals[0].y;
-        normals[normal_i++] = tri->normals[0].z;
-        normals[normal_i++] = tri->normals[1].x;
-        normals[normal_i++] = tri->normals[1].y;
-        normals[normal_i++] = tri->normals[1].z;
-        normals[normal_i++] = tri->normals[2].x;
-        normals[normal_i++] = tri->normals[2].y;
-        normals[normal_i++] = tri->normals[2].z;
-
-        uvs[uv_i++] = tri->uvs[0].x;
-        uvs[uv_i++] = tri->uvs[0].y;
-        uvs[uv_i++] = tri->uvs[1].x;
-        uvs[uv_i++] = tri->uvs[1].y;
-        uvs[uv_i++] = tri->uvs[2].x;
-        uvs[uv_i++] = tri->uvs[2].y;
+    const nsVertexAttribute attributes[3] = {
+        {0, 3, GL_FLOAT, false, offsetof(nsOBJVertex, position)},
+        {1, 3, GL_FLOAT, false, offsetof(nsOBJVertex, normal)},
+        {2, 2, GL_FLOAT, false, offsetof(nsOBJVertex, uv)}
+    };
+
+    // Loader output is already interleaved, upload it as is
+    nsBuffer *vertex_buffer = nsBuffer_new_interleaved(attributes, 3, sizeof(nsOBJVertex));
+    if (!vertex_buffer) return NULL;
+    nsBuffer_write_raw(vertex_buffer, obj->mesh.vertices->data, obj->mesh.vertices->size);
+
+    nsBuffer *index_buffer = nsBuffer_new_index();
+    if (!index_buffer) {
+        nsBuffer_free(vertex_buffer);
+        return NULL;
+    }
+    if (nsBuffer_write_indices(
+        index_buffer,
+        (ns_u32 *)obj->mesh.indices->data,
+        obj->mesh.indices->size
+    )) {
+        nsBuffer_free(vertex_buffer);
+        nsBuffer_free(index_buffer);
+        return NULL;
     }
 
-    nsBuffer *vertices_buffer = nsBuffer_new(0, 3);
-    nsBuffer_write(vertices_buffer, vertices, vertex_n);
+    nsMesh *mesh = nsMesh_new(material);
+    if (!mesh) {
+        nsBuffer_free(vertex_buffer);
+        nsBuffer_free(index_buffer);
+        return NULL;
+    }
 
-    nsBuffer *normals_buffer = nsBuffer_new(1, 3);
-    nsBuffer_write(normals_buffer, normals, vertex_n);
+    nsMesh_push_buffer(mesh, vertex_buffer);
+    nsMesh_set_index_buffer(mesh, index_buffer);
 
-    nsBuffer *uvs_buffer = nsBuffer_new(2, 2);
-    nsBuffer_write(uvs_buffer, uvs, vertex_n);
+    mesh->lod_count = obj->mesh.lod_count;
+    memcpy(mesh->lods, obj->mesh.lods, sizeof(nsMeshLOD) * obj->mesh.lod_count);
+
+    if (obj->mesh.meshlets && nsMesh_set_meshlets(mesh, obj->mesh.meshlets->data, obj->mesh.meshlets->size)) {
+        mesh->material = NULL;
+        nsMesh_free(mesh);
+        return NULL;
+    }
+
+    const nsOBJVertex *vertices = (const nsOBJVertex *)obj->mesh.vertices->data;
+    if (obj->mesh.vertices->size > 0) {
+        nsVector3 min = vertices[0].position;
+        nsVector3 max = vertices[0].position;
+        for (size_t i = 1; i < obj->mesh.vertices->size; i++) {
+            nsVector3 p = vertices[i].position;
+            if (p.x < min.x) min.x = p.x;
+            if (p.y < min.y) min.y = p.y;
+            if (p.z < min.z) min.z = p.z;
+            if (p.x > max.x) max.x = p.x;
+            if (p.y > max.y) max.y = p.y;
+            if (p.z > max.z) max.z = p.z;
+        }
+        set_bounds(mesh, min, max);
+    }
+
+    nsMesh_initialize(mesh);
+
+    return mesh;
+}
+
+/**
+ * @brief Create mesh from cache, recording the buffer copies instead of doing them if uploads is given.
+ */
+static nsMesh *from_cache(
+    nsMaterial *material,
+    const nsMeshCache *cache,
+    nsBufferUpload *uploads,
+    size_t *upload_count
+) {
+    const nsMeshCacheHeader *header = cache->header;
 
     nsMesh *mesh = nsMesh_new(material);
-    nsMesh_push_buffer(mesh, vertices_buffer);
-    nsMesh_push_buffer(mesh, normals_buffer);
-    nsMesh_push_buffer(mesh, uvs_buffer);
+    if (!mesh) return NULL;
+
+    // Attributes sharing a stream are interleaved in one buffer
+    ns_u64 stream_offsets[NS_MESH_CACHE_MAX_ATTRIBUTES];
+    nsVertexAttribute layouts[NS_MESH_CACHE_MAX_ATTRIBUTES][NS_MESH_CACHE_MAX_ATTRIBUTES];
+    ns_u32 layout_counts[NS_MESH_CACHE_MAX_ATTRIBUTES] = {0};
+    ns_u32 strides[NS_MESH_CACHE_MAX_ATTRIBUTES];
+    ns_u32 stream_n = 0;
+
+    for (ns_u32 i = 0; i < header->attribute_count; i++) {
+        const nsMeshCacheAttribute *attribute = &header->attributes[i];
+
+        ns_u32 stream = 0;
+        while (stream < stream_n && stream_offsets[stream] != attribute->stream_offset) stream++;
+
+        if (stream == stream_n) {
+            stream_offsets[stream] = attribute->stream_offset;
+            strides[stream] = attribute->stride;
+            stream_n++;
+        }
+        else if (strides[stream] != attribute->stride) {
+            ns_throw_error("Unsupported mesh cache vertex layout.", 0, nsErrorSeverity_ERROR);
+            mesh->material = NULL;
+            nsMesh_free(mesh);
+            return NULL;
+        }
+
+        layouts[stream][layout_counts[stream]++] = (nsVertexAttribute){
+            .location = attribute->location,
+            .components = attribute->components,
+            .type = attribute->type,
+            .normalized = attribute->normalized != 0,
+            .offset = attribute->offset
+        };
+    }
+
+    for (ns_u32 i = 0; i < stream_n; i++) {
+        nsBuffer *buffer = nsBuffer_new_interleaved(layouts[i], layout_counts[i], strides[i]);
+        if (!buffer) {
+            mesh->material = NULL;
+            nsMesh_free(mesh);
+            return NULL;
+        }
+
+        // Streams are uploaded directly from the mapping
+        const void *stream = (const char *)cache->file.data + stream_offsets[i];
+        nsBuffer_write_raw(buffer, uploads ? NULL : stream, (size_t)header->vertex_count);
+        nsMesh_push_buffer(mesh, buffer);
+
+        if (uploads) {
+            uploads[(*upload_count)++] = (nsBufferUpload){
+                .buffer = buffer,
+                .data = stream,
+                .size = strides[i] * (size_t)header->vertex_count,
+                .uploaded = 0
+            };
+        }
+    }
+
+    set_bounds(
+        mesh,
+        NS_VECTOR3(header->bounds_min[0], header->bounds_min[1], header->bounds_min[2]),
+        NS_VECTOR3(header->bounds_max[0], header->bounds_max[1], header->bounds_max[2])
+    );
+
+    if (header->flags & NS_MESH_CACHE_FLAG_QUANTIZED_POSITIONS) {
+        // Positions are normalized into the bounds
+        mesh->position_offset = NS_VECTOR3(
+            (header->bounds_min[0] + header->bounds_max[0]) * 0.5f,
+            (header->bounds_min[1] + header->bounds_max[1]) * 0.5f,
+            (header->bounds_min[2] + header->bounds_max[2]) * 0.5f
+        );
+        mesh->position_scale = NS_VECTOR3(
+            (header->bounds_max[0] - header->bounds_min[0]) * 0.5f,
+            (header->bounds_max[1] - header->bounds_min[1]) * 0.5f,
+            (header->bounds_max[2] - header->bounds_min[2]) * 0.5f
+        );
+    }
+
+    nsBuffer *index_buffer = nsBuffer_new_index();
+    if (!index_buffer) {
+        mesh->material = NULL;
+        nsMesh_free(mesh);
+        return NULL;
+    }
+    nsBuffer_write_indices_ex(
+        index_buffer,
+        uploads ? NULL : nsMeshCache_get_indices(cache),
+        (size_t)header->index_count,
+        header->index_type
+    );
+    nsMesh_set_index_buffer(mesh, index_buffer);
+
+    if (uploads) {
+        uploads[(*upload_count)++] = (nsBufferUpload){
+            .buffer = index_buffer,
+            .data = nsMeshCache_get_indices(cache),
+            .size = index_buffer->stride * (size_t)header->index_count,
+            .uploaded = 0
+        };
+    }
+
+    mesh->lod_count = header->lod_count;
+    memcpy(mesh->lods, header->lods, sizeof(nsMeshLOD) * header->lod_count);
+
+    if (nsMesh_set_meshlets(mesh, nsMeshCache_get_meshlets(cache), (size_t)header->meshlet_count)) {
+        mesh->material = NULL;
+        nsMesh_free(mesh);
+        return NULL;
+    }
+
     nsMesh_initialize(mesh);
 
-    NS_FREE(vertices);
-    NS_FREE(normals);
-    NS_FREE(uvs);
+    return mesh;
+}
+
+nsMesh *nsMesh_from_cache(nsMaterial *material, const nsMeshCache *cache) {
+    return from_cache(material, cache, NULL, NULL);
+}
+
+nsMesh *nsMesh_from_cache_deferred(
+    nsMaterial *material,
+    const nsMeshCache *cache,
+    nsBufferUpload *uploads,
+    size_t *upload_count
+) {
+    *upload_count = 0;
+    return from_cache(material, cache, uploads, upload_count);
+}
+
+int nsMeshSource_load(nsMeshSource *source, const char *filepath) {
+    source->cached = false;
+    source->obj = (nsOBJ){0};
+
+    size_t filepath_len = strlen(filepath);
+    size_t extension_len = strlen(NS_MESH_CACHE_EXTENSION);
+
+    // Baked mesh, no source to validate against
+    if (
+        filepath_len > extension_len &&
+        strcmp(filepath + filepath_len - extension_len, NS_MESH_CACHE_EXTENSION) == 0
+    ) {
+        if (nsMeshCache_open(&source->cache, filepath, NULL)) return 1;
+
+        source->cached = true;
+        return 0;
+    }
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    char *cache_filepath = nsArena_alloc(scratch, filepath_len + extension_len + 1);
+    if (!cache_filepath) return 1;
+    memcpy(cache_filepath, filepath, filepath_len);
+    memcpy(cache_filepath + filepath_len, NS_MESH_CACHE_EXTENSION, extension_len + 1);
+
+    if (!nsMeshCache_open(&source->cache, cache_filepath, filepath)) {
+        nsArena_rewind(scratch, mark);
+        source->cached = true;
+        return 0;
+    }
+
+    // Cache is missing or stale, parse the source and bake it for the next run
+    nsOBJ obj = nsOBJ_load(filepath);
+    if (!obj.mesh.vertices) {
+        nsArena_rewind(scratch, mark);
+        return 1;
+    }
+
+    // Detail levels and optimized order are baked into the cache, so this only runs on cold loads
+    if (nsOBJMesh_generate_lods(&obj.mesh, NS_MESH_MAX_LODS)) {
+        ns_log("Couldn't generate mesh detail levels, continuing without them.", nsErrorSeverity_WARNING);
+    }
+
+    if (nsOBJMesh_optimize(&obj.mesh, NULL)) {
+        ns_log("Couldn't optimize mesh, continuing with the original order.", nsErrorSeverity_WARNING);
+    }
+
+    if (nsOBJMesh_build_meshlets(&obj.mesh)) {
+        ns_log("Couldn't build meshlets, mesh will be drawn without culling.", nsErrorSeverity_WARNING);
+        for (ns_u32 i = 0; i < obj.mesh.lod_count; i++) obj.mesh.lods[i].meshlet_count = 0;
+        if (obj.mesh.meshlets) obj.mesh.meshlets->size = 0;
+    }
+
+    // Upload through the freshly written cache so cold and warm loads render the same
+    if (!nsMeshCache_write(cache_filepath, &obj.mesh, filepath, true)) {
+        nsOBJ_free(&obj);
+
+        int status = nsMeshCache_open(&source->cache, cache_filepath, filepath);
+        nsArena_rewind(scratch, mark);
+        if (status) return 1;
+
+        source->cached = true;
+        return 0;
+    }
+
+    ns_log("Couldn't write mesh cache, continuing without it.", nsErrorSeverity_WARNING);
+
+    source->obj = obj;
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+void nsMeshSource_free(nsMeshSource *source) {
+    if (source->cached) {
+        nsMeshCache_close(&source->cache);
+        source->cached = false;
+    }
+    else {
+        nsOBJ_free(&source->obj);
+    }
+}
+
+nsMesh *nsMesh_from_source(nsMaterial *material, nsMeshSource *source) {
+    if (source->cached) return nsMesh_from_cache(material, &source->cache);
+    return nsMesh_from_obj(material, &source->obj);
+}
+
+nsMesh *nsMesh_load(nsMaterial *material, const char *filepath) {
+    nsMeshSource source;
+    if (nsMeshSource_load(&source, filepath)) return NULL;
+
+    nsMesh *mesh = nsMesh_from_source(material, &source);
+    nsMeshSource_free(&source);
 
     return mesh;
 }
@@ -298,6 +576,30 @@ int nsMesh_push_buffer(nsMesh *mesh, nsBuffer *buffer) {
     return nsArray_add(mesh->buffers, buffer);
 }
 
+int nsMesh_set_meshlets(nsMesh *mesh, const nsMeshlet *meshlets, size_t meshlet_count) {
+    NS_FREE(mesh->meshlets);
+    mesh->meshlets = NULL;
+    mesh->meshlet_count = 0;
+
+    if (meshlet_count == 0) return 0;
+
+    mesh->meshlets = NS_MALLOC(sizeof(nsMeshlet) * meshlet_count);
+    NS_MEM_CHECK_I(mesh->meshlets);
+
+    memcpy(mesh->meshlets, meshlets, sizeof(nsMeshlet) * meshlet_count);
+    mesh->meshlet_count = (ns_u32)meshlet_count;
+
+    return 0;
+}
+
+void nsMesh_set_index_buffer(nsMesh *mesh, nsBuffer *buffer) {
+    if (mesh->index_buffer && mesh->index_buffer != buffer) {
+        nsBuffer_free(mesh->index_buffer);
+    }
+
+    mesh->index_buffer = buffer;
+}
+
 void nsMesh_initialize(nsMesh *mesh) {
     glBindVertexArray(mesh->vao_id);
     
@@ -305,31 +607,162 @@ void nsMesh_initialize(nsMesh *mesh) {
         nsBuffer *buffer = mesh->buffers->data[i];
 
         glBindBuffer(GL_ARRAY_BUFFER, buffer->buffer_id);
-        glVertexAttribPointer(
-            buffer->attribute_loc,
-            buffer->components,
-            GL_FLOAT,
-            GL_FALSE,
-            buffer->stride,
-            (void *)0
-        );
-        glEnableVertexAttribArray(buffer->attribute_loc);
+
+        for (ns_u32 j = 0; j < buffer->attribute_count; j++) {
+            nsVertexAttribute *attribute = &buffer->attributes[j];
+
+            glVertexAttribPointer(
+                attribute->location,
+                attribute->components,
+                attribute->type,
+                attribute->normalized ? GL_TRUE : GL_FALSE,
+                (GLsizei)buffer->stride,
+                (void *)attribute->offset
+            );
+            glEnableVertexAttribArray(attribute->location);
+        }
+    }
+
+    // Element buffer binding is recorded in the VAO
+    if (mesh->index_buffer) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer->buffer_id);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
-void nsMesh_render(nsMesh *mesh) {
+/**
+ * @brief Set the mesh's uniforms and bind it for drawing.
+ */
+static void bind_for_render(nsMesh *mesh) {
     if (mesh->material) {
-        glUseProgram(mesh->material->program_id);
-    }
+        nsMaterial *material = mesh->material;
 
-    // TODO: Make this option better
-    nsBuffer *primary_buffer = mesh->buffers->data[0];
-    size_t vertex_count = primary_buffer->count;
+        // mesh->material is public and can be swapped without the mesh knowing,
+        // so these are staged on every draw, unchanged values are not uploaded
+        nsMaterial_set_vector3(material, material->position_scale_uniform, mesh->position_scale);
+        nsMaterial_set_vector3(material, material->position_offset_uniform, mesh->position_offset);
+
+        nsMaterial_bind(material);
+    }
 
     glBindVertexArray(mesh->vao_id);
-    glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+}
+
+void nsMesh_render(nsMesh *mesh) {
+    nsMesh_render_lod(mesh, 0);
+}
+
+void nsMesh_render_lod(nsMesh *mesh, ns_u32 lod) {
+    NS_PROFILE_ZONE_BEGIN("nsMesh_render");
+    ns_gpu_profiler_begin_zone("nsMesh_render");
+
+    bind_for_render(mesh);
+
+    if (mesh->index_buffer) {
+        size_t first = 0;
+        size_t count = mesh->index_buffer->count;
+
+        if (mesh->lod_count > 0) {
+            if (lod >= mesh->lod_count) lod = mesh->lod_count - 1;
+            first = mesh->lods[lod].index_offset;
+            count = mesh->lods[lod].index_count;
+        }
+
+        // Index buffer stride is the size of one index
+        glDrawElements(
+            GL_TRIANGLES,
+            (GLsizei)count,
+            mesh->index_buffer->index_type,
+            (void *)(first * mesh->index_buffer->stride)
+        );
+    }
+    else {
+        // TODO: Make this option better
+        nsBuffer *primary_buffer = mesh->buffers->data[0];
+        size_t vertex_count = primary_buffer->count;
+
+        glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+    }
+
     glBindVertexArray(0);
+
+    ns_gpu_profiler_end_zone();
+    NS_PROFILE_ZONE_END();
+}
+
+void nsMesh_render_culled(nsMesh *mesh, ns_u32 lod, const nsCullContext *context) {
+    NS_PROFILE_ZONE_BEGIN("nsMesh_render_culled");
+
+    if (mesh->lod_count > 0 && lod >= mesh->lod_count) lod = mesh->lod_count - 1;
+
+    if (
+        !mesh->index_buffer ||
+        mesh->lod_count == 0 ||
+        mesh->lods[lod].meshlet_count == 0
+    ) {
+        mesh->drawn_meshlets = 0;
+        nsMesh_render_lod(mesh, lod);
+        NS_PROFILE_ZONE_END();
+        return;
+    }
+
+    const nsMeshLOD *level = &mesh->lods[lod];
+    size_t index_size = mesh->index_buffer->stride;
+
+    // Draw ranges are only needed until the draw call, the frame arena keeps them off the heap
+    nsArena *frame_arena = ns_get_frame_arena();
+    GLsizei *draw_counts = nsArena_alloc(frame_arena, sizeof(GLsizei) * level->meshlet_count);
+    const void **draw_offsets = nsArena_alloc(frame_arena, sizeof(void *) * level->meshlet_count);
+    if (!draw_counts || !draw_offsets) {
+        mesh->drawn_meshlets = 0;
+        nsMesh_render_lod(mesh, lod);
+        NS_PROFILE_ZONE_END();
+        return;
+    }
+
+    GLsizei draw_n = 0;
+    ns_u32 drawn = 0;
+    ns_u32 range_end = 0;
+
+    for (ns_u32 i = level->meshlet_offset; i < level->meshlet_offset + level->meshlet_count; i++) {
+        const nsMeshlet *meshlet = &mesh->meshlets[i];
+        if (!nsMeshlet_is_visible(meshlet, context)) continue;
+
+        // Meshlets are consecutive in the index buffer, extend the last range if possible
+        if (draw_n > 0 && range_end == meshlet->index_offset) {
+            draw_counts[draw_n - 1] += (GLsizei)meshlet->index_count;
+        }
+        else {
+            draw_counts[draw_n] = (GLsizei)meshlet->index_count;
+            draw_offsets[draw_n] = (const void *)((size_t)meshlet->index_offset * index_size);
+            draw_n++;
+        }
+
+        range_end = meshlet->index_offset + meshlet->index_count;
+        drawn++;
+    }
+
+    mesh->drawn_meshlets = drawn;
+    if (draw_n == 0) {
+        NS_PROFILE_ZONE_END();
+        return;
+    }
+
+    ns_gpu_profiler_begin_zone("nsMesh_render_culled");
+    bind_for_render(mesh);
+
+    glMultiDrawElements(
+        GL_TRIANGLES,
+        draw_counts,
+        mesh->index_buffer->index_type,
+        draw_offsets,
+        draw_n
+    );
+
+    glBindVertexArray(0);
+    ns_gpu_profiler_end_zone();
+
+    NS_PROFILE_ZONE_END();
 }
\ No newline at end of file
@@ -0,0 +1,665 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include <math.h>
+#include "engine/include/graphics/mesh_optimizer.h"
+#include "engine/include/core/arena.h"
+
+
+#define NO_TRIANGLE 0xFFFFFFFF
+
+// Valences above this share the same score
+#define MAX_VALENCE_SCORE 32
+
+
+/*
+    Vertex cache optimization
+
+    Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+
+    Every vertex gets a score from its position in a simulated LRU cache and
+    from how many not yet emitted triangles use it. Greedily emitting the
+    triangle with the highest score sum keeps the working set in the cache and
+    finishes off vertices with few triangles left so they can be evicted.
+*/
+
+typedef struct {
+    float cache[NS_MESH_OPTIMIZER_CACHE_SIZE];
+    float valence[MAX_VALENCE_SCORE + 1];
+} ScoreTable;
+
+static void ScoreTable_init(ScoreTable *table) {
+    for (int i = 0; i < NS_MESH_OPTIMIZER_CACHE_SIZE; i++) {
+        // Last triangle's vertices get a fixed score so it's not favored to be reused right away
+        if (i < 3) {
+            table->cache[i] = 0.75f;
+        }
+        else {
+            float scaler = 1.0f / (float)(NS_MESH_OPTIMIZER_CACHE_SIZE - 3);
+            table->cache[i] = powf(1.0f - (float)(i - 3) * scaler, 1.5f);
+        }
+    }
+
+    table->valence[0] = 0.0f;
+    for (int i = 1; i <= MAX_VALENCE_SCORE; i++) {
+        table->valence[i] = 2.0f * powf((float)i, -0.5f);
+    }
+}
+
+static inline float vertex_score(
+    const ScoreTable *table,
+    int cache_position,
+    ns_u32 live_triangles
+) {
+    // Vertex is done, it doesn't contribute anymore
+    if (live_triangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cache_position >= 0) score = table->cache[cache_position];
+
+    ns_u32 valence = live_triangles < MAX_VALENCE_SCORE ? live_triangles : MAX_VALENCE_SCORE;
+    return score + table->valence[valence];
+}
+
+int ns_optimize_vertex_cache(ns_u32 *indices, size_t index_count, size_t vertex_count) {
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return 0;
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    // Vertex -> triangle adjacency in compressed rows
+    ns_u32 *live = nsArena_alloc(scratch, sizeof(ns_u32) * vertex_count);
+    ns_u32 *offsets = nsArena_alloc(scratch, sizeof(ns_u32) * (vertex_count + 1));
+    ns_u32 *adjacency = nsArena_alloc(scratch, sizeof(ns_u32) * triangle_count * 3);
+    int *cache_positions = nsArena_alloc(scratch, sizeof(int) * vertex_count);
+    float *vertex_scores = nsArena_alloc(scratch, sizeof(float) * vertex_count);
+    ns_u8 *emitted = nsArena_alloc(scratch, triangle_count);
+    ns_u32 *output = nsArena_alloc(scratch, sizeof(ns_u32) * triangle_count * 3);
+
+    if (
+        !live || !offsets || !adjacency || !cache_positions ||
+        !vertex_scores || !emitted || !output
+    ) {
+        nsArena_rewind(scratch, mark);
+        return 1;
+    }
+
+    memset(live, 0, sizeof(ns_u32) * vertex_count);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        live[indices[i]]++;
+    }
+
+    offsets[0] = 0;
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+
+    // Reuse the live counts as fill cursors, they are restored by the end
+    memset(live, 0, sizeof(ns_u32) * vertex_count);
+    for (size_t t = 0; t < triangle_count; t++) {
+        for (size_t k = 0; k < 3; k++) {
+            ns_u32 v = indices[t * 3 + k];
+            adjacency[offsets[v] + live[v]++] = (ns_u32)t;
+        }
+    }
+
+    ScoreTable table;
+    ScoreTable_init(&table);
+
+    for (size_t v = 0; v < vertex_count; v++) {
+        cache_positions[v] = -1;
+        vertex_scores[v] = vertex_score(&table, -1, live[v]);
+    }
+
+    ns_u32 best = NO_TRIANGLE;
+    float best_score = -1.0f;
+    for (size_t t = 0; t < triangle_count; t++) {
+        float score =
+            vertex_scores[indices[t * 3 + 0]] +
+            vertex_scores[indices[t * 3 + 1]] +
+            vertex_scores[indices[t * 3 + 2]];
+
+        if (score > best_score) {
+            best_score = score;
+            best = (ns_u32)t;
+        }
+    }
+
+    memset(emitted, 0, triangle_count);
+
+    ns_u32 cache[NS_MESH_OPTIMIZER_CACHE_SIZE + 3];
+    ns_u32 new_cache[NS_MESH_OPTIMIZER_CACHE_SIZE + 3];
+    size_t cache_n = 0;
+    size_t cursor = 0;
+
+    for (size_t out = 0; out < triangle_count; out++) {
+        // Nothing in the cache has triangles left, continue with the next unused one
+        if (best == NO_TRIANGLE) {
+            while (emitted[cursor]) cursor++;
+            best = (ns_u32)cursor;
+        }
+
+        const ns_u32 *triangle = &indices[best * 3];
+        output[out * 3 + 0] = triangle[0];
+        output[out * 3 + 1] = triangle[1];
+        output[out * 3 + 2] = triangle[2];
+        emitted[best] = 1;
+
+        // Remove the triangle from the adjacency of its vertices
+        for (size_t k = 0; k < 3; k++) {
+            ns_u32 v = triangle[k];
+            ns_u32 *list = &adjacency[offsets[v]];
+
+            for (ns_u32 i = 0; i < live[v]; i++) {
+                if (list[i] == best) {
+                    list[i] = list[live[v] - 1];
+                    break;
+                }
+            }
+            live[v]--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        size_t new_cache_n = 0;
+        new_cache[new_cache_n++] = triangle[0];
+        new_cache[new_cache_n++] = triangle[1];
+        new_cache[new_cache_n++] = triangle[2];
+
+        for (size_t i = 0; i < cache_n; i++) {
+            ns_u32 v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                new_cache[new_cache_n++] = v;
+            }
+        }
+
+        // Entries past the cache size are evicted, but their scores still change
+        for (size_t i = 0; i < new_cache_n; i++) {
+            ns_u32 v = new_cache[i];
+            cache_positions[v] = i < NS_MESH_OPTIMIZER_CACHE_SIZE ? (int)i : -1;
+            vertex_scores[v] = vertex_score(&table, cache_positions[v], live[v]);
+        }
+
+        best = NO_TRIANGLE;
+        best_score = -1.0f;
+
+        for (size_t i = 0; i < new_cache_n; i++) {
+            ns_u32 v = new_cache[i];
+            const ns_u32 *list = &adjacency[offsets[v]];
+
+            for (ns_u32 j = 0; j < live[v]; j++) {
+                ns_u32 t = list[j];
+                const ns_u32 *adjacent = &indices[t * 3];
+
+                float score =
+                    vertex_scores[adjacent[0]] +
+                    vertex_scores[adjacent[1]] +
+                    vertex_scores[adjacent[2]];
+
+                // Lower triangle index wins ties, keeps the output deterministic
+                if (score > best_score || (score == best_score && t < best)) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        cache_n = new_cache_n < NS_MESH_OPTIMIZER_CACHE_SIZE ? new_cache_n : NS_MESH_OPTIMIZER_CACHE_SIZE;
+        memcpy(cache, new_cache, sizeof(ns_u32) * cache_n);
+    }
+
+    memcpy(indices, output, sizeof(ns_u32) * triangle_count * 3);
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+
+/*
+    FIFO cache simulation
+
+    Timestamps avoid storing the cache itself: a vertex is in the cache if it
+    was transformed less than cache size misses ago.
+*/
+
+typedef struct {
+    ns_u32 *timestamps;
+    ns_u32 time;
+    ns_u32 cache_size;
+} FIFOCache;
+
+static int FIFOCache_init(FIFOCache *cache, nsArena *arena, size_t vertex_count, ns_u32 cache_size) {
+    cache->timestamps = nsArena_alloc(arena, sizeof(ns_u32) * vertex_count);
+    if (!cache->timestamps) return 1;
+
+    memset(cache->timestamps, 0, sizeof(ns_u32) * vertex_count);
+    cache->cache_size = cache_size;
+    cache->time = cache_size + 1;
+
+    return 0;
+}
+
+static inline void FIFOCache_reset(FIFOCache *cache) {
+    cache->time += cache->cache_size + 1;
+}
+
+static inline ns_u32 FIFOCache_triangle(FIFOCache *cache, const ns_u32 *triangle) {
+    ns_u32 misses = 0;
+
+    for (size_t k = 0; k < 3; k++) {
+        ns_u32 v = triangle[k];
+        if (cache->time - cache->timestamps[v] > cache->cache_size) {
+            cache->timestamps[v] = cache->time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+nsVertexCacheStats ns_analyze_vertex_cache(
+    const ns_u32 *indices,
+    size_t index_count,
+    size_t vertex_count,
+    ns_u32 cache_size
+) {
+    nsVertexCacheStats stats = {0.0f, 0.0f};
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return stats;
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    FIFOCache cache;
+    if (FIFOCache_init(&cache, scratch, vertex_count, cache_size)) return stats;
+
+    size_t misses = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        misses += FIFOCache_triangle(&cache, &indices[t * 3]);
+    }
+
+    // Only count vertices that are actually referenced
+    size_t used = 0;
+    for (size_t v = 0; v < vertex_count; v++) {
+        if (cache.timestamps[v]) used++;
+    }
+
+    nsArena_rewind(scratch, mark);
+
+    stats.acmr = (float)misses / (float)triangle_count;
+    stats.atvr = used > 0 ? (float)misses / (float)used : 0.0f;
+
+    return stats;
+}
+
+
+/*
+    Overdraw optimization
+
+    Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and
+    Reduced Overdraw"
+
+    The cache optimized order is cut into clusters where the cache would be
+    flushed anyway (hard boundaries) and further where a cluster alone is
+    already as cache efficient as the whole (soft boundaries). Clusters are
+    then sorted so the ones facing away from the mesh center come first, they
+    are likely to occlude the rest.
+*/
+
+typedef struct {
+    float sort_key;
+    ns_u32 start; /**< First triangle. */
+    ns_u32 end; /**< One past the last triangle. */
+    double center[3]; /**< Area weighted centroid. */
+    double normal[3]; /**< Area weighted average normal. */
+} OverdrawCluster;
+
+static int compare_clusters(const void *a, const void *b) {
+    const OverdrawCluster *ca = a;
+    const OverdrawCluster *cb = b;
+
+    // Descending key, original order for ties so the sort is stable
+    if (ca->sort_key > cb->sort_key) return -1;
+    if (ca->sort_key < cb->sort_key) return 1;
+    return (ca->start > cb->start) - (ca->start < cb->start);
+}
+
+static inline const float *get_position(const float *positions, size_t stride, ns_u32 v) {
+    return (const float *)((const char *)positions + stride * v);
+}
+
+int ns_optimize_overdraw(
+    ns_u32 *indices,
+    size_t index_count,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count,
+    float threshold
+) {
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return 0;
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    FIFOCache cache;
+    if (FIFOCache_init(&cache, scratch, vertex_count, NS_MESH_OPTIMIZER_FIFO_SIZE)) return 1;
+
+    ns_u32 *hard = nsArena_alloc(scratch, sizeof(ns_u32) * (triangle_count + 1));
+    OverdrawCluster *clusters = nsArena_alloc(scratch, sizeof(OverdrawCluster) * triangle_count);
+    ns_u32 *output = nsArena_alloc(scratch, sizeof(ns_u32) * triangle_count * 3);
+    if (!hard || !clusters || !output) {
+        nsArena_rewind(scratch, mark);
+        return 1;
+    }
+
+    // Hard boundaries, triangles that miss on every vertex start a new cluster
+
+    size_t hard_n = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        if (FIFOCache_triangle(&cache, &indices[t * 3]) == 3) {
+            hard[hard_n++] = (ns_u32)t;
+        }
+    }
+    hard[hard_n] = (ns_u32)triangle_count;
+
+    // Soft boundaries
+    size_t cluster_n = 0;
+    for (size_t h = 0; h < hard_n; h++) {
+        ns_u32 start = hard[h];
+        ns_u32 end = hard[h + 1];
+
+        FIFOCache_reset(&cache);
+        size_t cluster_misses = 0;
+        for (ns_u32 t = start; t < end; t++) {
+            cluster_misses += FIFOCache_triangle(&cache, &indices[t * 3]);
+        }
+        float cluster_acmr = (float)cluster_misses / (float)(end - start);
+
+        FIFOCache_reset(&cache);
+        ns_u32 sub_start = start;
+        size_t misses = 0;
+
+        for (ns_u32 t = start; t < end; t++) {
+            misses += FIFOCache_triangle(&cache, &indices[t * 3]);
+
+            float acmr = (float)misses / (float)(t - sub_start + 1);
+            if (acmr <= cluster_acmr * threshold || t + 1 == end) {
+                clusters[cluster_n++] = (OverdrawCluster){.start = sub_start, .end = t + 1};
+                sub_start = t + 1;
+                misses = 0;
+                FIFOCache_reset(&cache);
+            }
+        }
+    }
+
+    // Cluster centroids & normals, and the mesh centroid
+    double mesh_center[3] = {0.0, 0.0, 0.0};
+    double mesh_area = 0.0;
+
+    for (size_t c = 0; c < cluster_n; c++) {
+        OverdrawCluster *cluster = &clusters[c];
+        double area = 0.0;
+
+        for (ns_u32 t = cluster->start; t < cluster->end; t++) {
+            const float *p0 = get_position(positions, position_stride, indices[t * 3 + 0]);
+            const float *p1 = get_position(positions, position_stride, indices[t * 3 + 1]);
+            const float *p2 = get_position(positions, position_stride, indices[t * 3 + 2]);
+
+            double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+
+            // Cross product length is twice the area, the factor cancels out
+            double n[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+            };
+            double a = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (size_t k = 0; k < 3; k++) {
+                cluster->center[k] += (p0[k] + p1[k] + p2[k]) / 3.0 * a;
+                cluster->normal[k] += n[k];
+            }
+            area += a;
+        }
+
+        for (size_t k = 0; k < 3; k++) mesh_center[k] += cluster->center[k];
+        mesh_area += area;
+
+        double n = cluster->normal[0] * cluster->normal[0] +
+                   cluster->normal[1] * cluster->normal[1] +
+                   cluster->normal[2] * cluster->normal[2];
+        double inv_normal = n > 0.0 ? 1.0 / sqrt(n) : 0.0;
+        double inv_area = area > 0.0 ? 1.0 / area : 0.0;
+
+        for (size_t k = 0; k < 3; k++) {
+            cluster->center[k] *= inv_area;
+            cluster->normal[k] *= inv_normal;
+        }
+    }
+
+    if (mesh_area > 0.0) {
+        for (size_t k = 0; k < 3; k++) mesh_center[k] /= mesh_area;
+    }
+
+    // Clusters facing outwards from the center are drawn first
+    for (size_t c = 0; c < cluster_n; c++) {
+        OverdrawCluster *cluster = &clusters[c];
+        double key = 0.0;
+        for (size_t k = 0; k < 3; k++) {
+            key += (cluster->center[k] - mesh_center[k]) * cluster->normal[k];
+        }
+        cluster->sort_key = (float)key;
+    }
+
+    qsort(clusters, cluster_n, sizeof(OverdrawCluster), compare_clusters);
+
+    size_t out = 0;
+    for (size_t c = 0; c < cluster_n; c++) {
+        size_t n = (clusters[c].end - clusters[c].start) * 3;
+        memcpy(&output[out], &indices[clusters[c].start * 3], sizeof(ns_u32) * n);
+        out += n;
+    }
+
+    memcpy(indices, output, sizeof(ns_u32) * triangle_count * 3);
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+
+size_t ns_optimize_vertex_fetch(
+    void *vertices,
+    size_t vertex_size,
+    size_t vertex_count,
+    ns_u32 *indices,
+    size_t index_count
+) {
+    if (vertex_count == 0) return 0;
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    ns_u32 *remap = nsArena_alloc(scratch, sizeof(ns_u32) * vertex_count);
+    char *reordered = nsArena_alloc(scratch, vertex_size * vertex_count);
+    if (!remap || !reordered) {
+        nsArena_rewind(scratch, mark);
+        return 0;
+    }
+
+    memset(remap, 0xFF, sizeof(ns_u32) * vertex_count);
+
+    ns_u32 next = 0;
+    for (size_t i = 0; i < index_count; i++) {
+        ns_u32 v = indices[i];
+
+        if (remap[v] == NO_TRIANGLE) {
+            remap[v] = next;
+            memcpy(reordered + (size_t)next * vertex_size, (char *)vertices + v * vertex_size, vertex_size);
+            next++;
+        }
+
+        indices[i] = remap[v];
+    }
+
+    memcpy(vertices, reordered, vertex_size * next);
+
+    nsArena_rewind(scratch, mark);
+
+    return next;
+}
+
+
+int nsOBJMesh_generate_lods(nsOBJMesh *mesh, ns_u32 max_lods) {
+    const nsOBJVertex *vertices = (const nsOBJVertex *)mesh->vertices->data;
+    size_t vertex_count = mesh->vertices->size;
+
+    if (max_lods > NS_MESH_MAX_LODS) max_lods = NS_MESH_MAX_LODS;
+
+    // Drop previously generated levels
+    if (mesh->lod_count > 0) mesh->indices->size = mesh->lods[0].index_count;
+
+    size_t base_count = mesh->indices->size;
+    mesh->lods[0] = (nsMeshLOD){0, (ns_u32)base_count, 0.0f};
+    mesh->lod_count = 1;
+
+    if (vertex_count == 0 || base_count < 3) return 0;
+
+    nsVector3 min = vertices[0].position;
+    nsVector3 max = vertices[0].position;
+    for (size_t i = 1; i < vertex_count; i++) {
+        nsVector3 p = vertices[i].position;
+        if (p.x < min.x) min.x = p.x;
+        if (p.y < min.y) min.y = p.y;
+        if (p.z < min.z) min.z = p.z;
+        if (p.x > max.x) max.x = p.x;
+        if (p.y > max.y) max.y = p.y;
+        if (p.z > max.z) max.z = p.z;
+    }
+
+    nsVector3 size = nsVector3_sub(max, min);
+    float extent = size.x > size.y ? size.x : size.y;
+    if (size.z > extent) extent = size.z;
+    float max_error = extent * NS_MESH_OPTIMIZER_LOD_MAX_ERROR;
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    ns_u32 *lod_indices = nsArena_alloc(scratch, sizeof(ns_u32) * base_count);
+    if (!lod_indices) return 1;
+
+    while (mesh->lod_count < max_lods) {
+        const nsMeshLOD *previous = &mesh->lods[mesh->lod_count - 1];
+
+        size_t target = (size_t)((float)previous->index_count * NS_MESH_OPTIMIZER_LOD_REDUCTION);
+        target -= target % 3;
+        if (target < 3 || previous->error >= max_error) break;
+
+        // Levels are simplified from the previous one, so their errors add up
+        size_t count;
+        float error;
+        if (ns_simplify(
+            lod_indices,
+            &count,
+            (const ns_u32 *)mesh->indices->data + previous->index_offset,
+            previous->index_count,
+            &((const nsOBJVertex *)mesh->vertices->data)->position.x,
+            sizeof(nsOBJVertex),
+            vertex_count,
+            target,
+            max_error - previous->error,
+            &error
+        )) {
+            nsArena_rewind(scratch, mark);
+            return 1;
+        }
+
+        if (
+            count == 0 ||
+            (float)count > (float)previous->index_count * NS_MESH_OPTIMIZER_LOD_MIN_REDUCTION
+        ) break;
+
+        size_t offset = mesh->indices->size;
+        if (nsPool_reserve(mesh->indices, offset + count)) {
+            nsArena_rewind(scratch, mark);
+            return 1;
+        }
+
+        memcpy((ns_u32 *)mesh->indices->data + offset, lod_indices, sizeof(ns_u32) * count);
+        mesh->indices->size = offset + count;
+
+        mesh->lods[mesh->lod_count] = (nsMeshLOD){
+            (ns_u32)offset,
+            (ns_u32)count,
+            mesh->lods[mesh->lod_count - 1].error + error
+        };
+        mesh->lod_count++;
+    }
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+int nsOBJMesh_optimize(nsOBJMesh *mesh, nsMeshOptimizeStats *stats) {
+    ns_u32 *indices = (ns_u32 *)mesh->indices->data;
+    size_t index_count = mesh->indices->size;
+    size_t vertex_count = mesh->vertices->size;
+
+    // Without generated levels the whole index buffer is the only level
+    nsMeshLOD full = {0, (ns_u32)index_count, 0.0f};
+    const nsMeshLOD *lods = mesh->lod_count > 0 ? mesh->lods : &full;
+    ns_u32 lod_count = mesh->lod_count > 0 ? mesh->lod_count : 1;
+
+    if (stats) {
+        stats->before = ns_analyze_vertex_cache(
+            indices + lods[0].index_offset, lods[0].index_count, vertex_count, NS_MESH_OPTIMIZER_FIFO_SIZE
+        );
+    }
+
+    for (ns_u32 i = 0; i < lod_count; i++) {
+        ns_u32 *lod_indices = indices + lods[i].index_offset;
+
+        if (ns_optimize_vertex_cache(lod_indices, lods[i].index_count, vertex_count)) return 1;
+
+        if (ns_optimize_overdraw(
+            lod_indices,
+            lods[i].index_count,
+            &((nsOBJVertex *)mesh->vertices->data)->position.x,
+            sizeof(nsOBJVertex),
+            vertex_count,
+            NS_MESH_OPTIMIZER_OVERDRAW_THRESHOLD
+        )) return 1;
+    }
+
+    // Vertices are ordered by the full detail level first, coarser levels mostly reuse them
+    if (vertex_count > 0) {
+        size_t new_count = ns_optimize_vertex_fetch(
+            mesh->vertices->data,
+            sizeof(nsOBJVertex),
+            vertex_count,
+            indices,
+            index_count
+        );
+        if (new_count == 0 && index_count > 0) return 1;
+        mesh->vertices->size = new_count;
+    }
+
+    if (stats) {
+        stats->after = ns_analyze_vertex_cache(
+            indices + lods[0].index_offset, lods[0].index_count, mesh->vertices->size, NS_MESH_OPTIMIZER_FIFO_SIZE
+        );
+    }
+
+    return 0;
+}
\ No newline at end of file
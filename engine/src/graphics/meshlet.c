@@ -0,0 +1,312 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#include <math.h>
+#include "engine/include/graphics/meshlet.h"
+#include "engine/include/core/arena.h"
+
+
+static inline nsVector3 get_position(const float *positions, size_t stride, ns_u32 v) {
+    const float *p = (const float *)((const char *)positions + stride * v);
+    return NS_VECTOR3(p[0], p[1], p[2]);
+}
+
+/**
+ * @brief Compute bounding sphere and normal cone of the triangles.
+ */
+static void compute_bounds(
+    nsMeshlet *meshlet,
+    const ns_u32 *indices,
+    const float *positions,
+    size_t position_stride
+) {
+    size_t triangle_count = meshlet->index_count / 3;
+
+    nsVector3 min = get_position(positions, position_stride, indices[0]);
+    nsVector3 max = min;
+    nsVector3 normal_sum = nsVector3_zero;
+
+    for (size_t t = 0; t < triangle_count; t++) {
+        nsVector3 p0 = get_position(positions, position_stride, indices[t * 3 + 0]);
+        nsVector3 p1 = get_position(positions, position_stride, indices[t * 3 + 1]);
+        nsVector3 p2 = get_position(positions, position_stride, indices[t * 3 + 2]);
+
+        nsVector3 corners[3] = {p0, p1, p2};
+        for (size_t k = 0; k < 3; k++) {
+            nsVector3 p = corners[k];
+            if (p.x < min.x) min.x = p.x;
+            if (p.y < min.y) min.y = p.y;
+            if (p.z < min.z) min.z = p.z;
+            if (p.x > max.x) max.x = p.x;
+            if (p.y > max.y) max.y = p.y;
+            if (p.z > max.z) max.z = p.z;
+        }
+
+        // Area weighted
+        normal_sum = nsVector3_add(
+            normal_sum,
+            nsVector3_cross(nsVector3_sub(p1, p0), nsVector3_sub(p2, p0))
+        );
+    }
+
+    meshlet->center = nsVector3_mul(nsVector3_add(min, max), 0.5f);
+    meshlet->radius = 0.0f;
+    for (size_t i = 0; i < meshlet->index_count; i++) {
+        nsVector3 p = get_position(positions, position_stride, indices[i]);
+        float distance = nsVector3_len(nsVector3_sub(p, meshlet->center));
+        if (distance > meshlet->radius) meshlet->radius = distance;
+    }
+
+    meshlet->cone_apex = meshlet->center;
+    meshlet->cone_axis = nsVector3_zero;
+    meshlet->cone_cutoff = 1.0f;
+
+    float axis_length = nsVector3_len(normal_sum);
+    if (axis_length <= 0.0f) return;
+    nsVector3 axis = nsVector3_div(normal_sum, axis_length);
+
+    // Widest triangle normal off the axis
+    float min_dot = 1.0f;
+    for (size_t t = 0; t < triangle_count; t++) {
+        nsVector3 p0 = get_position(positions, position_stride, indices[t * 3 + 0]);
+        nsVector3 p1 = get_position(positions, position_stride, indices[t * 3 + 1]);
+        nsVector3 p2 = get_position(positions, position_stride, indices[t * 3 + 2]);
+
+        nsVector3 normal = nsVector3_cross(nsVector3_sub(p1, p0), nsVector3_sub(p2, p0));
+        float length = nsVector3_len(normal);
+        if (length <= 0.0f) continue;
+
+        float dot = nsVector3_dot(nsVector3_div(normal, length), axis);
+        if (dot < min_dot) min_dot = dot;
+    }
+
+    // Normals spread too much, some triangle always faces the camera
+    if (min_dot <= NS_MESHLET_MIN_CONE_SPREAD) return;
+
+    /*
+        Move the apex back along the axis until every triangle's plane is in
+        front of it. Then if the direction from the camera to the apex is
+        within the cone's complement angle of the axis, every triangle faces
+        away from the camera.
+    */
+    float max_t = 0.0f;
+    for (size_t t = 0; t < triangle_count; t++) {
+        nsVector3 p0 = get_position(positions, position_stride, indices[t * 3 + 0]);
+        nsVector3 p1 = get_position(positions, position_stride, indices[t * 3 + 1]);
+        nsVector3 p2 = get_position(positions, position_stride, indices[t * 3 + 2]);
+
+        nsVector3 normal = nsVector3_cross(nsVector3_sub(p1, p0), nsVector3_sub(p2, p0));
+        float length = nsVector3_len(normal);
+        if (length <= 0.0f) continue;
+        normal = nsVector3_div(normal, length);
+
+        float dc = nsVector3_dot(nsVector3_sub(meshlet->center, p0), normal);
+        float dn = nsVector3_dot(axis, normal);
+
+        // dn is at least the minimum spread, so this can't divide by zero
+        float t_apex = dc / dn;
+        if (t_apex > max_t) max_t = t_apex;
+    }
+
+    meshlet->cone_apex = nsVector3_sub(meshlet->center, nsVector3_mul(axis, max_t));
+    meshlet->cone_axis = axis;
+    meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+int ns_build_meshlets(
+    nsPool *meshlets,
+    const ns_u32 *indices,
+    size_t index_count,
+    ns_u32 index_offset,
+    const float *positions,
+    size_t position_stride,
+    size_t vertex_count
+) {
+    size_t triangle_count = index_count / 3;
+    if (triangle_count == 0) return 0;
+
+    // Vertex is in the current meshlet if its stamp is the current meshlet's
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    ns_u32 *stamps = nsArena_alloc(scratch, sizeof(ns_u32) * vertex_count);
+    if (!stamps) return 1;
+    memset(stamps, 0, sizeof(ns_u32) * vertex_count);
+
+    ns_u32 stamp = 1;
+    size_t start = 0;
+    ns_u32 meshlet_vertices = 0;
+
+    for (size_t t = 0; t <= triangle_count; t++) {
+        ns_bool full = t == triangle_count;
+
+        ns_u32 new_vertices = 0;
+        if (!full) {
+            const ns_u32 *triangle = &indices[t * 3];
+            new_vertices += stamps[triangle[0]] != stamp;
+            new_vertices += stamps[triangle[1]] != stamp && triangle[1] != triangle[0];
+            new_vertices += stamps[triangle[2]] != stamp && triangle[2] != triangle[0] && triangle[2] != triangle[1];
+
+            full = (
+                meshlet_vertices + new_vertices > NS_MESHLET_MAX_VERTICES ||
+                t - start >= NS_MESHLET_MAX_TRIANGLES
+            );
+        }
+
+        if (full && t > start) {
+            nsMeshlet meshlet;
+            meshlet.index_offset = index_offset + (ns_u32)(start * 3);
+            meshlet.index_count = (ns_u32)((t - start) * 3);
+            compute_bounds(&meshlet, &indices[start * 3], positions, position_stride);
+
+            if (nsPool_add(meshlets, &meshlet)) {
+                nsArena_rewind(scratch, mark);
+                return 1;
+            }
+
+            start = t;
+            stamp++;
+            meshlet_vertices = 0;
+
+            // Recount against the fresh meshlet
+            if (t < triangle_count) {
+                const ns_u32 *triangle = &indices[t * 3];
+                new_vertices = 1;
+                new_vertices += triangle[1] != triangle[0];
+                new_vertices += triangle[2] != triangle[0] && triangle[2] != triangle[1];
+            }
+        }
+
+        if (t < triangle_count) {
+            const ns_u32 *triangle = &indices[t * 3];
+            stamps[triangle[0]] = stamp;
+            stamps[triangle[1]] = stamp;
+            stamps[triangle[2]] = stamp;
+            meshlet_vertices += new_vertices;
+        }
+    }
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+int nsOBJMesh_build_meshlets(nsOBJMesh *mesh) {
+    if (!mesh->meshlets) {
+        mesh->meshlets = nsPool_new(sizeof(nsMeshlet));
+        if (!mesh->meshlets) return 1;
+    }
+    mesh->meshlets->size = 0;
+
+    if (mesh->lod_count == 0) {
+        mesh->lods[0] = (nsMeshLOD){0, (ns_u32)mesh->indices->size, 0.0f};
+        mesh->lod_count = 1;
+    }
+
+    const ns_u32 *indices = (const ns_u32 *)mesh->indices->data;
+
+    for (ns_u32 i = 0; i < mesh->lod_count; i++) {
+        nsMeshLOD *lod = &mesh->lods[i];
+        lod->meshlet_offset = (ns_u32)mesh->meshlets->size;
+
+        if (ns_build_meshlets(
+            mesh->meshlets,
+            indices + lod->index_offset,
+            lod->index_count,
+            lod->index_offset,
+            &((const nsOBJVertex *)mesh->vertices->data)->position.x,
+            sizeof(nsOBJVertex),
+            mesh->vertices->size
+        )) return 1;
+
+        lod->meshlet_count = (ns_u32)mesh->meshlets->size - lod->meshlet_offset;
+    }
+
+    return 0;
+}
+
+
+void nsCullContext_from_camera(
+    nsCullContext *context,
+    const nsCamera *camera,
+    nsMatrix4 model
+) {
+    // Planes of the clip matrix are in the space it transforms from
+    nsMatrix4 clip = nsMatrix4_mul(nsMatrix4_mul(camera->projection_mat, camera->view_mat), model);
+    const float *m = clip.m;
+
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = (i % 2) ? -1.0f : 1.0f;
+
+        // Gribb & Hartmann: row 3 +- row 0/1/2
+        float *plane = context->planes[i];
+        plane[0] = m[3] + sign * m[row];
+        plane[1] = m[7] + sign * m[4 + row];
+        plane[2] = m[11] + sign * m[8 + row];
+        plane[3] = m[15] + sign * m[12 + row];
+
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            plane[0] /= length;
+            plane[1] /= length;
+            plane[2] /= length;
+            plane[3] /= length;
+        }
+    }
+
+    /*
+        Model matrix columns are rotation axes scaled by the scale, so the
+        inverse is projecting onto them and dividing by their squared length.
+    */
+    const float *mm = model.m;
+    nsVector3 d = NS_VECTOR3(
+        camera->position.x - mm[12],
+        camera->position.y - mm[13],
+        camera->position.z - mm[14]
+    );
+    float local[3];
+    for (int i = 0; i < 3; i++) {
+        const float *axis = &mm[i * 4];
+        float length2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float dot = axis[0] * d.x + axis[1] * d.y + axis[2] * d.z;
+        local[i] = length2 > 0.0f ? dot / length2 : 0.0f;
+    }
+    context->camera_position = NS_VECTOR3(local[0], local[1], local[2]);
+
+    context->cone_culling = camera->projection == nsCameraProjection_PERSPECTIVE;
+}
+
+ns_bool nsCullContext_test_sphere(
+    const nsCullContext *context,
+    nsVector3 center,
+    float radius
+) {
+    for (int i = 0; i < 6; i++) {
+        const float *plane = context->planes[i];
+        float distance = plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3];
+        if (distance < -radius) return false;
+    }
+
+    return true;
+}
+
+ns_bool nsMeshlet_is_visible(const nsMeshlet *meshlet, const nsCullContext *context) {
+    if (!nsCullContext_test_sphere(context, meshlet->center, meshlet->radius)) return false;
+
+    if (context->cone_culling && meshlet->cone_cutoff < 1.0f) {
+        nsVector3 view = nsVector3_sub(meshlet->cone_apex, context->camera_position);
+        float length = nsVector3_len(view);
+
+        if (nsVector3_dot(view, meshlet->cone_axis) >= meshlet->cone_cutoff * length) return false;
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_MESHES
+
+#include <math.h>
+#include "engine/include/graphics/quantize.h"
+
+
+ns_u16 ns_quantize_half(float value) {
+    ns_u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    ns_u32 sign = (bits >> 16) & 0x8000;
+    ns_u32 abs_bits = bits & 0x7FFFFFFF;
+
+    // NaN stays NaN, infinity stays infinity
+    if (abs_bits >= 0x7F800000) {
+        return (ns_u16)(sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0));
+    }
+
+    // Too large, rounds to infinity
+    if (abs_bits >= 0x477FF000) {
+        return (ns_u16)(sign | 0x7C00);
+    }
+
+    // Too small even for half subnormals, rounds to zero
+    if (abs_bits < 0x33000001) {
+        return (ns_u16)sign;
+    }
+
+    ns_u32 exponent = abs_bits >> 23;
+    ns_u32 mantissa = abs_bits & 0x7FFFFF;
+    ns_u32 shift;
+    ns_u32 half;
+
+    if (exponent < 113) {
+        // Half subnormal, make the implicit bit explicit and shift it down
+        mantissa |= 0x800000;
+        shift = 126 - exponent;
+        half = mantissa >> shift;
+    }
+    else {
+        shift = 13;
+        half = ((exponent - 112) << 10) | (mantissa >> 13);
+    }
+
+    // Round to nearest even, carrying into the exponent is intended
+    ns_u32 remainder = mantissa & ((1u << shift) - 1);
+    ns_u32 halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1))) {
+        half++;
+    }
+
+    return (ns_u16)(sign | half);
+}
+
+float ns_dequantize_half(ns_u16 value) {
+    ns_u32 sign = (ns_u32)(value & 0x8000) << 16;
+    ns_u32 exponent = (value >> 10) & 0x1F;
+    ns_u32 mantissa = value & 0x3FF;
+    ns_u32 bits;
+
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent == 0) {
+        float result = ldexpf((float)mantissa, -24);
+        return sign ? -result : result;
+    }
+    else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+ns_i16 ns_quantize_snorm16(float value) {
+    if (value > 1.0f) value = 1.0f;
+    else if (value < -1.0f) value = -1.0f;
+    else if (value != value) value = 0.0f;
+
+    return (ns_i16)lroundf(value * 32767.0f);
+}
+
+static inline ns_u32 quantize_snorm10(float value) {
+    if (value > 1.0f) value = 1.0f;
+    else if (value < -1.0f) value = -1.0f;
+    else if (value != value) value = 0.0f;
+
+    // Two's complement in 10 bits
+    return (ns_u32)lroundf(value * 511.0f) & 0x3FF;
+}
+
+ns_u32 ns_quantize_normal(nsVector3 normal) {
+    return quantize_snorm10(normal.x) |
+           (quantize_snorm10(normal.y) << 10) |
+           (quantize_snorm10(normal.z) << 20);
+}
+
+
+int nsQuantizedMesh_from_obj(
+    nsQuantizedMesh *quantized,
+    const nsOBJMesh *mesh,
+    nsVector3 bounds_min,
+    nsVector3 bounds_max
+) {
+    size_t vertex_n = mesh->vertices->size;
+
+    quantized->vertex_count = vertex_n;
+    quantized->vertices = NS_MALLOC(sizeof(nsQuantizedVertex) * (vertex_n > 0 ? vertex_n : 1));
+    NS_MEM_CHECK_I(quantized->vertices);
+
+    // Map the bounds to [-1, 1]
+    quantized->position_offset = nsVector3_mul(nsVector3_add(bounds_min, bounds_max), 0.5f);
+    quantized->position_scale = nsVector3_mul(nsVector3_sub(bounds_max, bounds_min), 0.5f);
+
+    nsVector3 inv_scale = NS_VECTOR3(
+        quantized->position_scale.x > 0.0f ? 1.0f / quantized->position_scale.x : 0.0f,
+        quantized->position_scale.y > 0.0f ? 1.0f / quantized->position_scale.y : 0.0f,
+        quantized->position_scale.z > 0.0f ? 1.0f / quantized->position_scale.z : 0.0f
+    );
+
+    const nsOBJVertex *vertices = (const nsOBJVertex *)mesh->vertices->data;
+    for (size_t i = 0; i < vertex_n; i++) {
+        const nsOBJVertex *vertex = &vertices[i];
+        nsQuantizedVertex *out = &quantized->vertices[i];
+
+        nsVector3 p = nsVector3_sub(vertex->position, quantized->position_offset);
+        out->position[0] = ns_quantize_snorm16(p.x * inv_scale.x);
+        out->position[1] = ns_quantize_snorm16(p.y * inv_scale.y);
+        out->position[2] = ns_quantize_snorm16(p.z * inv_scale.z);
+        out->position[3] = 0;
+
+        out->normal = ns_quantize_normal(vertex->normal);
+
+        out->uv[0] = ns_quantize_half(vertex->uv.x);
+        out->uv[1] = ns_quantize_half(vertex->uv.y);
+    }
+
+    return 0;
+}
+
+void nsQuantizedMesh_free(nsQuantizedMesh *quantized) {
+    NS_FREE(quantized->vertices);
+    quantized->vertices = NULL;
+    quantized->vertex_count = 0;
+}
\ No newline at end of file
@@ -8,11 +8,17 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_TEXTURES
+
 #include "engine/include/graphics/texture.h"
+#include "engine/include/core/object_pool.h"
+
+
+static nsObjectPool texture_pool = NS_OBJECT_POOL_INIT(nsTexture, 64, nsMemoryTag_TEXTURES);
 
 
 nsTexture *nsTexture_new() {
-    nsTexture *texture = NS_NEW(nsTexture);
+    nsTexture *texture = nsObjectPool_alloc(&texture_pool);
     NS_MEM_CHECK(texture);
 
     glGenTextures(1, &texture->texture_id);
@@ -32,7 +38,7 @@ void nsTexture_free(nsTexture *texture) {
 
     glDeleteTextures(1, &texture->texture_id);
 
-    NS_FREE(texture);
+    nsObjectPool_release(&texture_pool, texture);
 }
 
 void nsTexture_write(nsTexture *texture, size_t width, size_t height, ns_u8 *data) {
@@ -70,4 +76,25 @@ int nsTexture_fill(nsTexture *texture, nsColor color) {
     SDL_FreeSurface(surf);
 
     return 0;
+}
+
+void nsTexture_allocate(nsTexture *texture, size_t width, size_t height) {
+    glBindTexture(GL_TEXTURE_2D, texture->texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+}
+
+void nsTexture_write_rows(
+    nsTexture *texture,
+    size_t y,
+    size_t width,
+    size_t rows,
+    const ns_u8 *data
+) {
+    glBindTexture(GL_TEXTURE_2D, texture->texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
+void nsTexture_generate_mipmaps(nsTexture *texture) {
+    glBindTexture(GL_TEXTURE_2D, texture->texture_id);
+    glGenerateMipmap(GL_TEXTURE_2D);
 }
\ No newline at end of file
@@ -8,15 +8,32 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_MATERIALS
+
 #include "engine/include/graphics/uniform.h"
+#include "engine/include/core/object_pool.h"
+
 
+static nsObjectPool uniform_pool = NS_OBJECT_POOL_INIT(nsUniform, 256, nsMemoryTag_MATERIALS);
 
-nsUniform *nsUniform_new(char *name, ns_u32 location) {
-    nsUniform *uniform = NS_NEW(nsUniform);
+
+nsUniform *nsUniform_new(const char *name, ns_i32 location, ns_u32 type, ns_i32 size) {
+    nsUniform *uniform = nsObjectPool_alloc(&uniform_pool);
     NS_MEM_CHECK(uniform);
 
-    uniform->name = name;
+    size_t length = strlen(name);
+    char *name_copy = NS_MALLOC(length + 1);
+    if (!name_copy) {
+        nsObjectPool_release(&uniform_pool, uniform);
+        NS_MEM_CHECK(name_copy);
+    }
+    memcpy(name_copy, name, length + 1);
+
+    uniform->name = name_copy;
     uniform->location = location;
+    uniform->type = type;
+    uniform->size = size;
+    uniform->value_offset = 0;
 
     return uniform;
 }
@@ -24,5 +41,6 @@ nsUniform *nsUniform_new(char *name, ns_u32 location) {
 void nsUniform_free(nsUniform *uniform) {
     if (!uniform) return;
 
-    NS_FREE(uniform);
+    NS_FREE(uniform->name);
+    nsObjectPool_release(&uniform_pool, uniform);
 }
\ No newline at end of file
@@ -0,0 +1,485 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_LOADERS
+
+#include "engine/include/loaders/async.h"
+#include "engine/include/core/io.h"
+#include "engine/include/core/profiler.h"
+
+
+typedef enum {
+    UploadStatus_DONE,
+    UploadStatus_PENDING,
+    UploadStatus_WAITING
+} UploadStatus;
+
+
+static void queue_push(nsAsset **head, nsAsset **tail, nsAsset *asset) {
+    asset->_next = NULL;
+
+    if (*tail) (*tail)->_next = asset;
+    else *head = asset;
+
+    *tail = asset;
+}
+
+static nsAsset *queue_pop(nsAsset **head, nsAsset **tail) {
+    nsAsset *asset = *head;
+    if (!asset) return NULL;
+
+    *head = asset->_next;
+    if (!*head) *tail = NULL;
+    asset->_next = NULL;
+
+    return asset;
+}
+
+static char *copy_string(const char *str) {
+    size_t length = strlen(str);
+
+    char *copy = NS_MALLOC(length + 1);
+    NS_MEM_CHECK(copy);
+    memcpy(copy, str, length + 1);
+
+    return copy;
+}
+
+/**
+ * @brief Read one byte of every page, so the main thread doesn't stall on page faults while uploading.
+ */
+static void prefault(const void *data, size_t size) {
+    volatile ns_u8 sink = 0;
+    const ns_u8 *bytes = (const ns_u8 *)data;
+
+    for (size_t i = 0; i < size; i += 4096) {
+        sink ^= bytes[i];
+    }
+
+    (void)sink;
+}
+
+/**
+ * @brief Copy the last error of the calling thread into the asset.
+ */
+static void fail(nsAsset *asset) {
+    snprintf(asset->error, NS_ERROR_BUFFER_SIZE, "%s", _ns_global_error.message);
+}
+
+static void release_cpu_data(nsAsset *asset) {
+    nsMeshSource_free(&asset->_mesh_source);
+
+    SDL_FreeSurface(asset->_surface);
+    asset->_surface = NULL;
+
+    NS_FREE(asset->_shader_sources[0]);
+    NS_FREE(asset->_shader_sources[1]);
+    asset->_shader_sources[0] = NULL;
+    asset->_shader_sources[1] = NULL;
+}
+
+/**
+ * @brief Load asset data on a worker, no GL calls here.
+ */
+static int load_asset(nsAsset *asset) {
+    switch (asset->type) {
+        case nsAssetType_MESH:
+            if (nsMeshSource_load(&asset->_mesh_source, asset->filepaths[0])) return 1;
+
+            if (asset->_mesh_source.cached) {
+                prefault(asset->_mesh_source.cache.file.data, asset->_mesh_source.cache.file.size);
+            }
+            return 0;
+
+        case nsAssetType_TEXTURE: {
+            SDL_Surface *surface = IMG_Load(asset->filepaths[0]);
+            if (!surface) {
+                ns_throw_error(IMG_GetError(), 0, nsErrorSeverity_ERROR);
+                return 1;
+            }
+
+            // Rows can be uploaded as is when they are tightly packed RGBA
+            asset->_surface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            SDL_FreeSurface(surface);
+            if (!asset->_surface) {
+                ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_ERROR);
+                return 1;
+            }
+            return 0;
+        }
+
+        case nsAssetType_MATERIAL:
+            asset->_shader_sources[0] = ns_read_file_raw(asset->filepaths[0]);
+            if (!asset->_shader_sources[0]) return 1;
+
+            asset->_shader_sources[1] = ns_read_file_raw(asset->filepaths[1]);
+            if (!asset->_shader_sources[1]) return 1;
+            return 0;
+    }
+
+    return 1;
+}
+
+static int worker_thread(void *data) {
+    nsAsyncLoader *loader = (nsAsyncLoader *)data;
+
+    NS_PROFILE_THREAD("Asset loader");
+
+    while (true) {
+        SDL_LockMutex(loader->mutex);
+        while (!loader->requests && !loader->quit) {
+            SDL_CondWait(loader->condition, loader->mutex);
+        }
+
+        if (loader->quit) {
+            SDL_UnlockMutex(loader->mutex);
+            ns_free_scratch_arena();
+            NS_PROFILE_THREAD_EXIT();
+            return 0;
+        }
+
+        nsAsset *asset = queue_pop(&loader->requests, &loader->requests_tail);
+        SDL_AtomicSet(&asset->state, nsAssetState_LOADING);
+        SDL_UnlockMutex(loader->mutex);
+
+        NS_PROFILE_ZONE_BEGIN("Load asset");
+        int status = load_asset(asset);
+        NS_PROFILE_ZONE_END();
+
+        // Keep scratch blocks for the next load, but not the peak of a huge one
+        nsArena_trim(ns_get_scratch_arena(), NS_ARENA_SCRATCH_RETAIN);
+
+        if (status) {
+            // Errors are per thread, keep the reason with the asset for the main thread
+            fail(asset);
+            release_cpu_data(asset);
+            SDL_AtomicSet(&asset->state, nsAssetState_FAILED);
+        }
+        else {
+            SDL_AtomicSet(&asset->state, nsAssetState_UPLOADING);
+            nsIntrusiveStack_push(&loader->loaded, &asset->_loaded_node);
+        }
+    }
+}
+
+static UploadStatus upload_mesh(nsAsset *asset) {
+    if (!asset->mesh) {
+        nsAssetState material_state = nsAsset_get_state(asset->dependency);
+
+        if (material_state == nsAssetState_FAILED) {
+            ns_throw_error("Material of the mesh failed to load.", 0, nsErrorSeverity_ERROR);
+            return UploadStatus_DONE;
+        }
+        if (material_state != nsAssetState_READY) return UploadStatus_WAITING;
+
+        nsMaterial *material = asset->dependency->material;
+        nsMeshSource *source = &asset->_mesh_source;
+        asset->_upload_count = 0;
+        asset->_upload_index = 0;
+
+        // Meshes that couldn't be cached are rare, those are uploaded at once
+        if (source->cached) {
+            asset->mesh = nsMesh_from_cache_deferred(
+                material,
+                &source->cache,
+                asset->_uploads,
+                &asset->_upload_count
+            );
+        }
+        else {
+            asset->mesh = nsMesh_from_source(material, source);
+        }
+
+        if (!asset->mesh) return UploadStatus_DONE;
+    }
+
+    while (asset->_upload_index < asset->_upload_count) {
+        if (nsBufferUpload_step(&asset->_uploads[asset->_upload_index], NS_ASYNC_UPLOAD_CHUNK_SIZE)) {
+            asset->_upload_index++;
+        }
+        else {
+            return UploadStatus_PENDING;
+        }
+    }
+
+    return UploadStatus_DONE;
+}
+
+static UploadStatus upload_texture(nsAsset *asset) {
+    SDL_Surface *surface = asset->_surface;
+
+    if (!asset->texture) {
+        asset->texture = nsTexture_new();
+        if (!asset->texture) return UploadStatus_DONE;
+
+        nsTexture_allocate(asset->texture, (size_t)surface->w, (size_t)surface->h);
+        asset->_uploaded_rows = 0;
+        return UploadStatus_PENDING;
+    }
+
+    size_t height = (size_t)surface->h;
+    size_t rows = surface->pitch > 0 ? NS_ASYNC_UPLOAD_CHUNK_SIZE / (size_t)surface->pitch : height;
+    if (rows < 1) rows = 1;
+    if (rows > height - asset->_uploaded_rows) rows = height - asset->_uploaded_rows;
+
+    nsTexture_write_rows(
+        asset->texture,
+        asset->_uploaded_rows,
+        (size_t)surface->w,
+        rows,
+        (const ns_u8 *)surface->pixels + asset->_uploaded_rows * (size_t)surface->pitch
+    );
+    asset->_uploaded_rows += rows;
+
+    if (asset->_uploaded_rows < height) return UploadStatus_PENDING;
+
+    nsTexture_generate_mipmaps(asset->texture);
+    return UploadStatus_DONE;
+}
+
+static UploadStatus upload_material(nsAsset *asset) {
+    asset->material = nsMaterial_new(asset->_shader_sources[0], asset->_shader_sources[1]);
+    return UploadStatus_DONE;
+}
+
+/**
+ * @brief Do the next part of an asset's upload, finishing it when complete.
+ */
+static UploadStatus upload_step(nsAsset *asset) {
+    UploadStatus status = UploadStatus_DONE;
+
+    switch (asset->type) {
+        case nsAssetType_MESH:
+            status = upload_mesh(asset);
+            break;
+
+        case nsAssetType_TEXTURE:
+            status = upload_texture(asset);
+            break;
+
+        case nsAssetType_MATERIAL:
+            status = upload_material(asset);
+            break;
+    }
+
+    if (status != UploadStatus_DONE) return status;
+
+    release_cpu_data(asset);
+
+    ns_bool failed = (
+        (asset->type == nsAssetType_MESH && !asset->mesh) ||
+        (asset->type == nsAssetType_TEXTURE && !asset->texture) ||
+        (asset->type == nsAssetType_MATERIAL && !asset->material)
+    );
+    if (failed) fail(asset);
+    SDL_AtomicSet(&asset->state, failed ? nsAssetState_FAILED : nsAssetState_READY);
+
+    return UploadStatus_DONE;
+}
+
+static nsAsset *request(
+    nsAsyncLoader *loader,
+    nsAssetType type,
+    const char *filepath0,
+    const char *filepath1,
+    nsAsset *dependency
+) {
+    nsAsset *asset = NS_NEW(nsAsset);
+    NS_MEM_CHECK(asset);
+
+    *asset = (nsAsset){
+        .type = type,
+        .dependency = dependency
+    };
+    SDL_AtomicSet(&asset->state, nsAssetState_QUEUED);
+
+    asset->filepaths[0] = copy_string(filepath0);
+    if (!asset->filepaths[0]) {
+        NS_FREE(asset);
+        return NULL;
+    }
+
+    if (filepath1) {
+        asset->filepaths[1] = copy_string(filepath1);
+        if (!asset->filepaths[1]) {
+            NS_FREE(asset->filepaths[0]);
+            NS_FREE(asset);
+            return NULL;
+        }
+    }
+
+    // Owned list is only touched on the main thread
+    asset->_next_owned = loader->assets;
+    loader->assets = asset;
+
+    SDL_LockMutex(loader->mutex);
+    queue_push(&loader->requests, &loader->requests_tail, asset);
+    SDL_CondSignal(loader->condition);
+    SDL_UnlockMutex(loader->mutex);
+
+    return asset;
+}
+
+
+nsAsyncLoader *nsAsyncLoader_new(ns_u32 worker_count) {
+    nsAsyncLoader *loader = NS_NEW(nsAsyncLoader);
+    NS_MEM_CHECK(loader);
+
+    *loader = (nsAsyncLoader){
+        .upload_budget = NS_ASYNC_DEFAULT_UPLOAD_BUDGET
+    };
+
+    // Leave a core to the main thread
+    if (worker_count == 0) {
+        int cpu_count = SDL_GetCPUCount();
+        worker_count = cpu_count > 1 ? (ns_u32)cpu_count - 1 : 1;
+    }
+    if (worker_count > NS_ASYNC_MAX_WORKERS) worker_count = NS_ASYNC_MAX_WORKERS;
+
+    loader->mutex = SDL_CreateMutex();
+    loader->condition = SDL_CreateCond();
+    if (!loader->mutex || !loader->condition) {
+        ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_ERROR);
+        nsAsyncLoader_free(loader);
+        return NULL;
+    }
+
+    for (ns_u32 i = 0; i < worker_count; i++) {
+        loader->workers[i] = SDL_CreateThread(worker_thread, "nsAsyncLoader", loader);
+        if (!loader->workers[i]) {
+            ns_throw_error(SDL_GetError(), 0, nsErrorSeverity_ERROR);
+            nsAsyncLoader_free(loader);
+            return NULL;
+        }
+        loader->worker_count++;
+    }
+
+    return loader;
+}
+
+void nsAsyncLoader_free(nsAsyncLoader *loader) {
+    if (!loader) return;
+
+    if (loader->mutex) {
+        SDL_LockMutex(loader->mutex);
+        loader->quit = true;
+        SDL_CondBroadcast(loader->condition);
+        SDL_UnlockMutex(loader->mutex);
+    }
+
+    for (ns_u32 i = 0; i < loader->worker_count; i++) {
+        SDL_WaitThread(loader->workers[i], NULL);
+    }
+
+    nsAsset *asset = loader->assets;
+    while (asset) {
+        nsAsset *next = asset->_next_owned;
+
+        release_cpu_data(asset);
+
+        // Partially uploaded objects were never handed out
+        if (nsAsset_get_state(asset) != nsAssetState_READY) {
+            if (asset->mesh) asset->mesh->material = NULL;
+            nsMesh_free(asset->mesh);
+            nsTexture_free(asset->texture);
+        }
+
+        NS_FREE(asset->filepaths[0]);
+        NS_FREE(asset->filepaths[1]);
+        NS_FREE(asset);
+
+        asset = next;
+    }
+
+    SDL_DestroyCond(loader->condition);
+    SDL_DestroyMutex(loader->mutex);
+
+    NS_FREE(loader);
+}
+
+nsAsset *nsAsyncLoader_load_mesh(
+    nsAsyncLoader *loader,
+    nsAsset *material,
+    const char *filepath
+) {
+    if (!material || material->type != nsAssetType_MATERIAL) {
+        ns_throw_error("Mesh needs a material asset.", 0, nsErrorSeverity_ERROR);
+        return NULL;
+    }
+
+    return request(loader, nsAssetType_MESH, filepath, NULL, material);
+}
+
+nsAsset *nsAsyncLoader_load_texture(nsAsyncLoader *loader, const char *filepath) {
+    return request(loader, nsAssetType_TEXTURE, filepath, NULL, NULL);
+}
+
+nsAsset *nsAsyncLoader_load_material(
+    nsAsyncLoader *loader,
+    const char *vertex_shader_source_filepath,
+    const char *fragment_shader_source_filepath
+) {
+    return request(
+        loader,
+        nsAssetType_MATERIAL,
+        vertex_shader_source_filepath,
+        fragment_shader_source_filepath,
+        NULL
+    );
+}
+
+void nsAsyncLoader_upload(nsAsyncLoader *loader) {
+    NS_PROFILE_ZONE_BEGIN("nsAsyncLoader_upload");
+
+    // Take everything the workers finished since the last frame, in the order they finished
+    nsStackNode *node = nsStackNode_reverse(nsIntrusiveStack_pop_all(&loader->loaded));
+
+    nsAsset **end = &loader->uploading;
+    while (*end) end = &(*end)->_next;
+
+    for (; node; node = node->next) {
+        *end = NS_CONTAINER_OF(node, nsAsset, _loaded_node);
+        (*end)->_next = NULL;
+        end = &(*end)->_next;
+    }
+
+    nsPrecisionTimer timer;
+    nsPrecisionTimer_start(&timer);
+
+    nsAsset **link = &loader->uploading;
+    while (*link) {
+        nsAsset *asset = *link;
+
+        UploadStatus status;
+        do {
+            status = upload_step(asset);
+        } while (status == UploadStatus_PENDING && nsPrecisionTimer_stop(&timer) < loader->upload_budget);
+
+        if (status == UploadStatus_DONE) {
+            *link = asset->_next;
+            asset->_next = NULL;
+        }
+        else {
+            link = &asset->_next;
+        }
+
+        if (nsPrecisionTimer_stop(&timer) >= loader->upload_budget) break;
+    }
+
+    NS_PROFILE_ZONE_END();
+}
+
+nsAssetState nsAsset_get_state(nsAsset *asset) {
+    return (nsAssetState)SDL_AtomicGet(&asset->state);
+}
+
+ns_bool nsAsset_is_ready(nsAsset *asset) {
+    return nsAsset_get_state(asset) == nsAssetState_READY;
+}
\ No newline at end of file
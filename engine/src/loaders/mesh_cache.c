@@ -0,0 +1,449 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+#define NS_MEMORY_TAG nsMemoryTag_LOADERS
+
+#include <stddef.h>
+#include "engine/include/loaders/mesh_cache.h"
+#include "engine/include/graphics/quantize.h"
+#include "engine/include/core/arena.h"
+
+#if NS_PLATFORM == NS_PLATFORM_WINDOWS
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
+
+
+// 16-bit indices are narrowed through a small staging buffer while writing
+#define STAGING_INDICES 4096
+
+
+static ns_u64 hash_string(const char *str) {
+    // FNV-1a
+    ns_u64 hash = 0xCBF29CE484222325ull;
+    while (*str) {
+        hash ^= (ns_u8)*str++;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static inline ns_u64 align_up(ns_u64 value) {
+    return (value + NS_MESH_CACHE_ALIGNMENT - 1) & ~(ns_u64)(NS_MESH_CACHE_ALIGNMENT - 1);
+}
+
+static int write_padding(FILE *file, ns_u64 *offset) {
+    static const char zeros[NS_MESH_CACHE_ALIGNMENT] = {0};
+
+    ns_u64 aligned = align_up(*offset);
+    size_t n = (size_t)(aligned - *offset);
+    if (n > 0 && fwrite(zeros, 1, n, file) != n) return 1;
+
+    *offset = aligned;
+    return 0;
+}
+
+/**
+ * @brief Check if count elements at offset fit in the file.
+ * 
+ * Written so a crafted header can't overflow it, elem_size can't be 0.
+ */
+static inline ns_bool fits_in_file(ns_u64 offset, ns_u64 count, ns_u64 elem_size, ns_u64 file_size) {
+    return offset <= file_size && count <= (file_size - offset) / elem_size;
+}
+
+/**
+ * @brief Check if the attribute is in one of the formats the writer emits and stays inside its vertex.
+ */
+static ns_bool is_valid_attribute(const nsMeshCacheAttribute *attribute) {
+    ns_u32 component_size;
+
+    switch (attribute->type) {
+        case GL_FLOAT:
+            component_size = 4;
+            break;
+
+        case GL_SHORT:
+        case GL_HALF_FLOAT:
+            component_size = 2;
+            break;
+
+        // Packs all 4 components into 4 bytes
+        case GL_INT_2_10_10_10_REV:
+            if (attribute->components != 4) return false;
+            component_size = 1;
+            break;
+
+        default:
+            return false;
+    }
+
+    return (
+        attribute->components >= 1 && attribute->components <= 4 &&
+        attribute->normalized <= 1 &&
+        attribute->location < NS_MESH_CACHE_MAX_ATTRIBUTES &&
+        attribute->offset < attribute->stride &&
+        attribute->components * component_size <= attribute->stride - attribute->offset
+    );
+}
+
+int nsMeshCache_write(
+    const char *filepath,
+    const nsOBJMesh *mesh,
+    const char *source_filepath,
+    ns_bool quantize
+) {
+    const nsOBJVertex *vertices = (const nsOBJVertex *)mesh->vertices->data;
+    const ns_u32 *indices = (const ns_u32 *)mesh->indices->data;
+    size_t vertex_n = mesh->vertices->size;
+    size_t index_n = mesh->indices->size;
+
+    nsMeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, NS_MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = NS_MESH_CACHE_VERSION;
+    header.header_size = sizeof(nsMeshCacheHeader);
+
+    if (source_filepath) {
+        nsFileInfo info;
+        if (ns_get_file_info(source_filepath, &info)) return 1;
+
+        header.source_size = info.size;
+        header.source_mtime = info.modified_time;
+        header.source_hash = hash_string(source_filepath);
+    }
+
+    // Bounds
+    if (vertex_n > 0) {
+        nsVector3 min = vertices[0].position;
+        nsVector3 max = vertices[0].position;
+        for (size_t i = 1; i < vertex_n; i++) {
+            nsVector3 p = vertices[i].position;
+            if (p.x < min.x) min.x = p.x;
+            if (p.y < min.y) min.y = p.y;
+            if (p.z < min.z) min.z = p.z;
+            if (p.x > max.x) max.x = p.x;
+            if (p.y > max.y) max.y = p.y;
+            if (p.z > max.z) max.z = p.z;
+        }
+        header.bounds_min[0] = min.x; header.bounds_min[1] = min.y; header.bounds_min[2] = min.z;
+        header.bounds_max[0] = max.x; header.bounds_max[1] = max.y; header.bounds_max[2] = max.z;
+    }
+
+    // Layout: one interleaved vertex stream followed by indices
+    nsQuantizedMesh quantized = {0};
+    const void *vertex_data = vertices;
+    size_t vertex_size = sizeof(nsOBJVertex);
+
+    header.attribute_count = 3;
+    ns_u64 offset = align_up(sizeof(nsMeshCacheHeader));
+
+    if (quantize) {
+        if (nsQuantizedMesh_from_obj(
+            &quantized,
+            mesh,
+            NS_VECTOR3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]),
+            NS_VECTOR3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2])
+        )) return 1;
+
+        vertex_data = quantized.vertices;
+        vertex_size = sizeof(nsQuantizedVertex);
+        header.flags |= NS_MESH_CACHE_FLAG_QUANTIZED_POSITIONS;
+
+        header.attributes[0] = (nsMeshCacheAttribute){
+            0, 3, GL_SHORT, 1, sizeof(nsQuantizedVertex), offsetof(nsQuantizedVertex, position), offset
+        };
+        header.attributes[1] = (nsMeshCacheAttribute){
+            1, 4, GL_INT_2_10_10_10_REV, 1, sizeof(nsQuantizedVertex), offsetof(nsQuantizedVertex, normal), offset
+        };
+        header.attributes[2] = (nsMeshCacheAttribute){
+            2, 2, GL_HALF_FLOAT, 0, sizeof(nsQuantizedVertex), offsetof(nsQuantizedVertex, uv), offset
+        };
+    }
+    else {
+        header.attributes[0] = (nsMeshCacheAttribute){
+            0, 3, GL_FLOAT, 0, sizeof(nsOBJVertex), offsetof(nsOBJVertex, position), offset
+        };
+        header.attributes[1] = (nsMeshCacheAttribute){
+            1, 3, GL_FLOAT, 0, sizeof(nsOBJVertex), offsetof(nsOBJVertex, normal), offset
+        };
+        header.attributes[2] = (nsMeshCacheAttribute){
+            2, 2, GL_FLOAT, 0, sizeof(nsOBJVertex), offsetof(nsOBJVertex, uv), offset
+        };
+    }
+
+    offset = align_up(offset + (ns_u64)vertex_size * vertex_n);
+
+    ns_u32 max_index = 0;
+    for (size_t i = 0; i < index_n; i++) {
+        if (indices[i] > max_index) max_index = indices[i];
+    }
+
+    header.vertex_count = vertex_n;
+    header.index_count = index_n;
+    header.index_type = max_index <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.index_offset = offset;
+
+    if (mesh->lod_count > 0) {
+        header.lod_count = mesh->lod_count;
+        memcpy(header.lods, mesh->lods, sizeof(nsMeshLOD) * mesh->lod_count);
+    }
+    else {
+        header.lod_count = 1;
+        header.lods[0] = (nsMeshLOD){0, (ns_u32)index_n, 0.0f};
+    }
+
+    size_t index_size = header.index_type == GL_UNSIGNED_SHORT ? sizeof(ns_u16) : sizeof(ns_u32);
+    size_t meshlet_n = mesh->meshlets ? mesh->meshlets->size : 0;
+    header.meshlet_count = meshlet_n;
+    header.meshlet_offset = align_up(offset + (ns_u64)index_size * index_n);
+
+    /*
+        Write next to the cache and move it in place at the end, other threads
+        may have the old cache mapped or be baking the same source right now.
+    */
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    size_t filepath_len = strlen(filepath);
+    size_t temp_filepath_size = filepath_len + 64;
+    char *temp_filepath = nsArena_alloc(scratch, temp_filepath_size);
+    if (!temp_filepath) {
+        nsQuantizedMesh_free(&quantized);
+        return 1;
+    }
+    // Thread ids repeat across processes, several tools can bake the same cache
+    snprintf(
+        temp_filepath, temp_filepath_size, "%s.%lu.%lu.tmp",
+        filepath, (unsigned long)getpid(), (unsigned long)SDL_ThreadID()
+    );
+
+    FILE *file = fopen(temp_filepath, "wb");
+    if (!file) {
+        ns_throw_error("Failed to open mesh cache for writing.", 0, nsErrorSeverity_ERROR);
+        nsQuantizedMesh_free(&quantized);
+        nsArena_rewind(scratch, mark);
+        return 1;
+    }
+
+    ns_u64 written = 0;
+    int status = 0;
+
+    status |= fwrite(&header, sizeof(header), 1, file) != 1;
+    written += sizeof(header);
+
+    if (!status) {
+        status |= write_padding(file, &written);
+        status |= fwrite(vertex_data, vertex_size, vertex_n, file) != vertex_n;
+        written += (ns_u64)vertex_size * vertex_n;
+    }
+
+    if (!status) status |= write_padding(file, &written);
+
+    if (!status && header.index_type == GL_UNSIGNED_SHORT) {
+        ns_u16 staging[STAGING_INDICES];
+
+        for (size_t i = 0; i < index_n && !status; i += STAGING_INDICES) {
+            size_t n = index_n - i;
+            if (n > STAGING_INDICES) n = STAGING_INDICES;
+
+            for (size_t j = 0; j < n; j++) staging[j] = (ns_u16)indices[i + j];
+
+            status |= fwrite(staging, sizeof(ns_u16), n, file) != n;
+        }
+    }
+    else if (!status) {
+        status |= fwrite(indices, sizeof(ns_u32), index_n, file) != index_n;
+    }
+    written += (ns_u64)index_size * index_n;
+
+    if (!status && meshlet_n > 0) {
+        status |= write_padding(file, &written);
+        status |= fwrite(mesh->meshlets->data, sizeof(nsMeshlet), meshlet_n, file) != meshlet_n;
+    }
+
+    status |= fclose(file) != 0;
+    nsQuantizedMesh_free(&quantized);
+
+    if (!status) {
+        // Windows can't rename over an existing file
+        #if NS_PLATFORM == NS_PLATFORM_WINDOWS
+            remove(filepath);
+        #endif
+        status |= rename(temp_filepath, filepath) != 0;
+    }
+
+    if (status) {
+        ns_throw_error("Failed to write mesh cache.", 0, nsErrorSeverity_ERROR);
+        remove(temp_filepath);
+        nsArena_rewind(scratch, mark);
+        return 1;
+    }
+
+    nsArena_rewind(scratch, mark);
+
+    return 0;
+}
+
+int nsMeshCache_open(
+    nsMeshCache *cache,
+    const char *filepath,
+    const char *source_filepath
+) {
+    cache->header = NULL;
+
+    // Missing cache is the common first-run case, don't treat it as an error
+    FILE *probe = fopen(filepath, "rb");
+    if (!probe) {
+        ns_throw_error("Mesh cache not found.", 0, nsErrorSeverity_DEBUG);
+        return 1;
+    }
+    fclose(probe);
+
+    if (ns_map_file(&cache->file, filepath)) return 1;
+
+    const nsMeshCacheHeader *header = (const nsMeshCacheHeader *)cache->file.data;
+    ns_u64 file_size = cache->file.size;
+
+    if (
+        file_size < sizeof(nsMeshCacheHeader) ||
+        memcmp(header->magic, NS_MESH_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != NS_MESH_CACHE_VERSION ||
+        header->header_size != sizeof(nsMeshCacheHeader) ||
+        header->attribute_count > NS_MESH_CACHE_MAX_ATTRIBUTES
+    ) {
+        ns_throw_error("Invalid or outdated mesh cache.", 0, nsErrorSeverity_WARNING);
+        ns_unmap_file(&cache->file);
+        return 1;
+    }
+
+    // Make sure no stream reaches past the end of the file
+    for (ns_u32 i = 0; i < header->attribute_count; i++) {
+        const nsMeshCacheAttribute *attribute = &header->attributes[i];
+
+        if (
+            !is_valid_attribute(attribute) ||
+            !fits_in_file(attribute->stream_offset, header->vertex_count, attribute->stride, file_size)
+        ) {
+            ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+            ns_unmap_file(&cache->file);
+            return 1;
+        }
+    }
+
+    ns_u64 index_size = header->index_type == GL_UNSIGNED_SHORT ? sizeof(ns_u16) : sizeof(ns_u32);
+    if (
+        (header->index_type != GL_UNSIGNED_SHORT && header->index_type != GL_UNSIGNED_INT) ||
+        header->index_offset % index_size != 0 ||
+        !fits_in_file(header->index_offset, header->index_count, index_size, file_size)
+    ) {
+        ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+        ns_unmap_file(&cache->file);
+        return 1;
+    }
+
+    if (header->lod_count == 0 || header->lod_count > NS_MESH_MAX_LODS) {
+        ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+        ns_unmap_file(&cache->file);
+        return 1;
+    }
+
+    // Meshlets are read in place, the writer always aligns their stream
+    if (
+        header->meshlet_offset % NS_MESH_CACHE_ALIGNMENT != 0 ||
+        (
+            header->meshlet_count > 0 &&
+            !fits_in_file(header->meshlet_offset, header->meshlet_count, sizeof(nsMeshlet), file_size)
+        )
+    ) {
+        ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+        ns_unmap_file(&cache->file);
+        return 1;
+    }
+
+    // Meshlets are drawn as index ranges, they must not reach past the indices
+    const nsMeshlet *meshlets = (const nsMeshlet *)((const char *)cache->file.data + header->meshlet_offset);
+    for (ns_u64 i = 0; i < header->meshlet_count; i++) {
+        if ((ns_u64)meshlets[i].index_offset + meshlets[i].index_count > header->index_count) {
+            ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+            ns_unmap_file(&cache->file);
+            return 1;
+        }
+    }
+
+    for (ns_u32 i = 0; i < header->lod_count; i++) {
+        const nsMeshLOD *lod = &header->lods[i];
+
+        if (
+            (ns_u64)lod->index_offset + lod->index_count > header->index_count ||
+            (ns_u64)lod->meshlet_offset + lod->meshlet_count > header->meshlet_count
+        ) {
+            ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+            ns_unmap_file(&cache->file);
+            return 1;
+        }
+    }
+
+    if (source_filepath) {
+        nsFileInfo info;
+        if (
+            ns_get_file_info(source_filepath, &info) ||
+            info.size != header->source_size ||
+            info.modified_time != header->source_mtime ||
+            hash_string(source_filepath) != header->source_hash
+        ) {
+            ns_throw_error("Mesh cache is stale.", 0, nsErrorSeverity_INFO);
+            ns_unmap_file(&cache->file);
+            return 1;
+        }
+    }
+
+    /*
+        Indices go to the GPU as is, one past the vertices would read out of
+        the vertex buffer. Checked last so stale caches aren't read through.
+    */
+    const void *indices = (const char *)cache->file.data + header->index_offset;
+    ns_u64 max_index = 0;
+
+    if (header->index_type == GL_UNSIGNED_SHORT) {
+        const ns_u16 *indices16 = (const ns_u16 *)indices;
+        ns_u16 max16 = 0;
+        for (ns_u64 i = 0; i < header->index_count; i++) {
+            if (indices16[i] > max16) max16 = indices16[i];
+        }
+        max_index = max16;
+    }
+    else {
+        const ns_u32 *indices32 = (const ns_u32 *)indices;
+        ns_u32 max32 = 0;
+        for (ns_u64 i = 0; i < header->index_count; i++) {
+            if (indices32[i] > max32) max32 = indices32[i];
+        }
+        max_index = max32;
+    }
+
+    if (header->index_count > 0 && max_index >= header->vertex_count) {
+        ns_throw_error("Corrupted mesh cache.", 0, nsErrorSeverity_WARNING);
+        ns_unmap_file(&cache->file);
+        return 1;
+    }
+
+    cache->header = header;
+
+    return 0;
+}
+
+void nsMeshCache_close(nsMeshCache *cache) {
+    ns_unmap_file(&cache->file);
+    cache->header = NULL;
+}
\ No newline at end of file
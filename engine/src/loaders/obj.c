@@ -8,96 +8,282 @@
 
 */
 
+#define NS_MEMORY_TAG nsMemoryTag_LOADERS
+
 #include "engine/include/loaders/obj.h"
 #include "engine/include/core/io.h"
 #include "engine/include/core/profiler.h"
-
-static inline ns_bool is_whitespace(char chr) {
-    return (chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n');
+#include "engine/include/core/number.h"
+#include "engine/include/core/arena.h"
+
+#if NS_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+/**
+ * @brief Number of records of each kind in a range of the source.
+ */
+typedef struct {
+    size_t vertices;
+    size_t normals;
+    size_t uvs;
+    size_t faces;
+} OBJCounts;
+
+/**
+ * @brief One corner of a face, the v/vt/vn triple that becomes a vertex.
+ * 
+ * IDs are 1-based like in the source, 0 marks one that can't be valid.
+ */
+typedef struct {
+    ns_u32 vertex_id;
+    ns_u32 uv_id;
+    ns_u32 normal_id;
+} OBJCorner;
+
+/**
+ * @brief Triangle of the source, kept only until its corners are resolved.
+ */
+typedef struct {
+    OBJCorner corners[3];
+} OBJFace;
+
+/**
+ * @brief Hash table entry mapping a v/vt/vn triple to its output vertex index.
+ */
+typedef struct {
+    OBJCorner corner;
+    ns_u32 index; /**< Output vertex index, NS_OBJ_EMPTY_SLOT if the slot is unused. */
+} OBJVertexKey;
+
+#define NS_OBJ_EMPTY_SLOT 0xFFFFFFFF
+
+/**
+ * @brief Resolves face corners into unique interleaved vertices and indices.
+ * 
+ * Corners are added one at a time, so faces whose attributes are already
+ * parsed go straight into the output layout without being stored.
+ */
+typedef struct {
+    nsOBJMesh *mesh; /**< Output mesh, its pools are created by the builder. */
+    OBJVertexKey *table; /**< Open addressing table. */
+    size_t capacity;
+    ns_bool active;
+} OBJMeshBuilder;
+
+/**
+ * @brief Parsing state of one contiguous range of the source.
+ * 
+ * Every chunk owns its pools so chunks can be parsed on separate threads.
+ */
+typedef struct {
+    const char *current;
+    const char *end;
+    nsPool *vertices;
+    nsPool *normals;
+    nsPool *uvs;
+    nsPool *faces; /**< Pool of OBJFace, `NULL` when faces are resolved while parsing. */
+    OBJMeshBuilder *builder; /**< Resolves faces against this chunk's attributes while parsing if set. */
+    ns_bool prescan; /**< Count records first and allocate pools at exact capacity. */
+    ns_bool failed; /**< Allocation or resolving a face failed. */
+    double prescan_time;
+    double parse_time;
+    nsPoolReallocStats reallocs; /**< Pool reallocations of the thread that parsed it. */
+    nsError error; /**< Error of the thread that parsed it, if failed. */
+} OBJChunk;
+
+
+static inline ns_u32 hash_vertex_key(OBJCorner corner) {
+    ns_u32 h = corner.vertex_id * 0x9E3779B1u;
+    h ^= corner.uv_id * 0x85EBCA77u + (h << 6) + (h >> 2);
+    h ^= corner.normal_id * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+    h ^= h >> 16;
+    return h;
 }
 
-#define ADVANCE obj->current++
+static OBJVertexKey *alloc_vertex_table(size_t capacity) {
+    OBJVertexKey *table = NS_MALLOC(sizeof(OBJVertexKey) * capacity);
+    NS_MEM_CHECK(table);
 
-static inline void skip_whitespace(nsOBJ *obj) {
-    while (*obj->current != '\0' && is_whitespace(*obj->current)) {
-        ADVANCE;
+    for (size_t i = 0; i < capacity; i++) {
+        table[i].index = NS_OBJ_EMPTY_SLOT;
     }
+
+    return table;
 }
 
-static inline void skip_line(nsOBJ *obj) {
-    while (*obj->current != '\0') {
-        ADVANCE;
-        if (*obj->current == '\n') {
-            break;
+/**
+ * @brief Double the capacity of the vertex table and reinsert existing keys.
+ * 
+ * On the heap rather than the scratch arena, an arena would keep every
+ * smaller table until the load ends, as much again as the final table.
+ */
+static int grow_vertex_table(OBJVertexKey **table, size_t *capacity) {
+    size_t new_capacity = *capacity * 2;
+    OBJVertexKey *new_table = alloc_vertex_table(new_capacity);
+    if (!new_table) return 1;
+
+    size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < *capacity; i++) {
+        OBJVertexKey key = (*table)[i];
+        if (key.index == NS_OBJ_EMPTY_SLOT) continue;
+
+        size_t slot = hash_vertex_key(key.corner) & mask;
+        while (new_table[slot].index != NS_OBJ_EMPTY_SLOT) {
+            slot = (slot + 1) & mask;
         }
+        new_table[slot] = key;
     }
 
-    // Skin \n
-    ADVANCE;
+    NS_FREE(*table);
+    *table = new_table;
+    *capacity = new_capacity;
+
+    return 0;
+}
+
+/**
+ * @brief Release the table, and the output pools too if building failed.
+ */
+static void OBJMeshBuilder_finish(OBJMeshBuilder *builder, ns_bool failed) {
+    if (!builder->active) return;
+    builder->active = false;
+
+    NS_FREE(builder->table);
+    builder->table = NULL;
+
+    if (failed) {
+        nsPool_free(builder->mesh->vertices);
+        nsPool_free(builder->mesh->indices);
+        builder->mesh->vertices = NULL;
+        builder->mesh->indices = NULL;
+    }
 }
 
-// KOD NE YAPIYO ANLA, KENDIN TEKRAR YAZ, HATTA OPTIMIZE ET?
+/**
+ * @brief Create the output pools and the table, the mesh has to be set already.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ */
+static int OBJMeshBuilder_init(OBJMeshBuilder *builder, size_t vertex_hint, size_t index_hint) {
+    nsOBJMesh *mesh = builder->mesh;
+
+    builder->active = true;
 
-static inline float fast_atof(const char **p) {
-    const char *s = *p;
-    float sign = 1.0f;
-    if (*s == '-') { sign = -1.0f; s++; }
-    else if (*s == '+') { s++; }
+    /*
+        Unique vertex count is usually close to the position count,
+        so start the table there and grow at 50% load.
+    */
+    builder->capacity = 64;
+    while (builder->capacity < vertex_hint * 2) builder->capacity *= 2;
+
+    builder->table = alloc_vertex_table(builder->capacity);
+    mesh->vertices = nsPool_new_ex(sizeof(nsOBJVertex), vertex_hint > 0 ? vertex_hint : 1, 2.0);
+    mesh->indices = nsPool_new_ex(sizeof(ns_u32), index_hint > 0 ? index_hint : 1, 2.0);
+
+    if (!builder->table || !mesh->vertices || !mesh->indices) {
+        OBJMeshBuilder_finish(builder, true);
+        return 1;
+    }
+
+    return 0;
+}
 
-    float value = 0.0f;
-    while (*s >= '0' && *s <= '9') {
-        value = value * 10.0f + (*s - '0');
-        s++;
+/**
+ * @brief Add a face corner, emitting a new vertex the first time its triple is seen.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ */
+static int OBJMeshBuilder_add(
+    OBJMeshBuilder *builder,
+    OBJCorner corner,
+    nsPool *vertices,
+    nsPool *normals,
+    nsPool *uvs
+) {
+    if (
+        corner.vertex_id < 1 || corner.vertex_id > vertices->size ||
+        corner.uv_id < 1 || corner.uv_id > uvs->size ||
+        corner.normal_id < 1 || corner.normal_id > normals->size
+    ) {
+        ns_throw_error("Face index is out of bounds.", 0, nsErrorSeverity_ERROR);
+        return 1;
     }
 
-    if (*s == '.') {
-        s++;
-        float frac = 0.0f;
-        float scale = 1.0f;
-        while (*s >= '0' && *s <= '9') {
-            frac = frac * 10.0f + (*s - '0');
-            scale *= 10.0f;
-            s++;
+    nsOBJMesh *mesh = builder->mesh;
+    OBJVertexKey *table = builder->table;
+    size_t mask = builder->capacity - 1;
+    size_t slot = hash_vertex_key(corner) & mask;
+
+    while (table[slot].index != NS_OBJ_EMPTY_SLOT) {
+        OBJCorner key = table[slot].corner;
+        if (
+            key.vertex_id == corner.vertex_id &&
+            key.uv_id == corner.uv_id &&
+            key.normal_id == corner.normal_id
+        ) {
+            return nsPool_add(mesh->indices, &table[slot].index);
         }
-        value += frac / scale;
+        slot = (slot + 1) & mask;
+    }
+
+    // First time seeing this triple, emit new vertex
+    ns_u32 index = (ns_u32)mesh->vertices->size;
+
+    nsOBJVertex vertex = {
+        .position = ((nsVector3 *)vertices->data)[corner.vertex_id - 1],
+        .normal = ((nsVector3 *)normals->data)[corner.normal_id - 1],
+        .uv = ((nsVector2 *)uvs->data)[corner.uv_id - 1]
+    };
+    if (nsPool_add(mesh->vertices, &vertex)) return 1;
+
+    table[slot] = (OBJVertexKey){corner, index};
+
+    if (mesh->vertices->size * 2 > builder->capacity) {
+        if (grow_vertex_table(&builder->table, &builder->capacity)) return 1;
     }
 
-    *p = s;
-    return value * sign;
+    return nsPool_add(mesh->indices, &index);
 }
 
-static inline int fast_atoi(const char **p) {
-    const char *s = *p;
-    int sign = 1;
-    if (*s == '-') { sign = -1; s++; }
 
-    int value = 0;
-    while (*s >= '0' && *s <= '9') {
-        value = value * 10 + (*s - '0');
-        s++;
+static inline ns_bool is_whitespace(char chr) {
+    return (chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n');
+}
+
+#define ADVANCE chunk->current++
+
+static inline void skip_whitespace(OBJChunk *chunk) {
+    while (chunk->current < chunk->end && is_whitespace(*chunk->current)) {
+        ADVANCE;
     }
-    *p = s;
-    return value * sign;
 }
 
-static inline float parse_float(nsOBJ *obj) {
-    char *end;
-    float value = strtof(obj->current, &end);
-    obj->current = end;
-    return value;
+static inline void skip_line(OBJChunk *chunk) {
+    while (chunk->current < chunk->end) {
+        if (*chunk->current == '\n') {
+            // Skip \n
+            ADVANCE;
+            break;
+        }
+        ADVANCE;
+    }
+}
 
-    //return fast_atof(&obj->current);
+static inline float parse_float(OBJChunk *chunk) {
+    float value;
+    chunk->current = ns_parse_float(chunk->current, chunk->end, &value);
+    return value;
 }
 
-static inline long parse_long(nsOBJ *obj) {
-    char *end;
-    long value = strtol(obj->current, &end, 10);
-    obj->current = end;
+static inline long parse_long(OBJChunk *chunk) {
+    long value;
+    chunk->current = ns_parse_long(chunk->current, chunk->end, &value);
     return value;
-    //return (long)fast_atoi(&obj->current);
 }
 
-static inline void parse_vertex(nsOBJ *obj) {
+static inline void parse_vertex(OBJChunk *chunk) {
     /*
         Syntax:
         v float float float
@@ -105,20 +291,20 @@ static inline void parse_vertex(nsOBJ *obj) {
 
     ADVANCE; // skip v
 
-    skip_whitespace(obj);
-    float x = parse_float(obj);
+    skip_whitespace(chunk);
+    float x = parse_float(chunk);
 
-    skip_whitespace(obj);
-    float y = parse_float(obj);
+    skip_whitespace(chunk);
+    float y = parse_float(chunk);
 
-    skip_whitespace(obj);
-    float z = parse_float(obj);
+    skip_whitespace(chunk);
+    float z = parse_float(chunk);
 
     nsVector3 vertex = NS_VECTOR3(x, y, z);
-    nsPool_add(obj->vertices, &vertex);
+    nsPool_add(chunk->vertices, &vertex);
 }
 
-static inline void parse_normal(nsOBJ *obj) {
+static inline void parse_normal(OBJChunk *chunk) {
     /*
         Syntax:
         vn float float float
@@ -126,20 +312,20 @@ static inline void parse_normal(nsOBJ *obj) {
 
     ADVANCE; ADVANCE; // skip vn
 
-    skip_whitespace(obj);
-    float x = parse_float(obj);
+    skip_whitespace(chunk);
+    float x = parse_float(chunk);
 
-    skip_whitespace(obj);
-    float y = parse_float(obj);
+    skip_whitespace(chunk);
+    float y = parse_float(chunk);
 
-    skip_whitespace(obj);
-    float z = parse_float(obj);
+    skip_whitespace(chunk);
+    float z = parse_float(chunk);
 
     nsVector3 normal = NS_VECTOR3(x, y, z);
-    nsPool_add(obj->normals, &normal);
+    nsPool_add(chunk->normals, &normal);
 }
 
-static inline void parse_uv(nsOBJ *obj) {
+static inline void parse_uv(OBJChunk *chunk) {
     /*
         Syntax:
         vt float float
@@ -147,17 +333,24 @@ static inline void parse_uv(nsOBJ *obj) {
 
     ADVANCE; ADVANCE; // skip vt
 
-    skip_whitespace(obj);
-    float x = parse_float(obj);
+    skip_whitespace(chunk);
+    float x = parse_float(chunk);
 
-    skip_whitespace(obj);
-    float y = parse_float(obj);
+    skip_whitespace(chunk);
+    float y = parse_float(chunk);
 
     nsVector2 uv = NS_VECTOR2(x, y);
-    nsPool_add(obj->uvs, &uv);
+    nsPool_add(chunk->uvs, &uv);
 }
 
-static inline void parse_face(nsOBJ *obj) {
+/**
+ * @brief Face ID as stored in a corner, IDs that can't be valid become 0.
+ */
+static inline ns_u32 to_corner_id(long id) {
+    return (id > 0 && (unsigned long)id <= 0xFFFFFFFFul) ? (ns_u32)id : 0;
+}
+
+static inline void parse_face(OBJChunk *chunk) {
     /*
         Syntax:
         f int/[int]/[int] int/[int]/[int] int/[int]/[int]
@@ -167,130 +360,625 @@ static inline void parse_face(nsOBJ *obj) {
 
     ADVANCE; // skip f
 
-    skip_whitespace(obj);
-
-    long v0 = parse_long(obj);
-
-    ADVANCE;
-    long uv0 = parse_long(obj);
-
-    ADVANCE;
-    long n0 = parse_long(obj);
-
-    skip_whitespace(obj);
-
-    long v1 = parse_long(obj);
+    OBJFace face;
 
-    ADVANCE;
-    long uv1 = parse_long(obj);
+    for (size_t i = 0; i < 3; i++) {
+        skip_whitespace(chunk);
 
-    ADVANCE;
-    long n1 = parse_long(obj);
+        long v = parse_long(chunk);
 
-    skip_whitespace(obj);
+        ADVANCE;
+        long uv = parse_long(chunk);
 
-    long v2 = parse_long(obj);
+        ADVANCE;
+        long n = parse_long(chunk);
 
-    ADVANCE;
-    long uv2 = parse_long(obj);
+        face.corners[i] = (OBJCorner){to_corner_id(v), to_corner_id(uv), to_corner_id(n)};
+    }
 
-    ADVANCE;
-    long n2 = parse_long(obj);
+    if (!chunk->builder) {
+        nsPool_add(chunk->faces, &face);
+        return;
+    }
 
-    nsOBJFace face = {
-        .vertex_ids = {v0, v1, v2},
-        .normal_ids = {n0, n1, n2},
-        .uv_ids = {uv0, uv1, uv2}
-    };
-    nsPool_add(obj->faces, &face);
+    // Attributes before the face are parsed, so it goes straight into the output
+    for (size_t i = 0; i < 3; i++) {
+        if (OBJMeshBuilder_add(
+            chunk->builder,
+            face.corners[i],
+            chunk->vertices,
+            chunk->normals,
+            chunk->uvs
+        )) {
+            chunk->failed = true;
+            return;
+        }
+    }
 }
 
-static void parse_obj(nsOBJ *obj) {
-    while (*obj->current != '\0') {
-        skip_whitespace(obj);
+static void parse_obj(OBJChunk *chunk) {
+    while (chunk->current < chunk->end && !chunk->failed) {
+        skip_whitespace(chunk);
+
+        if (chunk->current >= chunk->end) {
+            break;
+        }
 
-        if (*obj->current == '#') {
-            skip_line(obj);
+        else if (*chunk->current == '#') {
+            skip_line(chunk);
         }
 
-        else if (*obj->current == 'v' && is_whitespace(*(obj->current + 1))) {
-            parse_vertex(obj);
+        // A trailing v without a next byte falls through to a malformed line,
+        // raw sources aren't NUL terminated
+        else if (*chunk->current == 'v' && chunk->current + 1 < chunk->end && is_whitespace(*(chunk->current + 1))) {
+            parse_vertex(chunk);
         }
 
-        else if (*obj->current == 'v' && *(obj->current + 1) == 'n') {
-            parse_normal(obj);
+        else if (*chunk->current == 'v' && chunk->current + 1 < chunk->end && *(chunk->current + 1) == 'n') {
+            parse_normal(chunk);
         }
 
-        else if (*obj->current == 'v' && *(obj->current + 1) == 't') {
-            parse_uv(obj);
+        else if (*chunk->current == 'v' && chunk->current + 1 < chunk->end && *(chunk->current + 1) == 't') {
+            parse_uv(chunk);
         }
 
-        else if (*obj->current == 'f') {
-            parse_face(obj);
+        else if (*chunk->current == 'f') {
+            parse_face(chunk);
         }
         
         else {
-            skip_line(obj);
+            skip_line(chunk);
         }
     }
 }
 
+static inline void count_line(const char *p, const char *end, OBJCounts *counts) {
+    // Same classification as parse_obj
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p + 1 >= end) return;
+
+    if (*p == 'f') counts->faces++;
+    else if (*p == 'v') {
+        if (is_whitespace(p[1])) counts->vertices++;
+        else if (p[1] == 'n') counts->normals++;
+        else if (p[1] == 't') counts->uvs++;
+    }
+}
+
+static inline int count_trailing_zeros(ns_u32 value) {
+    #if NS_COMPILER == NS_COMPILER_MSVC
+
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int)index;
+
+    #else
+
+    return __builtin_ctz(value);
+
+    #endif
+}
+
+/**
+ * @brief Count records by looking at the start of every line.
+ * 
+ * Newlines are searched 16 bytes at a time, only line starts are inspected.
+ */
+static void prescan(const char *start, const char *end, OBJCounts *counts) {
+    const char *p = start;
+
+    count_line(p, end, counts);
+
+    #if NS_SIMD_SSE2
+
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)p);
+        ns_u32 mask = (ns_u32)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+
+        while (mask) {
+            count_line(p + count_trailing_zeros(mask) + 1, end, counts);
+            mask &= mask - 1;
+        }
+
+        p += 16;
+    }
+
+    #endif
+
+    for (; p < end; p++) {
+        if (*p == '\n') count_line(p + 1, end, counts);
+    }
+}
+
+static int OBJChunk_alloc(OBJChunk *chunk, OBJCounts capacities) {
+    #define _CAPACITY(n) ((n) > 0 ? (n) : 1)
+
+    chunk->vertices = nsPool_new_ex(sizeof(nsVector3), _CAPACITY(capacities.vertices), 2.0);
+    chunk->normals = nsPool_new_ex(sizeof(nsVector3), _CAPACITY(capacities.normals), 2.0);
+    chunk->uvs = nsPool_new_ex(sizeof(nsVector2), _CAPACITY(capacities.uvs), 2.0);
+    if (!chunk->builder) {
+        chunk->faces = nsPool_new_ex(sizeof(OBJFace), _CAPACITY(capacities.faces), 2.0);
+    }
+
+    #undef _CAPACITY
+
+    if (
+        !chunk->vertices || !chunk->normals || !chunk->uvs ||
+        (!chunk->faces && !chunk->builder)
+    ) {
+        nsPool_free(chunk->vertices);
+        nsPool_free(chunk->normals);
+        nsPool_free(chunk->uvs);
+        nsPool_free(chunk->faces);
+        chunk->vertices = NULL;
+        chunk->normals = NULL;
+        chunk->uvs = NULL;
+        chunk->faces = NULL;
+        chunk->failed = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Pool reallocations the calling thread did since the snapshot.
+ */
+static nsPoolReallocStats reallocs_since(nsPoolReallocStats snapshot) {
+    nsPoolReallocStats now = ns_get_pool_realloc_stats();
+
+    return (nsPoolReallocStats){
+        .count = now.count - snapshot.count,
+        .bytes = now.bytes - snapshot.bytes,
+        .time = now.time - snapshot.time
+    };
+}
+
+/**
+ * @brief Allocate the pools of the chunk and parse it.
+ */
+static int process_chunk(OBJChunk *chunk) {
+    nsPrecisionTimer timer;
+    OBJCounts counts = {1, 1, 1, 1};
+    nsPoolReallocStats reallocs = ns_get_pool_realloc_stats();
+
+    if (chunk->prescan) {
+        counts = (OBJCounts){0, 0, 0, 0};
+
+        nsPrecisionTimer_start(&timer);
+        prescan(chunk->current, chunk->end, &counts);
+        chunk->prescan_time = nsPrecisionTimer_stop(&timer);
+    }
+
+    if (OBJChunk_alloc(chunk, counts)) return 1;
+
+    if (chunk->builder && OBJMeshBuilder_init(chunk->builder, counts.vertices, counts.faces * 3)) {
+        chunk->failed = true;
+        return 1;
+    }
+
+    nsPrecisionTimer_start(&timer);
+    parse_obj(chunk);
+    chunk->parse_time = nsPrecisionTimer_stop(&timer);
+
+    chunk->reallocs = reallocs_since(reallocs);
+
+    return 0;
+}
+
+static int parse_obj_thread(void *data) {
+    OBJChunk *chunk = (OBJChunk *)data;
+    int status = process_chunk(chunk);
+
+    // Errors are per thread, the calling thread reports it
+    if (chunk->failed) chunk->error = ns_get_error();
+
+    return status;
+}
+
+static void OBJChunk_init(
+    OBJChunk *chunk,
+    const char *start,
+    const char *end,
+    ns_bool prescan,
+    OBJMeshBuilder *builder
+) {
+    *chunk = (OBJChunk){
+        .current = start,
+        .end = end,
+        .builder = builder,
+        .prescan = prescan
+    };
+}
+
+static void OBJChunk_free(OBJChunk *chunk) {
+    nsPool_free(chunk->vertices);
+    nsPool_free(chunk->normals);
+    nsPool_free(chunk->uvs);
+    nsPool_free(chunk->faces);
+}
+
+/**
+ * @brief Concatenate the same pool of every chunk, in source order.
+ * 
+ * OBJ indices are global, so appending chunk data in order puts every element
+ * at its global index. Chunk N starts at the sum of sizes of chunks before it.
+ */
+static nsPool *merge_pools(nsPool **pools, size_t n, size_t elem_size) {
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        total += pools[i]->size;
+    }
+
+    nsPool *merged = nsPool_new_ex(elem_size, total > 0 ? total : 1, 2.0);
+    if (!merged) return NULL;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(
+            (char *)merged->data + offset * elem_size,
+            pools[i]->data,
+            pools[i]->size * elem_size
+        );
+        offset += pools[i]->size;
+    }
+    merged->size = total;
+
+    return merged;
+}
+
+/**
+ * @brief Resolve the stored faces of the chunks into the mesh, in source order.
+ * 
+ * Faces can refer to attributes parsed by any earlier chunk, so attributes of
+ * all chunks are merged first. Each chunk's attribute pools are freed as soon
+ * as they are merged.
+ * 
+ * Returns non-zero on error. Use @ref ns_get_error to get more information.
+ */
+static int resolve_faces(nsOBJMesh *mesh, OBJChunk *chunks, ns_u32 n) {
+    nsPool *pools[NS_OBJ_MAX_THREADS];
+
+    for (ns_u32 i = 0; i < n; i++) pools[i] = chunks[i].vertices;
+    nsPool *vertices = merge_pools(pools, n, sizeof(nsVector3));
+
+    for (ns_u32 i = 0; i < n; i++) pools[i] = chunks[i].normals;
+    nsPool *normals = merge_pools(pools, n, sizeof(nsVector3));
+
+    for (ns_u32 i = 0; i < n; i++) pools[i] = chunks[i].uvs;
+    nsPool *uvs = merge_pools(pools, n, sizeof(nsVector2));
+
+    for (ns_u32 i = 0; i < n; i++) {
+        nsPool_free(chunks[i].vertices);
+        nsPool_free(chunks[i].normals);
+        nsPool_free(chunks[i].uvs);
+        chunks[i].vertices = NULL;
+        chunks[i].normals = NULL;
+        chunks[i].uvs = NULL;
+    }
+
+    int status = !vertices || !normals || !uvs;
+
+    size_t face_n = 0;
+    for (ns_u32 i = 0; i < n; i++) face_n += chunks[i].faces->size;
+
+    OBJMeshBuilder builder = {.mesh = mesh};
+    if (!status) status = OBJMeshBuilder_init(&builder, vertices->size, face_n * 3);
+
+    for (ns_u32 i = 0; i < n && !status; i++) {
+        const OBJFace *faces = (const OBJFace *)chunks[i].faces->data;
+
+        for (size_t j = 0; j < chunks[i].faces->size && !status; j++) {
+            for (size_t k = 0; k < 3 && !status; k++) {
+                status = OBJMeshBuilder_add(&builder, faces[j].corners[k], vertices, normals, uvs);
+            }
+        }
+    }
+
+    OBJMeshBuilder_finish(&builder, status != 0);
+
+    nsPool_free(vertices);
+    nsPool_free(normals);
+    nsPool_free(uvs);
+
+    return status;
+}
+
+static ns_u32 resolve_thread_count(size_t length, ns_u32 requested) {
+    ns_u32 thread_count = requested;
+
+    if (thread_count == 0) {
+        int cpu_count = SDL_GetCPUCount();
+        thread_count = cpu_count > 0 ? (ns_u32)cpu_count : 1;
+    }
+
+    // Don't bother spawning threads for tiny chunks
+    size_t max_chunks = length / NS_OBJ_MIN_CHUNK_SIZE;
+    if (max_chunks < 1) max_chunks = 1;
+
+    if ((size_t)thread_count > max_chunks) thread_count = (ns_u32)max_chunks;
+    if (thread_count > NS_OBJ_MAX_THREADS) thread_count = NS_OBJ_MAX_THREADS;
+
+    return thread_count;
+}
 
 nsOBJ nsOBJ_load_raw(char *source) {
-    nsOBJ obj;
+    return nsOBJ_load_raw_ex(source, strlen(source), nsOBJLoadOptions_default);
+}
+
+nsOBJ nsOBJ_load_raw_ex(
+    const char *source,
+    size_t length,
+    nsOBJLoadOptions options
+) {
+    nsOBJ obj = {0};
+
+    // Chunks parsed on this thread are included, workers are added separately
+    nsPoolReallocStats reallocs = ns_get_pool_realloc_stats();
+
+    const char *source_end = source + length;
+    ns_u32 chunk_n = resolve_thread_count(length, options.thread_count);
+
+    OBJChunk chunks[NS_OBJ_MAX_THREADS];
+    SDL_Thread *threads[NS_OBJ_MAX_THREADS] = {NULL};
+
+    /*
+        A single chunk has every attribute a face can refer to parsed before
+        the face, so faces go straight into the interleaved output. Faces of
+        several chunks can refer to attributes of other chunks and are stored
+        until every chunk is parsed.
+    */
+    OBJMeshBuilder builder = {.mesh = &obj.mesh};
+
+    // Split the source on line boundaries
+    const char *chunk_start = source;
+    ns_u32 valid_n = 0;
+    for (ns_u32 i = 0; i < chunk_n; i++) {
+        const char *chunk_end = source_end;
+
+        if (i < chunk_n - 1) {
+            chunk_end = source + (length / chunk_n) * (i + 1);
+            if (chunk_end < chunk_start) chunk_end = chunk_start;
+
+            const char *newline = memchr(chunk_end, '\n', source_end - chunk_end);
+            chunk_end = newline ? newline + 1 : source_end;
+        }
+
+        OBJChunk_init(&chunks[i], chunk_start, chunk_end, options.prescan, NULL);
+        valid_n++;
+
+        chunk_start = chunk_end;
+        if (chunk_start >= source_end) break;
+    }
+
+    if (valid_n == 1) chunks[0].builder = &builder;
+
+    // First chunk is parsed on the calling thread, rest on workers
+    for (ns_u32 i = 1; i < valid_n; i++) {
+        threads[i] = SDL_CreateThread(parse_obj_thread, "nsOBJ", &chunks[i]);
+        if (!threads[i]) {
+            // Couldn't spawn the thread, parse it here instead
+            process_chunk(&chunks[i]);
+        }
+    }
 
-    obj.vertices = nsPool_new(sizeof(nsVector3));
-    obj.normals = nsPool_new(sizeof(nsVector3));
-    obj.uvs = nsPool_new(sizeof(nsVector2));
-    obj.faces = nsPool_new(sizeof(nsOBJFace));
+    process_chunk(&chunks[0]);
 
-    obj.mesh.tris = nsPool_new(sizeof(nsOBJTri));
+    for (ns_u32 i = 1; i < valid_n; i++) {
+        if (threads[i]) SDL_WaitThread(threads[i], NULL);
+    }
 
-    obj.current = source;
+    for (ns_u32 i = 0; i < valid_n; i++) {
+        if (chunks[i].failed) {
+            if (threads[i]) _ns_global_error = chunks[i].error;
+            OBJMeshBuilder_finish(&builder, true);
+            for (ns_u32 j = 0; j < valid_n; j++) OBJChunk_free(&chunks[j]);
+            return obj;
+        }
+    }
 
-    parse_obj(&obj);
+    nsOBJLoadStats stats = {0};
+    for (ns_u32 i = 0; i < valid_n; i++) {
+        OBJChunk *chunk = &chunks[i];
 
-    for (size_t i = 0; i < obj.faces->size; i++) {
-        nsOBJFace *face = nsPool_get(obj.faces, i);
+        if (chunk->prescan_time > stats.prescan_time) stats.prescan_time = chunk->prescan_time;
+        if (chunk->parse_time > stats.parse_time) stats.parse_time = chunk->parse_time;
 
-        nsOBJTri tri = {
-            .vertices = {
-                *(nsVector3 *)nsPool_get(obj.vertices, face->vertex_ids[0] - 1),
-                *(nsVector3 *)nsPool_get(obj.vertices, face->vertex_ids[1] - 1),
-                *(nsVector3 *)nsPool_get(obj.vertices, face->vertex_ids[2] - 1)
-            },
-            .normals = {
-                *(nsVector3 *)nsPool_get(obj.normals, face->normal_ids[0] - 1),
-                *(nsVector3 *)nsPool_get(obj.normals, face->normal_ids[1] - 1),
-                *(nsVector3 *)nsPool_get(obj.normals, face->normal_ids[2] - 1)
-            },
-            .uvs = {
-                *(nsVector2 *)nsPool_get(obj.uvs, face->uv_ids[0] - 1),
-                *(nsVector2 *)nsPool_get(obj.uvs, face->uv_ids[1] - 1),
-                *(nsVector2 *)nsPool_get(obj.uvs, face->uv_ids[2] - 1)
-            },
-        };
+        if (threads[i]) {
+            stats.realloc_count += chunk->reallocs.count;
+            stats.realloc_bytes += chunk->reallocs.bytes;
+            stats.realloc_time += chunk->reallocs.time;
+        }
 
-        nsPool_add(obj.mesh.tris, &tri);
+        stats.pool_memory += nsPool_total_memory_used(chunk->vertices);
+        stats.pool_memory += nsPool_total_memory_used(chunk->normals);
+        stats.pool_memory += nsPool_total_memory_used(chunk->uvs);
+        if (chunk->faces) stats.pool_memory += nsPool_total_memory_used(chunk->faces);
     }
 
-    nsPool_free(obj.vertices);
-    nsPool_free(obj.normals);
-    nsPool_free(obj.uvs);
-    nsPool_free(obj.faces);
+    nsPrecisionTimer timer;
+    nsPrecisionTimer_start(&timer);
+
+    if (valid_n == 1) {
+        OBJMeshBuilder_finish(&builder, false);
+    }
+    else if (resolve_faces(&obj.mesh, chunks, valid_n)) {
+        obj.mesh.vertices = NULL;
+        obj.mesh.indices = NULL;
+    }
+
+    stats.build_time = nsPrecisionTimer_stop(&timer);
+
+    for (ns_u32 i = 0; i < valid_n; i++) OBJChunk_free(&chunks[i]);
+
+    // Merging and building use pools too
+    nsPoolReallocStats local_reallocs = reallocs_since(reallocs);
+    stats.realloc_count += local_reallocs.count;
+    stats.realloc_bytes += local_reallocs.bytes;
+    stats.realloc_time += local_reallocs.time;
+
+    if (options.stats) *options.stats = stats;
 
     return obj;
 }
 
 nsOBJ nsOBJ_load(const char *filepath) {
+    return nsOBJ_load_ex(filepath, nsOBJLoadOptions_default);
+}
+
+nsOBJ nsOBJ_load_ex(const char *filepath, nsOBJLoadOptions options) {
+    NS_PROFILE_ZONE_BEGIN("nsOBJ_load");
+
+    /*
+        Not on the scratch arena, a block the size of the file would stay
+        allocated on threads that never trim it.
+    */
     char *content = ns_read_file_raw(filepath);
     if (!content) {
+        NS_PROFILE_ZONE_END();
         return (nsOBJ){0};
     }
 
-    nsOBJ obj = nsOBJ_load_raw(content);
+    nsOBJ obj = nsOBJ_load_raw_ex(content, strlen(content), options);
 
     NS_FREE(content);
+
+    NS_PROFILE_ZONE_END();
     
     return obj;
+}
+
+static int reserve_pool(nsPool *pool, size_t n) {
+    size_t needed = pool->size + n;
+    if (needed <= pool->max) return 0;
+
+    size_t grown = (size_t)((float)pool->max * pool->growth_factor);
+    return nsPool_reserve(pool, needed > grown ? needed : grown);
+}
+
+nsOBJ nsOBJ_load_stream(const char *filepath, size_t buffer_size) {
+    nsOBJ obj = {0};
+
+    if (buffer_size == 0) buffer_size = NS_OBJ_STREAM_BUFFER_SIZE;
+
+    FILE *file = fopen(filepath, "rb");
+    if (!file) {
+        ns_throw_error("Failed to open file.", 0, nsErrorSeverity_ERROR);
+        return obj;
+    }
+
+    nsArena *scratch = ns_get_scratch_arena();
+    nsArenaMark mark = nsArena_mark(scratch);
+
+    // One extra byte so the parser can always peek past the last character
+    char *buffer = nsArena_alloc(scratch, buffer_size + 1);
+    if (!buffer) {
+        fclose(file);
+        return obj;
+    }
+
+    /*
+        Faces are resolved into the output as each window is parsed and never
+        stored. Only attributes are kept, a face can refer to any before it.
+    */
+    OBJMeshBuilder builder = {.mesh = &obj.mesh};
+
+    OBJChunk chunk;
+    OBJChunk_init(&chunk, buffer, buffer, false, &builder);
+    if (
+        OBJChunk_alloc(&chunk, (OBJCounts){1, 1, 1, 1}) ||
+        OBJMeshBuilder_init(&builder, 1, 3)
+    ) {
+        OBJChunk_free(&chunk);
+        nsArena_rewind(scratch, mark);
+        fclose(file);
+        return obj;
+    }
+
+    size_t filled = 0;
+    ns_bool eof = false;
+    ns_bool failed = false;
+
+    while (!eof) {
+        size_t wanted = buffer_size - filled;
+        size_t read = fread(buffer + filled, 1, wanted, file);
+        filled += read;
+
+        if (read < wanted) {
+            if (ferror(file)) {
+                ns_throw_error("Failed to read file.", 0, nsErrorSeverity_ERROR);
+                failed = true;
+                break;
+            }
+            eof = feof(file);
+        }
+
+        buffer[filled] = '\0';
+
+        // Only parse complete lines, the tail is kept for the next refill
+        size_t parse_n = filled;
+        if (!eof) {
+            while (parse_n > 0 && buffer[parse_n - 1] != '\n') parse_n--;
+
+            // Line doesn't fit in the buffer
+            if (parse_n == 0) {
+                char *new_buffer = nsArena_alloc(scratch, buffer_size * 2 + 1);
+                if (!new_buffer) {
+                    failed = true;
+                    break;
+                }
+                memcpy(new_buffer, buffer, filled);
+                buffer = new_buffer;
+                buffer_size *= 2;
+                continue;
+            }
+        }
+
+        chunk.current = buffer;
+        chunk.end = buffer + parse_n;
+
+        // Reserve room for the records of this window, still growing geometrically
+        OBJCounts counts = {0, 0, 0, 0};
+        prescan(chunk.current, chunk.end, &counts);
+        if (
+            reserve_pool(chunk.vertices, counts.vertices) ||
+            reserve_pool(chunk.normals, counts.normals) ||
+            reserve_pool(chunk.uvs, counts.uvs) ||
+            reserve_pool(obj.mesh.vertices, counts.vertices) ||
+            reserve_pool(obj.mesh.indices, counts.faces * 3)
+        ) {
+            failed = true;
+            break;
+        }
+
+        parse_obj(&chunk);
+        if (chunk.failed) {
+            failed = true;
+            break;
+        }
+
+        filled -= parse_n;
+        memmove(buffer, buffer + parse_n, filled);
+    }
+
+    OBJMeshBuilder_finish(&builder, failed);
+    OBJChunk_free(&chunk);
+
+    nsArena_rewind(scratch, mark);
+    fclose(file);
+
+    return obj;
+}
+
+void nsOBJ_free(nsOBJ *obj) {
+    nsPool_free(obj->mesh.vertices);
+    nsPool_free(obj->mesh.indices);
+    nsPool_free(obj->mesh.meshlets);
+
+    obj->mesh.vertices = NULL;
+    obj->mesh.indices = NULL;
+    obj->mesh.lod_count = 0;
+    obj->mesh.meshlets = NULL;
 }
\ No newline at end of file
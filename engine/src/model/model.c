@@ -9,15 +9,21 @@
 */
 
 #include "engine/include/model/model.h"
+#include "engine/include/core/object_pool.h"
+
+
+static nsObjectPool model_pool = NS_OBJECT_POOL_INIT(nsModel, 256, nsMemoryTag_GENERAL);
 
 
 nsModel *nsModel_new(nsMesh *mesh) {
-    nsModel *model = NS_NEW(nsModel);
+    nsModel *model = nsObjectPool_alloc(&model_pool);
     NS_MEM_CHECK(model);
 
     model->mesh = mesh;
     model->xform = nsTransform_zero;
     model->xform_mat = nsMatrix4_identity;
+    model->lod = 0;
+    model->lod_threshold = NS_LOD_DEFAULT_THRESHOLD;
 
     return model;
 }
@@ -27,7 +33,7 @@ void nsModel_free(nsModel *model) {
 
     nsMesh_free(model->mesh);
 
-    NS_FREE(model);
+    nsObjectPool_release(&model_pool, model);
 }
 
 void nsModel_set_position(nsModel *model, nsVector3 position) {
@@ -59,6 +65,59 @@ nsVector3 nsModel_get_scale(nsModel *model) {
 }
 
 void nsModel_render(nsModel *model) {
-    nsMaterial_set_uniform_matrix4(model->mesh->material, "u_model", model->xform_mat);
+    nsMaterial *material = model->mesh->material;
+    nsMaterial_set_matrix4(material, material->model_uniform, model->xform_mat);
     nsMesh_render(model->mesh);
+}
+
+void nsModel_render_ex(nsModel *model, const nsCamera *camera) {
+    nsMesh *mesh = model->mesh;
+
+    nsCullContext context;
+    nsCullContext_from_camera(&context, camera, model->xform_mat);
+
+    // Meshes without bounds can't be culled as a whole
+    if (
+        mesh->bounds_radius > 0.0f &&
+        !nsCullContext_test_sphere(&context, mesh->bounds_center, mesh->bounds_radius)
+    ) {
+        mesh->drawn_meshlets = 0;
+        return;
+    }
+
+    const float *m = model->xform_mat.m;
+    nsVector3 c = mesh->bounds_center;
+
+    // Bounding sphere in world space
+    nsVector3 center = NS_VECTOR3(
+        m[0] * c.x + m[4] * c.y + m[8] * c.z + m[12],
+        m[1] * c.x + m[5] * c.y + m[9] * c.z + m[13],
+        m[2] * c.x + m[6] * c.y + m[10] * c.z + m[14]
+    );
+
+    nsVector3 scale = model->xform.scale;
+    float max_scale = ns_fabs(scale.x);
+    if (ns_fabs(scale.y) > max_scale) max_scale = ns_fabs(scale.y);
+    if (ns_fabs(scale.z) > max_scale) max_scale = ns_fabs(scale.z);
+
+    float distance = nsVector3_len(nsVector3_sub(center, camera->position)) - mesh->bounds_radius * max_scale;
+
+    // Orthographic projections don't shrink with distance
+    if (camera->projection == nsCameraProjection_PERSPECTIVE) {
+        model->lod = ns_select_lod(
+            mesh->lods,
+            mesh->lod_count,
+            model->lod,
+            max_scale,
+            distance,
+            camera->projection_mat.m[5],
+            model->lod_threshold
+        );
+    }
+    else {
+        model->lod = 0;
+    }
+
+    nsMaterial_set_matrix4(mesh->material, mesh->material->model_uniform, model->xform_mat);
+    nsMesh_render_culled(mesh, model->lod, &context);
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include <SDL.h>
 #include <SDL_opengl.h>
 
+NK_API void                 nk_sdl_set_allocator(const struct nk_allocator *allocator);
 NK_API struct nk_context*   nk_sdl_init(SDL_Window *win);
 NK_API void                 nk_sdl_font_stash_begin(struct nk_font_atlas **atlas);
 NK_API void                 nk_sdl_font_stash_end(void);
@@ -66,6 +67,7 @@ static struct nk_sdl {
     struct nk_sdl_device ogl;
     struct nk_context ctx;
     struct nk_font_atlas atlas;
+    struct nk_allocator alloc;
 } sdl;
 
 #ifdef __APPLE__
@@ -102,7 +104,8 @@ nk_sdl_device_create(void)
         "}\n";
 
     struct nk_sdl_device *dev = &sdl.ogl;
-    nk_buffer_init_default(&dev->cmds);
+    if (sdl.alloc.alloc) nk_buffer_init(&dev->cmds, &sdl.alloc, NK_BUFFER_DEFAULT_INITIAL_SIZE);
+    else nk_buffer_init_default(&dev->cmds);
     dev->prog = glCreateProgram();
     dev->vert_shdr = glCreateShader(GL_VERTEX_SHADER);
     dev->frag_shdr = glCreateShader(GL_FRAGMENT_SHADER);
@@ -310,11 +313,19 @@ nk_sdl_clipboard_copy(nk_handle usr, const char *text, int len)
     free(str);
 }
 
+NK_API void
+nk_sdl_set_allocator(const struct nk_allocator *allocator)
+{
+    /* has to be called before nk_sdl_init, memory is taken from it until shutdown */
+    sdl.alloc = *allocator;
+}
+
 NK_API struct nk_context*
 nk_sdl_init(SDL_Window *win)
 {
     sdl.win = win;
-    nk_init_default(&sdl.ctx, 0);
+    if (sdl.alloc.alloc) nk_init(&sdl.ctx, &sdl.alloc, 0);
+    else nk_init_default(&sdl.ctx, 0);
     sdl.ctx.clip.copy = nk_sdl_clipboard_copy;
     sdl.ctx.clip.paste = nk_sdl_clipboard_paste;
     sdl.ctx.clip.userdata = nk_handle_ptr(0);
@@ -325,7 +336,8 @@ nk_sdl_init(SDL_Window *win)
 NK_API void
 nk_sdl_font_stash_begin(struct nk_font_atlas **atlas)
 {
-    nk_font_atlas_init_default(&sdl.atlas);
+    if (sdl.alloc.alloc) nk_font_atlas_init(&sdl.atlas, &sdl.alloc);
+    else nk_font_atlas_init_default(&sdl.atlas);
     nk_font_atlas_begin(&sdl.atlas);
     *atlas = &sdl.atlas;
 }
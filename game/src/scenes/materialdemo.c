@@ -19,47 +19,77 @@ static struct nk_colorf dirlight_color;
 static float specular = 1.0;
 static int colored_specular = 1;
 
+static nsAsset *material_asset;
+static nsAsset *mesh_asset;
 static nsMaterial *material;
 static nsModel *model;
 static nsCamera *camera;
 
+// Uniforms set every frame, resolved once the material is loaded
+static nsUniformHandle view_uniform;
+static nsUniformHandle view_pos_uniform;
+static nsUniformHandle diffuse_uniform;
+static nsUniformHandle specular_uniform;
+static nsUniformHandle emissive_uniform;
+static nsUniformHandle shininess_uniform;
+static nsUniformHandle dirlight_color_uniform;
+
+
+static void resolve_uniforms(void) {
+    view_uniform = nsMaterial_get_uniform_handle(material, "u_view");
+    view_pos_uniform = nsMaterial_get_uniform_handle(material, "u_view_pos");
+    diffuse_uniform = nsMaterial_get_uniform_handle(material, "material.diffuse");
+    specular_uniform = nsMaterial_get_uniform_handle(material, "material.specular");
+    emissive_uniform = nsMaterial_get_uniform_handle(material, "material.emissive");
+    shininess_uniform = nsMaterial_get_uniform_handle(material, "material.shininess");
+    dirlight_color_uniform = nsMaterial_get_uniform_handle(material, "directional_light.color");
+}
+
+static void reset_material(void) {
+    nsMaterial_set_uniform_matrix4(material, "u_projection", camera->projection_mat);
+    nsMaterial_set_uniform_vector3(material, "directional_light.direction", NS_VECTOR3(-3.5f, -3.0f, 1.0f));
+    nsMaterial_set_uniform_vector3(material, "directional_light.color", NS_VECTOR3(1.0f, 1.0f, 1.0f));
+    nsMaterial_set_uniform_float(material, "directional_light.ambient_intensity", 0.1f);
+    nsMaterial_set_uniform_int(material, "point_lights_count", 0);
+    nsMaterial_set_uniform_float(material, "material.shininess", 5.95f);
+}
 
 static void on_ready(nsScene *scene) {
-    material  = nsMaterial_from_files(
+    // Model is loaded in the background and shows up once it's uploaded
+    nsAsyncLoader *loader = ns_global_app->loader;
+    material_asset = nsAsyncLoader_load_material(
+        loader,
         "../game/src/shaders/base.vsh",
         "../game/src/shaders/phong.fsh"
     );
-
-    nsOBJ obj = nsOBJ_load("../game/assets/models/shaderball.obj");
-    model = nsModel_new(nsMesh_from_obj(material, &obj));
-    nsModel_set_position(model, NS_VECTOR3(0.0f, -6.0f, 0.0f));
+    if (material_asset) {
+        mesh_asset = nsAsyncLoader_load_mesh(loader, material_asset, "../game/assets/models/shaderball.obj");
+    }
 
     diffuse_map = nsTexture_new();
     specular_map = nsTexture_new();
 
     float aspect = (float)ns_global_app->app_def.window_width / (float)ns_global_app->app_def.window_height;
     camera = nsCamera_new(nsCameraProjection_PERSPECTIVE, aspect);
-    nsMaterial_set_uniform_matrix4(material, "u_projection", camera->projection_mat);
 }
 
 static void on_free(nsScene *scene) {
-    nsModel_free(model);
+    // A loaded mesh owns the material, the model owns the mesh
+    if (model) nsModel_free(model);
+    else if (mesh_asset && nsAsset_is_ready(mesh_asset)) nsMesh_free(mesh_asset->mesh);
+    else if (material_asset) nsMaterial_free(material_asset->material);
+
     nsTexture_free(diffuse_map);
     nsTexture_free(specular_map);
     nsCamera_free(camera);
 }
 
 static void on_reset(nsScene *scene) {
-    nsMaterial_set_uniform_vector3(material, "directional_light.direction", NS_VECTOR3(-3.5f, -3.0f, 1.0f));
-    nsMaterial_set_uniform_vector3(material, "directional_light.color", NS_VECTOR3(1.0f, 1.0f, 1.0f));
-    nsMaterial_set_uniform_float(material, "directional_light.ambient_intensity", 0.1f);
-    nsMaterial_set_uniform_int(material, "point_lights_count", 0);
-    nsMaterial_set_uniform_float(material, "material.shininess", 32.0);
+    if (material) reset_material();
 
     dirlight_color = (struct nk_colorf){1.0f, 1.0f, 1.0f, 1.0f};
     diffuse_color = (struct nk_colorf){1.0f, 1.0f, 1.0f, 1.0f};
     specular_color = (struct nk_colorf){0.05f, 0.05f, 0.05f, 1.0f};
-    nsMaterial_set_uniform_float(material, "material.shininess", 5.95f);
 
     nsTexture_fill(specular_map, NS_RGB(diffuse_color.r, diffuse_color.g, diffuse_color.b));
     nsTexture_fill(specular_map, NS_RGB(specular_color.r, specular_color.g, specular_color.b));
@@ -71,6 +101,25 @@ static void on_reset(nsScene *scene) {
 static void on_render(nsScene *scene) {
     struct nk_context *ui_ctx = ns_global_app->ui_ctx;
 
+    if (!model) {
+        if (!mesh_asset || !nsAsset_is_ready(mesh_asset)) {
+            ns_bool failed = !mesh_asset || nsAsset_get_state(mesh_asset) == nsAssetState_FAILED;
+
+            if (nk_begin(ui_ctx, "Loading", nk_rect(0.0f, 0.0f, 200.0f, 60.0f), NK_WINDOW_TITLE)) {
+                nk_layout_row_dynamic(ui_ctx, 18, 1);
+                nk_label(ui_ctx, failed ? "Failed to load model." : "Loading model...", NK_TEXT_LEFT);
+            }
+            nk_end(ui_ctx);
+            return;
+        }
+
+        model = nsModel_new(mesh_asset->mesh);
+        nsModel_set_position(model, NS_VECTOR3(0.0f, -6.0f, 0.0f));
+        material = mesh_asset->mesh->material;
+        resolve_uniforms();
+        reset_material();
+    }
+
     // UI
     {
         if (nk_begin(ui_ctx, "Material Editor", nk_rect(0.0f, 0.0f, 300.0f, 430.0f), NK_WINDOW_TITLE | NK_WINDOW_MOVABLE)) {
@@ -123,13 +172,13 @@ static void on_render(nsScene *scene) {
 
                     nk_label(ui_ctx, "Shininess", NK_TEXT_LEFT);
 
-                    float value = nsMaterial_get_uniform_float(material, "material.shininess");
+                    float value = nsMaterial_get_float(material, shininess_uniform);
                     nk_slider_float(ui_ctx, 1.0f, &value, 100.0f, 0.05f);
                     
                     sprintf(display_buf, "%3.2f", value);
                     nk_label(ui_ctx, display_buf, NK_TEXT_LEFT);
 
-                    nsMaterial_set_uniform_float(material, "material.shininess", value);
+                    nsMaterial_set_float(material, shininess_uniform, value);
                 }
 
                 nk_layout_row_dynamic(ui_ctx, 18, 1);
@@ -138,25 +187,25 @@ static void on_render(nsScene *scene) {
                     colored_specular = 1;
                     diffuse_color = (struct nk_colorf){1.0f, 1.0f, 1.0f, 1.0f};
                     specular_color = (struct nk_colorf){0.05f, 0.05f, 0.05f, 1.0f};
-                    nsMaterial_set_uniform_float(material, "material.shininess", 5.95f);
+                    nsMaterial_set_float(material, shininess_uniform, 5.95f);
                 }
                 if (nk_button_label(ui_ctx, "Gold")) {
                     colored_specular = 1;
                     diffuse_color = (struct nk_colorf){0.960f, 0.847f, 0.113f, 1.0f};
                     specular_color = (struct nk_colorf){1.0f, 0.780f, 0.490f, 1.0f};
-                    nsMaterial_set_uniform_float(material, "material.shininess", 60.0f);
+                    nsMaterial_set_float(material, shininess_uniform, 60.0f);
                 }
                 if (nk_button_label(ui_ctx, "Chrome")) {
                     colored_specular = 1;
                     diffuse_color = (struct nk_colorf){0.35f, 0.35f, 0.35f, 1.0f};
                     specular_color = (struct nk_colorf){0.517f, 0.560f, 0.7f, 1.0f};
-                    nsMaterial_set_uniform_float(material, "material.shininess", 12.8f);
+                    nsMaterial_set_float(material, shininess_uniform, 12.8f);
                 }
                 if (nk_button_label(ui_ctx, "Ruby")) {
                     colored_specular = 1;
                     diffuse_color = (struct nk_colorf){0.61424f, 0.04136f, 0.04136f, 1.0f};
                     specular_color = (struct nk_colorf){0.727811f, 0.626959f, 0.626959f, 1.0f};
-                    nsMaterial_set_uniform_float(material, "material.shininess", 85.0f);
+                    nsMaterial_set_float(material, shininess_uniform, 85.0f);
                 }
 
                 nk_layout_row_dynamic(ui_ctx, 8, 1);
@@ -172,7 +221,7 @@ static void on_render(nsScene *scene) {
 
                     dirlight_color = nk_color_picker(ui_ctx, dirlight_color, NK_RGB);
                     
-                    nsMaterial_set_uniform_vector3(material, "directional_light.color", NS_VECTOR3(dirlight_color.r, dirlight_color.g, dirlight_color.b));
+                    nsMaterial_set_vector3(material, dirlight_color_uniform, NS_VECTOR3(dirlight_color.r, dirlight_color.g, dirlight_color.b));
 
                     sprintf(display_buf, "%1.1f,%1.1f,%1.1f", dirlight_color.r, dirlight_color.g, dirlight_color.b);
                     nk_label(ui_ctx, display_buf, NK_TEXT_LEFT);
@@ -188,21 +237,21 @@ static void on_render(nsScene *scene) {
 
 
     nsCamera_update(camera);
-    nsMaterial_set_uniform_matrix4(material, "u_view", camera->view_mat);
-    nsMaterial_set_uniform_vector3(material, "u_view_pos", camera->position);
+    nsMaterial_set_matrix4(material, view_uniform, camera->view_mat);
+    nsMaterial_set_vector3(material, view_pos_uniform, camera->position);
 
 
-    nsMaterial_set_uniform_int(material, "material.diffuse", 0);
+    nsMaterial_set_int(material, diffuse_uniform, 0);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, diffuse_map->texture_id);
 
-    nsMaterial_set_uniform_int(material, "material.specular", 1);
+    nsMaterial_set_int(material, specular_uniform, 1);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, specular_map->texture_id);
 
-    nsMaterial_set_uniform_vector3(material, "material.emissive", NS_VECTOR3(0.0f, 0.0f, 0.0f));
+    nsMaterial_set_vector3(material, emissive_uniform, NS_VECTOR3(0.0f, 0.0f, 0.0f));
     
-    nsModel_render(model);
+    nsModel_render_ex(model, camera);
 }
 
 
@@ -0,0 +1,1033 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/*
+    nsbench - Micro benchmarks for engine internals.
+
+    Usage:
+        nsbench <benchmark> [args...]
+
+    Benchmarks:
+        numparse <file.obj>    ns_parse_float vs strtof on the numbers of an OBJ file
+        objload <file.obj>     OBJ loading with and without pool prescan
+        slotmap [count]        Slot map spawn/kill churn and iteration
+        memory <file.obj>      Memory use per subsystem while baking a mesh
+        objpool [count]        Model allocation, update and churn with malloc vs object pool
+        hashmap [count]        Name lookup with linear strcmp scan vs hash map vs string IDs
+        jobs [workers]         Entity update on one thread vs parallel for, and job overhead
+        queue [count]          Cross-thread message throughput with mutex vs lock-free queues
+        timer                  Timestamp cost of ticks vs system clocks, and long interval accuracy
+*/
+
+#include "engine/include/engine.h"
+
+
+typedef int (*BenchmarkFunc)(int argc, char **argv);
+
+typedef struct {
+    const char *name;
+    const char *usage;
+    BenchmarkFunc func;
+} Benchmark;
+
+
+/*
+    numparse
+*/
+
+static int bench_numparse(int argc, char **argv) {
+    if (argc < 1) return 1;
+
+    char *content = ns_read_file_raw(argv[0]);
+    if (!content) return 1;
+
+    // Collect the start of every number on v, vn and vt lines
+    nsPool *tokens = nsPool_new(sizeof(const char *));
+    size_t total_bytes = 0;
+
+    const char *p = content;
+    while (*p) {
+        const char *line_end = strchr(p, '\n');
+        if (!line_end) line_end = p + strlen(p);
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == 'n' || p[1] == 't')) {
+            const char *q = p + (p[1] == ' ' ? 1 : 2);
+            while (q < line_end) {
+                while (q < line_end && (*q == ' ' || *q == '\t')) q++;
+                if (q >= line_end || *q == '\r') break;
+
+                nsPool_add(tokens, &q);
+                const char *token_start = q;
+                while (q < line_end && *q != ' ' && *q != '\t' && *q != '\r') q++;
+                total_bytes += q - token_start;
+            }
+        }
+
+        p = *line_end ? line_end + 1 : line_end;
+    }
+
+    const char **starts = (const char **)tokens->data;
+    size_t n = tokens->size;
+    const char *content_end = content + strlen(content);
+
+    if (n == 0) {
+        printf("No numbers found.\n");
+        nsPool_free(tokens);
+        NS_FREE(content);
+        return 0;
+    }
+
+    nsPrecisionTimer timer;
+    volatile float sink = 0.0f;
+    const int rounds = 5;
+    double strtof_best = 1e30;
+    double ns_best = 1e30;
+
+    for (int r = 0; r < rounds; r++) {
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < n; i++) {
+            sink += strtof(starts[i], NULL);
+        }
+        double elapsed = nsPrecisionTimer_stop(&timer);
+        if (elapsed < strtof_best) strtof_best = elapsed;
+
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < n; i++) {
+            float value;
+            ns_parse_float(starts[i], content_end, &value);
+            sink += value;
+        }
+        elapsed = nsPrecisionTimer_stop(&timer);
+        if (elapsed < ns_best) ns_best = elapsed;
+    }
+
+    // Results have to be bit-exact
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; i++) {
+        float a = strtof(starts[i], NULL);
+        float b;
+        ns_parse_float(starts[i], content_end, &b);
+        if (memcmp(&a, &b, sizeof(float)) != 0) mismatches++;
+    }
+
+    double mb = (double)total_bytes / (1024.0 * 1024.0);
+    printf(
+        "numbers: %zu (%.2f MB)\n"
+        "strtof:         %8.3f ms  %6.2f ns/number  %8.2f MB/s\n"
+        "ns_parse_float: %8.3f ms  %6.2f ns/number  %8.2f MB/s\n"
+        "speedup: %.2fx\n"
+        "mismatches: %zu\n",
+        n, mb,
+        strtof_best * 1000.0, strtof_best * 1e9 / (double)n, mb / strtof_best,
+        ns_best * 1000.0, ns_best * 1e9 / (double)n, mb / ns_best,
+        strtof_best / ns_best,
+        mismatches
+    );
+
+    nsPool_free(tokens);
+    NS_FREE(content);
+
+    return mismatches != 0;
+}
+
+
+/*
+    objload
+*/
+
+static int bench_objload(int argc, char **argv) {
+    if (argc < 1) return 1;
+
+    char *content = ns_read_file_raw(argv[0]);
+    if (!content) return 1;
+    size_t length = strlen(content);
+
+    printf(
+        "%-8s %12s %12s %12s %10s %12s %12s %12s\n",
+        "prescan", "prescan ms", "parse ms", "build ms",
+        "reallocs", "realloc MB", "realloc ms", "pool MB"
+    );
+
+    for (int prescan = 0; prescan < 2; prescan++) {
+        nsOBJLoadStats stats;
+        nsOBJLoadOptions options = nsOBJLoadOptions_default;
+        options.prescan = prescan;
+        options.stats = &stats;
+
+        nsOBJ obj = nsOBJ_load_raw_ex(content, length, options);
+        if (!obj.mesh.vertices) {
+            NS_FREE(content);
+            return 1;
+        }
+        nsOBJ_free(&obj);
+
+        printf(
+            "%-8s %12.3f %12.3f %12.3f %10zu %12.2f %12.3f %12.2f\n",
+            prescan ? "on" : "off",
+            stats.prescan_time * 1000.0,
+            stats.parse_time * 1000.0,
+            stats.build_time * 1000.0,
+            stats.realloc_count,
+            (double)stats.realloc_bytes / (1024.0 * 1024.0),
+            stats.realloc_time * 1000.0,
+            (double)stats.pool_memory / (1024.0 * 1024.0)
+        );
+    }
+
+    NS_FREE(content);
+
+    return 0;
+}
+
+
+/*
+    slotmap
+*/
+
+typedef struct {
+    nsVector3 position;
+    nsVector3 velocity;
+    float lifetime;
+} BenchEntity;
+
+static int bench_slotmap(int argc, char **argv) {
+    size_t count = argc > 0 ? (size_t)strtoul(argv[0], NULL, 10) : 100000;
+    if (count == 0 || count >= NS_SLOTMAP_MAX_SLOTS) return 1;
+
+    const int frames = 600;
+    const size_t churn = count / 10; // 10% of the entities die and respawn every frame
+
+    nsSlotMap *entities = nsSlotMap_new(sizeof(BenchEntity));
+    nsHandle *handles = NS_MALLOC(sizeof(nsHandle) * count);
+    nsHandle *killed = NS_MALLOC(sizeof(nsHandle) * churn);
+    if (!entities || !handles || !killed) {
+        nsSlotMap_free(entities);
+        NS_FREE(handles);
+        NS_FREE(killed);
+        return 1;
+    }
+
+    BenchEntity entity = {
+        .position = {0.0f, 0.0f, 0.0f},
+        .velocity = {1.0f, 0.5f, 0.25f},
+        .lifetime = 1.0f
+    };
+    for (size_t i = 0; i < count; i++) handles[i] = nsSlotMap_add(entities, &entity);
+
+    nsPrecisionTimer timer;
+    double churn_time = 0.0;
+    double iterate_time = 0.0;
+    double lookup_time = 0.0;
+    size_t stale_hits = 0;
+    ns_u32 seed = 12345;
+
+    for (int frame = 0; frame < frames; frame++) {
+        // Kill random entities and spawn new ones in their place
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < churn; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            size_t victim = (seed >> 8) % count;
+
+            killed[i] = handles[victim];
+            nsSlotMap_remove(entities, handles[victim]);
+            handles[victim] = nsSlotMap_add(entities, &entity);
+        }
+        churn_time += nsPrecisionTimer_stop(&timer);
+
+        // Dense update of every live entity
+        nsPrecisionTimer_start(&timer);
+        BenchEntity *values = (BenchEntity *)entities->values->data;
+        size_t n = nsSlotMap_size(entities);
+        for (size_t i = 0; i < n; i++) {
+            values[i].position = nsVector3_add(values[i].position, nsVector3_mul(values[i].velocity, 0.016f));
+            values[i].lifetime -= 0.016f;
+        }
+        iterate_time += nsPrecisionTimer_stop(&timer);
+
+        // Handle lookups, like systems following references to other entities
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < count; i += 4) {
+            BenchEntity *target = nsSlotMap_get(entities, handles[i]);
+            if (target) target->lifetime += 0.001f;
+        }
+        lookup_time += nsPrecisionTimer_stop(&timer);
+
+        // Handles of killed entities have to be stale
+        for (size_t i = 0; i < churn; i++) {
+            if (nsSlotMap_get(entities, killed[i])) stale_hits++;
+        }
+    }
+
+    double churn_ops = (double)churn * frames * 2.0;
+    double lookups = (double)((count + 3) / 4) * frames;
+    printf(
+        "entities: %zu, churn: %zu/frame, frames: %d\n"
+        "add+remove: %8.3f ms  %6.2f ns/op  %8.2f M ops/s\n"
+        "iterate:    %8.3f ms  %6.2f ns/entity\n"
+        "lookup:     %8.3f ms  %6.2f ns/lookup\n"
+        "slots: %zu, stale handle hits: %zu\n",
+        count, churn, frames,
+        churn_time * 1000.0, churn_time * 1e9 / churn_ops, churn_ops / churn_time / 1e6,
+        iterate_time * 1000.0, iterate_time * 1e9 / ((double)count * frames),
+        lookup_time * 1000.0, lookup_time * 1e9 / lookups,
+        entities->slots->size, stale_hits
+    );
+
+    nsSlotMap_free(entities);
+    NS_FREE(handles);
+    NS_FREE(killed);
+
+    return stale_hits != 0;
+}
+
+
+/*
+    memory
+*/
+
+static void print_memory_stats(const char *title) {
+    printf("%s\n", title);
+    printf(
+        "%-12s %12s %12s %10s %10s %10s\n",
+        "tag", "live MB", "peak MB", "allocs", "reallocs", "frees"
+    );
+
+    for (int tag = 0; tag < nsMemoryTag_COUNT; tag++) {
+        nsMemoryStats stats = ns_get_memory_stats((nsMemoryTag)tag);
+        if (stats.alloc_count == 0) continue;
+
+        printf(
+            "%-12s %12.2f %12.2f %10zu %10zu %10zu\n",
+            nsMemoryTag_as_string((nsMemoryTag)tag),
+            (double)stats.live_bytes / (1024.0 * 1024.0),
+            (double)stats.peak_bytes / (1024.0 * 1024.0),
+            stats.alloc_count,
+            stats.realloc_count,
+            stats.free_count
+        );
+    }
+}
+
+static int bench_memory(int argc, char **argv) {
+    if (argc < 1) return 1;
+
+    nsOBJ obj = nsOBJ_load(argv[0]);
+    if (!obj.mesh.vertices) return 1;
+
+    nsOBJMesh_generate_lods(&obj.mesh, NS_MESH_MAX_LODS);
+    nsOBJMesh_optimize(&obj.mesh, NULL);
+    nsOBJMesh_build_meshlets(&obj.mesh);
+
+    print_memory_stats("After baking:");
+
+    nsOBJ_free(&obj);
+    ns_free_scratch_arena();
+
+    printf("\n");
+    print_memory_stats("After freeing:");
+
+    return 0;
+}
+
+
+/*
+    objpool
+*/
+
+typedef struct {
+    nsModel **models;
+    void **noise;
+    double alloc_time;
+    double iterate_time;
+    double churn_time;
+} ObjPoolRun;
+
+static void *objpool_alloc(nsObjectPool *pool) {
+    return pool ? nsObjectPool_alloc(pool) : NS_NEW(nsModel);
+}
+
+static void objpool_release(nsObjectPool *pool, nsModel *model) {
+    if (pool) nsObjectPool_release(pool, model);
+    else NS_FREE(model);
+}
+
+/**
+ * @brief Allocate models interleaved with other allocations, then churn and update them.
+ */
+static void objpool_run(ObjPoolRun *run, nsObjectPool *pool, size_t count, int frames) {
+    nsPrecisionTimer timer;
+    ns_u32 seed = 12345;
+
+    // Other allocations in between scatter heap allocated models, like loading does
+    nsPrecisionTimer_start(&timer);
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        run->noise[i] = NS_MALLOC(16 + (seed >> 8) % 240);
+
+        nsModel *model = objpool_alloc(pool);
+        model->mesh = NULL;
+        model->xform = nsTransform_zero;
+        model->xform_mat = nsMatrix4_identity;
+        model->lod = 0;
+        model->lod_threshold = NS_LOD_DEFAULT_THRESHOLD;
+        run->models[i] = model;
+    }
+    run->alloc_time = nsPrecisionTimer_stop(&timer);
+
+    run->iterate_time = 0.0;
+    run->churn_time = 0.0;
+
+    for (int frame = 0; frame < frames; frame++) {
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < count; i++) {
+            nsModel *model = run->models[i];
+            model->xform.position.x += 0.016f;
+            model->xform_mat.m[12] = model->xform.position.x;
+        }
+        run->iterate_time += nsPrecisionTimer_stop(&timer);
+
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < count / 10; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            size_t victim = (seed >> 8) % count;
+
+            objpool_release(pool, run->models[victim]);
+            nsModel *model = objpool_alloc(pool);
+            model->xform = nsTransform_zero;
+            model->xform_mat = nsMatrix4_identity;
+            run->models[victim] = model;
+        }
+        run->churn_time += nsPrecisionTimer_stop(&timer);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        objpool_release(pool, run->models[i]);
+        NS_FREE(run->noise[i]);
+    }
+}
+
+static int bench_objpool(int argc, char **argv) {
+    size_t count = argc > 0 ? (size_t)strtoul(argv[0], NULL, 10) : 100000;
+    if (count == 0) return 1;
+
+    const int frames = 100;
+
+    ObjPoolRun run;
+    run.models = NS_MALLOC(sizeof(nsModel *) * count);
+    run.noise = NS_MALLOC(sizeof(void *) * count);
+    if (!run.models || !run.noise) {
+        NS_FREE(run.models);
+        NS_FREE(run.noise);
+        return 1;
+    }
+
+    printf("models: %zu, frames: %d, churn: %zu/frame\n", count, frames, count / 10);
+    printf("%-8s %12s %14s %14s\n", "", "alloc ms", "iterate ns/op", "churn ns/op");
+
+    const char *names[2] = {"malloc", "pool"};
+    nsObjectPool pool = NS_OBJECT_POOL_INIT(nsModel, 256, nsMemoryTag_GENERAL);
+
+    for (int i = 0; i < 2; i++) {
+        objpool_run(&run, i ? &pool : NULL, count, frames);
+
+        printf(
+            "%-8s %12.3f %14.2f %14.2f\n",
+            names[i],
+            run.alloc_time * 1000.0,
+            run.iterate_time * 1e9 / ((double)count * frames),
+            run.churn_time * 1e9 / ((double)(count / 10 > 0 ? count / 10 : 1) * frames)
+        );
+    }
+
+    nsObjectPool_free(&pool);
+    NS_FREE(run.models);
+    NS_FREE(run.noise);
+
+    return 0;
+}
+
+
+/*
+    hashmap
+*/
+
+// Keeps the generated names well inside their 32 byte buffers
+#define HASHMAP_MAX_NAMES 1000000
+
+typedef struct {
+    const char *name;
+    ns_i32 location;
+} BenchUniform;
+
+/**
+ * @brief Linear strcmp scan, like the uniform cache of materials.
+ */
+static BenchUniform *linear_find(BenchUniform *uniforms, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(uniforms[i].name, name) == 0) return &uniforms[i];
+    }
+    return NULL;
+}
+
+static void bench_hashmap_size(size_t count, size_t lookups) {
+    char (*names)[32] = NS_MALLOC(32 * count);
+    BenchUniform *uniforms = NS_MALLOC(sizeof(BenchUniform) * count);
+    nsStringId *name_ids = NS_MALLOC(sizeof(nsStringId) * count);
+    nsHashMap *by_name = nsHashMap_new(sizeof(const char *), sizeof(ns_i32), ns_hash_string_key, ns_equal_string_key);
+    nsHashMap *by_id = nsHashMap_new(sizeof(nsStringId), sizeof(ns_i32), NULL, NULL);
+
+    if (!names || !uniforms || !name_ids || !by_name || !by_id) {
+        NS_FREE(names);
+        NS_FREE(uniforms);
+        NS_FREE(name_ids);
+        nsHashMap_free(by_name);
+        nsHashMap_free(by_id);
+        return;
+    }
+
+    // Names share long prefixes like struct uniforms do
+    for (size_t i = 0; i < count; i++) {
+        snprintf(names[i], sizeof(names[i]), "point_lights[%zu].color", i);
+
+        ns_i32 location = (ns_i32)i;
+        const char *name = names[i];
+        uniforms[i] = (BenchUniform){.name = name, .location = location};
+        name_ids[i] = ns_intern_string(name);
+
+        nsHashMap_set(by_name, &name, &location);
+        nsHashMap_set(by_id, &name_ids[i], &location);
+    }
+
+    nsPrecisionTimer timer;
+    ns_u32 seed = 12345;
+    ns_i64 checksum[3] = {0, 0, 0};
+    double times[3];
+
+    // Callers pass their own string literals, not the stored pointers
+    char query[32];
+
+    nsPrecisionTimer_start(&timer);
+    for (size_t i = 0; i < lookups; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        memcpy(query, names[(seed >> 8) % count], 32);
+        checksum[0] += linear_find(uniforms, count, query)->location;
+    }
+    times[0] = nsPrecisionTimer_stop(&timer);
+
+    seed = 12345;
+    nsPrecisionTimer_start(&timer);
+    for (size_t i = 0; i < lookups; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        memcpy(query, names[(seed >> 8) % count], 32);
+        const char *key = query;
+        checksum[1] += *(ns_i32 *)nsHashMap_get(by_name, &key);
+    }
+    times[1] = nsPrecisionTimer_stop(&timer);
+
+    seed = 12345;
+    nsPrecisionTimer_start(&timer);
+    for (size_t i = 0; i < lookups; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        checksum[2] += *(ns_i32 *)nsHashMap_get(by_id, &name_ids[(seed >> 8) % count]);
+    }
+    times[2] = nsPrecisionTimer_stop(&timer);
+
+    printf(
+        "%8zu %14.2f %14.2f %14.2f %s\n",
+        count,
+        times[0] * 1e9 / (double)lookups,
+        times[1] * 1e9 / (double)lookups,
+        times[2] * 1e9 / (double)lookups,
+        checksum[0] == checksum[1] && checksum[1] == checksum[2] ? "" : "MISMATCH"
+    );
+
+    NS_FREE(names);
+    NS_FREE(uniforms);
+    NS_FREE(name_ids);
+    nsHashMap_free(by_name);
+    nsHashMap_free(by_id);
+}
+
+static int bench_hashmap(int argc, char **argv) {
+    const size_t lookups = 200000;
+
+    printf("lookups: %zu\n", lookups);
+    printf("%8s %14s %14s %14s\n", "names", "linear ns", "hashmap ns", "string id ns");
+
+    if (argc > 0) {
+        size_t count = (size_t)strtoul(argv[0], NULL, 10);
+        if (count == 0 || count > HASHMAP_MAX_NAMES) return 1;
+        bench_hashmap_size(count, lookups);
+    }
+    else {
+        const size_t counts[] = {4, 16, 64, 256, 1024};
+        for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+            bench_hashmap_size(counts[i], lookups);
+        }
+    }
+
+    ns_free_string_ids();
+
+    return 0;
+}
+
+
+/*
+    jobs
+*/
+
+static void jobs_update(size_t start, size_t end, void *data) {
+    BenchEntity *entities = data;
+
+    // Some math per entity so the update isn't bound by memory bandwidth alone
+    for (size_t i = start; i < end; i++) {
+        BenchEntity *entity = &entities[i];
+        float speed = nsVector3_len(entity->velocity);
+        float wobble = ns_sin(entity->lifetime * 3.0f) * 0.1f;
+
+        entity->velocity.y += wobble - speed * 0.001f;
+        entity->position = nsVector3_add(entity->position, nsVector3_mul(entity->velocity, 0.016f));
+        entity->lifetime -= 0.016f;
+    }
+}
+
+static void jobs_empty(void *data) {
+    (void)data;
+}
+
+static int bench_jobs(int argc, char **argv) {
+    ns_u32 worker_count = argc > 0 ? (ns_u32)strtoul(argv[0], NULL, 10) : 0;
+
+    const size_t count = 200000;
+    const int frames = 200;
+    const size_t empty_jobs = 1000;
+
+    nsJobSystem *jobs = nsJobSystem_new(worker_count);
+    BenchEntity *entities = NS_MALLOC(sizeof(BenchEntity) * count);
+    if (!jobs || !entities) {
+        nsJobSystem_free(jobs);
+        NS_FREE(entities);
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        entities[i] = (BenchEntity){
+            .position = {0.0f, 0.0f, 0.0f},
+            .velocity = {1.0f, 0.5f, 0.25f},
+            .lifetime = (float)(i % 100) * 0.01f
+        };
+    }
+
+    nsPrecisionTimer timer;
+    double serial_time = 0.0;
+    double parallel_time = 0.0;
+    double submit_time = 0.0;
+
+    for (int frame = 0; frame < frames; frame++) {
+        nsPrecisionTimer_start(&timer);
+        jobs_update(0, count, entities);
+        serial_time += nsPrecisionTimer_stop(&timer);
+
+        nsPrecisionTimer_start(&timer);
+        nsJobSystem_parallel_for(jobs, count, 0, jobs_update, entities);
+        parallel_time += nsPrecisionTimer_stop(&timer);
+
+        // Round trip of tiny jobs, the fixed cost a job has to amortize
+        nsJobCounter counter = {0};
+        nsPrecisionTimer_start(&timer);
+        for (size_t i = 0; i < empty_jobs; i++) {
+            nsJobSystem_run(jobs, jobs_empty, NULL, &counter);
+        }
+        nsJobSystem_wait(jobs, &counter);
+        submit_time += nsPrecisionTimer_stop(&timer);
+    }
+
+    printf(
+        "workers: %u, entities: %zu, frames: %d\n"
+        "serial:   %8.3f ms/frame\n"
+        "parallel: %8.3f ms/frame  %5.2fx\n"
+        "empty job submit+run: %6.2f ns/job\n",
+        jobs->worker_count, count, frames,
+        serial_time * 1000.0 / frames,
+        parallel_time * 1000.0 / frames, serial_time / parallel_time,
+        submit_time * 1e9 / ((double)empty_jobs * frames)
+    );
+
+    nsJobSystem_free(jobs);
+    NS_FREE(entities);
+
+    return 0;
+}
+
+
+/*
+    queue
+*/
+
+#define QUEUE_CAPACITY 1024
+#define QUEUE_MAX_THREADS 8
+
+typedef enum {
+    QueueKind_MUTEX_RING,
+    QueueKind_SPSC,
+    QueueKind_MPMC,
+    QueueKind_MUTEX_LIST,
+    QueueKind_STACK
+} QueueKind;
+
+typedef struct {
+    SDL_mutex *mutex;
+    ns_u64 data[QUEUE_CAPACITY];
+    size_t head;
+    size_t size;
+} MutexRing;
+
+typedef struct {
+    nsStackNode node;
+    ns_u64 value;
+} QueueMessage;
+
+typedef struct {
+    QueueKind kind;
+    size_t per_producer;
+    size_t total;
+
+    MutexRing ring;
+    nsSPSCQueue *spsc;
+    nsMPMCQueue *mpmc;
+    nsStackNode *list;
+    nsIntrusiveStack stack;
+    QueueMessage *messages;
+
+    nsAtomicI64 next_producer;
+    nsAtomicI64 consumed;
+    nsAtomicI64 checksum;
+} QueueBench;
+
+// Spin a little, then give the time slice away so oversubscribed runs still make progress
+static void queue_backoff(int *spins) {
+    if ((*spins)++ < 64) ns_cpu_relax();
+    else SDL_Delay(0);
+}
+
+static ns_bool queue_push(QueueBench *bench, size_t index) {
+    ns_u64 value = bench->messages[index].value;
+
+    switch (bench->kind) {
+        case QueueKind_MUTEX_RING: {
+            MutexRing *ring = &bench->ring;
+            ns_bool pushed = false;
+
+            SDL_LockMutex(ring->mutex);
+            if (ring->size < QUEUE_CAPACITY) {
+                ring->data[(ring->head + ring->size) % QUEUE_CAPACITY] = value;
+                ring->size++;
+                pushed = true;
+            }
+            SDL_UnlockMutex(ring->mutex);
+
+            return pushed;
+        }
+
+        case QueueKind_SPSC:
+            return nsSPSCQueue_push(bench->spsc, &value);
+
+        case QueueKind_MPMC:
+            return nsMPMCQueue_push(bench->mpmc, &value);
+
+        case QueueKind_MUTEX_LIST:
+            SDL_LockMutex(bench->ring.mutex);
+            bench->messages[index].node.next = bench->list;
+            bench->list = &bench->messages[index].node;
+            SDL_UnlockMutex(bench->ring.mutex);
+            return true;
+
+        case QueueKind_STACK:
+            nsIntrusiveStack_push(&bench->stack, &bench->messages[index].node);
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Pop messages and return how many, lists are taken all at once.
+ */
+static size_t queue_pop(QueueBench *bench, ns_u64 *checksum) {
+    ns_u64 value;
+
+    switch (bench->kind) {
+        case QueueKind_MUTEX_RING: {
+            MutexRing *ring = &bench->ring;
+            size_t popped = 0;
+
+            SDL_LockMutex(ring->mutex);
+            if (ring->size > 0) {
+                *checksum += ring->data[ring->head];
+                ring->head = (ring->head + 1) % QUEUE_CAPACITY;
+                ring->size--;
+                popped = 1;
+            }
+            SDL_UnlockMutex(ring->mutex);
+
+            return popped;
+        }
+
+        case QueueKind_SPSC:
+            if (!nsSPSCQueue_pop(bench->spsc, &value)) return 0;
+            *checksum += value;
+            return 1;
+
+        case QueueKind_MPMC:
+            if (!nsMPMCQueue_pop(bench->mpmc, &value)) return 0;
+            *checksum += value;
+            return 1;
+
+        case QueueKind_MUTEX_LIST:
+        case QueueKind_STACK: {
+            nsStackNode *node;
+
+            if (bench->kind == QueueKind_STACK) {
+                node = nsIntrusiveStack_pop_all(&bench->stack);
+            }
+            else {
+                SDL_LockMutex(bench->ring.mutex);
+                node = bench->list;
+                bench->list = NULL;
+                SDL_UnlockMutex(bench->ring.mutex);
+            }
+
+            size_t popped = 0;
+            for (; node; node = node->next) {
+                *checksum += NS_CONTAINER_OF(node, QueueMessage, node)->value;
+                popped++;
+            }
+
+            return popped;
+        }
+    }
+
+    return 0;
+}
+
+static int queue_producer(void *data) {
+    QueueBench *bench = data;
+
+    size_t producer = (size_t)ns_atomic_add_i64(&bench->next_producer, 1, NS_ATOMIC_RELAXED);
+    size_t start = producer * bench->per_producer;
+
+    for (size_t i = start; i < start + bench->per_producer; i++) {
+        int spins = 0;
+        while (!queue_push(bench, i)) queue_backoff(&spins);
+    }
+
+    return 0;
+}
+
+static int queue_consumer(void *data) {
+    QueueBench *bench = data;
+    ns_u64 checksum = 0;
+    int spins = 0;
+
+    while (ns_atomic_load_i64(&bench->consumed, NS_ATOMIC_RELAXED) < (ns_i64)bench->total) {
+        size_t popped = queue_pop(bench, &checksum);
+
+        if (popped) {
+            ns_atomic_add_i64(&bench->consumed, (ns_i64)popped, NS_ATOMIC_RELAXED);
+            spins = 0;
+        }
+        else {
+            queue_backoff(&spins);
+        }
+    }
+
+    ns_atomic_add_i64(&bench->checksum, (ns_i64)checksum, NS_ATOMIC_RELAXED);
+
+    return 0;
+}
+
+static void bench_queue_run(
+    const char *title,
+    QueueKind kind,
+    size_t producers,
+    size_t consumers,
+    size_t count,
+    QueueMessage *messages
+) {
+    QueueBench bench = {
+        .kind = kind,
+        .per_producer = count / producers,
+        .total = count / producers * producers,
+        .messages = messages
+    };
+
+    bench.ring.mutex = SDL_CreateMutex();
+    bench.spsc = nsSPSCQueue_new(sizeof(ns_u64), QUEUE_CAPACITY);
+    bench.mpmc = nsMPMCQueue_new(sizeof(ns_u64), QUEUE_CAPACITY);
+
+    SDL_Thread *threads[QUEUE_MAX_THREADS];
+    size_t thread_count = 0;
+
+    nsPrecisionTimer timer;
+    nsPrecisionTimer_start(&timer);
+
+    for (size_t i = 0; i < consumers; i++) {
+        threads[thread_count++] = SDL_CreateThread(queue_consumer, "nsbench consumer", &bench);
+    }
+    for (size_t i = 0; i < producers; i++) {
+        threads[thread_count++] = SDL_CreateThread(queue_producer, "nsbench producer", &bench);
+    }
+    for (size_t i = 0; i < thread_count; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    double elapsed = nsPrecisionTimer_stop(&timer);
+
+    ns_u64 expected = (ns_u64)bench.total * (bench.total - 1) / 2;
+    printf(
+        "%-12s %zuP%zuC  %8.3f ms  %7.2f M msgs/s %s\n",
+        title, producers, consumers,
+        elapsed * 1000.0, (double)bench.total / elapsed / 1e6,
+        (ns_u64)bench.checksum.value == expected ? "" : "MISMATCH"
+    );
+
+    SDL_DestroyMutex(bench.ring.mutex);
+    nsSPSCQueue_free(bench.spsc);
+    nsMPMCQueue_free(bench.mpmc);
+}
+
+static int bench_queue(int argc, char **argv) {
+    size_t count = argc > 0 ? (size_t)strtoul(argv[0], NULL, 10) : 500000;
+    if (count < 4) return 1;
+
+    QueueMessage *messages = NS_MALLOC(sizeof(QueueMessage) * count);
+    if (!messages) return 1;
+
+    for (size_t i = 0; i < count; i++) messages[i].value = i;
+
+    printf("messages: %zu, capacity: %d\n", count, QUEUE_CAPACITY);
+
+    bench_queue_run("mutex ring", QueueKind_MUTEX_RING, 1, 1, count, messages);
+    bench_queue_run("spsc", QueueKind_SPSC, 1, 1, count, messages);
+    bench_queue_run("mutex ring", QueueKind_MUTEX_RING, 2, 2, count, messages);
+    bench_queue_run("mpmc", QueueKind_MPMC, 2, 2, count, messages);
+    bench_queue_run("mutex list", QueueKind_MUTEX_LIST, 4, 1, count, messages);
+    bench_queue_run("stack", QueueKind_STACK, 4, 1, count, messages);
+
+    NS_FREE(messages);
+
+    return 0;
+}
+
+
+/*
+    timer
+*/
+
+static int bench_timer(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    const size_t calls = 10000000;
+    nsTimerCalibration calibration = ns_timer_get_calibration();
+
+    printf(
+        "tick source: %s, %.3f MHz\n",
+        calibration.use_tsc ? "TSC" : "system clock",
+        calibration.ticks_per_second / 1e6
+    );
+
+    // Cost of a call is measured with the clock itself, over many calls
+    volatile ns_u64 sink = 0;
+
+    ns_u64 start = ns_time_ns();
+    for (size_t i = 0; i < calls; i++) sink += ns_ticks();
+    double ticks_cost = (double)(ns_time_ns() - start) / (double)calls;
+
+    start = ns_time_ns();
+    for (size_t i = 0; i < calls; i++) sink += ns_time_ns();
+    double time_cost = (double)(ns_time_ns() - start) / (double)calls;
+
+    start = ns_time_ns();
+    for (size_t i = 0; i < calls; i++) sink += SDL_GetPerformanceCounter();
+    double sdl_cost = (double)(ns_time_ns() - start) / (double)calls;
+
+    printf(
+        "ns_ticks:                  %6.2f ns/call\n"
+        "ns_time_ns:                %6.2f ns/call\n"
+        "SDL_GetPerformanceCounter: %6.2f ns/call\n",
+        ticks_cost, time_cost, sdl_cost
+    );
+
+    // Intervals over a second used to lose their whole seconds
+    nsPrecisionTimer timer;
+    nsPrecisionTimer_start(&timer);
+    start = ns_time_ns();
+    SDL_Delay(1500);
+    double clock_elapsed = (double)(ns_time_ns() - start) / 1e9;
+    double timer_elapsed = nsPrecisionTimer_stop(&timer);
+
+    printf(
+        "1.5 s sleep: system clock %.6f s, precision timer %.6f s (%+.2f us)\n",
+        clock_elapsed, timer_elapsed, (timer_elapsed - clock_elapsed) * 1e6
+    );
+
+    return 0;
+}
+
+
+static const Benchmark BENCHMARKS[] = {
+    {"numparse", "numparse <file.obj>", bench_numparse},
+    {"objload", "objload <file.obj>", bench_objload},
+    {"slotmap", "slotmap [count]", bench_slotmap},
+    {"memory", "memory <file.obj>", bench_memory},
+    {"objpool", "objpool [count]", bench_objpool},
+    {"hashmap", "hashmap [count]", bench_hashmap},
+    {"jobs", "jobs [workers]", bench_jobs},
+    {"queue", "queue [count]", bench_queue},
+    {"timer", "timer", bench_timer}
+};
+
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS) / sizeof(Benchmark))
+
+
+static void print_usage() {
+    printf("Usage: nsbench <benchmark> [args...]\n\nBenchmarks:\n");
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        printf("  %s\n", BENCHMARKS[i].usage);
+    }
+}
+
+
+int main(int argc, char **argv) {
+    nsLogger *logger = ns_get_logger();
+    logger->outs[0] = stdout;
+    logger->min_severity = nsErrorSeverity_WARNING;
+
+    ns_timer_calibrate();
+
+    if (argc < 2) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+        if (strcmp(argv[1], BENCHMARKS[i].name) == 0) {
+            if (BENCHMARKS[i].func(argc - 2, argv + 2)) {
+                printf("Usage: nsbench %s\n", BENCHMARKS[i].usage);
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        }
+    }
+
+    print_usage();
+    return EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+
+  This file is a part of the Not Serious Engine
+  project and distributed under the GNU GPL v3 license.
+
+  Copyright © Kadir Aksoy
+  https://github.com/kadir014/not-serious-engine
+
+*/
+
+/*
+    nsmeshc - Bake meshes into the binary .nsmesh cache format ahead of time.
+
+    Usage:
+        nsmeshc <input.obj> [output.nsmesh] [--threads N] [--stream] [--no-optimize] [--no-quantize] [--no-lod]
+
+    --stream parses the input through a fixed-size buffer instead of reading
+    it whole, use it for very large files.
+
+    Meshes are reordered for vertex cache, overdraw and vertex fetch
+    efficiency unless --no-optimize is given.
+
+    Vertices are stored quantized (16 bytes instead of 32) unless
+    --no-quantize is given.
+
+    Simplified detail levels are generated and stored along the full mesh
+    unless --no-lod is given.
+
+    Every detail level is split into meshlets with culling bounds.
+
+    Output defaults to the input filepath + ".nsmesh", which is where
+    nsMesh_load looks for the cache at runtime.
+*/
+
+#include "engine/include/engine.h"
+
+
+static void print_usage() {
+    printf("Usage: nsmeshc <input.obj> [output.nsmesh] [--threads N] [--stream] [--no-optimize] [--no-quantize] [--no-lod]\n");
+}
+
+
+int main(int argc, char **argv) {
+    nsLogger *logger = ns_get_logger();
+    logger->outs[0] = stdout;
+    logger->min_severity = nsErrorSeverity_INFO;
+
+    ns_timer_calibrate();
+
+    const char *input = NULL;
+    const char *output = NULL;
+    nsOBJLoadOptions options = nsOBJLoadOptions_default;
+    ns_bool stream = false;
+    ns_bool optimize = true;
+    ns_bool quantize = true;
+    ns_bool lod = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.thread_count = (ns_u32)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        }
+        else if (strcmp(argv[i], "--no-optimize") == 0) {
+            optimize = false;
+        }
+        else if (strcmp(argv[i], "--no-quantize") == 0) {
+            quantize = false;
+        }
+        else if (strcmp(argv[i], "--no-lod") == 0) {
+            lod = false;
+        }
+        else if (!input) {
+            input = argv[i];
+        }
+        else if (!output) {
+            output = argv[i];
+        }
+        else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!input) {
+        print_usage();
+        return EXIT_FAILURE;
+    }
+
+    char default_output[1024];
+    if (!output) {
+        snprintf(default_output, sizeof(default_output), "%s%s", input, NS_MESH_CACHE_EXTENSION);
+        output = default_output;
+    }
+
+    nsPrecisionTimer timer;
+    nsPrecisionTimer_start(&timer);
+
+    nsOBJ obj;
+    if (stream) obj = nsOBJ_load_stream(input, 0);
+    else obj = nsOBJ_load_ex(input, options);
+    if (!obj.mesh.vertices) {
+        return EXIT_FAILURE;
+    }
+
+    double parse_time = nsPrecisionTimer_stop(&timer);
+
+    double lod_time = 0.0;
+    if (lod) {
+        nsPrecisionTimer_start(&timer);
+
+        if (nsOBJMesh_generate_lods(&obj.mesh, NS_MESH_MAX_LODS)) {
+            nsOBJ_free(&obj);
+            return EXIT_FAILURE;
+        }
+
+        lod_time = nsPrecisionTimer_stop(&timer);
+    }
+
+    nsMeshOptimizeStats optimize_stats;
+    double optimize_time = 0.0;
+    if (optimize) {
+        nsPrecisionTimer_start(&timer);
+
+        if (nsOBJMesh_optimize(&obj.mesh, &optimize_stats)) {
+            nsOBJ_free(&obj);
+            return EXIT_FAILURE;
+        }
+
+        optimize_time = nsPrecisionTimer_stop(&timer);
+    }
+
+    if (nsOBJMesh_build_meshlets(&obj.mesh)) {
+        nsOBJ_free(&obj);
+        return EXIT_FAILURE;
+    }
+
+    if (nsMeshCache_write(output, &obj.mesh, input, quantize)) {
+        nsOBJ_free(&obj);
+        return EXIT_FAILURE;
+    }
+
+    printf(
+        "%s -> %s\n"
+        "  vertices: %zu\n"
+        "  triangles: %zu\n"
+        "  meshlets: %zu\n"
+        "  parse time: %.3f ms\n",
+        input, output,
+        obj.mesh.vertices->size,
+        (size_t)obj.mesh.lods[0].index_count / 3,
+        obj.mesh.meshlets->size,
+        parse_time * 1000.0
+    );
+
+    if (lod) {
+        printf("  LOD time: %.3f ms\n", lod_time * 1000.0);
+
+        for (ns_u32 i = 0; i < obj.mesh.lod_count; i++) {
+            printf(
+                "  LOD %u: %u triangles, error %g\n",
+                i,
+                obj.mesh.lods[i].index_count / 3,
+                obj.mesh.lods[i].error
+            );
+        }
+    }
+
+    if (optimize) {
+        printf(
+            "  optimize time: %.3f ms\n"
+            "  ACMR: %.3f -> %.3f\n"
+            "  ATVR: %.3f -> %.3f\n",
+            optimize_time * 1000.0,
+            optimize_stats.before.acmr, optimize_stats.after.acmr,
+            optimize_stats.before.atvr, optimize_stats.after.atvr
+        );
+    }
+
+    nsOBJ_free(&obj);
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file